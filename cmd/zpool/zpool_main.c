@@ -513,7 +513,7 @@ get_usage(zpool_help_t idx)
 		return (gettext("\tinitialize [-c | -s | -u] [-w] <pool> "
 		    "[<device> ...]\n"));
 	case HELP_SCRUB:
-		return (gettext("\tscrub [-e | -s | -p | -C] [-w] "
+		return (gettext("\tscrub [-e | -s | -p | -C | -S txg] [-w] "
 		    "<pool> ...\n"));
 	case HELP_RESILVER:
 		return (gettext("\tresilver <pool> ...\n"));
@@ -8368,6 +8368,7 @@ zpool_do_reopen(int argc, char **argv)
 typedef struct scrub_cbdata {
 	int	cb_type;
 	pool_scrub_cmd_t cb_scrub_cmd;
+	uint64_t cb_txg_start;
 } scrub_cbdata_t;
 
 static boolean_t
@@ -8411,7 +8412,8 @@ scrub_callback(zpool_handle_t *zhp, void *data)
 		return (1);
 	}
 
-	err = zpool_scan(zhp, cb->cb_type, cb->cb_scrub_cmd);
+	err = zpool_scan_txg(zhp, cb->cb_type, cb->cb_scrub_cmd,
+	    cb->cb_txg_start);
 
 	if (err == 0 && zpool_has_checkpoint(zhp) &&
 	    cb->cb_type == POOL_SCAN_SCRUB) {
@@ -8431,13 +8433,14 @@ wait_callback(zpool_handle_t *zhp, void *data)
 }
 
 /*
- * zpool scrub [-e | -s | -p | -C] [-w] <pool> ...
+ * zpool scrub [-e | -s | -p | -C | -S txg] [-w] <pool> ...
  *
  *	-e	Only scrub blocks in the error log.
  *	-s	Stop.  Stops any in-progress scrub.
  *	-p	Pause. Pause in-progress scrub.
  *	-w	Wait.  Blocks until scrub has completed.
  *	-C	Scrub from last saved txg.
+ *	-S	Only scrub blocks born after the given txg.
  */
 int
 zpool_do_scrub(int argc, char **argv)
@@ -8449,14 +8452,17 @@ zpool_do_scrub(int argc, char **argv)
 
 	cb.cb_type = POOL_SCAN_SCRUB;
 	cb.cb_scrub_cmd = POOL_SCRUB_NORMAL;
+	cb.cb_txg_start = 0;
 
 	boolean_t is_error_scrub = B_FALSE;
 	boolean_t is_pause = B_FALSE;
 	boolean_t is_stop = B_FALSE;
 	boolean_t is_txg_continue = B_FALSE;
+	boolean_t is_txg_start = B_FALSE;
+	char *end;
 
 	/* check options */
-	while ((c = getopt(argc, argv, "spweC")) != -1) {
+	while ((c = getopt(argc, argv, ":spweCS:")) != -1) {
 		switch (c) {
 		case 'e':
 			is_error_scrub = B_TRUE;
@@ -8473,6 +8479,22 @@ zpool_do_scrub(int argc, char **argv)
 		case 'C':
 			is_txg_continue = B_TRUE;
 			break;
+		case 'S':
+			errno = 0;
+			cb.cb_txg_start = strtoull(optarg, &end, 10);
+			if (errno != 0 || *end != '\0' ||
+			    cb.cb_txg_start == 0) {
+				(void) fprintf(stderr,
+				    gettext("invalid txg '%s'\n"), optarg);
+				usage(B_FALSE);
+			}
+			is_txg_start = B_TRUE;
+			break;
+		case ':':
+			(void) fprintf(stderr, gettext("missing argument for "
+			    "'%c' option\n"), optopt);
+			usage(B_FALSE);
+			break;
 		case '?':
 			(void) fprintf(stderr, gettext("invalid option '%c'\n"),
 			    optopt);
@@ -8480,7 +8502,12 @@ zpool_do_scrub(int argc, char **argv)
 		}
 	}
 
-	if (is_pause && is_stop) {
+	if (is_txg_start &&
+	    (is_pause || is_stop || is_error_scrub || is_txg_continue)) {
+		(void) fprintf(stderr, gettext("invalid option "
+		    "combination: -S cannot be used with -p, -s, -e or -C\n"));
+		usage(B_FALSE);
+	} else if (is_pause && is_stop) {
 		(void) fprintf(stderr, gettext("invalid option "
 		    "combination: -s and -p are mutually exclusive\n"));
 		usage(B_FALSE);
@@ -8796,18 +8823,35 @@ print_err_scrub_status(pool_scan_stat_t *ps)
 	(void) printf("\n");
 }
 
+/*
+ * Print the txg range of an incremental scrub.
+ */
+static void
+print_scan_scrub_txg_range(pool_scan_stat_t *ps, uint_t c)
+{
+	if (ps->pss_func != POOL_SCAN_SCRUB ||
+	    c <= offsetof(pool_scan_stat_t, pss_max_txg) / 8 ||
+	    ps->pss_min_txg == 0)
+		return;
+
+	(void) printf(gettext("\tonly blocks born after txg %llu and before "
+	    "txg %llu\n"), (u_longlong_t)ps->pss_min_txg,
+	    (u_longlong_t)ps->pss_max_txg);
+}
+
 /*
  * Print out detailed scrub status.
  */
 static void
-print_scan_scrub_resilver_status(pool_scan_stat_t *ps)
+print_scan_scrub_resilver_status(pool_scan_stat_t *ps, uint_t c)
 {
 	time_t start, end, pause;
 	uint64_t pass_scanned, scanned, pass_issued, issued, total_s, total_i;
-	uint64_t elapsed, scan_rate, issue_rate;
+	uint64_t elapsed, scan_rate, issue_rate, rate_limit = 0;
 	double fraction_done;
 	char processed_buf[7], scanned_buf[7], issued_buf[7], total_s_buf[7];
-	char total_i_buf[7], srate_buf[7], irate_buf[7], time_buf[32];
+	char total_i_buf[7], srate_buf[7], irate_buf[7], lrate_buf[7];
+	char time_buf[32];
 
 	printf("  ");
 	printf_color(ANSI_BOLD, gettext("scan:"));
@@ -8839,6 +8883,7 @@ print_scan_scrub_resilver_status(pool_scan_stat_t *ps)
 			    "in %s with %llu errors on %s"), processed_buf,
 			    time_buf, (u_longlong_t)ps->pss_errors,
 			    ctime(&end));
+			print_scan_scrub_txg_range(ps, c);
 		} else if (is_resilver) {
 			(void) printf(gettext("resilvered %s "
 			    "in %s with %llu errors on %s"), processed_buf,
@@ -8874,6 +8919,7 @@ print_scan_scrub_resilver_status(pool_scan_stat_t *ps)
 		(void) printf(gettext("resilver in progress since %s"),
 		    ctime(&start));
 	}
+	print_scan_scrub_txg_range(ps, c);
 
 	scanned = ps->pss_examined;
 	pass_scanned = ps->pss_pass_exam;
@@ -8892,6 +8938,8 @@ print_scan_scrub_resilver_status(pool_scan_stat_t *ps)
 
 	scan_rate = pass_scanned / elapsed;
 	issue_rate = pass_issued / elapsed;
+	if (c > offsetof(pool_scan_stat_t, pss_rate_limit) / 8)
+		rate_limit = ps->pss_rate_limit;
 
 	/* format all of the numbers we will be reporting */
 	zfs_nicebytes(scanned, scanned_buf, sizeof (scanned_buf));
@@ -8910,6 +8958,10 @@ print_scan_scrub_resilver_status(pool_scan_stat_t *ps)
 		zfs_nicebytes(issue_rate, irate_buf, sizeof (irate_buf));
 		(void) printf(gettext(" at %s/s"), irate_buf);
 	}
+	if (pause == 0 && rate_limit > 0) {
+		zfs_nicebytes(rate_limit, lrate_buf, sizeof (lrate_buf));
+		(void) printf(gettext(" (limited to %s/s)"), lrate_buf);
+	}
 	(void) printf(gettext("\n"));
 
 	if (is_resilver) {
@@ -9833,6 +9885,17 @@ scan_status_nvlist(zpool_handle_t *zhp, status_cbdata_t *cb,
 		    cb->cb_json_as_int, ZFS_NICENUM_BYTES);
 		nice_num_str_nvlist(scan, "issued", ps->pss_issued,
 		    cb->cb_literal, cb->cb_json_as_int, ZFS_NICENUM_BYTES);
+		if (c > offsetof(pool_scan_stat_t, pss_rate_limit) / 8) {
+			nice_num_str_nvlist(scan, "rate_limit",
+			    ps->pss_rate_limit, cb->cb_literal,
+			    cb->cb_json_as_int, ZFS_NICENUM_BYTES);
+		}
+		if (c > offsetof(pool_scan_stat_t, pss_max_txg) / 8) {
+			nice_num_str_nvlist(scan, "min_txg", ps->pss_min_txg,
+			    B_TRUE, cb->cb_json_as_int, ZFS_NICENUM_1024);
+			nice_num_str_nvlist(scan, "max_txg", ps->pss_max_txg,
+			    B_TRUE, cb->cb_json_as_int, ZFS_NICENUM_1024);
+		}
 		if (ps->pss_error_scrub_func == POOL_SCAN_ERRORSCRUB &&
 		    ps->pss_error_scrub_start > ps->pss_start_time) {
 			fnvlist_add_string(scan, "err_scrub_func",
@@ -9957,7 +10020,7 @@ print_scan_status(zpool_handle_t *zhp, nvlist_t *nvroot)
 	boolean_t active_resilver = B_FALSE;
 	pool_checkpoint_stat_t *pcs = NULL;
 	pool_scan_stat_t *ps = NULL;
-	uint_t c;
+	uint_t c = 0;
 	time_t scrub_start = 0, errorscrub_start = 0;
 
 	if (nvlist_lookup_uint64_array(nvroot, ZPOOL_CONFIG_SCAN_STATS,
@@ -9983,7 +10046,7 @@ print_scan_status(zpool_handle_t *zhp, nvlist_t *nvroot)
 
 	/* Always print the scrub status when available. */
 	if (have_scrub && scrub_start > errorscrub_start)
-		print_scan_scrub_resilver_status(ps);
+		print_scan_scrub_resilver_status(ps, c);
 	else if (have_errorscrub && errorscrub_start >= scrub_start)
 		print_err_scrub_status(ps);
 
@@ -9993,7 +10056,7 @@ print_scan_status(zpool_handle_t *zhp, nvlist_t *nvroot)
 	 */
 	if (active_resilver || (!active_rebuild && have_resilver &&
 	    resilver_end_time && resilver_end_time > rebuild_end_time)) {
-		print_scan_scrub_resilver_status(ps);
+		print_scan_scrub_resilver_status(ps, c);
 	} else if (active_rebuild || (!active_resilver && have_rebuild &&
 	    rebuild_end_time && rebuild_end_time > resilver_end_time)) {
 		print_rebuild_status(zhp, nvroot);
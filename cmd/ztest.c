@@ -2209,6 +2209,16 @@ ztest_replay_write(void *arg1, void *arg2, boolean_t byteswap)
 	if (byteswap)
 		byteswap_uint64_array(lr, sizeof (*lr));
 
+	/*
+	 * In a pass that is going to be killed anyway, now and then crash in
+	 * the middle of replay, so that the next pass has to pick up a log
+	 * whose writes were only partly applied by the replay threads.
+	 */
+	if (zd->zd_zilog->zl_replay &&
+	    ztest_shared->zs_thread_kill < ztest_shared->zs_thread_stop &&
+	    ztest_random(1000) == 0)
+		ztest_kill(ztest_shared);
+
 	offset = lr->lr_offset;
 	length = lr->lr_length;
 
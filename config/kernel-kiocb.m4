@@ -0,0 +1,26 @@
+dnl #
+dnl # 5.16 API change,
+dnl # The unused res2 argument was removed from kiocb->ki_complete().
+dnl #
+AC_DEFUN([ZFS_AC_KERNEL_SRC_KIOCB_COMPLETE], [
+	ZFS_LINUX_TEST_SRC([kiocb_ki_complete_2args], [
+		#include <linux/fs.h>
+
+		static void complete(struct kiocb *iocb, long ret)
+		    { (void) iocb, (void) ret; }
+	],[
+		struct kiocb iocb __attribute__ ((unused));
+		iocb.ki_complete = complete;
+	])
+])
+
+AC_DEFUN([ZFS_AC_KERNEL_KIOCB_COMPLETE], [
+	AC_MSG_CHECKING([whether ki_complete() wants 2 args])
+	ZFS_LINUX_TEST_RESULT([kiocb_ki_complete_2args], [
+		AC_MSG_RESULT(yes)
+		AC_DEFINE(HAVE_KIOCB_KI_COMPLETE_2ARGS, 1,
+		    [ki_complete() wants 2 args])
+	],[
+		AC_MSG_RESULT(no)
+	])
+])
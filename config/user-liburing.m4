@@ -0,0 +1,18 @@
+dnl #
+dnl # Check for liburing - used by libzpool for asynchronous file vdev I/O.
+dnl #
+AC_DEFUN([ZFS_AC_CONFIG_USER_LIBURING], [
+	AC_ARG_WITH([liburing],
+	    AS_HELP_STRING([--with-liburing],
+		[use io_uring for file vdevs in libzpool @<:@default=auto@:>@]),
+	    [],
+	    [with_liburing=auto])
+
+	AS_IF([test "x$with_liburing" != "xno"], [
+		ZFS_AC_FIND_SYSTEM_LIBRARY(LIBURING, [liburing], [liburing.h], [], [uring], [io_uring_queue_init_params], [], [
+			AS_IF([test "x$with_liburing" = "xyes"], [
+				AC_MSG_FAILURE([--with-liburing was given, but liburing is not available, try installing liburing-devel])
+			])
+		])
+	])
+])
@@ -107,6 +107,9 @@
 #define	fletcher_4_param_set_args(var) \
     CTLTYPE_STRING, NULL, 0, fletcher_4_param, "A"
 
+#define	lz4_param_set_args(var) \
+    CTLTYPE_STRING, NULL, 0, lz4_param, "A"
+
 #define	blake3_param_set_args(var) \
     CTLTYPE_STRING, NULL, 0, blake3_param, "A"
 
@@ -77,6 +77,7 @@ extern "C" {
 typedef struct arc_buf_hdr arc_buf_hdr_t;
 typedef struct arc_buf arc_buf_t;
 typedef struct arc_prune arc_prune_t;
+typedef struct arc_dataset arc_dataset_t;
 
 /*
  * Because the ARC can store encrypted data, errors (not due to bugs) may arise
@@ -329,6 +330,14 @@ void arc_remove_prune_callback(arc_prune_t *p);
 void arc_freed(spa_t *spa, const blkptr_t *bp);
 int arc_cached(spa_t *spa, const blkptr_t *bp);
 
+arc_dataset_t *arc_dataset_get(spa_t *spa, uint64_t objset);
+void arc_dataset_hold(arc_dataset_t *ads);
+void arc_dataset_rele(arc_dataset_t *ads);
+void arc_dataset_set_quota(arc_dataset_t *ads, uint64_t quota);
+void arc_dataset_set_reservation(arc_dataset_t *ads, uint64_t reservation);
+void arc_dataset_stats(arc_dataset_t *ads, uint64_t *size, uint64_t *hits,
+    uint64_t *misses);
+
 void arc_flush(spa_t *spa, boolean_t retry);
 void arc_flush_async(spa_t *spa);
 void arc_tempreserve_clear(uint64_t reserve);
@@ -159,6 +159,32 @@ struct arc_write_callback {
  * words in pointers. arc_hdr_realloc() is used to switch a header between
  * these two allocation states.
  */
+/* Decision of the ARC admission filter, see arc_admit() */
+typedef enum arc_admit_state {
+	ARC_ADMIT_NONE = 0,	/* not filtered */
+	ARC_ADMIT_ACCEPTED,
+	ARC_ADMIT_REJECTED
+} arc_admit_state_t;
+
+/*
+ * Per dataset accounting for the arc_quota and arc_reservation properties,
+ * kept in arc_dataset_tree and held by the objset and by the headers of
+ * the blocks it caches.  See arc_dataset_get().
+ */
+struct arc_dataset {
+	avl_node_t	ads_node;
+	uint64_t	ads_spa;	/* spa_load_guid() */
+	uint64_t	ads_objset;
+	uint64_t	ads_refcnt;
+	uint64_t	ads_quota;	/* 0 if none */
+	uint64_t	ads_reservation;	/* 0 if none */
+	uint64_t	ads_size;	/* logical bytes in MRU/MFU/uncached */
+	uint32_t	ads_over_quota;	/* waiting for the evict thread */
+	boolean_t	ads_limited;	/* counted in arc_dataset_limited */
+	wmsum_t		ads_hits;
+	wmsum_t		ads_misses;
+};
+
 typedef struct l1arc_buf_hdr {
 	/* protected by arc state mutex */
 	arc_state_t		*b_state;
@@ -171,7 +197,9 @@ typedef struct l1arc_buf_hdr {
 	uint32_t		b_mfu_hits;
 	uint32_t		b_mfu_ghost_hits;
 	uint8_t			b_byteswap;
+	uint8_t			b_admit;	/* arc_admit_state_t */
 	arc_buf_t		*b_buf;
+	arc_dataset_t		*b_dataset;	/* held, may be NULL */
 
 	/* self protecting */
 	zfs_refcount_t		b_refcnt;
@@ -421,6 +449,14 @@ typedef struct l2arc_dev {
 	 */
 	zfs_refcount_t		l2ad_lb_count;
 	boolean_t		l2ad_trim_all; /* TRIM whole device */
+	/*
+	 * Feed scheduling, protected by l2arc_dev_mtx.  While l2ad_feeding
+	 * is set a feed task owns the device and holds its spa config lock.
+	 */
+	boolean_t		l2ad_feeding;
+	clock_t			l2ad_feed_next;	/* next feed due (lbolt) */
+	taskq_ent_t		l2ad_feed_tqent;
+	uint_t			l2ad_id;	/* see L2HDR_GET_DEV_ID() */
 } l2arc_dev_t;
 
 /*
@@ -455,13 +491,37 @@ typedef struct arc_buf_hdr_crypt {
 
 typedef struct l2arc_buf_hdr {
 	/* protected by arc_buf_hdr mutex */
-	l2arc_dev_t		*b_dev;		/* L2ARC device */
-	uint64_t		b_daddr;	/* disk address, offset byte */
-	uint32_t		b_hits;
-	arc_state_type_t	b_arcs_state;
+	uint64_t		b_prop;		/* see L2HDR_GET_DADDR() */
 	list_node_t		b_l2node;
 } l2arc_buf_hdr_t;
 
+/*
+ * Every L2ARC-only buffer costs an arc_buf_hdr_t up to b_l1hdr, which
+ * adds up with large cache devices.  Rather than a pointer to its
+ * l2arc_dev_t the header keeps the small id of the device (l2ad_id), and
+ * packs it with the disk address and the ARC state into b_prop.  Disk
+ * addresses are always SPA_MINBLOCKSIZE aligned.
+ *
+ *	64      56      48      40      32      24      16      8       0
+ *	+-------+-------+-------+-------+-------+-------+-------+-------+
+ *	|  dev id  |state|        disk address >> SPA_MINBLOCKSHIFT      |
+ *	+-------+-------+-------+-------+-------+-------+-------+-------+
+ */
+#define	L2ARC_DEV_ID_BITS	10
+#define	L2ARC_DEV_ID_MAX	((1U << L2ARC_DEV_ID_BITS) - 1)
+
+#define	L2HDR_GET_DADDR(l2hdr)	\
+	BF64_GET_SB((l2hdr)->b_prop, 0, 50, SPA_MINBLOCKSHIFT, 0)
+#define	L2HDR_GET_STATE(l2hdr)	BF64_GET((l2hdr)->b_prop, 50, 4)
+#define	L2HDR_GET_DEV_ID(l2hdr)	\
+	BF64_GET((l2hdr)->b_prop, 54, L2ARC_DEV_ID_BITS)
+
+#define	L2HDR_SET_DADDR(l2hdr, x)	\
+	BF64_SET_SB((l2hdr)->b_prop, 0, 50, SPA_MINBLOCKSHIFT, 0, x)
+#define	L2HDR_SET_STATE(l2hdr, x)	BF64_SET((l2hdr)->b_prop, 50, 4, x)
+#define	L2HDR_SET_DEV_ID(l2hdr, x)	\
+	BF64_SET((l2hdr)->b_prop, 54, L2ARC_DEV_ID_BITS, x)
+
 typedef struct l2arc_write_callback {
 	l2arc_dev_t	*l2wcb_dev;		/* device info */
 	arc_buf_hdr_t	*l2wcb_head;		/* head of write buflist */
@@ -473,11 +533,6 @@ struct arc_buf_hdr {
 	/* protected by hash lock */
 	dva_t			b_dva;
 	uint64_t		b_birth;
-
-	arc_buf_contents_t	b_type;
-	uint8_t			b_complevel;
-	uint8_t			b_reserved1;	/* used for 4 byte alignment */
-	uint16_t		b_l2size;	/* alignment or L2-only size */
 	arc_buf_hdr_t		*b_hash_next;
 	arc_flags_t		b_flags;
 
@@ -508,7 +563,15 @@ struct arc_buf_hdr {
 	uint16_t		b_lsize;	/* immutable */
 	uint64_t		b_spa;		/* immutable */
 
-	/* L2ARC fields. Undefined when not in L2ARC. */
+	uint8_t			b_type;		/* arc_buf_contents_t */
+	uint8_t			b_complevel;
+	uint16_t		b_l2size;	/* alignment or L2-only size */
+
+	/*
+	 * L2ARC fields. Undefined when not in L2ARC.  The hit count is
+	 * kept out of b_l2hdr so that it fills the hole before it.
+	 */
+	uint32_t		b_l2hits;
 	l2arc_buf_hdr_t		b_l2hdr;
 	/* L1ARC fields. Undefined when in l2arc_only state */
 	l1arc_buf_hdr_t		b_l1hdr;
@@ -547,6 +610,15 @@ typedef struct arc_stats {
 	kstat_named_t arcstat_mfu_hits;
 	kstat_named_t arcstat_mfu_ghost_hits;
 	kstat_named_t arcstat_uncached_hits;
+	/*
+	 * Data blocks accepted and rejected by the admission filter
+	 * (zfs_arc_admit), and later hits on them.  Rejected blocks can
+	 * only be hit while they are still in the uncached state.
+	 */
+	kstat_named_t arcstat_admit_accepted;
+	kstat_named_t arcstat_admit_rejected;
+	kstat_named_t arcstat_admit_accepted_hits;
+	kstat_named_t arcstat_admit_rejected_hits;
 	kstat_named_t arcstat_deleted;
 	/*
 	 * Number of buffers that could not be evicted because the hash lock
@@ -582,6 +654,16 @@ typedef struct arc_stats {
 	kstat_named_t arcstat_hash_collisions;
 	kstat_named_t arcstat_hash_chains;
 	kstat_named_t arcstat_hash_chain_max;
+	/* Current number of hash table buckets and lock stripes. */
+	kstat_named_t arcstat_hash_buckets;
+	kstat_named_t arcstat_hash_locks;
+	/* Number of times the hash table has been resized online. */
+	kstat_named_t arcstat_hash_resizes;
+	/*
+	 * Number of hash table lookups and inserts that found their
+	 * stripe lock already held by another thread.
+	 */
+	kstat_named_t arcstat_hash_lock_contended;
 	kstat_named_t arcstat_meta;
 	kstat_named_t arcstat_pd;
 	kstat_named_t arcstat_pm;
@@ -618,6 +700,11 @@ typedef struct arc_stats {
 	 * cache).
 	 */
 	kstat_named_t arcstat_hdr_size;
+	/*
+	 * Bytes of arcstat_hdr_size per MiB of data and metadata in the
+	 * ARC (arcstat_data_size + arcstat_metadata_size).
+	 */
+	kstat_named_t arcstat_hdr_overhead;
 	/*
 	 * Number of bytes consumed by ARC buffers of type equal to
 	 * ARC_BUFC_DATA. This is generally consumed by buffers backing
@@ -810,6 +897,11 @@ typedef struct arc_stats {
 	kstat_named_t arcstat_l2_lsize;
 	kstat_named_t arcstat_l2_psize;
 	kstat_named_t arcstat_l2_hdr_size;
+	/*
+	 * Bytes of arcstat_l2_hdr_size per MiB of data stored on the L2ARC
+	 * devices (arcstat_l2_psize).
+	 */
+	kstat_named_t arcstat_l2_hdr_overhead;
 	/*
 	 * Number of L2ARC log blocks written. These are used for restoring the
 	 * L2ARC. Updated during writing of L2ARC log blocks.
@@ -932,6 +1024,10 @@ typedef struct arc_sums {
 	wmsum_t arcstat_mfu_hits;
 	wmsum_t arcstat_mfu_ghost_hits;
 	wmsum_t arcstat_uncached_hits;
+	wmsum_t arcstat_admit_accepted;
+	wmsum_t arcstat_admit_rejected;
+	wmsum_t arcstat_admit_accepted_hits;
+	wmsum_t arcstat_admit_rejected_hits;
 	wmsum_t arcstat_deleted;
 	wmsum_t arcstat_mutex_miss;
 	wmsum_t arcstat_access_skip;
@@ -946,6 +1042,7 @@ typedef struct arc_sums {
 	wmsum_t arcstat_hash_elements;
 	wmsum_t arcstat_hash_collisions;
 	wmsum_t arcstat_hash_chains;
+	wmsum_t arcstat_hash_lock_contended;
 	aggsum_t arcstat_size;
 	wmsum_t arcstat_compressed_size;
 	wmsum_t arcstat_uncompressed_size;
@@ -29,9 +29,11 @@
 #define	_SYS_DATASET_KSTATS_H
 
 #include <sys/wmsum.h>
+#include <sys/arc.h>
 #include <sys/dmu.h>
 #include <sys/kstat.h>
 #include <sys/zil.h>
+#include <sys/zio_compress.h>
 
 typedef struct dataset_sum_stats_t {
 	wmsum_t dss_writes;
@@ -40,8 +42,28 @@ typedef struct dataset_sum_stats_t {
 	wmsum_t dss_nread;
 	wmsum_t dss_nunlinks;
 	wmsum_t dss_nunlinked;
+	wmsum_t dss_iolimit_read_delayed;
+	wmsum_t dss_iolimit_read_delay;
+	wmsum_t dss_iolimit_write_delayed;
+	wmsum_t dss_iolimit_write_delay;
 } dataset_sum_stats_t;
 
+/*
+ * compression=auto decisions and, for each candidate, the blocks assigned
+ * to it, how many of those were samples, and the smoothed compression ratio
+ * (* 100) and throughput (MB/s) measured for it.
+ */
+typedef struct dataset_compress_auto_kstat_values {
+	kstat_named_t dcak_current;
+	kstat_named_t dcak_switches;
+	struct {
+		kstat_named_t dcak_blocks;
+		kstat_named_t dcak_samples;
+		kstat_named_t dcak_ratio;
+		kstat_named_t dcak_mbps;
+	} dcak_cand[ZIO_COMPRESS_AUTO_CANDIDATES];
+} dataset_compress_auto_kstat_values_t;
+
 typedef struct dataset_kstat_values {
 	kstat_named_t dkv_ds_name;
 	kstat_named_t dkv_writes;
@@ -58,15 +80,36 @@ typedef struct dataset_kstat_values {
 	 * entry is removed from the unlinked set
 	 */
 	kstat_named_t dkv_nunlinked;
+	/*
+	 * Reads and writes delayed by the iolimit_* properties, and the
+	 * total time they were delayed for
+	 */
+	kstat_named_t dkv_iolimit_read_delayed;
+	kstat_named_t dkv_iolimit_read_delay_us;
+	kstat_named_t dkv_iolimit_write_delayed;
+	kstat_named_t dkv_iolimit_write_delay_us;
+	/*
+	 * Logical size of the dataset's blocks in the ARC, and ARC hits and
+	 * misses on them (see the arc_quota and arc_reservation properties)
+	 */
+	kstat_named_t dkv_arc_size;
+	kstat_named_t dkv_arc_hits;
+	kstat_named_t dkv_arc_misses;
 	/*
 	 * Per dataset zil kstats
 	 */
 	zil_kstat_values_t dkv_zil_stats;
+	/*
+	 * Per dataset compression=auto kstats
+	 */
+	dataset_compress_auto_kstat_values_t dkv_compress_auto;
 } dataset_kstat_values_t;
 
 typedef struct dataset_kstats {
 	dataset_sum_stats_t dk_sums;
 	zil_sums_t dk_zil_sums;
+	zio_compress_auto_t *dk_compress_auto;
+	arc_dataset_t *dk_arc_dataset;
 	kstat_t *dk_kstats;
 } dataset_kstats_t;
 
@@ -76,6 +119,8 @@ void dataset_kstats_rename(dataset_kstats_t *dk, const char *);
 
 void dataset_kstats_update_write_kstats(dataset_kstats_t *, int64_t);
 void dataset_kstats_update_read_kstats(dataset_kstats_t *, int64_t);
+void dataset_kstats_update_iolimit_kstats(dataset_kstats_t *, boolean_t,
+    hrtime_t);
 
 void dataset_kstats_update_nunlinks_kstat(dataset_kstats_t *, int64_t);
 void dataset_kstats_update_nunlinked_kstat(dataset_kstats_t *, int64_t);
@@ -328,14 +328,19 @@ typedef struct dmu_buf_impl {
 	dmu_buf_user_t *db_user;
 } dmu_buf_impl_t;
 
-#define	DBUF_HASH_MUTEX(h, idx) \
-	(&(h)->hash_mutexes[(idx) & ((h)->hash_mutex_mask)])
+#define	DBUF_HASH_RWLOCK(h, idx) \
+	(&(h)->hash_rwlocks[(idx) & ((h)->hash_rwlock_mask)])
 
+/*
+ * Lookups only need to hold the bucket lock as reader, so that concurrent
+ * dbuf_find() calls on the same bucket never wait for each other.  The
+ * lock is taken as writer only to insert or remove a dbuf.
+ */
 typedef struct dbuf_hash_table {
 	uint64_t hash_table_mask;
-	uint64_t hash_mutex_mask;
+	uint64_t hash_rwlock_mask;
 	dmu_buf_impl_t **hash_table;
-	kmutex_t *hash_mutexes;
+	krwlock_t *hash_rwlocks;
 } dbuf_hash_table_t;
 
 typedef void (*dbuf_prefetch_fn)(void *, uint64_t, uint64_t, boolean_t);
@@ -99,6 +99,29 @@ typedef struct objset_phys {
 
 typedef int (*dmu_objset_upgrade_cb_t)(objset_t *);
 
+/*
+ * Per dataset I/O limits (the iolimit_* properties), see dmu_iolimit.c.
+ */
+typedef enum dmu_iolimit_type {
+	DMU_IOLIMIT_READ_BPS,
+	DMU_IOLIMIT_WRITE_BPS,
+	DMU_IOLIMIT_READ_IOPS,
+	DMU_IOLIMIT_WRITE_IOPS,
+	DMU_IOLIMIT_TYPES
+} dmu_iolimit_type_t;
+
+typedef struct dmu_iolimit_bucket {
+	uint64_t	dib_limit;	/* per second, 0 if unlimited */
+	hrtime_t	dib_tat;	/* theoretical arrival time */
+} dmu_iolimit_bucket_t;
+
+typedef struct dmu_iolimit {
+	kmutex_t	dil_lock;
+	kcondvar_t	dil_cv;
+	uint64_t	dil_gen;	/* bumped when a limit changes */
+	dmu_iolimit_bucket_t dil_bucket[DMU_IOLIMIT_TYPES];
+} dmu_iolimit_t;
+
 #define	OBJSET_PROP_UNINITIALIZED	((uint64_t)-1)
 struct objset {
 	/* Immutable: */
@@ -127,6 +150,7 @@ struct objset {
 	enum zio_checksum os_checksum;
 	enum zio_compress os_compress;
 	uint8_t os_complevel;
+	struct zio_compress_auto *os_compress_auto;
 	uint8_t os_copies;
 	enum zio_checksum os_dedup_checksum;
 	boolean_t os_dedup_verify;
@@ -138,6 +162,8 @@ struct objset {
 	zfs_direct_t os_direct;
 	zfs_redundant_metadata_type_t os_redundant_metadata;
 	uint64_t os_recordsize;
+	dmu_iolimit_t os_iolimit;
+	arc_dataset_t *os_arc_dataset;	/* arc_quota and arc_reservation */
 	/*
 	 * The next four values are used as a cache of whatever's on disk, and
 	 * are initialized the first time these properties are queried. Before
@@ -236,6 +262,11 @@ int dmu_objset_find_dp(struct dsl_pool *dp, uint64_t ddobj,
     void *arg, int flags);
 void dmu_objset_evict_dbufs(objset_t *os);
 inode_timespec_t dmu_objset_snap_cmtime(objset_t *os);
+int dmu_objset_iolimit(objset_t *os, boolean_t write, uint64_t bytes,
+    boolean_t interruptible, hrtime_t *delayp);
+hrtime_t dmu_objset_iolimit_charge(objset_t *os, boolean_t write,
+    uint64_t bytes, uint64_t *genp);
+boolean_t dmu_objset_iolimit_changed(objset_t *os, uint64_t gen);
 
 /* called from dsl */
 void dmu_objset_sync(objset_t *os, zio_t *zio, dmu_tx_t *tx);
@@ -269,6 +300,11 @@ int dmu_fsname(const char *snapname, char *buf);
 void dmu_objset_evict_done(objset_t *os);
 void dmu_objset_willuse_space(objset_t *os, int64_t space, dmu_tx_t *tx);
 
+void dmu_iolimit_init(dmu_iolimit_t *dil);
+void dmu_iolimit_fini(dmu_iolimit_t *dil);
+void dmu_iolimit_set(dmu_iolimit_t *dil, dmu_iolimit_type_t type,
+    uint64_t limit);
+
 void dmu_objset_init(void);
 void dmu_objset_fini(void);
 
@@ -63,8 +63,12 @@ int dmu_send_obj(const char *pool, uint64_t tosnap, uint64_t fromsnap,
     struct dmu_send_outparams *dso);
 
 typedef int (*dmu_send_outfunc_t)(objset_t *os, void *buf, int len, void *arg);
+typedef int (*dmu_send_outfunc_abd_t)(objset_t *os, abd_t *abd, int len,
+    void *arg);
 typedef struct dmu_send_outparams {
 	dmu_send_outfunc_t	dso_outfunc;
+	/* Optional, writes payloads held in (possibly scatter) ABDs */
+	dmu_send_outfunc_abd_t	dso_outfunc_abd;
 	void			*dso_arg;
 	boolean_t		dso_dryrun;
 } dmu_send_outparams_t;
@@ -95,6 +95,17 @@ typedef struct dsl_errorscrub_phys {
 #define	ERRORSCRUB_PHYS_NUMINTS (sizeof (dsl_errorscrub_phys_t) \
 	/ sizeof (uint64_t))
 
+/*
+ * Virtual clock enforcing a scrub_rate limit, see scan_rate_wait().
+ * Nonzero limits must be at least SCAN_RATE_MIN bytes/sec.
+ */
+#define	SCAN_RATE_MIN	(1ULL << 20)
+
+typedef struct dsl_scan_rate {
+	hrtime_t	dsr_tat;	/* when all charged I/O is issued */
+	uint64_t	dsr_limit;	/* bytes/sec dsr_tat was charged at */
+} dsl_scan_rate_t;
+
 /*
  * Every pool will have one dsl_scan_t and this structure will contain
  * in-memory information about the scan and a pointer to the on-disk
@@ -142,6 +153,7 @@ typedef struct dsl_scan {
 	boolean_t scn_is_sorted;	/* doing sequential scan */
 	boolean_t scn_clearing;		/* scan is issuing sequential extents */
 	boolean_t scn_checkpointing;	/* scan is issuing all queued extents */
+	uint64_t scn_issue_mlim;	/* per queue limit while scanning */
 	boolean_t scn_suspending;	/* scan is suspending until next txg */
 	uint64_t scn_last_checkpoint;	/* time of last checkpoint */
 
@@ -154,6 +166,7 @@ typedef struct dsl_scan {
 	zbookmark_phys_t scn_prefetch_bookmark;	/* prefetch start bookmark */
 	avl_tree_t scn_prefetch_queue;	/* priority queue of prefetch IOs */
 	uint64_t scn_maxinflight_bytes; /* max bytes in flight for pool */
+	dsl_scan_rate_t scn_rate;	/* pool scrub_rate limit */
 
 	/* per txg statistics */
 	uint64_t scn_visited_this_txg;	/* total bps visited this txg */
@@ -219,6 +232,7 @@ boolean_t dsl_scan_active(dsl_scan_t *scn);
 boolean_t dsl_scan_is_paused_scrub(const dsl_scan_t *scn);
 boolean_t dsl_errorscrub_is_paused(const dsl_scan_t *scn);
 void dsl_scan_freed(spa_t *spa, const blkptr_t *bp);
+uint64_t dsl_scan_rate_limit(spa_t *spa);
 void dsl_scan_io_queue_destroy(dsl_scan_io_queue_t *queue);
 void dsl_scan_io_queue_vdev_xfer(vdev_t *svd, vdev_t *tvd);
 
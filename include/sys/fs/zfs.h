@@ -203,6 +203,12 @@ typedef enum {
 	ZFS_PROP_DEFAULTUSEROBJQUOTA,
 	ZFS_PROP_DEFAULTGROUPOBJQUOTA,
 	ZFS_PROP_DEFAULTPROJECTOBJQUOTA,
+	ZFS_PROP_IOLIMIT_READ_BPS,
+	ZFS_PROP_IOLIMIT_WRITE_BPS,
+	ZFS_PROP_IOLIMIT_READ_IOPS,
+	ZFS_PROP_IOLIMIT_WRITE_IOPS,
+	ZFS_PROP_ARC_QUOTA,
+	ZFS_PROP_ARC_RESERVATION,
 	ZFS_NUM_PROPS
 } zfs_prop_t;
 
@@ -272,6 +278,7 @@ typedef enum {
 	ZPOOL_PROP_DEDUP_TABLE_QUOTA,
 	ZPOOL_PROP_DEDUPCACHED,
 	ZPOOL_PROP_LAST_SCRUBBED_TXG,
+	ZPOOL_PROP_SCRUB_RATE,
 	ZPOOL_NUM_PROPS
 } zpool_prop_t;
 
@@ -385,9 +392,19 @@ typedef enum {
 	VDEV_PROP_TRIM_SUPPORT,
 	VDEV_PROP_TRIM_ERRORS,
 	VDEV_PROP_SLOW_IOS,
+	VDEV_PROP_SCHEDULER,
+	VDEV_PROP_SCRUB_RATE,
 	VDEV_NUM_PROPS
 } vdev_prop_t;
 
+/*
+ * I/O schedulers a leaf vdev's queue can use (vdev property "scheduler").
+ */
+typedef enum vdev_scheduler {
+	VDEV_SCHEDULER_CLASSIC,		/* min/max active per class */
+	VDEV_SCHEDULER_DEADLINE		/* latency targets, see vdev_queue.c */
+} vdev_scheduler_t;
+
 /*
  * Dataset property functions shared between libzfs and kernel.
  */
@@ -1190,6 +1207,12 @@ typedef struct pool_scan_stat {
 	/* error scrub pause time in milliseconds */
 	uint64_t	pss_pass_error_scrub_pause;
 
+	/* effective scrub_rate limit in bytes/sec, 0 if unlimited */
+	uint64_t	pss_rate_limit;
+
+	/* only blocks born after pss_min_txg and before pss_max_txg */
+	uint64_t	pss_min_txg;
+	uint64_t	pss_max_txg;
 } pool_scan_stat_t;
 
 typedef struct pool_removal_stat {
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: CDDL-1.0
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at usr/src/OPENSOLARIS.LICENSE
+ * or https://opensource.org/licenses/CDDL-1.0.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at usr/src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+#ifndef _SYS_LZ4_IMPL_H
+#define	_SYS_LZ4_IMPL_H
+
+#include <sys/types.h>
+#include <sys/simd.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/*
+ * Copy and match-count kernels the LZ4 compressor (lz4_zfs.c) and
+ * decompressor (lz4.c) can be instantiated with.  The scalar kernel is
+ * the portable upstream code; the others replace its inner copy and
+ * compare loops with SSE2, SSSE3 or AVX2 sequences.  All kernels produce
+ * and accept exactly the same stream.
+ */
+typedef enum lz4_kernel {
+	LZ4_KERNEL_SCALAR = 0,
+	LZ4_KERNEL_SSE2,
+	LZ4_KERNEL_SSSE3,
+	LZ4_KERNEL_AVX2
+} lz4_kernel_t;
+
+/*
+ * The SIMD kernels run between kfpu_begin() and kfpu_end(), which on Linux
+ * disable preemption and local interrupts.  So that a large block does not
+ * keep them disabled for long, they end and re-enter the FPU section every
+ * LZ4_FPU_CHUNK bytes of input (compression) or output (decompression),
+ * with LZ4_FPU_YIELD() at points where no vector registers are live.
+ */
+#define	LZ4_FPU_CHUNK		(32 * 1024)
+
+#define	LZ4_FPU_YIELD(kernel, pos, next) do {				\
+	if ((kernel) != LZ4_KERNEL_SCALAR && (pos) >= (next)) {	\
+		kfpu_end();						\
+		kfpu_begin();						\
+		(next) = (pos) + LZ4_FPU_CHUNK;				\
+	}								\
+} while (0)
+
+typedef int lz4_compress_f(void *ctx, const char *source, char *dest,
+    int isize, int osize);
+typedef int lz4_decompress_f(const char *source, char *dest,
+    int isize, int maxOutputSize);
+typedef boolean_t lz4_will_work_f(void);
+
+#define	LZ4_IMPL_NAME_MAX	(16)
+
+typedef struct lz4_impl_ops {
+	lz4_compress_f *compress;
+	lz4_decompress_f *decompress;
+	lz4_will_work_f *is_supported;
+	boolean_t uses_fpu;
+	char name[LZ4_IMPL_NAME_MAX];
+} lz4_impl_ops_t;
+
+/* See lz4.c */
+extern int LZ4_uncompress_unknownOutputSize(const char *source, char *dest,
+    int isize, int maxOutputSize);
+#if defined(__x86_64) && defined(HAVE_SSE2)
+extern int LZ4_uncompress_unknownOutputSize_sse2(const char *source,
+    char *dest, int isize, int maxOutputSize);
+#endif
+#if defined(__x86_64) && defined(HAVE_SSE2) && defined(HAVE_SSSE3)
+extern int LZ4_uncompress_unknownOutputSize_ssse3(const char *source,
+    char *dest, int isize, int maxOutputSize);
+#endif
+#if defined(__x86_64) && defined(HAVE_SSSE3) && defined(HAVE_AVX2)
+extern int LZ4_uncompress_unknownOutputSize_avx2(const char *source,
+    char *dest, int isize, int maxOutputSize);
+#endif
+
+extern int lz4_impl_set(const char *name);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* _SYS_LZ4_IMPL_H */
@@ -85,6 +85,8 @@ int metaslab_alloc(spa_t *, metaslab_class_t *, uint64_t, blkptr_t *, int,
 int metaslab_alloc_range(spa_t *, metaslab_class_t *, uint64_t, uint64_t,
     blkptr_t *, int, uint64_t, const blkptr_t *, int, zio_alloc_list_t *,
     int, const void *, uint64_t *);
+int metaslab_alloc_batch(spa_t *, metaslab_class_t *, int, const uint64_t *,
+    blkptr_t **, uint64_t, int, zio_alloc_list_t *, int, const void **);
 int metaslab_alloc_dva(spa_t *, metaslab_class_t *, uint64_t,
     dva_t *, int, const dva_t *, uint64_t, int, zio_alloc_list_t *, int);
 void metaslab_free(spa_t *, const blkptr_t *, uint64_t, boolean_t);
@@ -118,6 +120,7 @@ const char *metaslab_class_get_name(metaslab_class_t *);
 uint64_t metaslab_class_get_alloc(metaslab_class_t *);
 uint64_t metaslab_class_get_space(metaslab_class_t *);
 uint64_t metaslab_class_get_dspace(metaslab_class_t *);
+uint64_t metaslab_class_get_groups(metaslab_class_t *);
 uint64_t metaslab_class_get_deferred(metaslab_class_t *);
 
 void metaslab_space_update(vdev_t *, metaslab_class_t *,
@@ -922,6 +922,17 @@ typedef enum txg_state {
 	TXG_STATE_COMMITTED	= 5,
 } txg_state_t;
 
+/*
+ * Phases of spa_sync() whose cumulative time, across all sync passes,
+ * is reported in the txgs kstat.
+ */
+typedef enum spa_sync_phase {
+	SPA_SYNC_PHASE_DATASETS	= 0,	/* dsl_pool_sync() */
+	SPA_SYNC_PHASE_FREES	= 1,	/* frees, brt, ddt, scan, etc. */
+	SPA_SYNC_PHASE_VDEVS	= 2,	/* vdev_sync(), metaslab_sync() */
+	SPA_SYNC_PHASES
+} spa_sync_phase_t;
+
 typedef struct txg_stat {
 	vdev_stat_t		vs1;
 	vdev_stat_t		vs2;
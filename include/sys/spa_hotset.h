@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: CDDL-1.0
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at usr/src/OPENSOLARIS.LICENSE
+ * or https://opensource.org/licenses/CDDL-1.0.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at usr/src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+#ifndef _SYS_SPA_HOTSET_H
+#define	_SYS_SPA_HOTSET_H
+
+#include <sys/spa.h>
+#include <sys/avl.h>
+#include <sys/kstat.h>
+#include <sys/zio.h>
+#include <sys/zthr.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define	SPA_HOTSET_MAGIC	0x484f54534554ULL	/* ASCII: "HOTSET" */
+
+/*
+ * On-disk format of the hot set object in the MOS: a header padded to the
+ * size of an entry, followed by shp_count entries, hottest first.  Both
+ * are arrays of uint64_t as far as byteswapping is concerned.
+ */
+typedef struct spa_hotset_phys {
+	uint64_t	shp_magic;
+	uint64_t	shp_count;	/* number of entries */
+	uint64_t	shp_txg;	/* txg the set was saved in */
+	uint64_t	shp_pad[17];
+} spa_hotset_phys_t;
+
+typedef struct spa_hotset_ent_phys {
+	blkptr_t		shep_bp;
+	zbookmark_phys_t	shep_zb;
+} spa_hotset_ent_phys_t;
+
+typedef struct spa_hotset_kstat_values {
+	kstat_named_t	shkv_blocks;		/* blocks in the table */
+	kstat_named_t	shkv_dropped;		/* not recorded, table full */
+	kstat_named_t	shkv_saves;
+	kstat_named_t	shkv_saved_blocks;	/* blocks in the last save */
+	kstat_named_t	shkv_saved_txg;
+	kstat_named_t	shkv_restore_total;	/* blocks in the saved set */
+	kstat_named_t	shkv_restore_done;	/* blocks processed so far */
+	kstat_named_t	shkv_restore_bytes;	/* bytes read back */
+	kstat_named_t	shkv_restore_skipped;	/* invalid or over arc_c */
+	kstat_named_t	shkv_restore_errors;	/* failed or freed since */
+	kstat_named_t	shkv_restore_hits;	/* restored blocks read again */
+} spa_hotset_kstat_values_t;
+
+typedef struct spa_hotset {
+	kmutex_t	sh_lock;
+	avl_tree_t	sh_tree;	/* spa_hotset_ent_t, by DVA and birth */
+	uint64_t	sh_restored;	/* restored entries not yet hit */
+	boolean_t	sh_restore_pending; /* saved set not replayed yet */
+	uint64_t	sh_restore_next; /* next entry to replay */
+	hrtime_t	sh_next_save;
+	zio_cksum_t	sh_saved_cksum;	/* of the set saved last */
+	kstat_t		*sh_ksp;
+	spa_hotset_kstat_values_t sh_stats;
+} spa_hotset_t;
+
+void spa_hotset_init(spa_t *);
+void spa_hotset_fini(spa_t *);
+void spa_hotset_start(spa_t *);
+void spa_hotset_access(spa_t *, const blkptr_t *, const zbookmark_phys_t *,
+    boolean_t);
+
+boolean_t spa_hotset_thread_check(void *, zthr_t *);
+void spa_hotset_thread(void *, zthr_t *);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _SYS_SPA_HOTSET_H */
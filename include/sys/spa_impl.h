@@ -35,6 +35,7 @@
 
 #include <sys/spa.h>
 #include <sys/spa_checkpoint.h>
+#include <sys/spa_hotset.h>
 #include <sys/spa_log_spacemap.h>
 #include <sys/vdev.h>
 #include <sys/vdev_rebuild.h>
@@ -344,6 +345,7 @@ struct spa {
 	zthr_t		*spa_checkpoint_discard_zthr;
 
 	space_map_t	*spa_syncing_log_sm;	/* current log space map */
+	kmutex_t	spa_syncing_log_sm_lock; /* serializes log sm writes */
 	avl_tree_t	spa_sm_logs_by_txg;
 	kmutex_t	spa_flushed_ms_lock;	/* for metaslabs_by_flushed */
 	avl_tree_t	spa_metaslabs_by_flushed;
@@ -356,6 +358,9 @@ struct spa {
 	uint64_t	spa_livelists_to_delete; /* set of livelists to free */
 	livelist_condense_entry_t	spa_to_condense; /* next to condense */
 
+	spa_hotset_t	spa_hotset;		/* hot ARC blocks */
+	zthr_t		*spa_hotset_zthr;	/* saves and restores them */
+
 	char		*spa_root;		/* alternate root directory */
 	uint64_t	spa_ena;		/* spa-wide ereport ENA */
 	int		spa_last_open_failed;	/* error if last open failed */
@@ -430,6 +435,7 @@ struct spa {
 	taskqid_t	spa_deadman_tqid;	/* Task id */
 	uint64_t	spa_deadman_calls;	/* number of deadman calls */
 	hrtime_t	spa_sync_starttime;	/* starting time of spa_sync */
+	hrtime_t	spa_sync_phase_time[SPA_SYNC_PHASES]; /* per-phase */
 	uint64_t	spa_deadman_synctime;	/* deadman sync expiration */
 	uint64_t	spa_deadman_ziotime;	/* deadman zio expiration */
 	uint64_t	spa_all_vdev_zaps;	/* ZAP of per-vd ZAP obj #s */
@@ -463,6 +469,7 @@ struct spa {
 
 	char		*spa_compatibility;	/* compatibility file(s) */
 	uint64_t	spa_dedup_table_quota;	/* property DDT maximum size */
+	uint64_t	spa_scrub_rate;		/* property scan bytes/sec */
 	uint64_t	spa_dedup_dsize;	/* cached on-disk size of DDT */
 	uint64_t	spa_dedup_class_full_txg; /* txg dedup class was full */
 
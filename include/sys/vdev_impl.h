@@ -153,6 +153,16 @@ struct vdev_queue {
 	hrtime_t	vq_io_delta_ts;
 	zio_t		vq_io_search; /* used as local for stack reduction */
 	kmutex_t	vq_lock;
+
+	/* Deadline scheduler state, see vdev_queue.c */
+	vdev_scheduler_t vq_sched;
+	uint_t		vq_bg_pct;	/* Share of background max_active. */
+	boolean_t	vq_slo_missed;	/* Latency target missed. */
+	hrtime_t	vq_adjust_ts;	/* Last vq_bg_pct adjustment. */
+	hrtime_t	vq_lat[ZIO_PRIORITY_NUM_QUEUEABLE]; /* Avg latency. */
+	uint64_t	vq_slo_misses[ZIO_PRIORITY_NUM_QUEUEABLE];
+	uint64_t	vq_bg_decreases;
+	kstat_t		*vq_ksp;
 };
 
 typedef enum vdev_alloc_bias {
@@ -279,6 +289,7 @@ struct vdev {
 	uint64_t	vdev_noalloc;	/* device is passivated?	*/
 	uint64_t	vdev_removing;	/* device is being removed?	*/
 	uint64_t	vdev_failfast;	/* device failfast setting	*/
+	uint64_t	vdev_scrub_rate; /* scan I/O limit, bytes/sec	*/
 	boolean_t	vdev_rz_expanding; /* raidz is being expanded?	*/
 	boolean_t	vdev_ishole;	/* is a hole in the namespace	*/
 	uint64_t	vdev_top_zap;
@@ -591,6 +602,7 @@ extern boolean_t vdev_log_state_valid(vdev_t *vd);
 extern int vdev_load(vdev_t *vd);
 extern int vdev_dtl_load(vdev_t *vd);
 extern void vdev_sync(vdev_t *vd, uint64_t txg);
+extern void vdev_sync_metaslabs(vdev_t *vd, uint64_t txg);
 extern void vdev_sync_done(vdev_t *vd, uint64_t txg);
 extern void vdev_dirty(vdev_t *vd, int flags, void *arg, uint64_t txg);
 extern void vdev_dirty_leaves(vdev_t *vd, int flags, uint64_t txg);
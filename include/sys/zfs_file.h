@@ -51,6 +51,18 @@ int zfs_file_read(zfs_file_t *fp, void *buf, size_t len, ssize_t *resid);
 int zfs_file_pread(zfs_file_t *fp, void *buf, size_t len, loff_t off,
     ssize_t *resid);
 
+/*
+ * Asynchronous variants of zfs_file_pread() and zfs_file_pwrite().  They
+ * return ENOTSUP if the platform cannot issue the request asynchronously,
+ * otherwise done() is called with its error and resid once it completes.
+ */
+typedef void (zfs_file_io_done_t)(void *arg, int error, ssize_t resid);
+
+int zfs_file_pread_async(zfs_file_t *fp, void *buf, size_t len, loff_t off,
+    zfs_file_io_done_t *done, void *arg);
+int zfs_file_pwrite_async(zfs_file_t *fp, const void *buf, size_t len,
+    loff_t off, zfs_file_io_done_t *done, void *arg);
+
 int zfs_file_seek(zfs_file_t *fp, loff_t *offp, int whence);
 int zfs_file_getattr(zfs_file_t *fp, zfs_file_attr_t *zfattr);
 int zfs_file_fsync(zfs_file_t *fp, int flags);
@@ -62,4 +74,9 @@ zfs_file_t *zfs_file_get(int fd);
 void zfs_file_put(zfs_file_t *fp);
 void *zfs_file_private(zfs_file_t *fp);
 
+#ifndef _KERNEL
+void zfs_file_aio_init(void);
+void zfs_file_aio_fini(void);
+#endif
+
 #endif /* _SYS_ZFS_FILE_H */
@@ -200,6 +200,7 @@ typedef struct znode {
 	uint64_t	z_dnodesize;	/* dnode size */
 	uint64_t	z_size;		/* file size (cached) */
 	uint64_t	z_pflags;	/* pflags (cached) */
+	uint64_t	z_replay_eof;	/* new end of file - replay only */
 	uint32_t	z_sync_cnt;	/* synchronous open count */
 	uint32_t	z_sync_writes_cnt; /* synchronous write count */
 	uint32_t	z_async_writes_cnt; /* asynchronous write count */
@@ -468,6 +468,7 @@ typedef struct itx {
 	size_t		itx_size;	/* allocated itx structure size */
 	uint64_t	itx_oid;	/* object id */
 	uint64_t	itx_gen;	/* gen number for zfs_get_data */
+	uint64_t	itx_seq;	/* assignment order of the itx */
 	lr_t		itx_lr;		/* common part of log record */
 	uint8_t		itx_lr_data[];	/* type-specific part of lr_xx_t */
 } itx_t;
@@ -509,6 +510,14 @@ typedef struct zil_stats {
 	 */
 	kstat_named_t zil_itx_count;
 
+	/*
+	 * Number of transactions assigned to the in-memory intent log, and
+	 * how many of those had to wait for another thread to release the
+	 * lock of the list they were added to.
+	 */
+	kstat_named_t zil_itx_assign_count;
+	kstat_named_t zil_itx_assign_contended;
+
 	/*
 	 * See the documentation for itx_wr_state_t above.
 	 * Note that "bytes" accumulates the length of the transactions
@@ -541,6 +550,17 @@ typedef struct zil_stats {
 	kstat_named_t zil_itx_metaslab_slog_bytes;
 	kstat_named_t zil_itx_metaslab_slog_write;
 	kstat_named_t zil_itx_metaslab_slog_alloc;
+
+	/*
+	 * Log records applied by zil_replay(), how many of those were
+	 * applied concurrently by the replay threads, the bytes of log
+	 * records and write data they carried, and the total time spent
+	 * replaying.  bytes / time_ms is the replay throughput.
+	 */
+	kstat_named_t zil_replay_count;
+	kstat_named_t zil_replay_parallel_count;
+	kstat_named_t zil_replay_bytes;
+	kstat_named_t zil_replay_time_ms;
 } zil_kstat_values_t;
 
 typedef struct zil_sums {
@@ -550,6 +570,8 @@ typedef struct zil_sums {
 	wmsum_t zil_commit_stall_count;
 	wmsum_t zil_commit_suspend_count;
 	wmsum_t zil_itx_count;
+	wmsum_t zil_itx_assign_count;
+	wmsum_t zil_itx_assign_contended;
 	wmsum_t zil_itx_indirect_count;
 	wmsum_t zil_itx_indirect_bytes;
 	wmsum_t zil_itx_copied_count;
@@ -564,6 +586,10 @@ typedef struct zil_sums {
 	wmsum_t zil_itx_metaslab_slog_bytes;
 	wmsum_t zil_itx_metaslab_slog_write;
 	wmsum_t zil_itx_metaslab_slog_alloc;
+	wmsum_t zil_replay_count;
+	wmsum_t zil_replay_parallel_count;
+	wmsum_t zil_replay_bytes;
+	wmsum_t zil_replay_time_ms;
 } zil_sums_t;
 
 #define	ZIL_STAT_INCR(zil, stat, val) \
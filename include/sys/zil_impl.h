@@ -158,13 +158,22 @@ typedef struct zil_commit_waiter {
 typedef struct itxs {
 	list_t		i_sync_list;	/* list of synchronous itxs */
 	avl_tree_t	i_async_tree;	/* tree of foids for async itxs */
+	struct itxs	*i_next;	/* next itxs to free, see zil_clean() */
 } itxs_t;
 
+/*
+ * The itxs of every txg are spread over zl_itxg_sublists itxg_t, each with
+ * its own lock, and zil_itx_assign() adds an itx to the one of the CPU it
+ * runs on, so that concurrent callers seldom contend.  Every itx is
+ * numbered from zl_itx_seq while the lock is held, which keeps all lists
+ * of a sublist sorted by itx_seq; zil_async_to_sync() and
+ * zil_get_commit_list() merge the lists back into that order.
+ */
 typedef struct itxg {
 	kmutex_t	itxg_lock;	/* lock for this structure */
 	uint64_t	itxg_txg;	/* txg for this chain */
 	itxs_t		*itxg_itxs;	/* sync and async itxs */
-} itxg_t;
+} ____cacheline_aligned itxg_t;
 
 /* for async nodes we build up an AVL tree of lists of async itxs per file */
 typedef struct itx_async_node {
@@ -201,6 +210,7 @@ struct zilog {
 	uint64_t	zl_destroy_txg;	/* txg of last zil_destroy() */
 	uint64_t	zl_replayed_seq[TXG_SIZE]; /* last replayed rec seq */
 	uint64_t	zl_replaying_seq; /* current replay seq number */
+	struct zil_replay_arg *zl_replay_arg; /* parallel replay state */
 	uint32_t	zl_suspend;	/* log suspend count */
 	kcondvar_t	zl_cv_suspend;	/* log suspend completion */
 	uint8_t		zl_suspending;	/* log is currently suspending */
@@ -215,7 +225,10 @@ struct zilog {
 	uint64_t	zl_parse_lr_seq; /* highest lr seq on last parse */
 	uint64_t	zl_parse_blk_count; /* number of blocks parsed */
 	uint64_t	zl_parse_lr_count; /* number of log records parsed */
-	itxg_t		zl_itxg[TXG_SIZE]; /* intent log txg chains */
+	itxg_t		*zl_itxg[TXG_SIZE]; /* intent log txg chains */
+	uint_t		zl_itxg_sublists; /* number of itxg_t per txg */
+	uint64_t	zl_itx_seq;	/* last itx_seq assigned */
+	list_t		*zl_itx_merge;	/* per sublist zil_get_commit_list() */
 	list_t		zl_itx_commit_list; /* itx list to be committed */
 	uint64_t	zl_cur_size;	/* current burst full size */
 	uint64_t	zl_cur_left;	/* current burst remaining size */
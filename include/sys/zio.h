@@ -228,6 +228,7 @@ typedef uint64_t zio_flag_t;
 #define	ZIO_FLAG_DELEGATED	(1ULL << 31)
 #define	ZIO_FLAG_DIO_CHKSUM_ERR	(1ULL << 32)
 #define	ZIO_FLAG_PREALLOCATED	(1ULL << 33)
+#define	ZIO_FLAG_ALLOC_BATCHED	(1ULL << 34)
 
 #define	ZIO_ALLOCATOR_NONE	(-1)
 #define	ZIO_HAS_ALLOCATOR(zio)	((zio)->io_allocator != ZIO_ALLOCATOR_NONE)
@@ -365,6 +366,7 @@ typedef struct zio_prop {
 	uint8_t			zp_mac[ZIO_DATA_MAC_LEN];
 	uint32_t		zp_zpl_smallblk;
 	dmu_object_type_t	zp_storage_type;
+	struct zio_compress_auto *zp_compress_auto;
 } zio_prop_t;
 
 typedef struct zio_cksum_report zio_cksum_report_t;
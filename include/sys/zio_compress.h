@@ -116,7 +116,7 @@ enum zio_zstd_levels {
 	ZIO_ZSTD_LEVEL_FAST_500,
 	ZIO_ZSTD_LEVEL_FAST_1000,
 #define	ZIO_ZSTD_LEVEL_FAST_MAX	ZIO_ZSTD_LEVEL_FAST_1000
-	ZIO_ZSTD_LEVEL_AUTO = 251, /* Reserved for future use */
+	ZIO_ZSTD_LEVEL_AUTO = 251, /* compression=auto, never on disk */
 	ZIO_ZSTD_LEVEL_LEVELS
 };
 
@@ -181,6 +181,56 @@ extern int zio_decompress_data(enum zio_compress c, abd_t *src, abd_t *abd,
     size_t s_len, size_t d_len, uint8_t *level);
 extern int zio_compress_to_feature(enum zio_compress comp);
 
+/*
+ * Compression benchmark, see zio_compress_bench.c.
+ */
+#define	ZIO_COMPRESS_BENCH_NAMELEN	16
+
+typedef struct zio_compress_bench {
+	char		zcb_name[ZIO_COMPRESS_BENCH_NAMELEN];
+	enum zio_compress zcb_compress;
+	uint8_t		zcb_level;		/* zstd level, else unused */
+	uint32_t	zcb_bsize;		/* block size */
+	uint64_t	zcb_compress_mbs;	/* MiB/s */
+	uint64_t	zcb_decompress_mbs;	/* MiB/s */
+	uint64_t	zcb_ratio;		/* lsize / psize, * 100 */
+} zio_compress_bench_t;
+
+extern void zio_compress_bench_init(void);
+extern void zio_compress_bench_fini(void);
+extern boolean_t zio_compress_bench_match(const char *name,
+    const char *filter);
+extern uint_t zio_compress_bench_run(const char *filter);
+extern const zio_compress_bench_t *zio_compress_bench_get(uint_t i);
+
+/*
+ * Adaptive compression, see zio_compress_auto.c.
+ */
+#define	ZIO_COMPRESS_AUTO_CANDIDATES	6
+
+typedef struct zio_compress_auto zio_compress_auto_t;
+
+typedef struct zio_compress_auto_stats {
+	uint_t		zcas_current;	/* candidate currently chosen */
+	uint64_t	zcas_switches;	/* times the choice changed */
+	uint64_t	zcas_blocks[ZIO_COMPRESS_AUTO_CANDIDATES];
+	uint64_t	zcas_samples[ZIO_COMPRESS_AUTO_CANDIDATES];
+	uint64_t	zcas_ratio[ZIO_COMPRESS_AUTO_CANDIDATES]; /* * 100 */
+	uint64_t	zcas_mbps[ZIO_COMPRESS_AUTO_CANDIDATES];
+} zio_compress_auto_stats_t;
+
+extern zio_compress_auto_t *zio_compress_auto_alloc(void);
+extern void zio_compress_auto_hold(zio_compress_auto_t *zca);
+extern void zio_compress_auto_rele(zio_compress_auto_t *zca);
+extern const char *zio_compress_auto_name(uint_t i);
+extern void zio_compress_auto_select(zio_compress_auto_t *zca,
+    enum zio_compress *cp, uint8_t *levelp);
+extern void zio_compress_auto_update(zio_compress_auto_t *zca,
+    enum zio_compress c, uint8_t level, uint64_t lsize, uint64_t psize,
+    hrtime_t ns);
+extern void zio_compress_auto_stats(zio_compress_auto_t *zca,
+    zio_compress_auto_stats_t *zcas);
+
 #define	ZFS_COMPRESS_WRAP_DECL(name)					\
 size_t									\
 name(abd_t *src, abd_t *dst, size_t s_len, size_t d_len, int n)		\
@@ -2284,6 +2284,8 @@ get_numeric_property(zfs_handle_t *zhp, zfs_prop_t prop, zprop_source_t *src,
 	case ZFS_PROP_REFQUOTA:
 	case ZFS_PROP_RESERVATION:
 	case ZFS_PROP_REFRESERVATION:
+	case ZFS_PROP_ARC_QUOTA:
+	case ZFS_PROP_ARC_RESERVATION:
 	case ZFS_PROP_FILESYSTEM_LIMIT:
 	case ZFS_PROP_SNAPSHOT_LIMIT:
 	case ZFS_PROP_FILESYSTEM_COUNT:
@@ -2818,6 +2820,8 @@ zfs_prop_get(zfs_handle_t *zhp, zfs_prop_t prop, char *propbuf, size_t proplen,
 	case ZFS_PROP_REFQUOTA:
 	case ZFS_PROP_RESERVATION:
 	case ZFS_PROP_REFRESERVATION:
+	case ZFS_PROP_ARC_QUOTA:
+	case ZFS_PROP_ARC_RESERVATION:
 
 		if (get_numeric_property(zhp, prop, src, &source, &val) != 0)
 			return (-1);
@@ -2867,6 +2871,33 @@ zfs_prop_get(zfs_handle_t *zhp, zfs_prop_t prop, char *propbuf, size_t proplen,
 		zcp_check(zhp, prop, val, NULL);
 		break;
 
+	case ZFS_PROP_IOLIMIT_READ_BPS:
+	case ZFS_PROP_IOLIMIT_WRITE_BPS:
+	case ZFS_PROP_IOLIMIT_READ_IOPS:
+	case ZFS_PROP_IOLIMIT_WRITE_IOPS:
+
+		if (get_numeric_property(zhp, prop, src, &source, &val) != 0)
+			return (-1);
+
+		/*
+		 * A limit of 0 means no limit and is shown as 'none' (unless
+		 * literal is set).
+		 */
+		if (literal) {
+			(void) snprintf(propbuf, proplen, "%llu",
+			    (u_longlong_t)val);
+		} else if (val == 0) {
+			(void) strlcpy(propbuf, "none", proplen);
+		} else if (prop == ZFS_PROP_IOLIMIT_READ_BPS ||
+		    prop == ZFS_PROP_IOLIMIT_WRITE_BPS) {
+			zfs_nicebytes(val, propbuf, proplen);
+		} else {
+			zfs_nicenum(val, propbuf, proplen);
+		}
+
+		zcp_check(zhp, prop, val, NULL);
+		break;
+
 	case ZFS_PROP_REFRATIO:
 	case ZFS_PROP_COMPRESSRATIO:
 		if (get_numeric_property(zhp, prop, src, &source, &val) != 0)
@@ -387,6 +387,18 @@ zpool_get_prop(zpool_handle_t *zhp, zpool_prop_t prop, char *buf,
 				(void) zfs_nicenum(intval, buf, len);
 			break;
 
+		case ZPOOL_PROP_SCRUB_RATE:
+			if (intval == 0) {
+				(void) strlcpy(buf, literal ? "0" : "none",
+				    len);
+			} else if (literal) {
+				(void) snprintf(buf, len, "%llu",
+				    (u_longlong_t)intval);
+			} else {
+				(void) zfs_nicenum(intval, buf, len);
+			}
+			break;
+
 		case ZPOOL_PROP_EXPANDSZ:
 		case ZPOOL_PROP_CHECKPOINT:
 			if (intval == 0) {
@@ -2731,6 +2743,17 @@ out:
  */
 int
 zpool_scan(zpool_handle_t *zhp, pool_scan_func_t func, pool_scrub_cmd_t cmd)
+{
+	return (zpool_scan_txg(zhp, func, cmd, 0));
+}
+
+/*
+ * Scan the pool, limiting a scrub to blocks born after txgstart if it is
+ * not zero.
+ */
+int
+zpool_scan_txg(zpool_handle_t *zhp, pool_scan_func_t func,
+    pool_scrub_cmd_t cmd, uint64_t txgstart)
 {
 	char errbuf[ERRBUFLEN];
 	int err;
@@ -2739,13 +2762,15 @@ zpool_scan(zpool_handle_t *zhp, pool_scan_func_t func, pool_scrub_cmd_t cmd)
 	nvlist_t *args = fnvlist_alloc();
 	fnvlist_add_uint64(args, "scan_type", (uint64_t)func);
 	fnvlist_add_uint64(args, "scan_command", (uint64_t)cmd);
+	if (txgstart != 0)
+		fnvlist_add_uint64(args, "scan_txg_start", txgstart);
 
 	err = lzc_scrub(ZFS_IOC_POOL_SCRUB, zhp->zpool_name, args, NULL);
 	fnvlist_free(args);
 
 	if (err == 0) {
 		return (0);
-	} else if (err == ZFS_ERR_IOC_CMD_UNAVAIL) {
+	} else if (err == ZFS_ERR_IOC_CMD_UNAVAIL && txgstart == 0) {
 		zfs_cmd_t zc = {"\0"};
 		(void) strlcpy(zc.zc_name, zhp->zpool_name,
 		    sizeof (zc.zc_name));
@@ -2805,7 +2830,7 @@ zpool_scan(zpool_handle_t *zhp, pool_scan_func_t func, pool_scrub_cmd_t cmd)
 	}
 
 	/*
-	 * With EBUSY, six cases are possible:
+	 * With EBUSY, seven cases are possible:
 	 *
 	 * Current state		Requested
 	 * 1. Normal Scrub Running	Normal Scrub or Error Scrub
@@ -2814,6 +2839,7 @@ zpool_scan(zpool_handle_t *zhp, pool_scan_func_t func, pool_scrub_cmd_t cmd)
 	 * 4. Error Scrub Running	Normal Scrub or Error Scrub
 	 * 5. Error Scrub Paused	Pause Error Scrub
 	 * 6. Resilvering		Anything else
+	 * 7. Normal Scrub Paused	Normal Scrub from txgstart
 	 */
 	if (err == EBUSY) {
 		nvlist_t *nvroot;
@@ -2832,8 +2858,9 @@ zpool_scan(zpool_handle_t *zhp, pool_scan_func_t func, pool_scrub_cmd_t cmd)
 				return (zfs_error(hdl, EZFS_SCRUBBING,
 				    errbuf));
 			} else {
-				if (func == POOL_SCAN_ERRORSCRUB) {
-					/* handles case 2 */
+				if (func == POOL_SCAN_ERRORSCRUB ||
+				    txgstart != 0) {
+					/* handles cases 2 and 7 */
 					ASSERT3U(cmd, ==, POOL_SCRUB_NORMAL);
 					return (zfs_error(hdl,
 					    EZFS_SCRUB_PAUSED_TO_CANCEL,
@@ -5459,6 +5486,17 @@ zpool_get_vdev_prop_value(nvlist_t *nvprop, vdev_prop_t prop, char *prop_name,
 				    (u_longlong_t)intval);
 			}
 			break;
+		case VDEV_PROP_SCRUB_RATE:
+			if (intval == 0) {
+				(void) strlcpy(buf, literal ? "0" : "none",
+				    len);
+			} else if (literal) {
+				(void) snprintf(buf, len, "%llu",
+				    (u_longlong_t)intval);
+			} else {
+				(void) zfs_nicenum(intval, buf, len);
+			}
+			break;
 		case VDEV_PROP_FRAGMENTATION:
 			if (intval == UINT64_MAX) {
 				(void) strlcpy(buf, "-", len);
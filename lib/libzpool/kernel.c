@@ -834,6 +834,8 @@ kernel_init(int mode)
 
 	zstd_init();
 
+	zfs_file_aio_init();
+
 	spa_init((spa_mode_t)mode);
 
 	fletcher_4_init();
@@ -847,6 +849,8 @@ kernel_fini(void)
 	fletcher_4_fini();
 	spa_fini();
 
+	zfs_file_aio_fini();
+
 	zstd_fini();
 
 	icp_fini();
@@ -0,0 +1,387 @@
+// SPDX-License-Identifier: CDDL-1.0
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at usr/src/OPENSOLARIS.LICENSE
+ * or https://opensource.org/licenses/CDDL-1.0.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at usr/src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*
+ * Asynchronous file I/O for libzpool, used by vdev_file.c.
+ *
+ * When libzpool is built with liburing and the running kernel allows it,
+ * zfs_file_pread_async() and zfs_file_pwrite_async() queue the request on
+ * one of zfs_file_uring_count io_uring instances and return immediately.
+ * Each ring has a thread that reaps its completions and calls the done
+ * callback, so a few threads keep up to zfs_file_uring_entries requests
+ * in flight per ring instead of blocking a taskq thread on every one.
+ *
+ * Otherwise both return ENOTSUP and the caller falls back to the
+ * synchronous zfs_file_pread() and zfs_file_pwrite().
+ */
+
+#include <stdlib.h>
+#include <sys/spa.h>
+#include <sys/zfs_context.h>
+#include <sys/zfs_file.h>
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+
+/* Number of rings, and of requests each may have in flight */
+static uint_t zfs_file_uring_count = 4;
+static uint_t zfs_file_uring_entries = 256;
+
+typedef struct zfs_file_ring {
+	kmutex_t	zfr_lock;	/* serializes submission */
+	kcondvar_t	zfr_cv;		/* signaled when entries complete */
+	uint_t		zfr_inflight;	/* SQEs submitted, not yet reaped */
+	struct io_uring	zfr_ring;
+	kthread_t	*zfr_thread;
+} zfs_file_ring_t;
+
+typedef struct zfs_file_aio {
+	zfs_file_io_done_t	*zfa_done;
+	void			*zfa_arg;
+	size_t			zfa_count;
+	size_t			zfa_bytes;	/* transferred so far */
+	int			zfa_error;
+	uint_t			zfa_pending;	/* SQEs not yet completed */
+} zfs_file_aio_t;
+
+static zfs_file_ring_t *zfs_file_rings;
+static uint_t zfs_file_nrings;
+static uint_t zfs_file_ring_next;
+
+static void
+zfs_file_aio_complete(zfs_file_aio_t *zfa, int res)
+{
+	if (res < 0) {
+		/*
+		 * As in zfs_file_pread(), EINVAL most likely means an
+		 * alignment issue due to O_DIRECT, so abort() to catch
+		 * the offender.  A request linked to a failed or short
+		 * one is canceled, which only counts as a short transfer.
+		 */
+		if (res == -EINVAL)
+			abort();
+		if (res != -ECANCELED && zfa->zfa_error == 0)
+			zfa->zfa_error = -res;
+	} else {
+		zfa->zfa_bytes += res;
+	}
+
+	if (--zfa->zfa_pending > 0)
+		return;
+
+	zfa->zfa_done(zfa->zfa_arg, zfa->zfa_error,
+	    zfa->zfa_count - zfa->zfa_bytes);
+	umem_free(zfa, sizeof (zfs_file_aio_t));
+}
+
+static __attribute__((noreturn)) void
+zfs_file_ring_thread(void *arg)
+{
+	zfs_file_ring_t *zfr = arg;
+	struct io_uring_cqe *cqe;
+	boolean_t exiting = B_FALSE;
+
+	while (!exiting) {
+		unsigned head, reaped = 0;
+		int err;
+
+		err = io_uring_wait_cqe(&zfr->zfr_ring, &cqe);
+		if (err == -EINTR || err == -EAGAIN)
+			continue;
+		VERIFY0(err);
+
+		io_uring_for_each_cqe(&zfr->zfr_ring, head, cqe) {
+			zfs_file_aio_t *zfa = io_uring_cqe_get_data(cqe);
+
+			if (zfa == NULL)
+				exiting = B_TRUE;
+			else
+				zfs_file_aio_complete(zfa, cqe->res);
+			reaped++;
+		}
+		io_uring_cq_advance(&zfr->zfr_ring, reaped);
+
+		mutex_enter(&zfr->zfr_lock);
+		zfr->zfr_inflight -= reaped;
+		cv_broadcast(&zfr->zfr_cv);
+		mutex_exit(&zfr->zfr_lock);
+	}
+
+	thread_exit();
+}
+
+/*
+ * Reserve n SQEs on the ring, fill them in with prep() and submit them.
+ */
+static void
+zfs_file_ring_submit(zfs_file_ring_t *zfr, uint_t n,
+    void (*prep)(struct io_uring_sqe **, uint_t, void *), void *arg)
+{
+	struct io_uring_sqe *sqes[2];
+	int err;
+
+	ASSERT3U(n, <=, ARRAY_SIZE(sqes));
+
+	mutex_enter(&zfr->zfr_lock);
+	while (zfr->zfr_inflight + n > zfs_file_uring_entries)
+		cv_wait(&zfr->zfr_cv, &zfr->zfr_lock);
+
+	for (uint_t i = 0; i < n; i++) {
+		sqes[i] = io_uring_get_sqe(&zfr->zfr_ring);
+		VERIFY3P(sqes[i], !=, NULL);
+	}
+	prep(sqes, n, arg);
+	zfr->zfr_inflight += n;
+
+	do {
+		err = io_uring_submit(&zfr->zfr_ring);
+	} while (err == -EINTR || err == -EAGAIN);
+	VERIFY3S(err, ==, n);
+	mutex_exit(&zfr->zfr_lock);
+}
+
+static zfs_file_ring_t *
+zfs_file_ring_pick(void)
+{
+	return (&zfs_file_rings[atomic_inc_32_nv(&zfs_file_ring_next) %
+	    zfs_file_nrings]);
+}
+
+typedef struct zfs_file_aio_args {
+	zfs_file_t	*zaa_fp;
+	void		*zaa_buf;
+	size_t		zaa_count;
+	loff_t		zaa_off;
+	size_t		zaa_split;
+	zfs_file_aio_t	*zaa_zfa;
+} zfs_file_aio_args_t;
+
+static zfs_file_aio_t *
+zfs_file_aio_alloc(size_t count, uint_t pending, zfs_file_io_done_t *done,
+    void *arg)
+{
+	zfs_file_aio_t *zfa = umem_zalloc(sizeof (zfs_file_aio_t),
+	    UMEM_NOFAIL);
+
+	zfa->zfa_done = done;
+	zfa->zfa_arg = arg;
+	zfa->zfa_count = count;
+	zfa->zfa_pending = pending;
+
+	return (zfa);
+}
+
+static void
+zfs_file_prep_read(struct io_uring_sqe **sqes, uint_t n, void *arg)
+{
+	zfs_file_aio_args_t *zaa = arg;
+
+	ASSERT3U(n, ==, 1);
+	io_uring_prep_read(sqes[0], zaa->zaa_fp->f_fd, zaa->zaa_buf,
+	    zaa->zaa_count, zaa->zaa_off);
+	io_uring_sqe_set_data(sqes[0], zaa->zaa_zfa);
+}
+
+static void
+zfs_file_prep_write(struct io_uring_sqe **sqes, uint_t n, void *arg)
+{
+	zfs_file_aio_args_t *zaa = arg;
+	size_t split = zaa->zaa_split;
+
+	if (n == 1) {
+		io_uring_prep_write(sqes[0], zaa->zaa_fp->f_fd, zaa->zaa_buf,
+		    zaa->zaa_count, zaa->zaa_off);
+		io_uring_sqe_set_data(sqes[0], zaa->zaa_zfa);
+		return;
+	}
+
+	io_uring_prep_write(sqes[0], zaa->zaa_fp->f_fd, zaa->zaa_buf,
+	    split, zaa->zaa_off);
+	io_uring_sqe_set_data(sqes[0], zaa->zaa_zfa);
+	sqes[0]->flags |= IOSQE_IO_LINK;
+	io_uring_prep_write(sqes[1], zaa->zaa_fp->f_fd,
+	    (char *)zaa->zaa_buf + split, zaa->zaa_count - split,
+	    zaa->zaa_off + split);
+	io_uring_sqe_set_data(sqes[1], zaa->zaa_zfa);
+}
+
+int
+zfs_file_pread_async(zfs_file_t *fp, void *buf, size_t count, loff_t off,
+    zfs_file_io_done_t *done, void *arg)
+{
+	/* The dump file is written synchronously by zfs_file_pread() */
+	if (zfs_file_nrings == 0 || fp->f_dump_fd != -1)
+		return (SET_ERROR(ENOTSUP));
+
+	zfs_file_aio_args_t zaa = {
+		.zaa_fp = fp,
+		.zaa_buf = buf,
+		.zaa_count = count,
+		.zaa_off = off,
+		.zaa_zfa = zfs_file_aio_alloc(count, 1, done, arg),
+	};
+	zfs_file_ring_submit(zfs_file_ring_pick(), 1, zfs_file_prep_read,
+	    &zaa);
+
+	return (0);
+}
+
+int
+zfs_file_pwrite_async(zfs_file_t *fp, const void *buf, size_t count,
+    loff_t off, zfs_file_io_done_t *done, void *arg)
+{
+	if (zfs_file_nrings == 0)
+		return (SET_ERROR(ENOTSUP));
+
+	/*
+	 * Like zfs_file_pwrite(), split the write in two so that ztest can
+	 * kill the process in between and observe partial writes.  The
+	 * second half is linked to the first and only issued after it.
+	 */
+	int sectors = count >> SPA_MINBLOCKSHIFT;
+	size_t split = (sectors > 0 ? rand() % sectors : 0) <<
+	    SPA_MINBLOCKSHIFT;
+	uint_t n = (split == 0) ? 1 : 2;
+
+	zfs_file_aio_args_t zaa = {
+		.zaa_fp = fp,
+		.zaa_buf = (void *)buf,
+		.zaa_count = count,
+		.zaa_off = off,
+		.zaa_split = split,
+		.zaa_zfa = zfs_file_aio_alloc(count, n, done, arg),
+	};
+	zfs_file_ring_submit(zfs_file_ring_pick(), n, zfs_file_prep_write,
+	    &zaa);
+
+	return (0);
+}
+
+void
+zfs_file_aio_init(void)
+{
+	zfs_file_ring_t *rings;
+	uint_t n;
+
+	ASSERT0P(zfs_file_rings);
+
+	rings = umem_zalloc(zfs_file_uring_count * sizeof (zfs_file_ring_t),
+	    UMEM_NOFAIL);
+
+	/*
+	 * io_uring may be unavailable, e.g. on old kernels or when it is
+	 * disabled by sysctl or seccomp.  Use whatever rings could be set
+	 * up, and the synchronous path if there are none.
+	 */
+	for (n = 0; n < zfs_file_uring_count; n++) {
+		zfs_file_ring_t *zfr = &rings[n];
+		struct io_uring_params p = {
+			.flags = IORING_SETUP_CQSIZE,
+			.cq_entries = 2 * zfs_file_uring_entries,
+		};
+
+		if (io_uring_queue_init_params(zfs_file_uring_entries,
+		    &zfr->zfr_ring, &p) != 0)
+			break;
+
+		mutex_init(&zfr->zfr_lock, NULL, MUTEX_DEFAULT, NULL);
+		cv_init(&zfr->zfr_cv, NULL, CV_DEFAULT, NULL);
+		zfr->zfr_thread = thread_create_named("z_file_uring", NULL, 0,
+		    zfs_file_ring_thread, zfr, 0, &p0, TS_RUN | TS_JOINABLE,
+		    defclsyspri);
+	}
+
+	if (n == 0) {
+		umem_free(rings, zfs_file_uring_count *
+		    sizeof (zfs_file_ring_t));
+		return;
+	}
+
+	zfs_file_rings = rings;
+	zfs_file_nrings = n;
+}
+
+static void
+zfs_file_prep_exit(struct io_uring_sqe **sqes, uint_t n, void *arg)
+{
+	(void) arg;
+
+	ASSERT3U(n, ==, 1);
+	io_uring_prep_nop(sqes[0]);
+	io_uring_sqe_set_data(sqes[0], NULL);
+}
+
+void
+zfs_file_aio_fini(void)
+{
+	if (zfs_file_rings == NULL)
+		return;
+
+	for (uint_t i = 0; i < zfs_file_nrings; i++) {
+		zfs_file_ring_t *zfr = &zfs_file_rings[i];
+
+		zfs_file_ring_submit(zfr, 1, zfs_file_prep_exit, NULL);
+		thread_join(zfr->zfr_thread);
+		ASSERT0(zfr->zfr_inflight);
+
+		io_uring_queue_exit(&zfr->zfr_ring);
+		cv_destroy(&zfr->zfr_cv);
+		mutex_destroy(&zfr->zfr_lock);
+	}
+
+	umem_free(zfs_file_rings, zfs_file_uring_count *
+	    sizeof (zfs_file_ring_t));
+	zfs_file_rings = NULL;
+	zfs_file_nrings = 0;
+}
+
+#else	/* !HAVE_LIBURING */
+
+int
+zfs_file_pread_async(zfs_file_t *fp, void *buf, size_t count, loff_t off,
+    zfs_file_io_done_t *done, void *arg)
+{
+	(void) fp, (void) buf, (void) count, (void) off, (void) done,
+	    (void) arg;
+	return (SET_ERROR(ENOTSUP));
+}
+
+int
+zfs_file_pwrite_async(zfs_file_t *fp, const void *buf, size_t count,
+    loff_t off, zfs_file_io_done_t *done, void *arg)
+{
+	(void) fp, (void) buf, (void) count, (void) off, (void) done,
+	    (void) arg;
+	return (SET_ERROR(ENOTSUP));
+}
+
+void
+zfs_file_aio_init(void)
+{
+}
+
+void
+zfs_file_aio_fini(void)
+{
+}
+
+#endif	/* HAVE_LIBURING */
@@ -220,6 +220,28 @@ zfs_file_pread(zfs_file_t *fp, void *buf, size_t count, loff_t off,
 	return (zfs_file_read_impl(fp, buf, count, &off, resid));
 }
 
+/*
+ * Asynchronous I/O is not implemented, callers fall back to
+ * zfs_file_pread() and zfs_file_pwrite().
+ */
+int
+zfs_file_pread_async(zfs_file_t *fp, void *buf, size_t count, loff_t off,
+    zfs_file_io_done_t *done, void *arg)
+{
+	(void) fp, (void) buf, (void) count, (void) off, (void) done,
+	    (void) arg;
+	return (SET_ERROR(ENOTSUP));
+}
+
+int
+zfs_file_pwrite_async(zfs_file_t *fp, const void *buf, size_t count,
+    loff_t off, zfs_file_io_done_t *done, void *arg)
+{
+	(void) fp, (void) buf, (void) count, (void) off, (void) done,
+	    (void) arg;
+	return (SET_ERROR(ENOTSUP));
+}
+
 int
 zfs_file_seek(zfs_file_t *fp, loff_t *offp, int whence)
 {
@@ -152,6 +152,7 @@ zfs_znode_cache_constructor(void *buf, void *arg, int kmflags)
 	zp->z_vnode = NULL;
 	zp->z_sync_writes_cnt = 0;
 	zp->z_async_writes_cnt = 0;
+	zp->z_replay_eof = 0;
 
 	return (0);
 }
@@ -458,6 +459,7 @@ zfs_znode_alloc(zfsvfs_t *zfsvfs, dmu_buf_t *db, int blksz,
 	zp->z_sync_cnt = 0;
 	zp->z_sync_writes_cnt = 0;
 	zp->z_async_writes_cnt = 0;
+	zp->z_replay_eof = 0;
 	atomic_store_ptr(&zp->z_cached_symlink, NULL);
 
 	zfs_znode_sa_init(zfsvfs, zp, db, obj_type, hdl);
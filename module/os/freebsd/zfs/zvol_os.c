@@ -611,6 +611,10 @@ zvol_strategy_impl(zv_request_t *zvr)
 
 	rw_enter(&zv->zv_suspend_lock, ZVOL_RW_READER);
 
+	/* may drop and retake zv_suspend_lock, see zvol_iolimit() */
+	if (bp->bio_cmd == BIO_READ || bp->bio_cmd == BIO_WRITE)
+		zvol_iolimit(zv, bp->bio_cmd == BIO_WRITE, bp->bio_length);
+
 	if (zv->zv_flags & ZVOL_REMOVING) {
 		error = SET_ERROR(ENXIO);
 		goto resume;
@@ -825,6 +829,7 @@ zvol_cdev_read(struct cdev *dev, struct uio *uio_s, int ioflag)
 
 	rw_enter(&zv->zv_suspend_lock, ZVOL_RW_READER);
 	ssize_t start_resid = zfs_uio_resid(&uio);
+	zvol_iolimit(zv, B_FALSE, start_resid);
 	lr = zfs_rangelock_enter(&zv->zv_rangelock, zfs_uio_offset(&uio),
 	    zfs_uio_resid(&uio), RL_READER);
 	while (zfs_uio_resid(&uio) > 0 && zfs_uio_offset(&uio) < volsize) {
@@ -876,6 +881,7 @@ zvol_cdev_write(struct cdev *dev, struct uio *uio_s, int ioflag)
 	    (zv->zv_objset->os_sync == ZFS_SYNC_ALWAYS);
 
 	rw_enter(&zv->zv_suspend_lock, ZVOL_RW_READER);
+	zvol_iolimit(zv, B_TRUE, start_resid);
 	zvol_ensure_zilog(zv);
 
 	lr = zfs_rangelock_enter(&zv->zv_rangelock, zfs_uio_offset(&uio),
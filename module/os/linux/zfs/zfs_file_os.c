@@ -194,6 +194,201 @@ zfs_file_pread(zfs_file_t *fp, void *buf, size_t count, loff_t off,
 	return (0);
 }
 
+/*
+ * Asynchronous stateless read/write, used by vdev_file.c.
+ *
+ * The request is handed to ->read_iter() or ->write_iter() with an async
+ * kiocb, so a filesystem that supports it (e.g. for direct I/O) queues it
+ * and calls zfs_file_ki_complete() when it is done, possibly from
+ * interrupt context.  IOCB_NOWAIT is set, when the file supports it, so
+ * that a filesystem which would block instead returns EAGAIN, and the
+ * caller falls back to the synchronous path on its own thread; requests
+ * that complete without blocking, like cached reads and buffered writes,
+ * are finished inline.  If one stops short, the rest is transferred
+ * synchronously from system_taskq rather than blocking the submitter.
+ */
+typedef struct zfs_file_kiocb {
+	struct kiocb		zfk_iocb;
+	zfs_file_io_done_t	*zfk_done;
+	void			*zfk_arg;
+	char			*zfk_buf;
+	size_t			zfk_count;
+	ssize_t			zfk_ret;
+	boolean_t		zfk_write;
+	taskq_ent_t		zfk_ent;
+} zfs_file_kiocb_t;
+
+static void
+zfs_file_kiocb_end(zfs_file_kiocb_t *zfk)
+{
+	struct file *fp = zfk->zfk_iocb.ki_filp;
+
+	/* Like aio, take back freeze protection released on submission */
+	if (zfk->zfk_write) {
+		__sb_writers_acquired(file_inode(fp)->i_sb, SB_FREEZE_WRITE);
+		file_end_write(fp);
+	}
+}
+
+static void
+zfs_file_kiocb_done(zfs_file_kiocb_t *zfk, long ret)
+{
+	int error = 0;
+	ssize_t resid = 0;
+
+	if (ret < 0)
+		error = -ret;
+	else
+		resid = zfk->zfk_count - ret;
+
+	zfk->zfk_done(zfk->zfk_arg, error, resid);
+	kmem_free(zfk, sizeof (zfs_file_kiocb_t));
+}
+
+#ifdef HAVE_KIOCB_KI_COMPLETE_2ARGS
+static void
+zfs_file_ki_complete(struct kiocb *iocb, long ret)
+#else
+static void
+zfs_file_ki_complete(struct kiocb *iocb, long ret, long ret2)
+#endif
+{
+	zfs_file_kiocb_t *zfk = container_of(iocb, zfs_file_kiocb_t, zfk_iocb);
+
+#ifndef HAVE_KIOCB_KI_COMPLETE_2ARGS
+	(void) ret2;
+#endif
+	zfs_file_kiocb_end(zfk);
+	zfs_file_kiocb_done(zfk, ret);
+}
+
+/*
+ * Finish a request that completed short without blocking by transferring
+ * the remainder synchronously.
+ */
+static void
+zfs_file_kiocb_remainder(void *arg)
+{
+	zfs_file_kiocb_t *zfk = arg;
+	struct file *fp = zfk->zfk_iocb.ki_filp;
+	ssize_t done = zfk->zfk_ret;
+	loff_t off = zfk->zfk_iocb.ki_pos;
+	ssize_t resid;
+	int error;
+
+	if (zfk->zfk_write) {
+		error = zfs_file_pwrite(fp, zfk->zfk_buf + done,
+		    zfk->zfk_count - done, off, &resid);
+	} else {
+		error = zfs_file_pread(fp, zfk->zfk_buf + done,
+		    zfk->zfk_count - done, off, &resid);
+	}
+	if (error == 0)
+		done = zfk->zfk_count - resid;
+
+	zfs_file_kiocb_done(zfk, done);
+}
+
+static int
+zfs_file_kiocb_submit(zfs_file_t *fp, void *buf, size_t count, loff_t off,
+    boolean_t write, zfs_file_io_done_t *done, void *arg)
+{
+	zfs_file_kiocb_t *zfk;
+	struct kvec kv = { .iov_base = buf, .iov_len = count };
+	struct iov_iter iter;
+	ssize_t ret;
+	int dir = write ? WRITE : READ;
+
+	if (!S_ISREG(file_inode(fp)->i_mode) ||
+	    (write ? fp->f_op->write_iter : fp->f_op->read_iter) == NULL)
+		return (SET_ERROR(ENOTSUP));
+
+	zfk = kmem_alloc(sizeof (zfs_file_kiocb_t), KM_SLEEP);
+	zfk->zfk_done = done;
+	zfk->zfk_arg = arg;
+	zfk->zfk_buf = buf;
+	zfk->zfk_count = count;
+	zfk->zfk_write = write;
+	taskq_init_ent(&zfk->zfk_ent);
+
+	init_sync_kiocb(&zfk->zfk_iocb, fp);
+	zfk->zfk_iocb.ki_pos = off;
+	/*
+	 * Without FMODE_NOWAIT the filesystem may reject IOCB_NOWAIT or
+	 * ignore it and block; submit those requests without it only when
+	 * they are direct I/O, which is queued rather than waited on.
+	 */
+	if (fp->f_mode & FMODE_NOWAIT) {
+		zfk->zfk_iocb.ki_flags |= IOCB_NOWAIT;
+	} else if (!(zfk->zfk_iocb.ki_flags & IOCB_DIRECT)) {
+		kmem_free(zfk, sizeof (zfs_file_kiocb_t));
+		return (SET_ERROR(EAGAIN));
+	}
+	zfk->zfk_iocb.ki_complete = zfs_file_ki_complete;
+
+#ifdef HAVE_IOV_ITER_TYPE
+	iov_iter_kvec(&iter, dir, &kv, 1, count);
+#else
+	iov_iter_kvec(&iter, ITER_KVEC | dir, &kv, 1, count);
+#endif
+
+	if (write) {
+		file_start_write(fp);
+		__sb_writers_release(file_inode(fp)->i_sb, SB_FREEZE_WRITE);
+		ret = fp->f_op->write_iter(&zfk->zfk_iocb, &iter);
+	} else {
+		ret = fp->f_op->read_iter(&zfk->zfk_iocb, &iter);
+	}
+
+	/* zfs_file_ki_complete() owns zfk now */
+	if (ret == -EIOCBQUEUED)
+		return (0);
+
+	zfs_file_kiocb_end(zfk);
+
+	/*
+	 * Some filesystems refuse IOCB_NOWAIT for particular requests with
+	 * EINVAL or EOPNOTSUPP rather than EAGAIN; nothing was transferred
+	 * either way, so let the caller retry synchronously.
+	 */
+	if (ret == -EAGAIN || ret == -EINVAL || ret == -EOPNOTSUPP) {
+		kmem_free(zfk, sizeof (zfs_file_kiocb_t));
+		return (SET_ERROR(EAGAIN));
+	}
+
+	/*
+	 * Completed inline.  IOCB_NOWAIT may have stopped it short of
+	 * blocking, so transfer the rest from a taskq.  ki_pos has been
+	 * advanced past the bytes already transferred.
+	 */
+	if (ret >= 0 && ret < count) {
+		zfk->zfk_ret = ret;
+		zfk->zfk_iocb.ki_pos = off + ret;
+		taskq_dispatch_ent(system_taskq, zfs_file_kiocb_remainder,
+		    zfk, 0, &zfk->zfk_ent);
+		return (0);
+	}
+	zfs_file_kiocb_done(zfk, ret);
+
+	return (0);
+}
+
+int
+zfs_file_pread_async(zfs_file_t *fp, void *buf, size_t count, loff_t off,
+    zfs_file_io_done_t *done, void *arg)
+{
+	return (zfs_file_kiocb_submit(fp, buf, count, off, B_FALSE, done,
+	    arg));
+}
+
+int
+zfs_file_pwrite_async(zfs_file_t *fp, const void *buf, size_t count,
+    loff_t off, zfs_file_io_done_t *done, void *arg)
+{
+	return (zfs_file_kiocb_submit(fp, (void *)buf, count, off, B_TRUE,
+	    done, arg));
+}
+
 /*
  * lseek - set / get file pointer
  *
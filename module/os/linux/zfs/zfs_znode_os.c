@@ -128,6 +128,7 @@ zfs_znode_cache_constructor(void *buf, void *arg, int kmflags)
 	zp->z_xattr_parent = 0;
 	zp->z_sync_writes_cnt = 0;
 	zp->z_async_writes_cnt = 0;
+	zp->z_replay_eof = 0;
 
 	return (0);
 }
@@ -537,6 +538,7 @@ zfs_znode_alloc(zfsvfs_t *zfsvfs, dmu_buf_t *db, int blksz,
 	zp->z_sync_cnt = 0;
 	zp->z_sync_writes_cnt = 0;
 	zp->z_async_writes_cnt = 0;
+	zp->z_replay_eof = 0;
 
 	zfs_znode_sa_init(zfsvfs, zp, db, obj_type, hdl);
 
@@ -532,6 +532,17 @@ zvol_request_impl(zvol_state_t *zv, struct bio *bio, struct request *rq,
 		 */
 		rw_enter(&zv->zv_suspend_lock, RW_READER);
 
+		/*
+		 * Apply the iolimit_* properties here rather than in the
+		 * taskq worker; the zvol taskqs are shared by all zvols, so a
+		 * worker sleeping for one throttled zvol would stall I/O to
+		 * every other zvol hashed to it.  This may drop and retake
+		 * zv_suspend_lock, so it comes before the ZIL is opened.
+		 */
+		if (size > 0 && !io_is_discard(bio, rq) &&
+		    !io_is_secure_erase(bio, rq))
+			zvol_iolimit(zv, B_TRUE, size);
+
 		/*
 		 * Open a ZIL if this is the first time we have written to this
 		 * zvol. We protect zv->zv_zilog with zv_suspend_lock rather
@@ -612,7 +623,9 @@ zvol_request_impl(zvol_state_t *zv, struct bio *bio, struct request *rq,
 
 		rw_enter(&zv->zv_suspend_lock, RW_READER);
 
-		/* See comment in WRITE case above. */
+		/* See comments in WRITE case above. */
+		zvol_iolimit(zv, B_FALSE, size);
+
 		if (force_sync) {
 			zvol_read(&zvr);
 		} else {
@@ -213,6 +213,12 @@ zfs_prop_init(void)
 		    ZIO_COMPLEVEL_ZSTD(ZIO_ZSTD_LEVEL_FAST_500) },
 		{ "zstd-fast-1000",
 		    ZIO_COMPLEVEL_ZSTD(ZIO_ZSTD_LEVEL_FAST_1000) },
+
+		/*
+		 * Adaptive compression is stored as a reserved ZSTD level, the
+		 * algorithm and level are picked per block at write time.
+		 */
+		{ "auto",	ZIO_COMPLEVEL_ZSTD(ZIO_ZSTD_LEVEL_AUTO) },
 		{ NULL }
 	};
 
@@ -433,7 +439,7 @@ zfs_prop_init(void)
 	    ZIO_COMPRESS_DEFAULT, PROP_INHERIT,
 	    ZFS_TYPE_FILESYSTEM | ZFS_TYPE_VOLUME,
 	    "on | off | lzjb | gzip | gzip-[1-9] | zle | lz4 | "
-	    "zstd | zstd-[1-19] | "
+	    "zstd | zstd-[1-19] | auto | "
 	    "zstd-fast | zstd-fast-[1-10,20,30,40,50,60,70,80,90,100,500,1000]",
 	    "COMPRESS", compress_table, sfeatures);
 	zprop_register_index(ZFS_PROP_SNAPDIR, "snapdir", ZFS_SNAPDIR_HIDDEN,
@@ -702,6 +708,12 @@ zfs_prop_init(void)
 	zprop_register_number(ZFS_PROP_REFRESERVATION, "refreservation", 0,
 	    PROP_DEFAULT, ZFS_TYPE_FILESYSTEM | ZFS_TYPE_VOLUME,
 	    "<size> | none", "REFRESERV", B_FALSE, sfeatures);
+	zprop_register_number(ZFS_PROP_ARC_QUOTA, "arc_quota", 0,
+	    PROP_DEFAULT, ZFS_TYPE_FILESYSTEM | ZFS_TYPE_VOLUME,
+	    "<size> | none", "ARCQUOTA", B_FALSE, sfeatures);
+	zprop_register_number(ZFS_PROP_ARC_RESERVATION, "arc_reservation", 0,
+	    PROP_DEFAULT, ZFS_TYPE_FILESYSTEM | ZFS_TYPE_VOLUME,
+	    "<size> | none", "ARCRESERV", B_FALSE, sfeatures);
 	zprop_register_number(ZFS_PROP_FILESYSTEM_LIMIT, "filesystem_limit",
 	    UINT64_MAX, PROP_DEFAULT, ZFS_TYPE_FILESYSTEM,
 	    "<count> | none", "FSLIMIT", B_FALSE, sfeatures);
@@ -741,6 +753,21 @@ zfs_prop_init(void)
 	    ZFS_TYPE_FILESYSTEM | ZFS_TYPE_VOLUME,
 	    "zero or 512 to 1M, power of 2", "SPECIAL_SMALL_BLOCKS", B_FALSE,
 	    sfeatures);
+	zprop_register_number(ZFS_PROP_IOLIMIT_READ_BPS, "iolimit_read_bps", 0,
+	    PROP_INHERIT, ZFS_TYPE_FILESYSTEM | ZFS_TYPE_VOLUME,
+	    "<bytes per second> | none", "RBPSLIMIT", B_FALSE, sfeatures);
+	zprop_register_number(ZFS_PROP_IOLIMIT_WRITE_BPS, "iolimit_write_bps",
+	    0, PROP_INHERIT, ZFS_TYPE_FILESYSTEM | ZFS_TYPE_VOLUME,
+	    "<bytes per second> | none", "WBPSLIMIT", B_FALSE, sfeatures);
+	zprop_register_number(ZFS_PROP_IOLIMIT_READ_IOPS, "iolimit_read_iops",
+	    0, PROP_INHERIT, ZFS_TYPE_FILESYSTEM | ZFS_TYPE_VOLUME,
+	    "<operations per second> | none", "RIOPSLIMIT", B_FALSE,
+	    sfeatures);
+	zprop_register_number(ZFS_PROP_IOLIMIT_WRITE_IOPS,
+	    "iolimit_write_iops", 0, PROP_INHERIT,
+	    ZFS_TYPE_FILESYSTEM | ZFS_TYPE_VOLUME,
+	    "<operations per second> | none", "WIOPSLIMIT", B_FALSE,
+	    sfeatures);
 
 	/* hidden properties */
 	zprop_register_hidden(ZFS_PROP_NUMCLONES, "numclones", PROP_TYPE_NUMBER,
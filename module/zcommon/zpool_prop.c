@@ -143,6 +143,9 @@ zpool_prop_init(void)
 	zprop_register_number(ZPOOL_PROP_DEDUP_TABLE_QUOTA, "dedup_table_quota",
 	    UINT64_MAX, PROP_DEFAULT, ZFS_TYPE_POOL, "<size>", "DDTQUOTA",
 	    B_FALSE, sfeatures);
+	zprop_register_number(ZPOOL_PROP_SCRUB_RATE, "scrub_rate", 0,
+	    PROP_DEFAULT, ZFS_TYPE_POOL, "<bytes/sec> | none", "SCRUBRATE",
+	    B_FALSE, sfeatures);
 
 	/* default index (boolean) properties */
 	zprop_register_index(ZPOOL_PROP_DELEGATION, "delegation", 1,
@@ -325,6 +328,11 @@ vdev_prop_init(void)
 		{ "-",		2},	/* ZPROP_BOOLEAN_NA */
 		{ NULL }
 	};
+	static const zprop_index_t scheduler_table[] = {
+		{ "classic",	VDEV_SCHEDULER_CLASSIC },
+		{ "deadline",	VDEV_SCHEDULER_DEADLINE },
+		{ NULL }
+	};
 
 	struct zfs_mod_supported_features *sfeatures =
 	    zfs_mod_list_supported(ZFS_SYSFS_VDEV_PROPERTIES);
@@ -456,6 +464,9 @@ vdev_prop_init(void)
 	zprop_register_number(VDEV_PROP_SLOW_IO_T, "slow_io_t", UINT64_MAX,
 	    PROP_DEFAULT, ZFS_TYPE_VDEV, "<seconds>", "SLOW_IO_T", B_FALSE,
 	    sfeatures);
+	zprop_register_number(VDEV_PROP_SCRUB_RATE, "scrub_rate", 0,
+	    PROP_DEFAULT, ZFS_TYPE_VDEV, "<bytes/sec> | none", "SCRUBRATE",
+	    B_FALSE, sfeatures);
 
 	/* default index (boolean) properties */
 	zprop_register_index(VDEV_PROP_REMOVING, "removing", 0,
@@ -475,6 +486,9 @@ vdev_prop_init(void)
 	zprop_register_index(VDEV_PROP_FAILFAST, "failfast", B_TRUE,
 	    PROP_DEFAULT, ZFS_TYPE_VDEV, "on | off", "FAILFAST", boolean_table,
 	    sfeatures);
+	zprop_register_index(VDEV_PROP_SCHEDULER, "scheduler",
+	    VDEV_SCHEDULER_CLASSIC, PROP_DEFAULT, ZFS_TYPE_VDEV,
+	    "classic | deadline", "SCHEDULER", scheduler_table, sfeatures);
 
 	/* hidden properties */
 	zprop_register_hidden(VDEV_PROP_NAME, "name", PROP_TYPE_STRING,
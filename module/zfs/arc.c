@@ -89,7 +89,7 @@
  * or 2) via one of the ARC lists.  The arc_read() interface
  * uses method 1, while the internal ARC algorithms for
  * adjusting the cache use method 2.  We therefore provide two
- * types of locks: 1) the hash table lock array, and 2) the
+ * types of locks: 1) the hash table lock stripes, and 2) the
  * ARC list locks.
  *
  * Buffers do not have their own mutexes, rather they rely on the
@@ -103,6 +103,10 @@
  * buf_hash_remove() expects the appropriate hash mutex to be
  * already held before it is invoked.
  *
+ * The hash table may be resized online (see buf_hash_resize()), but a
+ * header always maps to the same hash mutex, so a mutex returned by
+ * HDR_LOCK() remains valid across a resize.
+ *
  * Each ARC state also has a mutex which is used to protect the
  * buffer list associated with the state.  When attempting to
  * obtain a hash table lock while holding an ARC list lock you
@@ -287,6 +291,7 @@
 #include <sys/spa.h>
 #include <sys/zio.h>
 #include <sys/spa_impl.h>
+#include <sys/spa_hotset.h>
 #include <sys/zio_compress.h>
 #include <sys/zio_checksum.h>
 #include <sys/zfs_context.h>
@@ -333,6 +338,12 @@ static zthr_t *arc_evict_zthr;
 static arc_buf_hdr_t **arc_state_evict_markers;
 static int arc_state_evict_marker_count;
 
+/*
+ * This thread's job is to keep the hash table load factor in bounds, by
+ * calling buf_hash_resize() as the number of headers grows and shrinks.
+ */
+static zthr_t *arc_hash_zthr;
+
 static kmutex_t arc_evict_lock;
 static boolean_t arc_evict_needed = B_FALSE;
 static clock_t arc_last_uncached_flush;
@@ -371,6 +382,13 @@ static uint_t zfs_arc_eviction_pct = 200;
  */
 static uint_t zfs_arc_evict_batch_limit = 10;
 
+/*
+ * The number of headers arc_dataset_evict_quota() looks at per sublist
+ * before moving to the next one, so that a dataset with few cached blocks
+ * does not cost a walk of the whole MRU and MFU.
+ */
+static uint_t zfs_arc_dataset_scan_limit = 1024;
+
 /* number of seconds before growing cache again */
 uint_t arc_grow_retry = 5;
 
@@ -390,6 +408,9 @@ uint_t arc_shrink_shift = 7;
 uint_t zfs_arc_pc_percent = 0;
 #endif
 
+/* Filter data blocks entering a full ARC by frequency, see arc_admit() */
+static int zfs_arc_admit = 0;
+
 /*
  * log2(fraction of ARC which must be free to allow growing).
  * I.e. If there is less than arc_c >> arc_no_grow_shift free memory,
@@ -430,6 +451,12 @@ static uint_t zfs_arc_grow_retry = 0;
 static uint_t zfs_arc_shrink_shift = 0;
 uint_t zfs_arc_average_blocksize = 8 * 1024; /* 8KB */
 
+/*
+ * Average number of headers per hash bucket above which the ARC hash
+ * table is grown online.  Zero disables online resizing.
+ */
+static uint_t zfs_arc_hash_max_load = 2;
+
 /*
  * ARC dirty data constraints for arc_tempreserve_space() throttle:
  * * total dirty data limit
@@ -515,6 +542,10 @@ arc_stats_t arc_stats = {
 	{ "mfu_hits",			KSTAT_DATA_UINT64 },
 	{ "mfu_ghost_hits",		KSTAT_DATA_UINT64 },
 	{ "uncached_hits",		KSTAT_DATA_UINT64 },
+	{ "admit_accepted",		KSTAT_DATA_UINT64 },
+	{ "admit_rejected",		KSTAT_DATA_UINT64 },
+	{ "admit_accepted_hits",	KSTAT_DATA_UINT64 },
+	{ "admit_rejected_hits",	KSTAT_DATA_UINT64 },
 	{ "deleted",			KSTAT_DATA_UINT64 },
 	{ "mutex_miss",			KSTAT_DATA_UINT64 },
 	{ "access_skip",		KSTAT_DATA_UINT64 },
@@ -531,6 +562,10 @@ arc_stats_t arc_stats = {
 	{ "hash_collisions",		KSTAT_DATA_UINT64 },
 	{ "hash_chains",		KSTAT_DATA_UINT64 },
 	{ "hash_chain_max",		KSTAT_DATA_UINT64 },
+	{ "hash_buckets",		KSTAT_DATA_UINT64 },
+	{ "hash_locks",			KSTAT_DATA_UINT64 },
+	{ "hash_resizes",		KSTAT_DATA_UINT64 },
+	{ "hash_lock_contended",	KSTAT_DATA_UINT64 },
 	{ "meta",			KSTAT_DATA_UINT64 },
 	{ "pd",				KSTAT_DATA_UINT64 },
 	{ "pm",				KSTAT_DATA_UINT64 },
@@ -542,6 +577,7 @@ arc_stats_t arc_stats = {
 	{ "uncompressed_size",		KSTAT_DATA_UINT64 },
 	{ "overhead_size",		KSTAT_DATA_UINT64 },
 	{ "hdr_size",			KSTAT_DATA_UINT64 },
+	{ "hdr_overhead",		KSTAT_DATA_UINT64 },
 	{ "data_size",			KSTAT_DATA_UINT64 },
 	{ "metadata_size",		KSTAT_DATA_UINT64 },
 	{ "dbuf_size",			KSTAT_DATA_UINT64 },
@@ -605,6 +641,7 @@ arc_stats_t arc_stats = {
 	{ "l2_size",			KSTAT_DATA_UINT64 },
 	{ "l2_asize",			KSTAT_DATA_UINT64 },
 	{ "l2_hdr_size",		KSTAT_DATA_UINT64 },
+	{ "l2_hdr_overhead",		KSTAT_DATA_UINT64 },
 	{ "l2_log_blk_writes",		KSTAT_DATA_UINT64 },
 	{ "l2_log_blk_avg_asize",	KSTAT_DATA_UINT64 },
 	{ "l2_log_blk_asize",		KSTAT_DATA_UINT64 },
@@ -711,6 +748,15 @@ static kstat_t			*arc_ksp;
 hrtime_t arc_growtime;
 list_t arc_prune_list;
 kmutex_t arc_prune_mtx;
+
+/* Per dataset accounting, see arc_dataset_get() */
+static avl_tree_t arc_dataset_tree;
+static krwlock_t arc_dataset_lock;
+static uint64_t arc_dataset_reserved;	/* sum of all arc_reservations */
+static uint64_t arc_dataset_limited;	/* datasets with quota or reservation */
+static boolean_t arc_dataset_over_quota;	/* for arc_evict_cb_check() */
+/* persistent MRU and MFU markers of arc_dataset_evict_quota() */
+static arc_buf_hdr_t **arc_dataset_markers[2][ARC_BUFC_NUMTYPES];
 taskq_t *arc_prune_taskq;
 
 #define	GHOST_STATE(state)	\
@@ -774,22 +820,49 @@ taskq_t *arc_prune_taskq;
 
 /*
  * Hash table routines
+ *
+ * The hash table is an array of buckets protected by a separate array of
+ * lock stripes.  A header with hash value hv lives in bucket (hv & mask)
+ * and is protected by stripe (hv & (ht_nlocks - 1)).  The table never has
+ * fewer buckets than there are stripes, so every bucket belongs to exactly
+ * one stripe no matter how large the table currently is.
+ *
+ * This allows the table to be resized online by buf_hash_resize().  A new
+ * bucket array is allocated next to the current one and the chains are
+ * migrated one stripe at a time, holding only that stripe's lock.  Each
+ * stripe records which of the two arrays its buckets currently live in,
+ * so lookups never need anything beyond the stripe lock they already take.
+ *
+ * The number of stripes is fixed at load time, since HDR_LOCK() must stay
+ * stable while a hash lock is held, and is scaled with the number of CPUs
+ * and the initial size of the table.
  */
 
-#define	BUF_LOCKS 2048
+#define	BUF_LOCKS_MIN		2048
+#define	BUF_LOCKS_MAX		65536
+#define	BUF_LOCKS_PER_CPU	256
+
+typedef struct buf_hash_lock {
+	kmutex_t	hl_lock;
+	uint_t		hl_table;	/* index of the bucket array in use */
+} ____cacheline_aligned buf_hash_lock_t;
+
 typedef struct buf_hash_table {
-	uint64_t ht_mask;
-	arc_buf_hdr_t **ht_table;
-	kmutex_t ht_locks[BUF_LOCKS] ____cacheline_aligned;
+	uint64_t ht_mask[2];
+	arc_buf_hdr_t **ht_table[2];
+	uint_t ht_cur;		/* bucket array all stripes use when idle */
+	uint64_t ht_min_size;	/* never shrink below the initial size */
+	uint64_t ht_nlocks;
+	buf_hash_lock_t *ht_locks;
 } buf_hash_table_t;
 
 static buf_hash_table_t buf_hash_table;
 
-#define	BUF_HASH_INDEX(spa, dva, birth) \
-	(buf_hash(spa, dva, birth) & buf_hash_table.ht_mask)
-#define	BUF_HASH_LOCK(idx)	(&buf_hash_table.ht_locks[idx & (BUF_LOCKS-1)])
-#define	HDR_LOCK(hdr) \
-	(BUF_HASH_LOCK(BUF_HASH_INDEX(hdr->b_spa, &hdr->b_dva, hdr->b_birth)))
+#define	BUF_HASH_STRIPE(hv) \
+	(&buf_hash_table.ht_locks[(hv) & (buf_hash_table.ht_nlocks - 1)])
+#define	BUF_HASH_LOCK(hv)	(&BUF_HASH_STRIPE(hv)->hl_lock)
+#define	HDR_HASH(hdr)	buf_hash((hdr)->b_spa, &(hdr)->b_dva, (hdr)->b_birth)
+#define	HDR_LOCK(hdr)	BUF_HASH_LOCK(HDR_HASH(hdr))
 
 uint64_t zfs_crc64_table[256];
 
@@ -842,6 +915,7 @@ int l2arc_noprefetch = B_TRUE;			/* don't cache prefetch bufs */
 int l2arc_feed_again = B_TRUE;			/* turbo warmup */
 int l2arc_norw = B_FALSE;			/* no reads during writes */
 static uint_t l2arc_meta_percent = 33;	/* limit on headers size */
+static uint_t l2arc_feed_threads = 8;	/* max devices fed in parallel */
 
 /*
  * L2ARC Internals
@@ -849,12 +923,27 @@ static uint_t l2arc_meta_percent = 33;	/* limit on headers size */
 static list_t L2ARC_dev_list;			/* device list */
 static list_t *l2arc_dev_list;			/* device list pointer */
 static kmutex_t l2arc_dev_mtx;			/* device list mutex */
-static l2arc_dev_t *l2arc_dev_last;		/* last device used */
 static list_t L2ARC_free_on_write;		/* free after write buf list */
 static list_t *l2arc_free_on_write;		/* free after write list ptr */
 static kmutex_t l2arc_free_on_write_mtx;	/* mutex for list */
 static uint64_t l2arc_ndev;			/* number of devices */
 
+/*
+ * Devices by l2ad_id, as referenced by L2ARC headers.  Ids are assigned
+ * under l2arc_dev_mtx and released once the last header of a device is
+ * gone, so a header's entry can be read without the lock.
+ */
+static l2arc_dev_t *l2arc_dev_ids[L2ARC_DEV_ID_MAX + 1];
+
+static inline l2arc_dev_t *
+l2arc_hdr_dev(const arc_buf_hdr_t *hdr)
+{
+	l2arc_dev_t *dev = l2arc_dev_ids[L2HDR_GET_DEV_ID(&hdr->b_l2hdr)];
+
+	ASSERT3P(dev, !=, NULL);
+	return (dev);
+}
+
 typedef struct l2arc_read_callback {
 	arc_buf_hdr_t		*l2rcb_hdr;		/* read header */
 	blkptr_t		l2rcb_bp;		/* original blkptr */
@@ -888,6 +977,7 @@ typedef enum arc_ovf_level {
 static kmutex_t l2arc_feed_thr_lock;
 static kcondvar_t l2arc_feed_thr_cv;
 static uint8_t l2arc_thread_exit;
+static taskq_t *l2arc_feed_taskq;
 
 static kmutex_t l2arc_rebuild_thr_lock;
 static kcondvar_t l2arc_rebuild_thr_cv;
@@ -925,6 +1015,7 @@ static void l2arc_hdr_arcstats_update(arc_buf_hdr_t *hdr, boolean_t incr,
     boolean_t state_only);
 
 static void arc_prune_async(uint64_t adjust);
+static void arc_admit_age(void);
 
 #define	l2arc_hdr_arcstats_increment(hdr) \
 	l2arc_hdr_arcstats_update((hdr), B_TRUE, B_FALSE)
@@ -1048,17 +1139,40 @@ buf_discard_identity(arc_buf_hdr_t *hdr)
 	hdr->b_birth = 0;
 }
 
+/*
+ * Return the bucket for hash value hv.  The caller must hold the stripe
+ * lock for hv, which keeps the stripe from being migrated underneath it.
+ */
+static inline arc_buf_hdr_t **
+buf_hash_bucket(uint64_t hv)
+{
+	buf_hash_lock_t *hl = BUF_HASH_STRIPE(hv);
+	uint_t t = hl->hl_table;
+
+	ASSERT(MUTEX_HELD(&hl->hl_lock));
+	return (&buf_hash_table.ht_table[t][hv & buf_hash_table.ht_mask[t]]);
+}
+
+static inline void
+buf_hash_lock_enter(kmutex_t *hash_lock)
+{
+	if (!mutex_tryenter(hash_lock)) {
+		ARCSTAT_BUMP(arcstat_hash_lock_contended);
+		mutex_enter(hash_lock);
+	}
+}
+
 static arc_buf_hdr_t *
 buf_hash_find(uint64_t spa, const blkptr_t *bp, kmutex_t **lockp)
 {
 	const dva_t *dva = BP_IDENTITY(bp);
 	uint64_t birth = BP_GET_BIRTH(bp);
-	uint64_t idx = BUF_HASH_INDEX(spa, dva, birth);
-	kmutex_t *hash_lock = BUF_HASH_LOCK(idx);
+	uint64_t hv = buf_hash(spa, dva, birth);
+	kmutex_t *hash_lock = BUF_HASH_LOCK(hv);
 	arc_buf_hdr_t *hdr;
 
-	mutex_enter(hash_lock);
-	for (hdr = buf_hash_table.ht_table[idx]; hdr != NULL;
+	buf_hash_lock_enter(hash_lock);
+	for (hdr = *buf_hash_bucket(hv); hdr != NULL;
 	    hdr = hdr->b_hash_next) {
 		if (HDR_EQUAL(spa, dva, birth, hdr)) {
 			*lockp = hash_lock;
@@ -1080,9 +1194,9 @@ buf_hash_find(uint64_t spa, const blkptr_t *bp, kmutex_t **lockp)
 static arc_buf_hdr_t *
 buf_hash_insert(arc_buf_hdr_t *hdr, kmutex_t **lockp)
 {
-	uint64_t idx = BUF_HASH_INDEX(hdr->b_spa, &hdr->b_dva, hdr->b_birth);
-	kmutex_t *hash_lock = BUF_HASH_LOCK(idx);
-	arc_buf_hdr_t *fhdr;
+	uint64_t hv = HDR_HASH(hdr);
+	kmutex_t *hash_lock = BUF_HASH_LOCK(hv);
+	arc_buf_hdr_t *fhdr, **bucket;
 	uint32_t i;
 
 	ASSERT(!DVA_IS_EMPTY(&hdr->b_dva));
@@ -1091,19 +1205,20 @@ buf_hash_insert(arc_buf_hdr_t *hdr, kmutex_t **lockp)
 
 	if (lockp != NULL) {
 		*lockp = hash_lock;
-		mutex_enter(hash_lock);
+		buf_hash_lock_enter(hash_lock);
 	} else {
 		ASSERT(MUTEX_HELD(hash_lock));
 	}
 
-	for (fhdr = buf_hash_table.ht_table[idx], i = 0; fhdr != NULL;
+	bucket = buf_hash_bucket(hv);
+	for (fhdr = *bucket, i = 0; fhdr != NULL;
 	    fhdr = fhdr->b_hash_next, i++) {
 		if (HDR_EQUAL(hdr->b_spa, &hdr->b_dva, hdr->b_birth, fhdr))
 			return (fhdr);
 	}
 
-	hdr->b_hash_next = buf_hash_table.ht_table[idx];
-	buf_hash_table.ht_table[idx] = hdr;
+	hdr->b_hash_next = *bucket;
+	*bucket = hdr;
 	arc_hdr_set_flags(hdr, ARC_FLAG_IN_HASH_TABLE);
 
 	/* collect some hash table performance data */
@@ -1121,13 +1236,13 @@ buf_hash_insert(arc_buf_hdr_t *hdr, kmutex_t **lockp)
 static void
 buf_hash_remove(arc_buf_hdr_t *hdr)
 {
-	arc_buf_hdr_t *fhdr, **hdrp;
-	uint64_t idx = BUF_HASH_INDEX(hdr->b_spa, &hdr->b_dva, hdr->b_birth);
+	arc_buf_hdr_t *fhdr, **hdrp, **bucket;
+	uint64_t hv = HDR_HASH(hdr);
 
-	ASSERT(MUTEX_HELD(BUF_HASH_LOCK(idx)));
+	ASSERT(MUTEX_HELD(BUF_HASH_LOCK(hv)));
 	ASSERT(HDR_IN_HASH_TABLE(hdr));
 
-	hdrp = &buf_hash_table.ht_table[idx];
+	bucket = hdrp = buf_hash_bucket(hv);
 	while ((fhdr = *hdrp) != hdr) {
 		ASSERT3P(fhdr, !=, NULL);
 		hdrp = &fhdr->b_hash_next;
@@ -1138,11 +1253,153 @@ buf_hash_remove(arc_buf_hdr_t *hdr)
 
 	/* collect some hash table performance data */
 	ARCSTAT_BUMPDOWN(arcstat_hash_elements);
-	if (buf_hash_table.ht_table[idx] &&
-	    buf_hash_table.ht_table[idx]->b_hash_next == NULL)
+	if (*bucket && (*bucket)->b_hash_next == NULL)
 		ARCSTAT_BUMPDOWN(arcstat_hash_chains);
 }
 
+static arc_buf_hdr_t **
+buf_hash_table_alloc(uint64_t size, int kmflag)
+{
+#if defined(_KERNEL)
+	/*
+	 * Large allocations which do not require contiguous pages
+	 * should be using vmem_alloc() in the linux kernel
+	 */
+	return (vmem_zalloc(size * sizeof (void *), kmflag));
+#else
+	return (kmem_zalloc(size * sizeof (void *), kmflag));
+#endif
+}
+
+static void
+buf_hash_table_free(arc_buf_hdr_t **table, uint64_t size)
+{
+#if defined(_KERNEL)
+	vmem_free(table, size * sizeof (void *));
+#else
+	kmem_free(table, size * sizeof (void *));
+#endif
+}
+
+/*
+ * Move every header from the current bucket array into a newly allocated
+ * one with nsize buckets.  Only one stripe is locked at a time, so lookups
+ * and inserts in other stripes proceed normally while the table is being
+ * resized.  Returns B_FALSE if the new bucket array could not be allocated.
+ */
+static boolean_t
+buf_hash_resize(uint64_t nsize)
+{
+	buf_hash_table_t *ht = &buf_hash_table;
+	uint_t from = ht->ht_cur, to = !from;
+	uint64_t omask = ht->ht_mask[from], nmask = nsize - 1;
+	arc_buf_hdr_t **otable = ht->ht_table[from], **ntable;
+
+	ASSERT(ISP2(nsize));
+	ASSERT3U(nsize, >=, ht->ht_nlocks);
+	ASSERT3P(ht->ht_table[to], ==, NULL);
+
+	ntable = buf_hash_table_alloc(nsize, KM_NOSLEEP);
+	if (ntable == NULL)
+		return (B_FALSE);
+	ht->ht_table[to] = ntable;
+	ht->ht_mask[to] = nmask;
+
+	for (uint64_t l = 0; l < ht->ht_nlocks; l++) {
+		buf_hash_lock_t *hl = &ht->ht_locks[l];
+		int64_t chains = 0;
+
+		mutex_enter(&hl->hl_lock);
+		ASSERT3U(hl->hl_table, ==, from);
+		for (uint64_t i = l; i <= omask; i += ht->ht_nlocks) {
+			arc_buf_hdr_t *hdr, *next;
+
+			if (otable[i] != NULL && otable[i]->b_hash_next != NULL)
+				chains--;
+			for (hdr = otable[i]; hdr != NULL; hdr = next) {
+				uint64_t j = HDR_HASH(hdr) & nmask;
+
+				next = hdr->b_hash_next;
+				if (ntable[j] != NULL &&
+				    ntable[j]->b_hash_next == NULL)
+					chains++;
+				hdr->b_hash_next = ntable[j];
+				ntable[j] = hdr;
+			}
+			otable[i] = NULL;
+		}
+		hl->hl_table = to;
+		mutex_exit(&hl->hl_lock);
+
+		if (chains != 0)
+			ARCSTAT_INCR(arcstat_hash_chains, chains);
+		if ((l & 0xff) == 0xff)
+			kpreempt(KPREEMPT_SYNC);
+	}
+
+	/*
+	 * Every stripe now points at the new array, and each was locked
+	 * after any thread still walking the old one had dropped it.
+	 */
+	ht->ht_cur = to;
+	ht->ht_table[from] = NULL;
+	buf_hash_table_free(otable, omask + 1);
+
+	ARCSTAT(arcstat_hash_buckets) = nsize;
+	ARCSTAT(arcstat_hash_resizes)++;
+	return (B_TRUE);
+}
+
+/*
+ * Return the number of buckets the hash table should have for the current
+ * number of elements.  The table is grown to a load factor of at most one
+ * when it exceeds zfs_arc_hash_max_load, and is shrunk back towards its
+ * initial size once the load falls below one eighth.
+ */
+static uint64_t
+buf_hash_target_size(void)
+{
+	buf_hash_table_t *ht = &buf_hash_table;
+	uint64_t size = ht->ht_mask[ht->ht_cur] + 1;
+	uint64_t elements = wmsum_value(&arc_sums.arcstat_hash_elements);
+	uint64_t nsize = size;
+
+	if (zfs_arc_hash_max_load == 0)
+		return (size);
+
+	if (elements > size * zfs_arc_hash_max_load) {
+		while (nsize < elements)
+			nsize <<= 1;
+	} else if (elements < size / 8 && size > ht->ht_min_size) {
+		while (nsize / 2 > 2 * elements && nsize > ht->ht_min_size)
+			nsize >>= 1;
+	}
+	return (nsize);
+}
+
+static boolean_t
+arc_hash_resize_cb_check(void *arg, zthr_t *zthr)
+{
+	(void) arg, (void) zthr;
+	buf_hash_table_t *ht = &buf_hash_table;
+
+	return (buf_hash_target_size() != ht->ht_mask[ht->ht_cur] + 1);
+}
+
+static void
+arc_hash_resize_cb(void *arg, zthr_t *zthr)
+{
+	(void) arg, (void) zthr;
+	buf_hash_table_t *ht = &buf_hash_table;
+	uint64_t nsize = buf_hash_target_size();
+
+	if (nsize != ht->ht_mask[ht->ht_cur] + 1) {
+		fstrans_cookie_t cookie = spl_fstrans_mark();
+		(void) buf_hash_resize(nsize);
+		spl_fstrans_unmark(cookie);
+	}
+}
+
 /*
  * Global data structures and functions for the buf kmem cache.
  */
@@ -1154,19 +1411,13 @@ static kmem_cache_t *buf_cache;
 static void
 buf_fini(void)
 {
-#if defined(_KERNEL)
-	/*
-	 * Large allocations which do not require contiguous pages
-	 * should be using vmem_free() in the linux kernel\
-	 */
-	vmem_free(buf_hash_table.ht_table,
-	    (buf_hash_table.ht_mask + 1) * sizeof (void *));
-#else
-	kmem_free(buf_hash_table.ht_table,
-	    (buf_hash_table.ht_mask + 1) * sizeof (void *));
-#endif
-	for (int i = 0; i < BUF_LOCKS; i++)
-		mutex_destroy(BUF_HASH_LOCK(i));
+	buf_hash_table_t *ht = &buf_hash_table;
+
+	buf_hash_table_free(ht->ht_table[ht->ht_cur],
+	    ht->ht_mask[ht->ht_cur] + 1);
+	for (uint64_t i = 0; i < ht->ht_nlocks; i++)
+		mutex_destroy(&ht->ht_locks[i].hl_lock);
+	vmem_free(ht->ht_locks, ht->ht_nlocks * sizeof (buf_hash_lock_t));
 	kmem_cache_destroy(hdr_full_cache);
 	kmem_cache_destroy(hdr_l2only_cache);
 	kmem_cache_destroy(buf_cache);
@@ -1260,8 +1511,10 @@ buf_dest(void *vbuf, void *unused)
 static void
 buf_init(void)
 {
+	buf_hash_table_t *ht = &buf_hash_table;
 	uint64_t *ct = NULL;
 	uint64_t hsize = 1ULL << 12;
+	uint64_t nlocks;
 	int i, j;
 
 	/*
@@ -1273,23 +1526,38 @@ buf_init(void)
 	while (hsize * zfs_arc_average_blocksize < arc_all_memory())
 		hsize <<= 1;
 retry:
-	buf_hash_table.ht_mask = hsize - 1;
 #if defined(_KERNEL)
-	/*
-	 * Large allocations which do not require contiguous pages
-	 * should be using vmem_alloc() in the linux kernel
-	 */
-	buf_hash_table.ht_table =
-	    vmem_zalloc(hsize * sizeof (void*), KM_SLEEP);
+	ht->ht_table[0] = buf_hash_table_alloc(hsize, KM_SLEEP);
 #else
-	buf_hash_table.ht_table =
-	    kmem_zalloc(hsize * sizeof (void*), KM_NOSLEEP);
+	ht->ht_table[0] = buf_hash_table_alloc(hsize, KM_NOSLEEP);
 #endif
-	if (buf_hash_table.ht_table == NULL) {
+	if (ht->ht_table[0] == NULL) {
 		ASSERT(hsize > (1ULL << 8));
 		hsize >>= 1;
 		goto retry;
 	}
+	ht->ht_mask[0] = hsize - 1;
+	ht->ht_cur = 0;
+	ht->ht_min_size = hsize;
+
+	/*
+	 * Size the lock stripes for the expected concurrency and for the
+	 * initial table size, but never beyond the number of buckets.
+	 */
+	nlocks = BUF_LOCKS_MIN;
+	while (nlocks < BUF_LOCKS_MAX &&
+	    (nlocks < boot_ncpus * BUF_LOCKS_PER_CPU || nlocks < hsize >> 12))
+		nlocks <<= 1;
+	while (nlocks > hsize)
+		nlocks >>= 1;
+	ht->ht_nlocks = nlocks;
+	ht->ht_locks = vmem_zalloc(nlocks * sizeof (buf_hash_lock_t),
+	    KM_SLEEP);
+	for (uint64_t l = 0; l < nlocks; l++)
+		mutex_init(&ht->ht_locks[l].hl_lock, NULL, MUTEX_DEFAULT, NULL);
+
+	ARCSTAT(arcstat_hash_buckets) = hsize;
+	ARCSTAT(arcstat_hash_locks) = nlocks;
 
 	hdr_full_cache = kmem_cache_create("arc_buf_hdr_t_full", HDR_FULL_SIZE,
 	    0, hdr_full_cons, hdr_full_dest, NULL, NULL, NULL, KMC_RECLAIMABLE);
@@ -1302,9 +1570,6 @@ retry:
 	for (i = 0; i < 256; i++)
 		for (ct = zfs_crc64_table + i, *ct = i, j = 8; j > 0; j--)
 			*ct = (*ct >> 1) ^ (-(*ct & 1) & ZFS_CRC64_POLY);
-
-	for (i = 0; i < BUF_LOCKS; i++)
-		mutex_init(BUF_HASH_LOCK(i), NULL, MUTEX_DEFAULT, NULL);
 }
 
 #define	ARC_MINTIME	(hz>>4) /* 62 ms */
@@ -1772,9 +2037,10 @@ arc_buf_alloc_l2only(size_t size, arc_buf_contents_t type, l2arc_dev_t *dev,
 
 	hdr->b_dva = dva;
 
-	hdr->b_l2hdr.b_dev = dev;
-	hdr->b_l2hdr.b_daddr = daddr;
-	hdr->b_l2hdr.b_arcs_state = arcs_state;
+	hdr->b_l2hdr.b_prop = 0;
+	L2HDR_SET_DEV_ID(&hdr->b_l2hdr, dev->l2ad_id);
+	L2HDR_SET_DADDR(&hdr->b_l2hdr, daddr);
+	L2HDR_SET_STATE(&hdr->b_l2hdr, arcs_state);
 
 	return (hdr);
 }
@@ -2405,8 +2671,8 @@ arc_buf_info(arc_buf_t *ab, arc_buf_info_t *abi, int state_index)
 	}
 
 	if (l2hdr) {
-		abi->abi_l2arc_dattr = l2hdr->b_daddr;
-		abi->abi_l2arc_hits = l2hdr->b_hits;
+		abi->abi_l2arc_dattr = L2HDR_GET_DADDR(l2hdr);
+		abi->abi_l2arc_hits = hdr->b_l2hits;
 	}
 
 	abi->abi_state_type = state ? state->arcs_state : ARC_STATE_ANON;
@@ -2414,6 +2680,226 @@ arc_buf_info(arc_buf_t *ab, arc_buf_info_t *abi, int state_index)
 	abi->abi_size = arc_hdr_size(hdr);
 }
 
+/*
+ * Per dataset accounting (the arc_quota and arc_reservation properties).
+ *
+ * Every open filesystem or volume registers an arc_dataset_t, keyed by the
+ * pool's load guid and its objset id, and the headers of blocks read or
+ * written through it hold a reference to it in b_dataset.  The logical size
+ * of headers in the MRU, MFU and uncached states is charged to their
+ * dataset by arc_change_state().  A block shared by several datasets
+ * (snapshots, clones, dedup) is charged to the first one that cached it.
+ *
+ * A dataset that grows beyond its arc_quota wakes up the eviction thread,
+ * which evicts only that dataset's buffers until it fits again (see
+ * arc_dataset_evict_quota()).  Regular eviction skips the buffers of a
+ * dataset that is not larger than its arc_reservation, as long as all
+ * reservations together are no more than half of arc_c, so that they can
+ * neither starve the other datasets nor keep the ARC from shrinking.
+ *
+ * As long as no dataset has a limit, blocks are not attached to their
+ * dataset at all, which keeps the lookup and the accounting off the read
+ * and write paths.
+ */
+#define	ARC_DATASET_STATE(state)	\
+	((state) == arc_mru || (state) == arc_mfu || (state) == arc_uncached)
+
+static int
+arc_dataset_compare(const void *x1, const void *x2)
+{
+	const arc_dataset_t *a1 = x1, *a2 = x2;
+
+	int cmp = TREE_CMP(a1->ads_spa, a2->ads_spa);
+	if (likely(cmp))
+		return (cmp);
+
+	return (TREE_CMP(a1->ads_objset, a2->ads_objset));
+}
+
+/*
+ * Return the held arc_dataset_t of an objset, or NULL if it is not open.
+ */
+static arc_dataset_t *
+arc_dataset_lookup(uint64_t spa, uint64_t objset)
+{
+	arc_dataset_t search, *ads;
+
+	search.ads_spa = spa;
+	search.ads_objset = objset;
+
+	rw_enter(&arc_dataset_lock, RW_READER);
+	ads = avl_find(&arc_dataset_tree, &search, NULL);
+	if (ads != NULL)
+		atomic_inc_64(&ads->ads_refcnt);
+	rw_exit(&arc_dataset_lock);
+
+	return (ads);
+}
+
+/*
+ * Called when an objset is opened.  Returns its arc_dataset_t, held, which
+ * may already exist if blocks of the dataset are still cached.
+ */
+arc_dataset_t *
+arc_dataset_get(spa_t *spa, uint64_t objset)
+{
+	uint64_t guid = spa_load_guid(spa);
+	arc_dataset_t *ads, *nads;
+	avl_index_t where;
+
+	if ((ads = arc_dataset_lookup(guid, objset)) != NULL)
+		return (ads);
+
+	nads = kmem_zalloc(sizeof (*nads), KM_SLEEP);
+	nads->ads_spa = guid;
+	nads->ads_objset = objset;
+	nads->ads_refcnt = 1;
+	wmsum_init(&nads->ads_hits, 0);
+	wmsum_init(&nads->ads_misses, 0);
+
+	rw_enter(&arc_dataset_lock, RW_WRITER);
+	ads = avl_find(&arc_dataset_tree, nads, &where);
+	if (ads == NULL) {
+		avl_insert(&arc_dataset_tree, nads, where);
+		rw_exit(&arc_dataset_lock);
+		return (nads);
+	}
+	atomic_inc_64(&ads->ads_refcnt);
+	rw_exit(&arc_dataset_lock);
+
+	wmsum_fini(&nads->ads_hits);
+	wmsum_fini(&nads->ads_misses);
+	kmem_free(nads, sizeof (*nads));
+	return (ads);
+}
+
+void
+arc_dataset_hold(arc_dataset_t *ads)
+{
+	ASSERT3U(ads->ads_refcnt, >, 0);
+	atomic_inc_64(&ads->ads_refcnt);
+}
+
+/*
+ * Lookups take holds under the reader lock, so the last hold is only
+ * dropped under the writer lock, where the entry can be safely removed.
+ */
+void
+arc_dataset_rele(arc_dataset_t *ads)
+{
+	uint64_t refcnt;
+
+	while ((refcnt = ads->ads_refcnt) > 1) {
+		if (atomic_cas_64(&ads->ads_refcnt, refcnt, refcnt - 1) ==
+		    refcnt)
+			return;
+	}
+
+	rw_enter(&arc_dataset_lock, RW_WRITER);
+	if (atomic_dec_64_nv(&ads->ads_refcnt) > 0) {
+		rw_exit(&arc_dataset_lock);
+		return;
+	}
+	avl_remove(&arc_dataset_tree, ads);
+	rw_exit(&arc_dataset_lock);
+
+	ASSERT0(ads->ads_size);
+	ASSERT0(ads->ads_reservation);
+	wmsum_fini(&ads->ads_hits);
+	wmsum_fini(&ads->ads_misses);
+	kmem_free(ads, sizeof (*ads));
+}
+
+/*
+ * Hand a dataset over its quota to the eviction thread, once.
+ */
+static void
+arc_dataset_over(arc_dataset_t *ads)
+{
+	if (atomic_cas_32(&ads->ads_over_quota, B_FALSE, B_TRUE) == B_FALSE) {
+		arc_dataset_over_quota = B_TRUE;
+		zthr_wakeup(arc_evict_zthr);
+	}
+}
+
+static void
+arc_dataset_charge(arc_dataset_t *ads, int64_t delta)
+{
+	uint64_t size = atomic_add_64_nv(&ads->ads_size, delta);
+	uint64_t quota = ads->ads_quota;
+
+	if (delta > 0 && quota != 0 && size > quota)
+		arc_dataset_over(ads);
+}
+
+/*
+ * Bytes by which a dataset exceeds its quota, if any.
+ */
+static int64_t
+arc_dataset_excess(const arc_dataset_t *ads)
+{
+	uint64_t quota = ads->ads_quota;
+
+	return (quota == 0 ? 0 : (int64_t)(ads->ads_size - quota));
+}
+
+/*
+ * Whether regular eviction has to leave the dataset's buffers alone.
+ */
+static boolean_t
+arc_dataset_protected(const arc_dataset_t *ads)
+{
+	return (ads != NULL && ads->ads_size <= ads->ads_reservation &&
+	    arc_dataset_reserved <= arc_c / 2);
+}
+
+/*
+ * Keep arc_dataset_limited up to date after a limit of the dataset changed.
+ */
+static void
+arc_dataset_limits_changed(arc_dataset_t *ads)
+{
+	ASSERT(RW_WRITE_HELD(&arc_dataset_lock));
+
+	boolean_t limited = (ads->ads_quota != 0 || ads->ads_reservation != 0);
+	if (limited != ads->ads_limited) {
+		ads->ads_limited = limited;
+		atomic_add_64(&arc_dataset_limited, limited ? 1 : -1);
+	}
+}
+
+void
+arc_dataset_set_quota(arc_dataset_t *ads, uint64_t quota)
+{
+	rw_enter(&arc_dataset_lock, RW_WRITER);
+	ads->ads_quota = quota;
+	arc_dataset_limits_changed(ads);
+	rw_exit(&arc_dataset_lock);
+
+	if (arc_dataset_excess(ads) > 0)
+		arc_dataset_over(ads);
+}
+
+void
+arc_dataset_set_reservation(arc_dataset_t *ads, uint64_t reservation)
+{
+	rw_enter(&arc_dataset_lock, RW_WRITER);
+	uint64_t old = atomic_swap_64(&ads->ads_reservation, reservation);
+	arc_dataset_limits_changed(ads);
+	rw_exit(&arc_dataset_lock);
+
+	atomic_add_64(&arc_dataset_reserved, reservation - old);
+}
+
+void
+arc_dataset_stats(arc_dataset_t *ads, uint64_t *size, uint64_t *hits,
+    uint64_t *misses)
+{
+	*size = ads->ads_size;
+	*hits = wmsum_value(&ads->ads_hits);
+	*misses = wmsum_value(&ads->ads_misses);
+}
+
 /*
  * Move the supplied buffer to the indicated state. The hash lock
  * for the buffer must be held by the caller.
@@ -2607,9 +3093,17 @@ arc_change_state(arc_state_t *new_state, arc_buf_hdr_t *hdr)
 
 		if (HDR_HAS_L2HDR(hdr) && new_state != arc_l2c_only) {
 			l2arc_hdr_arcstats_decrement_state(hdr);
-			hdr->b_l2hdr.b_arcs_state = new_state->arcs_state;
+			L2HDR_SET_STATE(&hdr->b_l2hdr, new_state->arcs_state);
 			l2arc_hdr_arcstats_increment_state(hdr);
 		}
+
+		if (hdr->b_l1hdr.b_dataset != NULL &&
+		    ARC_DATASET_STATE(old_state) !=
+		    ARC_DATASET_STATE(new_state)) {
+			int64_t lsize = HDR_GET_LSIZE(hdr);
+			arc_dataset_charge(hdr->b_l1hdr.b_dataset,
+			    ARC_DATASET_STATE(new_state) ? lsize : -lsize);
+		}
 	}
 }
 
@@ -3309,7 +3803,9 @@ arc_hdr_alloc(uint64_t spa, int32_t psize, int32_t lsize,
 	hdr->b_l1hdr.b_mru_ghost_hits = 0;
 	hdr->b_l1hdr.b_mfu_hits = 0;
 	hdr->b_l1hdr.b_mfu_ghost_hits = 0;
+	hdr->b_l1hdr.b_admit = ARC_ADMIT_NONE;
 	hdr->b_l1hdr.b_buf = NULL;
+	hdr->b_l1hdr.b_dataset = NULL;
 
 	ASSERT(zfs_refcount_is_zero(&hdr->b_l1hdr.b_refcnt));
 
@@ -3329,7 +3825,7 @@ arc_hdr_realloc(arc_buf_hdr_t *hdr, kmem_cache_t *old, kmem_cache_t *new)
 	ASSERT(HDR_HAS_L2HDR(hdr));
 
 	arc_buf_hdr_t *nhdr;
-	l2arc_dev_t *dev = hdr->b_l2hdr.b_dev;
+	l2arc_dev_t *dev = l2arc_hdr_dev(hdr);
 
 	ASSERT((old == hdr_full_cache && new == hdr_l2only_cache) ||
 	    (old == hdr_l2only_cache && new == hdr_full_cache));
@@ -3349,6 +3845,8 @@ arc_hdr_realloc(arc_buf_hdr_t *hdr, kmem_cache_t *old, kmem_cache_t *new)
 		 * l2c_only even though it's about to change.
 		 */
 		nhdr->b_l1hdr.b_state = arc_l2c_only;
+		nhdr->b_l1hdr.b_admit = ARC_ADMIT_NONE;
+		nhdr->b_l1hdr.b_dataset = NULL;
 
 		/* Verify previous threads set to NULL before freeing */
 		ASSERT3P(nhdr->b_l1hdr.b_pabd, ==, NULL);
@@ -3378,6 +3876,10 @@ arc_hdr_realloc(arc_buf_hdr_t *hdr, kmem_cache_t *old, kmem_cache_t *new)
 		VERIFY3P(hdr->b_l1hdr.b_pabd, ==, NULL);
 		ASSERT(!HDR_HAS_RABD(hdr));
 
+		/* arc_read() looks the dataset up again if it is read */
+		if (hdr->b_l1hdr.b_dataset != NULL)
+			arc_dataset_rele(hdr->b_l1hdr.b_dataset);
+
 		arc_hdr_clear_flags(nhdr, ARC_FLAG_HAS_L1HDR);
 	}
 	/*
@@ -3583,7 +4085,7 @@ l2arc_hdr_arcstats_update(arc_buf_hdr_t *hdr, boolean_t incr,
 		 * possibly absent L1 header (apparent in buffers restored
 		 * from persistent L2ARC).
 		 */
-		switch (hdr->b_l2hdr.b_arcs_state) {
+		switch (L2HDR_GET_STATE(&hdr->b_l2hdr)) {
 			case ARC_STATE_MRU_GHOST:
 			case ARC_STATE_MRU:
 				ARCSTAT_INCR(arcstat_l2_mru_asize, asize_s);
@@ -3619,8 +4121,7 @@ l2arc_hdr_arcstats_update(arc_buf_hdr_t *hdr, boolean_t incr,
 static void
 arc_hdr_l2hdr_destroy(arc_buf_hdr_t *hdr)
 {
-	l2arc_buf_hdr_t *l2hdr = &hdr->b_l2hdr;
-	l2arc_dev_t *dev = l2hdr->b_dev;
+	l2arc_dev_t *dev = l2arc_hdr_dev(hdr);
 
 	ASSERT(MUTEX_HELD(&dev->l2ad_mtx));
 	ASSERT(HDR_HAS_L2HDR(hdr));
@@ -3649,7 +4150,7 @@ arc_hdr_destroy(arc_buf_hdr_t *hdr)
 	ASSERT(!HDR_IN_HASH_TABLE(hdr));
 
 	if (HDR_HAS_L2HDR(hdr)) {
-		l2arc_dev_t *dev = hdr->b_l2hdr.b_dev;
+		l2arc_dev_t *dev = l2arc_hdr_dev(hdr);
 		boolean_t buflist_held = MUTEX_HELD(&dev->l2ad_mtx);
 
 		if (!buflist_held)
@@ -3705,6 +4206,8 @@ arc_hdr_destroy(arc_buf_hdr_t *hdr)
 #ifdef ZFS_DEBUG
 		ASSERT3P(hdr->b_l1hdr.b_freeze_cksum, ==, NULL);
 #endif
+		if (hdr->b_l1hdr.b_dataset != NULL)
+			arc_dataset_rele(hdr->b_l1hdr.b_dataset);
 		kmem_cache_free(hdr_full_cache, hdr);
 	} else {
 		kmem_cache_free(hdr_l2only_cache, hdr);
@@ -3899,13 +4402,14 @@ arc_set_need_free(void)
 
 static uint64_t
 arc_evict_state_impl(multilist_t *ml, int idx, arc_buf_hdr_t *marker,
-    uint64_t spa, uint64_t bytes)
+    uint64_t spa, arc_dataset_t *ads, boolean_t reserve, uint64_t bytes)
 {
 	multilist_sublist_t *mls;
 	uint64_t bytes_evicted = 0, real_evicted = 0;
 	arc_buf_hdr_t *hdr;
 	kmutex_t *hash_lock;
 	uint_t evict_count = zfs_arc_evict_batch_limit;
+	uint_t scan_count = zfs_arc_dataset_scan_limit;
 
 	ASSERT3P(marker, !=, NULL);
 
@@ -3915,6 +4419,8 @@ arc_evict_state_impl(multilist_t *ml, int idx, arc_buf_hdr_t *marker,
 	    hdr = multilist_sublist_prev(mls, marker)) {
 		if ((evict_count == 0) || (bytes_evicted >= bytes))
 			break;
+		if (ads != NULL && scan_count-- == 0)
+			break;
 
 		/*
 		 * To keep our iteration location, move the marker
@@ -3947,6 +4453,16 @@ arc_evict_state_impl(multilist_t *ml, int idx, arc_buf_hdr_t *marker,
 			continue;
 		}
 
+		/* or of a certain dataset, see arc_dataset_evict_quota() */
+		if (ads != NULL && hdr->b_l1hdr.b_dataset != ads)
+			continue;
+
+		/* leave datasets their arc_reservation */
+		if (reserve && arc_dataset_protected(hdr->b_l1hdr.b_dataset)) {
+			ARCSTAT_BUMP(arcstat_evict_skip);
+			continue;
+		}
+
 		hash_lock = HDR_LOCK(hdr);
 
 		/*
@@ -3981,6 +4497,12 @@ arc_evict_state_impl(multilist_t *ml, int idx, arc_buf_hdr_t *marker,
 		}
 	}
 
+	/* the markers of arc_dataset_evict_quota() go round and round */
+	if (ads != NULL && hdr == NULL) {
+		multilist_sublist_remove(mls, marker);
+		multilist_sublist_insert_tail(mls, marker);
+	}
+
 	multilist_sublist_unlock(mls);
 
 	/*
@@ -4070,6 +4592,8 @@ typedef struct evict_arg {
 	arc_buf_hdr_t		*eva_marker;
 	int			eva_idx;
 	uint64_t		eva_spa;
+	arc_dataset_t		*eva_ads;
+	boolean_t		eva_reserve;
 	uint64_t		eva_bytes;
 	uint64_t		eva_evicted;
 } evict_arg_t;
@@ -4079,7 +4603,8 @@ arc_evict_task(void *arg)
 {
 	evict_arg_t *eva = arg;
 	eva->eva_evicted = arc_evict_state_impl(eva->eva_ml, eva->eva_idx,
-	    eva->eva_marker, eva->eva_spa, eva->eva_bytes);
+	    eva->eva_marker, eva->eva_spa, eva->eva_ads, eva->eva_reserve,
+	    eva->eva_bytes);
 }
 
 static void
@@ -4132,16 +4657,24 @@ arc_evict_thread_init(void)
  * If bytes is specified using the special value ARC_EVICT_ALL, this
  * will evict all available (i.e. unlocked and evictable) buffers from
  * the given arc state; which is used by arc_flush().
+ *
+ * If ads is given, only the buffers of that dataset are evicted, starting
+ * where the previous such call left off, see arc_dataset_evict_quota().
+ * Regular eviction, i.e. of any dataset and less than everything, honours
+ * the arc_reservation of datasets.
  */
 static uint64_t
 arc_evict_state(arc_state_t *state, arc_buf_contents_t type, uint64_t spa,
-    uint64_t bytes)
+    arc_dataset_t *ads, uint64_t bytes)
 {
 	uint64_t total_evicted = 0;
 	multilist_t *ml = &state->arcs_list[type];
 	int num_sublists;
 	arc_buf_hdr_t **markers;
 	evict_arg_t *eva = NULL;
+	boolean_t reserve = (spa == 0 && ads == NULL &&
+	    bytes != ARC_EVICT_ALL && !GHOST_STATE(state) &&
+	    arc_dataset_reserved != 0);
 
 	num_sublists = multilist_get_num_sublists(ml);
 
@@ -4154,13 +4687,16 @@ arc_evict_state(arc_state_t *state, arc_buf_contents_t type, uint64_t spa,
 	 * pick up where we left off for each individual sublist, rather
 	 * than starting from the tail each time.
 	 */
-	if (zthr_iscurthread(arc_evict_zthr)) {
+	if (ads != NULL) {
+		ASSERT(state == arc_mru || state == arc_mfu);
+		markers = arc_dataset_markers[state == arc_mfu][type];
+	} else if (zthr_iscurthread(arc_evict_zthr)) {
 		markers = arc_state_evict_markers;
 		ASSERT3S(num_sublists, <=, arc_state_evict_marker_count);
 	} else {
 		markers = arc_state_alloc_markers(num_sublists);
 	}
-	for (int i = 0; i < num_sublists; i++) {
+	for (int i = 0; ads == NULL && i < num_sublists; i++) {
 		multilist_sublist_t *mls;
 
 		mls = multilist_sublist_lock_idx(ml, i);
@@ -4179,6 +4715,8 @@ arc_evict_state(arc_state_t *state, arc_buf_contents_t type, uint64_t spa,
 				taskq_init_ent(&eva[i].eva_tqent);
 				eva[i].eva_ml = ml;
 				eva[i].eva_spa = spa;
+				eva[i].eva_ads = ads;
+				eva[i].eva_reserve = reserve;
 			}
 		} else {
 			/*
@@ -4259,7 +4797,8 @@ arc_evict_state(arc_state_t *state, arc_buf_contents_t type, uint64_t spa,
 				break;
 
 			bytes_evicted = arc_evict_state_impl(ml, sublist_idx,
-			    markers[sublist_idx], spa, bytes_remaining);
+			    markers[sublist_idx], spa, ads, reserve,
+			    bytes_remaining);
 
 			scan_evicted += bytes_evicted;
 			total_evicted += bytes_evicted;
@@ -4317,13 +4856,13 @@ arc_evict_state(arc_state_t *state, arc_buf_contents_t type, uint64_t spa,
 	if (eva != NULL && eva != arc_evict_arg)
 		kmem_free(eva, sizeof (evict_arg_t) * zfs_arc_evict_threads);
 
-	for (int i = 0; i < num_sublists; i++) {
+	for (int i = 0; ads == NULL && i < num_sublists; i++) {
 		multilist_sublist_t *mls = multilist_sublist_lock_idx(ml, i);
 		multilist_sublist_remove(mls, markers[i]);
 		multilist_sublist_unlock(mls);
 	}
 
-	if (markers != arc_state_evict_markers)
+	if (ads == NULL && markers != arc_state_evict_markers)
 		arc_state_free_markers(markers, num_sublists);
 
 	return (total_evicted);
@@ -4351,7 +4890,8 @@ arc_flush_state(arc_state_t *state, uint64_t spa, arc_buf_contents_t type,
 	uint64_t evicted = 0;
 
 	while (zfs_refcount_count(&state->arcs_esize[type]) != 0) {
-		evicted += arc_evict_state(state, type, spa, ARC_EVICT_ALL);
+		evicted += arc_evict_state(state, type, spa, NULL,
+		    ARC_EVICT_ALL);
 
 		if (!retry)
 			break;
@@ -4375,12 +4915,110 @@ arc_evict_impl(arc_state_t *state, arc_buf_contents_t type, int64_t bytes)
 	if (bytes > 0 && zfs_refcount_count(&state->arcs_esize[type]) > 0) {
 		delta = MIN(zfs_refcount_count(&state->arcs_esize[type]),
 		    bytes);
-		return (arc_evict_state(state, type, 0, delta));
+		return (arc_evict_state(state, type, 0, NULL, delta));
 	}
 
 	return (0);
 }
 
+/*
+ * Evict the buffers of datasets over their arc_quota until they fit again,
+ * least recently used first.  Entries are held while the tree is unlocked,
+ * so that iteration can continue from them.
+ *
+ * The MRU and MFU hold the buffers of all datasets, so instead of walking
+ * them from the tail every time, each sublist has a marker that stays in it
+ * and moves towards the head by at most zfs_arc_dataset_scan_limit headers
+ * per call, going back to the tail when it gets there.
+ */
+static uint64_t
+arc_dataset_evict_quota(void)
+{
+	arc_state_t *states[] = { arc_mru, arc_mfu };
+	arc_dataset_t *ads, *held = NULL;
+	uint64_t evicted = 0;
+
+	arc_dataset_over_quota = B_FALSE;
+
+	rw_enter(&arc_dataset_lock, RW_READER);
+	for (ads = avl_first(&arc_dataset_tree); ads != NULL;
+	    ads = AVL_NEXT(&arc_dataset_tree, ads)) {
+		if (!ads->ads_over_quota)
+			continue;
+
+		atomic_inc_64(&ads->ads_refcnt);
+		rw_exit(&arc_dataset_lock);
+		if (held != NULL)
+			arc_dataset_rele(held);
+		held = ads;
+
+		ads->ads_over_quota = B_FALSE;
+		for (int s = 0; s < ARRAY_SIZE(states); s++) {
+			for (int t = 0; t < ARC_BUFC_NUMTYPES; t++) {
+				int64_t excess = arc_dataset_excess(ads);
+				if (excess <= 0)
+					break;
+				evicted += arc_evict_state(states[s], t, 0,
+				    ads, excess);
+			}
+		}
+
+		rw_enter(&arc_dataset_lock, RW_READER);
+	}
+	rw_exit(&arc_dataset_lock);
+
+	if (held != NULL)
+		arc_dataset_rele(held);
+
+	return (evicted);
+}
+
+static void
+arc_dataset_markers_init(void)
+{
+	arc_state_t *states[] = { arc_mru, arc_mfu };
+
+	for (int s = 0; s < ARRAY_SIZE(states); s++) {
+		for (int t = 0; t < ARC_BUFC_NUMTYPES; t++) {
+			multilist_t *ml = &states[s]->arcs_list[t];
+			int num_sublists = multilist_get_num_sublists(ml);
+			arc_buf_hdr_t **markers =
+			    arc_state_alloc_markers(num_sublists);
+
+			for (int i = 0; i < num_sublists; i++) {
+				multilist_sublist_t *mls =
+				    multilist_sublist_lock_idx(ml, i);
+				multilist_sublist_insert_tail(mls, markers[i]);
+				multilist_sublist_unlock(mls);
+			}
+			arc_dataset_markers[s][t] = markers;
+		}
+	}
+}
+
+static void
+arc_dataset_markers_fini(void)
+{
+	arc_state_t *states[] = { arc_mru, arc_mfu };
+
+	for (int s = 0; s < ARRAY_SIZE(states); s++) {
+		for (int t = 0; t < ARC_BUFC_NUMTYPES; t++) {
+			multilist_t *ml = &states[s]->arcs_list[t];
+			int num_sublists = multilist_get_num_sublists(ml);
+			arc_buf_hdr_t **markers = arc_dataset_markers[s][t];
+
+			for (int i = 0; i < num_sublists; i++) {
+				multilist_sublist_t *mls =
+				    multilist_sublist_lock_idx(ml, i);
+				multilist_sublist_remove(mls, markers[i]);
+				multilist_sublist_unlock(mls);
+			}
+			arc_state_free_markers(markers, num_sublists);
+			arc_dataset_markers[s][t] = NULL;
+		}
+	}
+}
+
 /*
  * Adjust specified fraction, taking into account initial ghost state(s) size,
  * ghost hit bytes towards increasing the fraction, ghost hit bytes towards
@@ -4829,7 +5467,7 @@ arc_evict_cb_check(void *arg, zthr_t *zthr)
 	 * which is held before this function is called, and is held by
 	 * arc_wait_for_eviction() when it calls zthr_wakeup().
 	 */
-	if (arc_evict_needed)
+	if (arc_evict_needed || arc_dataset_over_quota)
 		return (B_TRUE);
 
 	/*
@@ -4858,6 +5496,10 @@ arc_evict_cb(void *arg, zthr_t *zthr)
 	evicted += arc_flush_state(arc_uncached, 0, ARC_BUFC_DATA, B_FALSE);
 	evicted += arc_flush_state(arc_uncached, 0, ARC_BUFC_METADATA, B_FALSE);
 
+	/* Trim datasets that grew beyond their arc_quota. */
+	if (arc_dataset_over_quota)
+		evicted += arc_dataset_evict_quota();
+
 	/* Evict from other states only if told to. */
 	if (arc_evict_needed)
 		evicted += arc_evict();
@@ -4935,6 +5577,9 @@ arc_reap_cb_check(void *arg, zthr_t *zthr)
 	if (!((reap_cb_check_counter++) % 60))
 		zfs_zstd_cache_reap_now();
 
+	/* Likewise, age the zfs_arc_admit sketch off the arc_read() path */
+	arc_admit_age();
+
 	return (B_FALSE);
 }
 
@@ -5320,6 +5965,133 @@ arc_free_data_impl(arc_buf_hdr_t *hdr, uint64_t size, const void *tag)
 	}
 }
 
+/*
+ * Scan-resistant admission (zfs_arc_admit).
+ *
+ * Every data block read from disk normally enters the MRU state, so a
+ * single large sequential read or backup pushes out the working set.  With
+ * zfs_arc_admit set, reads that miss the ARC record their block in a
+ * count-min sketch of small saturating counters, which are all halved
+ * for every arc_admit_window recorded reads so that old history fades, as
+ * in TinyLFU.  The halving is done by the arc_reap thread, never by the
+ * reader.  Once the ARC is full, a data block which the sketch has not
+ * seen before is not admitted: it is read into the uncached state, like
+ * with primarycache=metadata, and evicted as soon as it is released.  A
+ * block read again while the sketch still remembers it is admitted to the
+ * MRU state as usual.  Blocks that are in a ghost state or the L2ARC, and
+ * metadata, are always admitted.
+ *
+ * The sketch is updated without locks; a lost update only makes an
+ * estimate slightly low, and one racing with aging leaves a single counter
+ * unaged.  The admit_* arcstats count the decisions and the
+ * later hits on accepted and rejected blocks.
+ */
+#define	ARC_ADMIT_ROWS		4
+#define	ARC_ADMIT_MAX		15
+
+/* A distinct odd multiplier per row keeps the rows' hashes independent */
+static const uint64_t arc_admit_mult[ARC_ADMIT_ROWS] = {
+	0x9E3779B97F4A7C15ULL,
+	0xC2B2AE3D27D4EB4FULL,
+	0x165667B19E3779F9ULL,
+	0xD6E8FEB86659FD93ULL,
+};
+
+static uint8_t *arc_admit_sketch;
+static uint_t arc_admit_shift;		/* log2 of counters per row */
+static uint64_t arc_admit_window;	/* reads between agings */
+static uint64_t arc_admit_reads;
+static uint64_t arc_admit_aged;		/* arc_admit_reads at last aging */
+
+static void
+arc_admit_init(void)
+{
+	/* About one counter per 256K of ARC, but at least 1024 per row */
+	arc_admit_shift = MAX(highbit64(arc_c_max >> 18), 10);
+	arc_admit_window = 8ULL << arc_admit_shift;
+	arc_admit_sketch = vmem_zalloc(ARC_ADMIT_ROWS << arc_admit_shift,
+	    KM_SLEEP);
+}
+
+static void
+arc_admit_fini(void)
+{
+	vmem_free(arc_admit_sketch, ARC_ADMIT_ROWS << arc_admit_shift);
+	arc_admit_sketch = NULL;
+}
+
+/*
+ * Called from the arc_reap thread.  Halve the counters once for each full
+ * window of reads recorded since the last aging.
+ */
+static void
+arc_admit_age(void)
+{
+	uint64_t n = ARC_ADMIT_ROWS << arc_admit_shift;
+	uint64_t windows = (atomic_load_64(&arc_admit_reads) -
+	    arc_admit_aged) / arc_admit_window;
+
+	if (windows == 0)
+		return;
+	arc_admit_aged += windows * arc_admit_window;
+
+	/* Counters saturate at ARC_ADMIT_MAX, so four halvings clear them */
+	uint_t shift = MIN(windows, 4);
+	for (uint64_t i = 0; i < n; i++)
+		arc_admit_sketch[i] >>= shift;
+}
+
+/*
+ * Record a read of hdr's block and return how often it was read before
+ * within the current window.
+ */
+static uint_t
+arc_admit_record(const arc_buf_hdr_t *hdr)
+{
+	uint64_t key = buf_hash(hdr->b_spa, &hdr->b_dva, hdr->b_birth);
+	uint64_t idx[ARC_ADMIT_ROWS];
+	uint_t freq = ARC_ADMIT_MAX;
+
+	for (int r = 0; r < ARC_ADMIT_ROWS; r++) {
+		idx[r] = ((uint64_t)r << arc_admit_shift) +
+		    ((key * arc_admit_mult[r]) >> (64 - arc_admit_shift));
+		freq = MIN(freq, arc_admit_sketch[idx[r]]);
+	}
+
+	/* Conservative update, only the smallest counters are raised */
+	if (freq < ARC_ADMIT_MAX) {
+		for (int r = 0; r < ARC_ADMIT_ROWS; r++) {
+			if (arc_admit_sketch[idx[r]] == freq)
+				arc_admit_sketch[idx[r]] = freq + 1;
+		}
+	}
+
+	atomic_inc_64(&arc_admit_reads);
+
+	return (freq);
+}
+
+/*
+ * Called by arc_read() for a data block which is not in the ARC at all.
+ * Returns B_FALSE if it should only be given a short-lived uncached slot.
+ */
+static boolean_t
+arc_admit(arc_buf_hdr_t *hdr)
+{
+	uint_t freq = arc_admit_record(hdr);
+
+	if (freq == 0 &&
+	    aggsum_lower_bound(&arc_sums.arcstat_size) >= arc_c) {
+		hdr->b_l1hdr.b_admit = ARC_ADMIT_REJECTED;
+		ARCSTAT_BUMP(arcstat_admit_rejected);
+		return (B_FALSE);
+	}
+
+	hdr->b_l1hdr.b_admit = ARC_ADMIT_ACCEPTED;
+	ARCSTAT_BUMP(arcstat_admit_accepted);
+	return (B_TRUE);
+}
+
 /*
  * This routine is called whenever a buffer is accessed.
  */
@@ -5329,6 +6101,15 @@ arc_access(arc_buf_hdr_t *hdr, arc_flags_t arc_flags, boolean_t hit)
 	ASSERT(MUTEX_HELD(HDR_LOCK(hdr)));
 	ASSERT(HDR_HAS_L1HDR(hdr));
 
+	if (hit && !HDR_IO_IN_PROGRESS(hdr)) {
+		if (hdr->b_l1hdr.b_dataset != NULL)
+			wmsum_add(&hdr->b_l1hdr.b_dataset->ads_hits, 1);
+		if (hdr->b_l1hdr.b_admit == ARC_ADMIT_ACCEPTED)
+			ARCSTAT_BUMP(arcstat_admit_accepted_hits);
+		else if (hdr->b_l1hdr.b_admit == ARC_ADMIT_REJECTED)
+			ARCSTAT_BUMP(arcstat_admit_rejected_hits);
+	}
+
 	/*
 	 * Update buffer prefetch status.
 	 */
@@ -6006,9 +6787,19 @@ top:
 		    hdr->b_l1hdr.b_state == arc_mfu ||
 		    hdr->b_l1hdr.b_state == arc_uncached);
 
+		/*
+		 * Demand reads that promote a block to the MFU, or that are
+		 * the first after its prefetch (which may have promoted it
+		 * already), are reported to the hot set.
+		 */
+		boolean_t was_mfu = hdr->b_l1hdr.b_state == arc_mfu;
+		boolean_t was_prefetch = HDR_PREFETCH(hdr);
+
 		DTRACE_PROBE1(arc__hit, arc_buf_hdr_t *, hdr);
 		arc_access(hdr, *arc_flags, B_TRUE);
 
+		boolean_t mfu = hdr->b_l1hdr.b_state == arc_mfu;
+
 		if (done && !no_buf) {
 			ASSERT(!embedded_bp || !BP_IS_HOLE(bp));
 
@@ -6044,6 +6835,9 @@ top:
 		ARCSTAT_BUMP(arcstat_hits);
 		ARCSTAT_CONDSTAT(!(*arc_flags & ARC_FLAG_PREFETCH),
 		    demand, prefetch, is_data, data, metadata, hits);
+		if (!(*arc_flags & ARC_FLAG_PREFETCH) &&
+		    ((mfu && !was_mfu) || was_prefetch))
+			spa_hotset_access(spa, bp, zb, mfu);
 		*arc_flags |= ARC_FLAG_CACHED;
 		goto done;
 	} else {
@@ -6057,6 +6851,7 @@ top:
 		abd_t *hdr_abd;
 		int alloc_flags = encrypted_read ? ARC_HDR_ALLOC_RDATA : 0;
 		arc_buf_contents_t type = BP_GET_BUFC_TYPE(bp);
+		boolean_t uncached = !!(*arc_flags & ARC_FLAG_UNCACHED);
 		int config_lock;
 		int error;
 
@@ -6117,6 +6912,9 @@ top:
 				arc_hdr_destroy(hdr);
 				goto top; /* restart the IO request */
 			}
+			if (zfs_arc_admit && !embedded_bp && !uncached &&
+			    type == ARC_BUFC_DATA && !arc_admit(hdr))
+				uncached = B_TRUE;
 		} else {
 			/*
 			 * This block is in the ghost cache or encrypted data
@@ -6174,7 +6972,14 @@ top:
 				goto top;
 			}
 		}
-		if (*arc_flags & ARC_FLAG_UNCACHED) {
+		if (hdr->b_l1hdr.b_dataset == NULL && !embedded_bp &&
+		    zb != NULL && arc_dataset_limited != 0) {
+			hdr->b_l1hdr.b_dataset =
+			    arc_dataset_lookup(guid, zb->zb_objset);
+		}
+		if (hdr->b_l1hdr.b_dataset != NULL)
+			wmsum_add(&hdr->b_l1hdr.b_dataset->ads_misses, 1);
+		if (uncached) {
 			arc_hdr_set_flags(hdr, ARC_FLAG_UNCACHED);
 			if (!encrypted_read)
 				alloc_flags |= ARC_HDR_ALLOC_LINEAR;
@@ -6235,9 +7040,9 @@ top:
 		hdr->b_l1hdr.b_acb = acb;
 
 		if (HDR_HAS_L2HDR(hdr) &&
-		    (vd = hdr->b_l2hdr.b_dev->l2ad_vdev) != NULL) {
-			devw = hdr->b_l2hdr.b_dev->l2ad_writing;
-			addr = hdr->b_l2hdr.b_daddr;
+		    (vd = l2arc_hdr_dev(hdr)->l2ad_vdev) != NULL) {
+			devw = l2arc_hdr_dev(hdr)->l2ad_writing;
+			addr = L2HDR_GET_DADDR(&hdr->b_l2hdr);
 			/*
 			 * Lock out L2ARC device removal.
 			 */
@@ -6302,7 +7107,7 @@ top:
 
 				DTRACE_PROBE1(l2arc__hit, arc_buf_hdr_t *, hdr);
 				ARCSTAT_BUMP(arcstat_l2_hits);
-				hdr->b_l2hdr.b_hits++;
+				hdr->b_l2hits++;
 
 				cb = kmem_zalloc(sizeof (l2arc_read_callback_t),
 				    KM_SLEEP);
@@ -6733,11 +7538,13 @@ arc_release(arc_buf_t *buf, const void *tag)
 		ASSERT(!HDR_IO_IN_PROGRESS(hdr));
 
 		if (HDR_HAS_L2HDR(hdr)) {
-			mutex_enter(&hdr->b_l2hdr.b_dev->l2ad_mtx);
+			l2arc_dev_t *dev = l2arc_hdr_dev(hdr);
+
+			mutex_enter(&dev->l2ad_mtx);
 			/* Recheck to prevent race with l2arc_evict(). */
 			if (HDR_HAS_L2HDR(hdr))
 				arc_hdr_l2hdr_destroy(hdr);
-			mutex_exit(&hdr->b_l2hdr.b_dev->l2ad_mtx);
+			mutex_exit(&dev->l2ad_mtx);
 		}
 
 		hdr->b_l1hdr.b_mru_hits = 0;
@@ -7011,8 +7818,14 @@ arc_write_done(zio_t *zio)
 		arc_hdr_clear_flags(hdr, ARC_FLAG_IO_IN_PROGRESS);
 		VERIFY3S(remove_reference(hdr, hdr), >, 0);
 		/* if it's not anon, we are doing a scrub */
-		if (exists == NULL && hdr->b_l1hdr.b_state == arc_anon)
+		if (exists == NULL && hdr->b_l1hdr.b_state == arc_anon) {
+			if (hdr->b_l1hdr.b_dataset == NULL &&
+			    arc_dataset_limited != 0) {
+				hdr->b_l1hdr.b_dataset = arc_dataset_lookup(
+				    hdr->b_spa, zio->io_bookmark.zb_objset);
+			}
 			arc_access(hdr, 0, B_FALSE);
+		}
 		mutex_exit(hash_lock);
 	} else {
 		arc_hdr_clear_flags(hdr, ARC_FLAG_IO_IN_PROGRESS);
@@ -7230,6 +8043,17 @@ arc_kstat_update_state(arc_state_t *state, kstat_named_t *size,
 	    zfs_refcount_count(&state->arcs_esize[ARC_BUFC_METADATA]);
 }
 
+/*
+ * Bytes of headers per MiB of the data they describe.
+ */
+static uint64_t
+arc_hdr_overhead(uint64_t hdr_size, uint64_t data_size)
+{
+	if (data_size == 0)
+		return (0);
+	return (hdr_size * (1ULL << 20) / data_size);
+}
+
 static int
 arc_kstat_update(kstat_t *ksp, int rw)
 {
@@ -7278,6 +8102,14 @@ arc_kstat_update(kstat_t *ksp, int rw)
 	    wmsum_value(&arc_sums.arcstat_mfu_ghost_hits);
 	as->arcstat_uncached_hits.value.ui64 =
 	    wmsum_value(&arc_sums.arcstat_uncached_hits);
+	as->arcstat_admit_accepted.value.ui64 =
+	    wmsum_value(&arc_sums.arcstat_admit_accepted);
+	as->arcstat_admit_rejected.value.ui64 =
+	    wmsum_value(&arc_sums.arcstat_admit_rejected);
+	as->arcstat_admit_accepted_hits.value.ui64 =
+	    wmsum_value(&arc_sums.arcstat_admit_accepted_hits);
+	as->arcstat_admit_rejected_hits.value.ui64 =
+	    wmsum_value(&arc_sums.arcstat_admit_rejected_hits);
 	as->arcstat_deleted.value.ui64 =
 	    wmsum_value(&arc_sums.arcstat_deleted);
 	as->arcstat_mutex_miss.value.ui64 =
@@ -7307,6 +8139,8 @@ arc_kstat_update(kstat_t *ksp, int rw)
 	    wmsum_value(&arc_sums.arcstat_hash_collisions);
 	as->arcstat_hash_chains.value.ui64 =
 	    wmsum_value(&arc_sums.arcstat_hash_chains);
+	as->arcstat_hash_lock_contended.value.ui64 =
+	    wmsum_value(&arc_sums.arcstat_hash_lock_contended);
 	as->arcstat_size.value.ui64 =
 	    aggsum_value(&arc_sums.arcstat_size);
 	as->arcstat_compressed_size.value.ui64 =
@@ -7321,6 +8155,10 @@ arc_kstat_update(kstat_t *ksp, int rw)
 	    wmsum_value(&arc_sums.arcstat_data_size);
 	as->arcstat_metadata_size.value.ui64 =
 	    wmsum_value(&arc_sums.arcstat_metadata_size);
+	as->arcstat_hdr_overhead.value.ui64 = arc_hdr_overhead(
+	    as->arcstat_hdr_size.value.ui64,
+	    as->arcstat_data_size.value.ui64 +
+	    as->arcstat_metadata_size.value.ui64);
 	as->arcstat_dbuf_size.value.ui64 =
 	    wmsum_value(&arc_sums.arcstat_dbuf_size);
 #if defined(COMPAT_FREEBSD11)
@@ -7421,6 +8259,9 @@ arc_kstat_update(kstat_t *ksp, int rw)
 	    wmsum_value(&arc_sums.arcstat_l2_psize);
 	as->arcstat_l2_hdr_size.value.ui64 =
 	    aggsum_value(&arc_sums.arcstat_l2_hdr_size);
+	as->arcstat_l2_hdr_overhead.value.ui64 = arc_hdr_overhead(
+	    as->arcstat_l2_hdr_size.value.ui64,
+	    as->arcstat_l2_psize.value.ui64);
 	as->arcstat_l2_log_blk_writes.value.ui64 =
 	    wmsum_value(&arc_sums.arcstat_l2_log_blk_writes);
 	as->arcstat_l2_log_blk_asize.value.ui64 =
@@ -7716,6 +8557,10 @@ arc_state_init(void)
 	wmsum_init(&arc_sums.arcstat_mfu_hits, 0);
 	wmsum_init(&arc_sums.arcstat_mfu_ghost_hits, 0);
 	wmsum_init(&arc_sums.arcstat_uncached_hits, 0);
+	wmsum_init(&arc_sums.arcstat_admit_accepted, 0);
+	wmsum_init(&arc_sums.arcstat_admit_rejected, 0);
+	wmsum_init(&arc_sums.arcstat_admit_accepted_hits, 0);
+	wmsum_init(&arc_sums.arcstat_admit_rejected_hits, 0);
 	wmsum_init(&arc_sums.arcstat_deleted, 0);
 	wmsum_init(&arc_sums.arcstat_mutex_miss, 0);
 	wmsum_init(&arc_sums.arcstat_access_skip, 0);
@@ -7730,6 +8575,7 @@ arc_state_init(void)
 	wmsum_init(&arc_sums.arcstat_hash_elements, 0);
 	wmsum_init(&arc_sums.arcstat_hash_collisions, 0);
 	wmsum_init(&arc_sums.arcstat_hash_chains, 0);
+	wmsum_init(&arc_sums.arcstat_hash_lock_contended, 0);
 	aggsum_init(&arc_sums.arcstat_size, 0);
 	wmsum_init(&arc_sums.arcstat_compressed_size, 0);
 	wmsum_init(&arc_sums.arcstat_uncompressed_size, 0);
@@ -7875,6 +8721,10 @@ arc_state_fini(void)
 	wmsum_fini(&arc_sums.arcstat_mfu_hits);
 	wmsum_fini(&arc_sums.arcstat_mfu_ghost_hits);
 	wmsum_fini(&arc_sums.arcstat_uncached_hits);
+	wmsum_fini(&arc_sums.arcstat_admit_accepted);
+	wmsum_fini(&arc_sums.arcstat_admit_rejected);
+	wmsum_fini(&arc_sums.arcstat_admit_accepted_hits);
+	wmsum_fini(&arc_sums.arcstat_admit_rejected_hits);
 	wmsum_fini(&arc_sums.arcstat_deleted);
 	wmsum_fini(&arc_sums.arcstat_mutex_miss);
 	wmsum_fini(&arc_sums.arcstat_access_skip);
@@ -7889,6 +8739,7 @@ arc_state_fini(void)
 	wmsum_fini(&arc_sums.arcstat_hash_elements);
 	wmsum_fini(&arc_sums.arcstat_hash_collisions);
 	wmsum_fini(&arc_sums.arcstat_hash_chains);
+	wmsum_fini(&arc_sums.arcstat_hash_lock_contended);
 	aggsum_fini(&arc_sums.arcstat_size);
 	wmsum_fini(&arc_sums.arcstat_compressed_size);
 	wmsum_fini(&arc_sums.arcstat_uncompressed_size);
@@ -8040,11 +8891,16 @@ arc_init(void)
 	arc_state_init();
 
 	buf_init();
+	arc_admit_init();
 
 	list_create(&arc_prune_list, sizeof (arc_prune_t),
 	    offsetof(arc_prune_t, p_node));
 	mutex_init(&arc_prune_mtx, NULL, MUTEX_DEFAULT, NULL);
 
+	avl_create(&arc_dataset_tree, arc_dataset_compare,
+	    sizeof (arc_dataset_t), offsetof(arc_dataset_t, ads_node));
+	rw_init(&arc_dataset_lock, NULL, RW_DEFAULT, NULL);
+
 	arc_prune_taskq = taskq_create("arc_prune", zfs_arc_prune_task_threads,
 	    defclsyspri, 100, INT_MAX, TASKQ_PREPOPULATE | TASKQ_DYNAMIC);
 
@@ -8067,10 +8923,14 @@ arc_init(void)
 
 	arc_state_evict_markers =
 	    arc_state_alloc_markers(arc_state_evict_marker_count);
+	arc_dataset_markers_init();
 	arc_evict_zthr = zthr_create_timer("arc_evict",
 	    arc_evict_cb_check, arc_evict_cb, NULL, SEC2NSEC(1), defclsyspri);
 	arc_reap_zthr = zthr_create_timer("arc_reap",
 	    arc_reap_cb_check, arc_reap_cb, NULL, SEC2NSEC(1), minclsyspri);
+	arc_hash_zthr = zthr_create_timer("arc_hash",
+	    arc_hash_resize_cb_check, arc_hash_resize_cb, NULL, SEC2NSEC(1),
+	    minclsyspri);
 
 	arc_warm = B_FALSE;
 
@@ -8150,13 +9010,18 @@ arc_fini(void)
 	list_destroy(&arc_prune_list);
 	mutex_destroy(&arc_prune_mtx);
 
+	avl_destroy(&arc_dataset_tree);
+	rw_destroy(&arc_dataset_lock);
+
 	if (arc_evict_taskq != NULL)
 		taskq_wait(arc_evict_taskq);
 
 	(void) zthr_cancel(arc_evict_zthr);
 	(void) zthr_cancel(arc_reap_zthr);
+	(void) zthr_cancel(arc_hash_zthr);
 	arc_state_free_markers(arc_state_evict_markers,
 	    arc_state_evict_marker_count);
+	arc_dataset_markers_fini();
 
 	if (arc_evict_taskq != NULL) {
 		taskq_destroy(arc_evict_taskq);
@@ -8179,6 +9044,7 @@ arc_fini(void)
 	 * trigger the release of kmem magazines, which can callback to
 	 * arc_space_return() which accesses aggsums freed in act_state_fini().
 	 */
+	arc_admit_fini();
 	buf_fini();
 	arc_state_fini();
 
@@ -8191,6 +9057,7 @@ arc_fini(void)
 	 */
 	zthr_destroy(arc_evict_zthr);
 	zthr_destroy(arc_reap_zthr);
+	zthr_destroy(arc_hash_zthr);
 
 	ASSERT0(arc_loaned_bytes);
 }
@@ -8305,7 +9172,9 @@ arc_fini(void)
  * 6. Writes to the L2ARC devices are grouped and sent in-sequence, so that
  * the vdev queue can aggregate them into larger and fewer writes.  Each
  * device is written to in a rotor fashion, sweeping writes through
- * available space then repeating.
+ * available space then repeating.  Devices are fed independently of each
+ * other, each on its own interval and by its own task, so that the total
+ * write rate grows with the number of L2ARC devices.
  *
  * 7. The L2ARC does not store dirty content.  It never needs to flush
  * write buffers back to disk based storage.
@@ -8326,6 +9195,7 @@ arc_fini(void)
  *				since more compressed buffers are likely to
  *				be present
  *	l2arc_feed_secs		seconds between L2ARC writing
+ *	l2arc_feed_threads	max number of devices fed in parallel
  *
  * Tunables may be removed or added as future performance improvements are
  * integrated, and also may become zpool properties.
@@ -8532,13 +9402,17 @@ l2arc_dev_invalid(const l2arc_dev_t *dev)
 }
 
 /*
- * Cycle through L2ARC devices.  This is how L2ARC load balances.
+ * Find an L2ARC device that is due to be fed and mark it as being fed.
+ * Every device is fed on its own schedule, so that the L2ARC fill rate
+ * scales with the number of cache devices.  The earliest time at which one
+ * of the devices not returned becomes due is folded into *wakeup.
  * If a device is returned, this also returns holding the spa config lock.
  */
 static l2arc_dev_t *
-l2arc_dev_get_next(void)
+l2arc_dev_get_due(clock_t *wakeup)
 {
-	l2arc_dev_t *first, *next = NULL;
+	l2arc_dev_t *dev;
+	clock_t now = ddi_get_lbolt();
 
 	/*
 	 * Lock out the removal of spas (spa_namespace_lock), then removal
@@ -8548,49 +9422,28 @@ l2arc_dev_get_next(void)
 	mutex_enter(&spa_namespace_lock);
 	mutex_enter(&l2arc_dev_mtx);
 
-	/* if there are no vdevs, there is nothing to do */
-	if (l2arc_ndev == 0)
-		goto out;
-
-	first = NULL;
-	next = l2arc_dev_last;
-	do {
-		/* loop around the list looking for a non-faulted vdev */
-		if (next == NULL) {
-			next = list_head(l2arc_dev_list);
-		} else {
-			next = list_next(l2arc_dev_list, next);
-			if (next == NULL)
-				next = list_head(l2arc_dev_list);
-		}
-
-		/* if we have come back to the start, bail out */
-		if (first == NULL)
-			first = next;
-		else if (next == first)
+	for (dev = list_head(l2arc_dev_list); dev != NULL;
+	    dev = list_next(l2arc_dev_list, dev)) {
+		if (dev->l2ad_feeding || l2arc_dev_invalid(dev))
+			continue;
+		if (dev->l2ad_feed_next <= now)
 			break;
+		*wakeup = MIN(*wakeup, dev->l2ad_feed_next);
+	}
+	if (dev != NULL)
+		dev->l2ad_feeding = B_TRUE;
 
-		ASSERT3P(next, !=, NULL);
-	} while (l2arc_dev_invalid(next));
-
-	/* if we were unable to find any usable vdevs, return NULL */
-	if (l2arc_dev_invalid(next))
-		next = NULL;
-
-	l2arc_dev_last = next;
-
-out:
 	mutex_exit(&l2arc_dev_mtx);
 
 	/*
-	 * Grab the config lock to prevent the 'next' device from being
-	 * removed while we are writing to it.
+	 * Grab the config lock to prevent the device from being removed
+	 * while we are writing to it.
 	 */
-	if (next != NULL)
-		spa_config_enter(next->l2ad_spa, SCL_L2ARC, next, RW_READER);
+	if (dev != NULL)
+		spa_config_enter(dev->l2ad_spa, SCL_L2ARC, dev, RW_READER);
 	mutex_exit(&spa_namespace_lock);
 
-	return (next);
+	return (dev);
 }
 
 /*
@@ -9258,8 +10111,10 @@ retry:
 		ASSERT(!HDR_L2_WRITING(hdr));
 		ASSERT(!HDR_L2_WRITE_HEAD(hdr));
 
-		if (!all && (hdr->b_l2hdr.b_daddr >= dev->l2ad_evict ||
-		    hdr->b_l2hdr.b_daddr < dev->l2ad_hand)) {
+		uint64_t daddr = L2HDR_GET_DADDR(&hdr->b_l2hdr);
+
+		if (!all && (daddr >= dev->l2ad_evict ||
+		    daddr < dev->l2ad_hand)) {
 			/*
 			 * We've evicted to the target address,
 			 * or the end of the device.
@@ -9622,11 +10477,12 @@ skip:
 				l2arc_free_abd_on_write(to_write, asize, type);
 			}
 
-			hdr->b_l2hdr.b_dev = dev;
-			hdr->b_l2hdr.b_daddr = dev->l2ad_hand;
-			hdr->b_l2hdr.b_hits = 0;
-			hdr->b_l2hdr.b_arcs_state =
-			    hdr->b_l1hdr.b_state->arcs_state;
+			hdr->b_l2hdr.b_prop = 0;
+			L2HDR_SET_DEV_ID(&hdr->b_l2hdr, dev->l2ad_id);
+			L2HDR_SET_DADDR(&hdr->b_l2hdr, dev->l2ad_hand);
+			L2HDR_SET_STATE(&hdr->b_l2hdr,
+			    hdr->b_l1hdr.b_state->arcs_state);
+			hdr->b_l2hits = 0;
 			/* l2arc_hdr_arcstats_update() expects a valid asize */
 			HDR_SET_L2SIZE(hdr, asize);
 			arc_hdr_set_flags(hdr, ARC_FLAG_HAS_L2HDR |
@@ -9747,9 +10603,81 @@ l2arc_hdr_limit_reached(void)
 	    (s > (arc_warm ? arc_c : arc_c_max) * l2arc_meta_percent / 100));
 }
 
+/*
+ * Feed a single L2ARC device.  Dispatched by l2arc_feed_thread() with the
+ * device marked as being fed and its spa config lock held; both are
+ * released here once the next feed has been scheduled.
+ */
+static void
+l2arc_feed_dev(void *arg)
+{
+	l2arc_dev_t *dev = arg;
+	spa_t *spa = dev->l2ad_spa;
+	uint64_t size, wrote;
+	clock_t begin, next;
+	fstrans_cookie_t cookie;
+
+	ASSERT3P(spa, !=, NULL);
+	ASSERT(dev->l2ad_feeding);
+
+	cookie = spl_fstrans_mark();
+	begin = ddi_get_lbolt();
+
+	if (!spa_writeable(spa)) {
+		/*
+		 * If the pool is read-only then feed this device a little
+		 * less often.
+		 */
+		next = begin + 5 * l2arc_feed_secs * hz;
+	} else if (l2arc_hdr_limit_reached()) {
+		/*
+		 * Avoid contributing to memory pressure.
+		 */
+		ARCSTAT_BUMP(arcstat_l2_abort_lowmem);
+		next = begin + hz;
+	} else {
+		ARCSTAT_BUMP(arcstat_l2_feeds);
+
+		size = l2arc_write_size(dev);
+
+		/*
+		 * Evict L2ARC buffers that will be overwritten.
+		 */
+		l2arc_evict(dev, size, B_FALSE);
+
+		/*
+		 * Write ARC buffers.
+		 */
+		wrote = l2arc_write_buffers(spa, dev, size);
+
+		/*
+		 * Calculate interval between writes.
+		 */
+		next = l2arc_write_interval(begin, size, wrote);
+	}
+	spl_fstrans_unmark(cookie);
+
+	/*
+	 * The device may be removed as soon as the config lock is dropped,
+	 * so it must not be touched afterwards.
+	 */
+	mutex_enter(&l2arc_dev_mtx);
+	dev->l2ad_feed_next = next;
+	dev->l2ad_feeding = B_FALSE;
+	mutex_exit(&l2arc_dev_mtx);
+	spa_config_exit(spa, SCL_L2ARC, dev);
+
+	/* Let the feed thread schedule the next feed of this device. */
+	mutex_enter(&l2arc_feed_thr_lock);
+	cv_signal(&l2arc_feed_thr_cv);
+	mutex_exit(&l2arc_feed_thr_lock);
+}
+
 /*
  * This thread feeds the L2ARC at regular intervals.  This is the beating
- * heart of the L2ARC.
+ * heart of the L2ARC.  The writes themselves are done by l2arc_feed_dev()
+ * on the l2arc_feed_taskq, one task per device, so that devices are fed
+ * in parallel and a slow device does not hold up the others.
  */
 static  __attribute__((noreturn)) void
 l2arc_feed_thread(void *unused)
@@ -9757,16 +10685,12 @@ l2arc_feed_thread(void *unused)
 	(void) unused;
 	callb_cpr_t cpr;
 	l2arc_dev_t *dev;
-	spa_t *spa;
-	uint64_t size, wrote;
-	clock_t begin, next = ddi_get_lbolt();
-	fstrans_cookie_t cookie;
+	clock_t next = ddi_get_lbolt();
 
 	CALLB_CPR_INIT(&cpr, &l2arc_feed_thr_lock, callb_generic_cpr, FTAG);
 
 	mutex_enter(&l2arc_feed_thr_lock);
 
-	cookie = spl_fstrans_mark();
 	while (l2arc_thread_exit == 0) {
 		CALLB_CPR_SAFE_BEGIN(&cpr);
 		(void) cv_timedwait_idle(&l2arc_feed_thr_cv,
@@ -9783,64 +10707,19 @@ l2arc_feed_thread(void *unused)
 			continue;
 		}
 		mutex_exit(&l2arc_dev_mtx);
-		begin = ddi_get_lbolt();
-
-		/*
-		 * This selects the next l2arc device to write to, and in
-		 * doing so the next spa to feed from: dev->l2ad_spa.   This
-		 * will return NULL if there are now no l2arc devices or if
-		 * they are all faulted.
-		 *
-		 * If a device is returned, its spa's config lock is also
-		 * held to prevent device removal.  l2arc_dev_get_next()
-		 * will grab and release l2arc_dev_mtx.
-		 */
-		if ((dev = l2arc_dev_get_next()) == NULL)
-			continue;
-
-		spa = dev->l2ad_spa;
-		ASSERT3P(spa, !=, NULL);
-
-		/*
-		 * If the pool is read-only then force the feed thread to
-		 * sleep a little longer.
-		 */
-		if (!spa_writeable(spa)) {
-			next = ddi_get_lbolt() + 5 * l2arc_feed_secs * hz;
-			spa_config_exit(spa, SCL_L2ARC, dev);
-			continue;
-		}
 
 		/*
-		 * Avoid contributing to memory pressure.
+		 * Hand every device that is due to the feed taskq.  Each of
+		 * them is returned with its spa's config lock held to prevent
+		 * device removal, which l2arc_feed_dev() drops when done.
+		 * Devices that are still being fed are skipped; their task
+		 * wakes us up again when it finishes.
 		 */
-		if (l2arc_hdr_limit_reached()) {
-			ARCSTAT_BUMP(arcstat_l2_abort_lowmem);
-			spa_config_exit(spa, SCL_L2ARC, dev);
-			continue;
+		while ((dev = l2arc_dev_get_due(&next)) != NULL) {
+			taskq_dispatch_ent(l2arc_feed_taskq, l2arc_feed_dev,
+			    dev, TQ_SLEEP, &dev->l2ad_feed_tqent);
 		}
-
-		ARCSTAT_BUMP(arcstat_l2_feeds);
-
-		size = l2arc_write_size(dev);
-
-		/*
-		 * Evict L2ARC buffers that will be overwritten.
-		 */
-		l2arc_evict(dev, size, B_FALSE);
-
-		/*
-		 * Write ARC buffers.
-		 */
-		wrote = l2arc_write_buffers(spa, dev, size);
-
-		/*
-		 * Calculate interval between writes.
-		 */
-		next = l2arc_write_interval(begin, size, wrote);
-		spa_config_exit(spa, SCL_L2ARC, dev);
 	}
-	spl_fstrans_unmark(cookie);
 
 	l2arc_thread_exit = 0;
 	cv_broadcast(&l2arc_feed_thr_cv);
@@ -9963,6 +10842,7 @@ l2arc_add_vdev(spa_t *spa, vdev_t *vd)
 {
 	l2arc_dev_t		*adddev;
 	uint64_t		l2dhdr_asize;
+	uint_t			id;
 
 	ASSERT(!l2arc_vdev_present(vd));
 
@@ -9970,6 +10850,27 @@ l2arc_add_vdev(spa_t *spa, vdev_t *vd)
 	 * Create a new l2arc device entry.
 	 */
 	adddev = vmem_zalloc(sizeof (l2arc_dev_t), KM_SLEEP);
+
+	/*
+	 * Reserve an id for the headers of the device.  Should they ever
+	 * run out, the device is left unused like one that failed to open.
+	 */
+	mutex_enter(&l2arc_dev_mtx);
+	for (id = 1; id <= L2ARC_DEV_ID_MAX; id++) {
+		if (l2arc_dev_ids[id] == NULL)
+			break;
+	}
+	if (id > L2ARC_DEV_ID_MAX) {
+		mutex_exit(&l2arc_dev_mtx);
+		vmem_free(adddev, sizeof (l2arc_dev_t));
+		zfs_dbgmsg("l2arc: no device id left for vdev %llu",
+		    (u_longlong_t)vd->vdev_guid);
+		return;
+	}
+	l2arc_dev_ids[id] = adddev;
+	mutex_exit(&l2arc_dev_mtx);
+	adddev->l2ad_id = id;
+
 	adddev->l2ad_spa = spa;
 	adddev->l2ad_vdev = vd;
 	/* leave extra size for an l2arc device header */
@@ -9978,11 +10879,15 @@ l2arc_add_vdev(spa_t *spa, vdev_t *vd)
 	adddev->l2ad_start = VDEV_LABEL_START_SIZE + l2dhdr_asize;
 	adddev->l2ad_end = VDEV_LABEL_START_SIZE + vdev_get_min_asize(vd);
 	ASSERT3U(adddev->l2ad_start, <, adddev->l2ad_end);
+	ASSERT3U(adddev->l2ad_end, <=, 1ULL << (50 + SPA_MINBLOCKSHIFT));
 	adddev->l2ad_hand = adddev->l2ad_start;
 	adddev->l2ad_evict = adddev->l2ad_start;
 	adddev->l2ad_first = B_TRUE;
 	adddev->l2ad_writing = B_FALSE;
 	adddev->l2ad_trim_all = B_FALSE;
+	adddev->l2ad_feeding = B_FALSE;
+	adddev->l2ad_feed_next = ddi_get_lbolt();
+	taskq_init_ent(&adddev->l2ad_feed_tqent);
 	list_link_init(&adddev->l2ad_node);
 	adddev->l2ad_dev_hdr = kmem_zalloc(l2dhdr_asize, KM_SLEEP);
 
@@ -10081,6 +10986,11 @@ l2arc_device_teardown(void *arg)
 	zfs_refcount_destroy(&remdev->l2ad_lb_asize);
 	zfs_refcount_destroy(&remdev->l2ad_lb_count);
 	kmem_free(remdev->l2ad_dev_hdr, remdev->l2ad_dev_hdr_asize);
+
+	mutex_enter(&l2arc_dev_mtx);
+	ASSERT3P(l2arc_dev_ids[remdev->l2ad_id], ==, remdev);
+	l2arc_dev_ids[remdev->l2ad_id] = NULL;
+	mutex_exit(&l2arc_dev_mtx);
 	vmem_free(remdev, sizeof (l2arc_dev_t));
 
 	uint64_t elaspsed = NSEC2MSEC(gethrtime() - start_time);
@@ -10138,8 +11048,8 @@ l2arc_remove_vdev(vdev_t *vd)
 	 */
 	ASSERT(spa_config_held(spa, SCL_L2ARC, RW_WRITER) & SCL_L2ARC);
 	mutex_enter(&l2arc_dev_mtx);
+	ASSERT(!remdev->l2ad_feeding);
 	list_remove(l2arc_dev_list, remdev);
-	l2arc_dev_last = NULL;		/* may have been invalidated */
 	atomic_dec_64(&l2arc_ndev);
 
 	/* During a pool export spa & vdev will no longer be valid */
@@ -10201,6 +11111,9 @@ l2arc_start(void)
 	if (!(spa_mode_global & SPA_MODE_WRITE))
 		return;
 
+	l2arc_feed_taskq = taskq_create("l2arc_feed",
+	    MAX(l2arc_feed_threads, 1), defclsyspri, 1, INT_MAX,
+	    TASKQ_DYNAMIC);
 	(void) thread_create(NULL, 0, l2arc_feed_thread, NULL, 0, &p0,
 	    TS_RUN, defclsyspri);
 }
@@ -10217,6 +11130,10 @@ l2arc_stop(void)
 	while (l2arc_thread_exit != 0)
 		cv_wait(&l2arc_feed_thr_cv, &l2arc_feed_thr_lock);
 	mutex_exit(&l2arc_feed_thr_lock);
+
+	/* Wait for the devices that are still being fed. */
+	taskq_destroy(l2arc_feed_taskq);
+	l2arc_feed_taskq = NULL;
 }
 
 /*
@@ -10820,10 +11737,11 @@ l2arc_hdr_restore(const l2arc_log_ent_phys_t *le, l2arc_dev_t *dev)
 		 */
 		if (!HDR_HAS_L2HDR(exists)) {
 			arc_hdr_set_flags(exists, ARC_FLAG_HAS_L2HDR);
-			exists->b_l2hdr.b_dev = dev;
-			exists->b_l2hdr.b_daddr = le->le_daddr;
-			exists->b_l2hdr.b_arcs_state =
-			    L2BLK_GET_STATE((le)->le_prop);
+			exists->b_l2hdr.b_prop = 0;
+			L2HDR_SET_DEV_ID(&exists->b_l2hdr, dev->l2ad_id);
+			L2HDR_SET_DADDR(&exists->b_l2hdr, le->le_daddr);
+			L2HDR_SET_STATE(&exists->b_l2hdr,
+			    L2BLK_GET_STATE((le)->le_prop));
 			/* l2arc_hdr_arcstats_update() expects a valid asize */
 			HDR_SET_L2SIZE(exists, asize);
 			mutex_enter(&dev->l2ad_mtx);
@@ -11121,7 +12039,7 @@ l2arc_log_blk_insert(l2arc_dev_t *dev, const arc_buf_hdr_t *hdr)
 	memset(le, 0, sizeof (*le));
 	le->le_dva = hdr->b_dva;
 	le->le_birth = hdr->b_birth;
-	le->le_daddr = hdr->b_l2hdr.b_daddr;
+	le->le_daddr = L2HDR_GET_DADDR(&hdr->b_l2hdr);
 	if (index == 0)
 		dev->l2ad_log_blk_payload_start = le->le_daddr;
 	L2BLK_SET_LSIZE((le)->le_prop, HDR_GET_LSIZE(hdr));
@@ -11131,7 +12049,7 @@ l2arc_log_blk_insert(l2arc_dev_t *dev, const arc_buf_hdr_t *hdr)
 	L2BLK_SET_TYPE((le)->le_prop, hdr->b_type);
 	L2BLK_SET_PROTECTED((le)->le_prop, !!(HDR_PROTECTED(hdr)));
 	L2BLK_SET_PREFETCH((le)->le_prop, !!(HDR_PREFETCH(hdr)));
-	L2BLK_SET_STATE((le)->le_prop, hdr->b_l2hdr.b_arcs_state);
+	L2BLK_SET_STATE((le)->le_prop, L2HDR_GET_STATE(&hdr->b_l2hdr));
 
 	dev->l2ad_log_blk_payload_asize += vdev_psize_to_asize(dev->l2ad_vdev,
 	    HDR_GET_PSIZE(hdr));
@@ -11210,6 +12128,9 @@ ZFS_MODULE_PARAM(zfs_arc, zfs_arc_, pc_percent, UINT, ZMOD_RW,
 ZFS_MODULE_PARAM(zfs_arc, zfs_arc_, average_blocksize, UINT, ZMOD_RD,
 	"Target average block size");
 
+ZFS_MODULE_PARAM(zfs_arc, zfs_arc_, hash_max_load, UINT, ZMOD_RW,
+	"Average headers per ARC hash bucket before the table is grown");
+
 ZFS_MODULE_PARAM(zfs, zfs_, compressed_arc_enabled, INT, ZMOD_RW,
 	"Disable compressed ARC buffers");
 
@@ -11250,6 +12171,9 @@ ZFS_MODULE_PARAM(zfs_l2arc, l2arc_, feed_again, INT, ZMOD_RW,
 ZFS_MODULE_PARAM(zfs_l2arc, l2arc_, norw, INT, ZMOD_RW,
 	"No reads during writes");
 
+ZFS_MODULE_PARAM(zfs_l2arc, l2arc_, feed_threads, UINT, ZMOD_RW,
+	"Max number of L2ARC devices fed in parallel");
+
 ZFS_MODULE_PARAM(zfs_l2arc, l2arc_, meta_percent, UINT, ZMOD_RW,
 	"Percent of ARC size allowed for L2ARC-only headers");
 
@@ -11287,6 +12211,12 @@ ZFS_MODULE_PARAM(zfs_arc, zfs_arc_, eviction_pct, UINT, ZMOD_RW,
 ZFS_MODULE_PARAM(zfs_arc, zfs_arc_, evict_batch_limit, UINT, ZMOD_RW,
 	"The number of headers to evict per sublist before moving to the next");
 
+ZFS_MODULE_PARAM(zfs_arc, zfs_arc_, dataset_scan_limit, UINT, ZMOD_RW,
+	"The number of headers to scan per sublist when enforcing arc_quota");
+
+ZFS_MODULE_PARAM(zfs_arc, zfs_arc_, admit, INT, ZMOD_RW,
+	"Only admit data blocks read before into a full ARC");
+
 ZFS_MODULE_PARAM(zfs_arc, zfs_arc_, prune_task_threads, INT, ZMOD_RW,
 	"Number of arc_prune threads");
 
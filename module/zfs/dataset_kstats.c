@@ -30,6 +30,9 @@
 #include <sys/dsl_dataset.h>
 #include <sys/spa.h>
 
+/* Room for the name of the current compression=auto candidate */
+#define	DATASET_COMPRESS_AUTO_NAMELEN	16
+
 static dataset_kstat_values_t empty_dataset_kstats = {
 	{ "dataset_name",	KSTAT_DATA_STRING },
 	{ "writes",	KSTAT_DATA_UINT64 },
@@ -38,6 +41,13 @@ static dataset_kstat_values_t empty_dataset_kstats = {
 	{ "nread",	KSTAT_DATA_UINT64 },
 	{ "nunlinks",	KSTAT_DATA_UINT64 },
 	{ "nunlinked",	KSTAT_DATA_UINT64 },
+	{ "iolimit_read_delayed",	KSTAT_DATA_UINT64 },
+	{ "iolimit_read_delay_us",	KSTAT_DATA_UINT64 },
+	{ "iolimit_write_delayed",	KSTAT_DATA_UINT64 },
+	{ "iolimit_write_delay_us",	KSTAT_DATA_UINT64 },
+	{ "arc_size",	KSTAT_DATA_UINT64 },
+	{ "arc_hits",	KSTAT_DATA_UINT64 },
+	{ "arc_misses",	KSTAT_DATA_UINT64 },
 	{
 	{ "zil_commit_count",			KSTAT_DATA_UINT64 },
 	{ "zil_commit_writer_count",		KSTAT_DATA_UINT64 },
@@ -45,6 +55,8 @@ static dataset_kstat_values_t empty_dataset_kstats = {
 	{ "zil_commit_stall_count",		KSTAT_DATA_UINT64 },
 	{ "zil_commit_suspend_count",		KSTAT_DATA_UINT64 },
 	{ "zil_itx_count",			KSTAT_DATA_UINT64 },
+	{ "zil_itx_assign_count",		KSTAT_DATA_UINT64 },
+	{ "zil_itx_assign_contended",		KSTAT_DATA_UINT64 },
 	{ "zil_itx_indirect_count",		KSTAT_DATA_UINT64 },
 	{ "zil_itx_indirect_bytes",		KSTAT_DATA_UINT64 },
 	{ "zil_itx_copied_count",		KSTAT_DATA_UINT64 },
@@ -58,7 +70,53 @@ static dataset_kstat_values_t empty_dataset_kstats = {
 	{ "zil_itx_metaslab_slog_count",	KSTAT_DATA_UINT64 },
 	{ "zil_itx_metaslab_slog_bytes",	KSTAT_DATA_UINT64 },
 	{ "zil_itx_metaslab_slog_write",	KSTAT_DATA_UINT64 },
-	{ "zil_itx_metaslab_slog_alloc",	KSTAT_DATA_UINT64 }
+	{ "zil_itx_metaslab_slog_alloc",	KSTAT_DATA_UINT64 },
+	{ "zil_replay_count",			KSTAT_DATA_UINT64 },
+	{ "zil_replay_parallel_count",		KSTAT_DATA_UINT64 },
+	{ "zil_replay_bytes",			KSTAT_DATA_UINT64 },
+	{ "zil_replay_time_ms",			KSTAT_DATA_UINT64 }
+	},
+	{
+	{ "compress_auto_current",		KSTAT_DATA_STRING },
+	{ "compress_auto_switches",		KSTAT_DATA_UINT64 },
+	{
+	{
+	{ "compress_auto_off_blocks",		KSTAT_DATA_UINT64 },
+	{ "compress_auto_off_samples",		KSTAT_DATA_UINT64 },
+	{ "compress_auto_off_ratio",		KSTAT_DATA_UINT64 },
+	{ "compress_auto_off_mbps",		KSTAT_DATA_UINT64 }
+	},
+	{
+	{ "compress_auto_lz4_blocks",		KSTAT_DATA_UINT64 },
+	{ "compress_auto_lz4_samples",		KSTAT_DATA_UINT64 },
+	{ "compress_auto_lz4_ratio",		KSTAT_DATA_UINT64 },
+	{ "compress_auto_lz4_mbps",		KSTAT_DATA_UINT64 }
+	},
+	{
+	{ "compress_auto_zstd1_blocks",		KSTAT_DATA_UINT64 },
+	{ "compress_auto_zstd1_samples",	KSTAT_DATA_UINT64 },
+	{ "compress_auto_zstd1_ratio",		KSTAT_DATA_UINT64 },
+	{ "compress_auto_zstd1_mbps",		KSTAT_DATA_UINT64 }
+	},
+	{
+	{ "compress_auto_zstd3_blocks",		KSTAT_DATA_UINT64 },
+	{ "compress_auto_zstd3_samples",	KSTAT_DATA_UINT64 },
+	{ "compress_auto_zstd3_ratio",		KSTAT_DATA_UINT64 },
+	{ "compress_auto_zstd3_mbps",		KSTAT_DATA_UINT64 }
+	},
+	{
+	{ "compress_auto_zstd6_blocks",		KSTAT_DATA_UINT64 },
+	{ "compress_auto_zstd6_samples",	KSTAT_DATA_UINT64 },
+	{ "compress_auto_zstd6_ratio",		KSTAT_DATA_UINT64 },
+	{ "compress_auto_zstd6_mbps",		KSTAT_DATA_UINT64 }
+	},
+	{
+	{ "compress_auto_zstd9_blocks",		KSTAT_DATA_UINT64 },
+	{ "compress_auto_zstd9_samples",	KSTAT_DATA_UINT64 },
+	{ "compress_auto_zstd9_ratio",		KSTAT_DATA_UINT64 },
+	{ "compress_auto_zstd9_mbps",		KSTAT_DATA_UINT64 }
+	}
+	}
 	}
 };
 
@@ -84,9 +142,46 @@ dataset_kstats_update(kstat_t *ksp, int rw)
 	    wmsum_value(&dk->dk_sums.dss_nunlinks);
 	dkv->dkv_nunlinked.value.ui64 =
 	    wmsum_value(&dk->dk_sums.dss_nunlinked);
+	dkv->dkv_iolimit_read_delayed.value.ui64 =
+	    wmsum_value(&dk->dk_sums.dss_iolimit_read_delayed);
+	dkv->dkv_iolimit_read_delay_us.value.ui64 =
+	    NSEC2USEC(wmsum_value(&dk->dk_sums.dss_iolimit_read_delay));
+	dkv->dkv_iolimit_write_delayed.value.ui64 =
+	    wmsum_value(&dk->dk_sums.dss_iolimit_write_delayed);
+	dkv->dkv_iolimit_write_delay_us.value.ui64 =
+	    NSEC2USEC(wmsum_value(&dk->dk_sums.dss_iolimit_write_delay));
+
+	if (dk->dk_arc_dataset != NULL) {
+		arc_dataset_stats(dk->dk_arc_dataset,
+		    &dkv->dkv_arc_size.value.ui64,
+		    &dkv->dkv_arc_hits.value.ui64,
+		    &dkv->dkv_arc_misses.value.ui64);
+	}
 
 	zil_kstat_values_update(&dkv->dkv_zil_stats, &dk->dk_zil_sums);
 
+	if (dk->dk_compress_auto != NULL) {
+		dataset_compress_auto_kstat_values_t *dcak =
+		    &dkv->dkv_compress_auto;
+		zio_compress_auto_stats_t zcas;
+
+		zio_compress_auto_stats(dk->dk_compress_auto, &zcas);
+		(void) strlcpy(KSTAT_NAMED_STR_PTR(&dcak->dcak_current),
+		    zio_compress_auto_name(zcas.zcas_current),
+		    KSTAT_NAMED_STR_BUFLEN(&dcak->dcak_current));
+		dcak->dcak_switches.value.ui64 = zcas.zcas_switches;
+		for (uint_t i = 0; i < ZIO_COMPRESS_AUTO_CANDIDATES; i++) {
+			dcak->dcak_cand[i].dcak_blocks.value.ui64 =
+			    zcas.zcas_blocks[i];
+			dcak->dcak_cand[i].dcak_samples.value.ui64 =
+			    zcas.zcas_samples[i];
+			dcak->dcak_cand[i].dcak_ratio.value.ui64 =
+			    zcas.zcas_ratio[i];
+			dcak->dcak_cand[i].dcak_mbps.value.ui64 =
+			    zcas.zcas_mbps[i];
+		}
+	}
+
 	return (0);
 }
 
@@ -162,10 +257,29 @@ dataset_kstats_create(dataset_kstats_t *dk, objset_t *objset)
 	KSTAT_NAMED_STR_BUFLEN(&dk_kstats->dkv_ds_name) =
 	    ZFS_MAX_DATASET_NAME_LEN;
 
+	dataset_compress_auto_kstat_values_t *dcak =
+	    &dk_kstats->dkv_compress_auto;
+	KSTAT_NAMED_STR_PTR(&dcak->dcak_current) =
+	    kmem_zalloc(DATASET_COMPRESS_AUTO_NAMELEN, KM_SLEEP);
+	KSTAT_NAMED_STR_BUFLEN(&dcak->dcak_current) =
+	    DATASET_COMPRESS_AUTO_NAMELEN;
+
 	kstat->ks_data = dk_kstats;
 	kstat->ks_update = dataset_kstats_update;
 	kstat->ks_private = dk;
-	kstat->ks_data_size += ZFS_MAX_DATASET_NAME_LEN;
+	kstat->ks_data_size += ZFS_MAX_DATASET_NAME_LEN +
+	    DATASET_COMPRESS_AUTO_NAMELEN;
+
+	/*
+	 * The compression=auto state is owned by the objset, which may be
+	 * evicted before these kstats are destroyed; keep it around.
+	 */
+	dk->dk_compress_auto = objset->os_compress_auto;
+	if (dk->dk_compress_auto != NULL)
+		zio_compress_auto_hold(dk->dk_compress_auto);
+	dk->dk_arc_dataset = objset->os_arc_dataset;
+	if (dk->dk_arc_dataset != NULL)
+		arc_dataset_hold(dk->dk_arc_dataset);
 
 	wmsum_init(&dk->dk_sums.dss_writes, 0);
 	wmsum_init(&dk->dk_sums.dss_nwritten, 0);
@@ -173,6 +287,10 @@ dataset_kstats_create(dataset_kstats_t *dk, objset_t *objset)
 	wmsum_init(&dk->dk_sums.dss_nread, 0);
 	wmsum_init(&dk->dk_sums.dss_nunlinks, 0);
 	wmsum_init(&dk->dk_sums.dss_nunlinked, 0);
+	wmsum_init(&dk->dk_sums.dss_iolimit_read_delayed, 0);
+	wmsum_init(&dk->dk_sums.dss_iolimit_read_delay, 0);
+	wmsum_init(&dk->dk_sums.dss_iolimit_write_delayed, 0);
+	wmsum_init(&dk->dk_sums.dss_iolimit_write_delay, 0);
 	zil_sums_init(&dk->dk_zil_sums);
 
 	dk->dk_kstats = kstat;
@@ -191,14 +309,29 @@ dataset_kstats_destroy(dataset_kstats_t *dk)
 	dk->dk_kstats = NULL;
 	kmem_free(KSTAT_NAMED_STR_PTR(&dkv->dkv_ds_name),
 	    KSTAT_NAMED_STR_BUFLEN(&dkv->dkv_ds_name));
+	kmem_free(KSTAT_NAMED_STR_PTR(&dkv->dkv_compress_auto.dcak_current),
+	    KSTAT_NAMED_STR_BUFLEN(&dkv->dkv_compress_auto.dcak_current));
 	kmem_free(dkv, sizeof (empty_dataset_kstats));
 
+	if (dk->dk_compress_auto != NULL) {
+		zio_compress_auto_rele(dk->dk_compress_auto);
+		dk->dk_compress_auto = NULL;
+	}
+	if (dk->dk_arc_dataset != NULL) {
+		arc_dataset_rele(dk->dk_arc_dataset);
+		dk->dk_arc_dataset = NULL;
+	}
+
 	wmsum_fini(&dk->dk_sums.dss_writes);
 	wmsum_fini(&dk->dk_sums.dss_nwritten);
 	wmsum_fini(&dk->dk_sums.dss_reads);
 	wmsum_fini(&dk->dk_sums.dss_nread);
 	wmsum_fini(&dk->dk_sums.dss_nunlinks);
 	wmsum_fini(&dk->dk_sums.dss_nunlinked);
+	wmsum_fini(&dk->dk_sums.dss_iolimit_read_delayed);
+	wmsum_fini(&dk->dk_sums.dss_iolimit_read_delay);
+	wmsum_fini(&dk->dk_sums.dss_iolimit_write_delayed);
+	wmsum_fini(&dk->dk_sums.dss_iolimit_write_delay);
 	zil_sums_fini(&dk->dk_zil_sums);
 }
 
@@ -241,6 +374,24 @@ dataset_kstats_update_read_kstats(dataset_kstats_t *dk, int64_t nread)
 	wmsum_add(&dk->dk_sums.dss_nread, nread);
 }
 
+void
+dataset_kstats_update_iolimit_kstats(dataset_kstats_t *dk, boolean_t write,
+    hrtime_t delay)
+{
+	ASSERT3S(delay, >=, 0);
+
+	if (dk->dk_kstats == NULL || delay == 0)
+		return;
+
+	if (write) {
+		wmsum_add(&dk->dk_sums.dss_iolimit_write_delayed, 1);
+		wmsum_add(&dk->dk_sums.dss_iolimit_write_delay, delay);
+	} else {
+		wmsum_add(&dk->dk_sums.dss_iolimit_read_delayed, 1);
+		wmsum_add(&dk->dk_sums.dss_iolimit_read_delay, delay);
+	}
+}
+
 void
 dataset_kstats_update_nunlinks_kstat(dataset_kstats_t *dk, int64_t delta)
 {
@@ -235,7 +235,7 @@ static uint64_t dbuf_metadata_cache_max_bytes = UINT64_MAX;
 static uint_t dbuf_cache_shift = 5;
 static uint_t dbuf_metadata_cache_shift = 6;
 
-/* Set the dbuf hash mutex count as log2 shift (dynamic by default) */
+/* Set the dbuf hash lock count as log2 shift (dynamic by default) */
 static uint_t dbuf_mutex_cache_shift = 0;
 
 static unsigned long dbuf_cache_target_bytes(void);
@@ -351,18 +351,18 @@ dbuf_find(objset_t *os, uint64_t obj, uint8_t level, uint64_t blkid,
 	hv = dbuf_hash(os, obj, level, blkid);
 	idx = hv & h->hash_table_mask;
 
-	mutex_enter(DBUF_HASH_MUTEX(h, idx));
+	rw_enter(DBUF_HASH_RWLOCK(h, idx), RW_READER);
 	for (db = h->hash_table[idx]; db != NULL; db = db->db_hash_next) {
 		if (DBUF_EQUAL(db, os, obj, level, blkid)) {
 			mutex_enter(&db->db_mtx);
 			if (db->db_state != DB_EVICTING) {
-				mutex_exit(DBUF_HASH_MUTEX(h, idx));
+				rw_exit(DBUF_HASH_RWLOCK(h, idx));
 				return (db);
 			}
 			mutex_exit(&db->db_mtx);
 		}
 	}
-	mutex_exit(DBUF_HASH_MUTEX(h, idx));
+	rw_exit(DBUF_HASH_RWLOCK(h, idx));
 	if (hash_out != NULL)
 		*hash_out = hv;
 	return (NULL);
@@ -407,13 +407,13 @@ dbuf_hash_insert(dmu_buf_impl_t *db)
 	ASSERT3U(dbuf_hash(os, obj, level, blkid), ==, db->db_hash);
 	idx = db->db_hash & h->hash_table_mask;
 
-	mutex_enter(DBUF_HASH_MUTEX(h, idx));
+	rw_enter(DBUF_HASH_RWLOCK(h, idx), RW_WRITER);
 	for (dbf = h->hash_table[idx], i = 0; dbf != NULL;
 	    dbf = dbf->db_hash_next, i++) {
 		if (DBUF_EQUAL(dbf, os, obj, level, blkid)) {
 			mutex_enter(&dbf->db_mtx);
 			if (dbf->db_state != DB_EVICTING) {
-				mutex_exit(DBUF_HASH_MUTEX(h, idx));
+				rw_exit(DBUF_HASH_RWLOCK(h, idx));
 				return (dbf);
 			}
 			mutex_exit(&dbf->db_mtx);
@@ -431,7 +431,7 @@ dbuf_hash_insert(dmu_buf_impl_t *db)
 	mutex_enter(&db->db_mtx);
 	db->db_hash_next = h->hash_table[idx];
 	h->hash_table[idx] = db;
-	mutex_exit(DBUF_HASH_MUTEX(h, idx));
+	rw_exit(DBUF_HASH_RWLOCK(h, idx));
 	DBUF_STAT_BUMP(hash_elements);
 
 	return (NULL);
@@ -487,13 +487,13 @@ dbuf_hash_remove(dmu_buf_impl_t *db)
 
 	/*
 	 * We mustn't hold db_mtx to maintain lock ordering:
-	 * DBUF_HASH_MUTEX > db_mtx.
+	 * DBUF_HASH_RWLOCK > db_mtx.
 	 */
 	ASSERT(zfs_refcount_is_zero(&db->db_holds));
 	ASSERT(db->db_state == DB_EVICTING);
 	ASSERT(!MUTEX_HELD(&db->db_mtx));
 
-	mutex_enter(DBUF_HASH_MUTEX(h, idx));
+	rw_enter(DBUF_HASH_RWLOCK(h, idx), RW_WRITER);
 	dbp = &h->hash_table[idx];
 	while ((dbf = *dbp) != db) {
 		dbp = &dbf->db_hash_next;
@@ -504,7 +504,7 @@ dbuf_hash_remove(dmu_buf_impl_t *db)
 	if (h->hash_table[idx] &&
 	    h->hash_table[idx]->db_hash_next == NULL)
 		DBUF_STAT_BUMPDOWN(hash_chains);
-	mutex_exit(DBUF_HASH_MUTEX(h, idx));
+	rw_exit(DBUF_HASH_RWLOCK(h, idx));
 	DBUF_STAT_BUMPDOWN(hash_elements);
 }
 
@@ -922,7 +922,7 @@ dbuf_kstat_update(kstat_t *ksp, int rw)
 	ds->hash_insert_race.value.ui64 =
 	    wmsum_value(&dbuf_sums.hash_insert_race);
 	ds->hash_table_count.value.ui64 = h->hash_table_mask + 1;
-	ds->hash_mutex_count.value.ui64 = h->hash_mutex_mask + 1;
+	ds->hash_mutex_count.value.ui64 = h->hash_rwlock_mask + 1;
 	ds->metadata_cache_count.value.ui64 =
 	    wmsum_value(&dbuf_sums.metadata_cache_count);
 	ds->metadata_cache_size_bytes.value.ui64 = zfs_refcount_count(
@@ -959,8 +959,8 @@ dbuf_init(void)
 	}
 
 	/*
-	 * The hash table buckets are protected by an array of mutexes where
-	 * each mutex is reponsible for protecting 128 buckets.  A minimum
+	 * The hash table buckets are protected by an array of rwlocks where
+	 * each lock is reponsible for protecting 128 buckets.  A minimum
 	 * array size of 8192 is targeted to avoid contention.
 	 */
 	if (dbuf_mutex_cache_shift == 0)
@@ -968,13 +968,13 @@ dbuf_init(void)
 	else
 		hmsize = 1ULL << MIN(dbuf_mutex_cache_shift, 24);
 
-	h->hash_mutexes = NULL;
-	while (h->hash_mutexes == NULL) {
-		h->hash_mutex_mask = hmsize - 1;
+	h->hash_rwlocks = NULL;
+	while (h->hash_rwlocks == NULL) {
+		h->hash_rwlock_mask = hmsize - 1;
 
-		h->hash_mutexes = vmem_zalloc(hmsize * sizeof (kmutex_t),
+		h->hash_rwlocks = vmem_zalloc(hmsize * sizeof (krwlock_t),
 		    KM_SLEEP);
-		if (h->hash_mutexes == NULL)
+		if (h->hash_rwlocks == NULL)
 			hmsize >>= 1;
 	}
 
@@ -985,7 +985,7 @@ dbuf_init(void)
 	    sizeof (dbuf_dirty_record_t), 0, NULL, NULL, NULL, NULL, NULL, 0);
 
 	for (int i = 0; i < hmsize; i++)
-		mutex_init(&h->hash_mutexes[i], NULL, MUTEX_NOLOCKDEP, NULL);
+		rw_init(&h->hash_rwlocks[i], NULL, RW_NOLOCKDEP, NULL);
 
 	dbuf_stats_init(h);
 
@@ -1051,12 +1051,12 @@ dbuf_fini(void)
 
 	dbuf_stats_destroy();
 
-	for (int i = 0; i < (h->hash_mutex_mask + 1); i++)
-		mutex_destroy(&h->hash_mutexes[i]);
+	for (int i = 0; i < (h->hash_rwlock_mask + 1); i++)
+		rw_destroy(&h->hash_rwlocks[i]);
 
 	vmem_free(h->hash_table, (h->hash_table_mask + 1) * sizeof (void *));
-	vmem_free(h->hash_mutexes, (h->hash_mutex_mask + 1) *
-	    sizeof (kmutex_t));
+	vmem_free(h->hash_rwlocks, (h->hash_rwlock_mask + 1) *
+	    sizeof (krwlock_t));
 
 	kmem_cache_destroy(dbuf_kmem_cache);
 	kmem_cache_destroy(dbuf_dirty_kmem_cache);
@@ -2321,6 +2321,7 @@ dmu_write_policy(objset_t *os, dnode_t *dn, int level, int wp, zio_prop_t *zp)
 	enum zio_checksum checksum = os->os_checksum;
 	enum zio_compress compress = os->os_compress;
 	uint8_t complevel = os->os_complevel;
+	zio_compress_auto_t *compress_auto = NULL;
 	enum zio_checksum dedup_checksum = os->os_dedup_checksum;
 	boolean_t dedup = B_FALSE;
 	boolean_t nopwrite = B_FALSE;
@@ -2422,6 +2423,19 @@ dmu_write_policy(objset_t *os, dnode_t *dn, int level, int wp, zio_prop_t *zp)
 		complevel = zio_complevel_select(os->os_spa, compress,
 		    complevel, complevel);
 
+		/*
+		 * compression=auto is stored as a reserved zstd level, have
+		 * the objset pick the actual algorithm and level for this
+		 * block.
+		 */
+		if (compress == ZIO_COMPRESS_ZSTD &&
+		    complevel == ZIO_ZSTD_LEVEL_AUTO &&
+		    os->os_compress_auto != NULL) {
+			compress_auto = os->os_compress_auto;
+			zio_compress_auto_select(compress_auto, &compress,
+			    &complevel);
+		}
+
 		/*
 		 * Storing many references to an all zeros block in the dedup
 		 * table would be expensive.  Instead, if dedup is enabled,
@@ -2496,6 +2510,7 @@ dmu_write_policy(objset_t *os, dnode_t *dn, int level, int wp, zio_prop_t *zp)
 
 	zp->zp_compress = compress;
 	zp->zp_complevel = complevel;
+	zp->zp_compress_auto = compress_auto;
 	zp->zp_checksum = checksum;
 	zp->zp_type = (wp & WP_SPILL) ? dn->dn_bonustype : type;
 	zp->zp_level = level;
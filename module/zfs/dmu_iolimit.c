@@ -0,0 +1,229 @@
+// SPDX-License-Identifier: CDDL-1.0
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at usr/src/OPENSOLARIS.LICENSE
+ * or https://opensource.org/licenses/CDDL-1.0.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at usr/src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*
+ * Per dataset I/O limits.
+ *
+ * The iolimit_read_bps, iolimit_write_bps, iolimit_read_iops and
+ * iolimit_write_iops properties are inherited like any other dsl_prop and
+ * cached in the objset by the callbacks registered in
+ * dmu_objset_open_impl().  The ZPL (zfs_read(), zfs_write()) calls
+ * dmu_objset_iolimit() before it locks the range it accesses, and it puts
+ * the calling thread to sleep for as long as it takes for the request to
+ * fit into the limits.  zvols use dmu_objset_iolimit_charge() and sleep
+ * themselves, see zvol_iolimit().
+ *
+ * Each limit is a token bucket, implemented as a virtual clock: every
+ * request moves dib_tat, the time at which the bucket would be empty again,
+ * forward by the time the limit allows for its size, and the caller sleeps
+ * until dib_tat is no longer in the future.  Idle time is credited for up
+ * to zfs_iolimit_burst_ms, so that short bursts above the limit pass
+ * without delay.  A request is charged to both its bandwidth and its IOPS
+ * bucket and waits for whichever is further behind.
+ *
+ * The number of delayed requests and the time spent sleeping are exported
+ * through the dataset kstats (see dataset_kstats.c).
+ */
+
+#include <sys/zfs_context.h>
+#include <sys/dmu_objset.h>
+
+/* Idle time credited to a bucket, i.e. how long a burst may exceed it */
+static uint_t zfs_iolimit_burst_ms = 1000;
+
+/* Slack allowed when sleeping, like zfs_sleep_until() */
+#define	DMU_IOLIMIT_RESOLUTION	USEC2NSEC(100)
+
+void
+dmu_iolimit_init(dmu_iolimit_t *dil)
+{
+	mutex_init(&dil->dil_lock, NULL, MUTEX_DEFAULT, NULL);
+	cv_init(&dil->dil_cv, NULL, CV_DEFAULT, NULL);
+	dil->dil_gen = 0;
+	for (int t = 0; t < DMU_IOLIMIT_TYPES; t++) {
+		dil->dil_bucket[t].dib_limit = 0;
+		dil->dil_bucket[t].dib_tat = 0;
+	}
+}
+
+void
+dmu_iolimit_fini(dmu_iolimit_t *dil)
+{
+	cv_destroy(&dil->dil_cv);
+	mutex_destroy(&dil->dil_lock);
+}
+
+/*
+ * Called by the property callbacks.  The bucket starts out full, and
+ * threads sleeping under the old limit are woken up to go ahead.
+ */
+void
+dmu_iolimit_set(dmu_iolimit_t *dil, dmu_iolimit_type_t type, uint64_t limit)
+{
+	ASSERT3U(type, <, DMU_IOLIMIT_TYPES);
+
+	mutex_enter(&dil->dil_lock);
+	dil->dil_bucket[type].dib_limit = limit;
+	dil->dil_bucket[type].dib_tat = 0;
+	dil->dil_gen++;
+	cv_broadcast(&dil->dil_cv);
+	mutex_exit(&dil->dil_lock);
+}
+
+/*
+ * Time the limit allows for amount, i.e. amount * NANOSEC / limit without
+ * overflowing for any realistic amount.
+ */
+static hrtime_t
+dmu_iolimit_cost(uint64_t amount, uint64_t limit)
+{
+	uint64_t whole = amount / limit;
+	uint64_t rem = amount % limit;
+
+	if (rem <= UINT64_MAX / NANOSEC)
+		return (whole * NANOSEC + rem * NANOSEC / limit);
+	return (whole * NANOSEC + rem / (limit / NANOSEC));
+}
+
+/*
+ * Charge amount to a bucket and return how long the caller must wait.
+ */
+static hrtime_t
+dmu_iolimit_charge(dmu_iolimit_bucket_t *dib, uint64_t amount, hrtime_t now)
+{
+	hrtime_t burst = MSEC2NSEC(zfs_iolimit_burst_ms);
+
+	if (dib->dib_limit == 0)
+		return (0);
+
+	dib->dib_tat = MAX(dib->dib_tat, now - burst) +
+	    dmu_iolimit_cost(amount, dib->dib_limit);
+
+	return (MAX(dib->dib_tat - now, 0));
+}
+
+/*
+ * Whether a read or write is subject to any limit of the objset.
+ */
+static boolean_t
+dmu_iolimit_limited(dmu_iolimit_t *dil, boolean_t write)
+{
+	return (dil->dil_bucket[write ?
+	    DMU_IOLIMIT_WRITE_BPS : DMU_IOLIMIT_READ_BPS].dib_limit != 0 ||
+	    dil->dil_bucket[write ?
+	    DMU_IOLIMIT_WRITE_IOPS : DMU_IOLIMIT_READ_IOPS].dib_limit != 0);
+}
+
+/*
+ * Charge a read or write of bytes to its buckets and return the time until
+ * which the caller has to wait.
+ */
+static hrtime_t
+dmu_iolimit_account(dmu_iolimit_t *dil, boolean_t write, uint64_t bytes,
+    hrtime_t now)
+{
+	ASSERT(MUTEX_HELD(&dil->dil_lock));
+
+	return (now + MAX(dmu_iolimit_charge(&dil->dil_bucket[write ?
+	    DMU_IOLIMIT_WRITE_BPS : DMU_IOLIMIT_READ_BPS], bytes, now),
+	    dmu_iolimit_charge(&dil->dil_bucket[write ?
+	    DMU_IOLIMIT_WRITE_IOPS : DMU_IOLIMIT_READ_IOPS], 1, now)));
+}
+
+/*
+ * Account a read or write of bytes against the limits of the objset and
+ * sleep until it is allowed to proceed.  The time slept is returned in
+ * delayp.  If interruptible is set, a signal ends the wait with EINTR.
+ */
+int
+dmu_objset_iolimit(objset_t *os, boolean_t write, uint64_t bytes,
+    boolean_t interruptible, hrtime_t *delayp)
+{
+	dmu_iolimit_t *dil = &os->os_iolimit;
+	hrtime_t start, now, wakeup;
+	uint64_t gen;
+	int error = 0;
+
+	*delayp = 0;
+	if (!dmu_iolimit_limited(dil, write))
+		return (0);
+
+	mutex_enter(&dil->dil_lock);
+	start = now = gethrtime();
+	wakeup = dmu_iolimit_account(dil, write, bytes, now);
+	gen = dil->dil_gen;
+
+	while (error == 0 && now < wakeup && dil->dil_gen == gen) {
+		if (interruptible) {
+			if (cv_timedwait_sig_hires(&dil->dil_cv,
+			    &dil->dil_lock, wakeup, DMU_IOLIMIT_RESOLUTION,
+			    CALLOUT_FLAG_ABSOLUTE) == 0)
+				error = SET_ERROR(EINTR);
+		} else {
+			(void) cv_timedwait_hires(&dil->dil_cv,
+			    &dil->dil_lock, wakeup, DMU_IOLIMIT_RESOLUTION,
+			    CALLOUT_FLAG_ABSOLUTE);
+		}
+		now = gethrtime();
+	}
+	mutex_exit(&dil->dil_lock);
+
+	*delayp = now - start;
+	return (error);
+}
+
+/*
+ * Like dmu_objset_iolimit(), but return the time until which the caller
+ * has to wait instead of sleeping, for callers that must not sleep on the
+ * objset (see zvol_iolimit()).  The generation of the limits is returned in
+ * genp, for dmu_objset_iolimit_changed().  Returns 0 if there is no limit.
+ */
+hrtime_t
+dmu_objset_iolimit_charge(objset_t *os, boolean_t write, uint64_t bytes,
+    uint64_t *genp)
+{
+	dmu_iolimit_t *dil = &os->os_iolimit;
+	hrtime_t wakeup;
+
+	if (!dmu_iolimit_limited(dil, write))
+		return (0);
+
+	mutex_enter(&dil->dil_lock);
+	wakeup = dmu_iolimit_account(dil, write, bytes, gethrtime());
+	*genp = dil->dil_gen;
+	mutex_exit(&dil->dil_lock);
+
+	return (wakeup);
+}
+
+/*
+ * Whether the limits changed since dmu_objset_iolimit_charge() returned gen,
+ * in which case the caller may go ahead.
+ */
+boolean_t
+dmu_objset_iolimit_changed(objset_t *os, uint64_t gen)
+{
+	return (os->os_iolimit.dil_gen != gen);
+}
+
+ZFS_MODULE_PARAM(zfs, zfs_, iolimit_burst_ms, UINT, ZMOD_RW,
+	"Time a dataset may exceed its iolimit_* properties in a burst");
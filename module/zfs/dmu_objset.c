@@ -65,6 +65,7 @@
 #include <sys/spa_impl.h>
 #include <sys/dmu_recv.h>
 #include <sys/zfs_project.h>
+#include <sys/zio_compress.h>
 #include "zfs_namecheck.h"
 #include <sys/vdev_impl.h>
 #include <sys/arc.h>
@@ -388,6 +389,70 @@ recordsize_changed_cb(void *arg, uint64_t newval)
 	os->os_recordsize = newval;
 }
 
+static void
+iolimit_read_bps_changed_cb(void *arg, uint64_t newval)
+{
+	objset_t *os = arg;
+
+	dmu_iolimit_set(&os->os_iolimit, DMU_IOLIMIT_READ_BPS, newval);
+}
+
+static void
+iolimit_write_bps_changed_cb(void *arg, uint64_t newval)
+{
+	objset_t *os = arg;
+
+	dmu_iolimit_set(&os->os_iolimit, DMU_IOLIMIT_WRITE_BPS, newval);
+}
+
+static void
+iolimit_read_iops_changed_cb(void *arg, uint64_t newval)
+{
+	objset_t *os = arg;
+
+	dmu_iolimit_set(&os->os_iolimit, DMU_IOLIMIT_READ_IOPS, newval);
+}
+
+static void
+iolimit_write_iops_changed_cb(void *arg, uint64_t newval)
+{
+	objset_t *os = arg;
+
+	dmu_iolimit_set(&os->os_iolimit, DMU_IOLIMIT_WRITE_IOPS, newval);
+}
+
+static void
+arc_quota_changed_cb(void *arg, uint64_t newval)
+{
+	objset_t *os = arg;
+
+	arc_dataset_set_quota(os->os_arc_dataset, newval);
+}
+
+static void
+arc_reservation_changed_cb(void *arg, uint64_t newval)
+{
+	objset_t *os = arg;
+
+	arc_dataset_set_reservation(os->os_arc_dataset, newval);
+}
+
+/*
+ * The ARC's accounting may outlive the objset while its blocks are still
+ * cached, but the limits only apply while the dataset is open.
+ */
+static void
+dmu_objset_arc_dataset_rele(objset_t *os)
+{
+	if (os->os_arc_dataset == NULL)
+		return;
+
+	arc_dataset_set_quota(os->os_arc_dataset, 0);
+	arc_dataset_set_reservation(os->os_arc_dataset, 0);
+	arc_dataset_rele(os->os_arc_dataset);
+	os->os_arc_dataset = NULL;
+}
+
 void
 dmu_objset_byteswap(void *buf, size_t size)
 {
@@ -561,6 +626,7 @@ dmu_objset_open_impl(spa_t *spa, dsl_dataset_t *ds, blkptr_t *bp,
 	os->os_normalization = OBJSET_PROP_UNINITIALIZED;
 	os->os_utf8only = OBJSET_PROP_UNINITIALIZED;
 	os->os_casesensitivity = OBJSET_PROP_UNINITIALIZED;
+	dmu_iolimit_init(&os->os_iolimit);
 
 	/*
 	 * Note: the changed_cb will be called once before the register
@@ -585,6 +651,8 @@ dmu_objset_open_impl(spa_t *spa, dsl_dataset_t *ds, blkptr_t *bp,
 			    prefetch_changed_cb, os);
 		}
 		if (!ds->ds_is_snapshot) {
+			os->os_arc_dataset = arc_dataset_get(spa,
+			    ds->ds_object);
 			if (err == 0) {
 				err = dsl_prop_register(ds,
 				    zfs_prop_to_name(ZFS_PROP_CHECKSUM),
@@ -642,9 +710,44 @@ dmu_objset_open_impl(spa_t *spa, dsl_dataset_t *ds, blkptr_t *bp,
 				    zfs_prop_to_name(ZFS_PROP_DIRECT),
 				    direct_changed_cb, os);
 			}
+			if (err == 0) {
+				err = dsl_prop_register(ds,
+				    zfs_prop_to_name(ZFS_PROP_IOLIMIT_READ_BPS),
+				    iolimit_read_bps_changed_cb, os);
+			}
+			if (err == 0) {
+				err = dsl_prop_register(ds,
+				    zfs_prop_to_name(
+				    ZFS_PROP_IOLIMIT_WRITE_BPS),
+				    iolimit_write_bps_changed_cb, os);
+			}
+			if (err == 0) {
+				err = dsl_prop_register(ds,
+				    zfs_prop_to_name(
+				    ZFS_PROP_IOLIMIT_READ_IOPS),
+				    iolimit_read_iops_changed_cb, os);
+			}
+			if (err == 0) {
+				err = dsl_prop_register(ds,
+				    zfs_prop_to_name(
+				    ZFS_PROP_IOLIMIT_WRITE_IOPS),
+				    iolimit_write_iops_changed_cb, os);
+			}
+			if (err == 0) {
+				err = dsl_prop_register(ds,
+				    zfs_prop_to_name(ZFS_PROP_ARC_QUOTA),
+				    arc_quota_changed_cb, os);
+			}
+			if (err == 0) {
+				err = dsl_prop_register(ds,
+				    zfs_prop_to_name(ZFS_PROP_ARC_RESERVATION),
+				    arc_reservation_changed_cb, os);
+			}
 		}
 		if (err != 0) {
 			arc_buf_destroy(os->os_phys_buf, &os->os_phys_buf);
+			dmu_iolimit_fini(&os->os_iolimit);
+			dmu_objset_arc_dataset_rele(os);
 			kmem_free(os, sizeof (objset_t));
 			return (err);
 		}
@@ -688,6 +791,8 @@ dmu_objset_open_impl(spa_t *spa, dsl_dataset_t *ds, blkptr_t *bp,
 	os->os_obj_next_percpu_len = boot_ncpus;
 	os->os_obj_next_percpu = kmem_zalloc(os->os_obj_next_percpu_len *
 	    sizeof (os->os_obj_next_percpu[0]), KM_SLEEP);
+	if (ds != NULL)
+		os->os_compress_auto = zio_compress_auto_alloc();
 
 	dnode_special_open(os, &os->os_phys->os_meta_dnode,
 	    DMU_META_DNODE_OBJECT, &os->os_meta_dnode);
@@ -1058,6 +1163,10 @@ dmu_objset_evict_done(objset_t *os)
 
 	kmem_free(os->os_obj_next_percpu,
 	    os->os_obj_next_percpu_len * sizeof (os->os_obj_next_percpu[0]));
+	if (os->os_compress_auto != NULL)
+		zio_compress_auto_rele(os->os_compress_auto);
+	dmu_iolimit_fini(&os->os_iolimit);
+	dmu_objset_arc_dataset_rele(os);
 
 	mutex_destroy(&os->os_lock);
 	mutex_destroy(&os->os_userused_lock);
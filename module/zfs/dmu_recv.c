@@ -74,6 +74,7 @@
 static uint_t zfs_recv_queue_length = SPA_MAXBLOCKSIZE;
 static uint_t zfs_recv_queue_ff = 20;
 static uint_t zfs_recv_write_batch_size = 1024 * 1024;
+static uint_t zfs_recv_writer_threads = 1;
 static int zfs_recv_best_effort_corrective = 0;
 
 static const void *const dmu_recv_tag = "dmu_recv_tag";
@@ -99,6 +100,7 @@ struct receive_record_arg {
 	int payload_size;
 	uint64_t bytes_read; /* bytes read from stream when record created */
 	boolean_t eos_marker; /* Marks the end of the stream */
+	boolean_t barrier_marker; /* Flush and report back to the dispatcher */
 	bqueue_node_t node;
 };
 
@@ -141,6 +143,18 @@ struct receive_writer_arg {
 
 	/* Keep track of DRR_FREEOBJECTS right after DRR_OBJECT_RANGE */
 	or_need_sync_t or_need_sync;
+
+	/*
+	 * Parallel receive (see receive_dispatch_record()).  The dispatcher
+	 * owns the workers array; each worker points back at it via parent
+	 * so errors can be reported.  barriers counts the barriers issued by
+	 * the dispatcher, or completed by a worker.
+	 */
+	struct receive_writer_arg *parent;
+	struct receive_writer_arg **workers;
+	uint_t nworkers;
+	uint64_t barriers;
+	boolean_t barrier_needed;
 };
 
 typedef struct dmu_recv_begin_arg {
@@ -3227,8 +3241,198 @@ receive_process_record(struct receive_writer_arg *rwa,
 }
 
 /*
- * dmu_recv_stream's worker thread; pull records off the queue, and then call
- * receive_process_record  When we're done, signal the main thread and exit.
+ * Record the first error hit by a writer.  A worker of a parallel receive
+ * also reports it to the dispatcher, which then stops handing out records
+ * and, through its own err, makes dmu_recv_stream() stop reading the stream.
+ */
+static void
+receive_writer_set_err(struct receive_writer_arg *rwa, int err)
+{
+	if (err == 0)
+		return;
+
+	if (rwa->parent != NULL) {
+		if (rwa->err == 0)
+			rwa->err = err;
+		rwa = rwa->parent;
+	}
+	mutex_enter(&rwa->mutex);
+	if (rwa->err == 0)
+		rwa->err = err;
+	mutex_exit(&rwa->mutex);
+}
+
+static boolean_t
+receive_writer_failed(struct receive_writer_arg *rwa)
+{
+	return (rwa->err != 0 ||
+	    (rwa->parent != NULL && rwa->parent->err != 0));
+}
+
+static void
+receive_free_record_payload(struct receive_record_arg *rrd)
+{
+	if (rrd->abd != NULL) {
+		abd_free(rrd->abd);
+		rrd->abd = NULL;
+		rrd->payload = NULL;
+	} else if (rrd->payload != NULL) {
+		kmem_free(rrd->payload, rrd->payload_size);
+		rrd->payload = NULL;
+	}
+}
+
+/*
+ * If the record only modifies objects within a single block of dnodes,
+ * return B_TRUE and the first such object.  All records for a given dnode
+ * block are applied by the same worker, which keeps their stream order and
+ * means a multi-slot dnode, and the slots it frees, never straddle workers.
+ */
+static boolean_t
+receive_record_object(const struct receive_record_arg *rrd, uint64_t *objp)
+{
+	const dmu_replay_record_t *drr = &rrd->header;
+
+	switch (drr->drr_type) {
+	case DRR_OBJECT:
+		*objp = drr->drr_u.drr_object.drr_object;
+		return (B_TRUE);
+	case DRR_WRITE:
+		*objp = drr->drr_u.drr_write.drr_object;
+		return (B_TRUE);
+	case DRR_WRITE_EMBEDDED:
+		*objp = drr->drr_u.drr_write_embedded.drr_object;
+		return (B_TRUE);
+	case DRR_FREE:
+		*objp = drr->drr_u.drr_free.drr_object;
+		return (B_TRUE);
+	case DRR_SPILL:
+		*objp = drr->drr_u.drr_spill.drr_object;
+		return (B_TRUE);
+	case DRR_REDACT:
+		*objp = drr->drr_u.drr_redact.drr_object;
+		return (B_TRUE);
+	case DRR_FREEOBJECTS:
+	{
+		const struct drr_freeobjects *drrfo =
+		    &drr->drr_u.drr_freeobjects;
+		uint64_t first = drrfo->drr_firstobj;
+		uint64_t last = first + MAX(drrfo->drr_numobjs, 1) - 1;
+
+		if (last < first || (first >> DNODES_PER_BLOCK_SHIFT) !=
+		    (last >> DNODES_PER_BLOCK_SHIFT))
+			return (B_FALSE);
+		*objp = first;
+		return (B_TRUE);
+	}
+	default:
+		return (B_FALSE);
+	}
+}
+
+/*
+ * Wait until every worker has applied all records dispatched to it so far,
+ * including its pending write batch.
+ */
+static void
+receive_writer_barrier(struct receive_writer_arg *rwa)
+{
+	if (!rwa->barrier_needed)
+		return;
+	rwa->barrier_needed = B_FALSE;
+	rwa->barriers++;
+
+	for (uint_t i = 0; i < rwa->nworkers; i++) {
+		struct receive_record_arg *rrd =
+		    kmem_zalloc(sizeof (*rrd), KM_SLEEP);
+		rrd->barrier_marker = B_TRUE;
+		bqueue_enqueue_flush(&rwa->workers[i]->q, rrd, 1);
+	}
+	for (uint_t i = 0; i < rwa->nworkers; i++) {
+		struct receive_writer_arg *w = rwa->workers[i];
+
+		mutex_enter(&w->mutex);
+		while (w->barriers < rwa->barriers)
+			cv_wait(&w->cv, &w->mutex);
+		mutex_exit(&w->mutex);
+	}
+}
+
+/*
+ * Parallel receive.  Records which only touch one dnode block are handed to
+ * the worker owning that block, and are applied concurrently with records
+ * for other blocks.  Everything else (FREEOBJECTS spanning blocks and any
+ * unexpected record) is a barrier: all workers are drained first and the
+ * record is then applied by the dispatcher itself, so it is ordered with
+ * respect to every record around it, exactly as in a serial receive.
+ *
+ * Returns EAGAIN when the record was handed off to a worker.
+ */
+static int
+receive_dispatch_record(struct receive_writer_arg *rwa,
+    struct receive_record_arg *rrd)
+{
+	uint64_t obj;
+
+	if (receive_record_object(rrd, &obj)) {
+		struct receive_writer_arg *w = rwa->workers[
+		    (obj >> DNODES_PER_BLOCK_SHIFT) % rwa->nworkers];
+
+		rwa->barrier_needed = B_TRUE;
+		bqueue_enqueue(&w->q, rrd,
+		    sizeof (struct receive_record_arg) + rrd->payload_size);
+		return (EAGAIN);
+	}
+
+	receive_writer_barrier(rwa);
+	if (rwa->err != 0) {
+		receive_free_record_payload(rrd);
+		return (0);
+	}
+	return (receive_process_record(rwa, rrd));
+}
+
+/*
+ * Stop the workers of a parallel receive and fold their state back into
+ * the dispatcher's.
+ */
+static void
+receive_writer_workers_fini(struct receive_writer_arg *rwa)
+{
+	for (uint_t i = 0; i < rwa->nworkers; i++) {
+		struct receive_record_arg *rrd =
+		    kmem_zalloc(sizeof (*rrd), KM_SLEEP);
+		rrd->eos_marker = B_TRUE;
+		bqueue_enqueue_flush(&rwa->workers[i]->q, rrd, 1);
+	}
+	for (uint_t i = 0; i < rwa->nworkers; i++) {
+		struct receive_writer_arg *w = rwa->workers[i];
+
+		mutex_enter(&w->mutex);
+		while (!w->done)
+			cv_wait(&w->cv, &w->mutex);
+		mutex_exit(&w->mutex);
+
+		rwa->max_object = MAX(rwa->max_object, w->max_object);
+		ASSERT(w->err == 0 || rwa->err != 0);
+
+		ASSERT(list_is_empty(&w->write_batch));
+		list_destroy(&w->write_batch);
+		bqueue_destroy(&w->q);
+		cv_destroy(&w->cv);
+		mutex_destroy(&w->mutex);
+		kmem_free(w, sizeof (*w));
+	}
+	kmem_free(rwa->workers, rwa->nworkers * sizeof (*rwa->workers));
+	rwa->workers = NULL;
+	rwa->nworkers = 0;
+}
+
+/*
+ * dmu_recv_stream's writer thread; pull records off the queue, and then call
+ * receive_process_record (or, for a parallel receive, hand them to the
+ * worker threads, which run this same loop).  When we're done, signal the
+ * main thread and exit.
  */
 static __attribute__((noreturn)) void
 receive_writer_thread(void *arg)
@@ -3244,37 +3448,43 @@ receive_writer_thread(void *arg)
 		 * on the queue, but we need to clear everything in it before we
 		 * can exit.
 		 */
+		if (rrd->barrier_marker) {
+			receive_writer_set_err(rwa, flush_write_batch(rwa));
+			kmem_free(rrd, sizeof (*rrd));
+			mutex_enter(&rwa->mutex);
+			rwa->barriers++;
+			cv_signal(&rwa->cv);
+			mutex_exit(&rwa->mutex);
+			continue;
+		}
+
 		int err = 0;
-		if (rwa->err == 0) {
+		if (receive_writer_failed(rwa))
+			receive_free_record_payload(rrd);
+		else if (rwa->nworkers > 1)
+			err = receive_dispatch_record(rwa, rrd);
+		else
 			err = receive_process_record(rwa, rrd);
-		} else if (rrd->abd != NULL) {
-			abd_free(rrd->abd);
-			rrd->abd = NULL;
-			rrd->payload = NULL;
-		} else if (rrd->payload != NULL) {
-			kmem_free(rrd->payload, rrd->payload_size);
-			rrd->payload = NULL;
-		}
 		/*
 		 * EAGAIN indicates that this record has been saved (on
-		 * raw->write_batch), and will be used again, so we don't
-		 * free it.
+		 * raw->write_batch) or handed to a worker, and will be used
+		 * again, so we don't free it.
 		 * When healing data we always need to free the record.
 		 */
 		if (err != EAGAIN || rwa->heal) {
-			if (rwa->err == 0)
-				rwa->err = err;
+			receive_writer_set_err(rwa, err);
 			kmem_free(rrd, sizeof (*rrd));
 		}
 	}
 	kmem_free(rrd, sizeof (*rrd));
 
+	if (rwa->nworkers > 1)
+		receive_writer_workers_fini(rwa);
+
 	if (rwa->heal) {
 		zio_wait(rwa->heal_pio);
 	} else {
-		int err = flush_write_batch(rwa);
-		if (rwa->err == 0)
-			rwa->err = err;
+		receive_writer_set_err(rwa, flush_write_batch(rwa));
 	}
 	mutex_enter(&rwa->mutex);
 	rwa->done = B_TRUE;
@@ -3284,6 +3494,47 @@ receive_writer_thread(void *arg)
 	thread_exit();
 }
 
+/*
+ * Start zfs_recv_writer_threads workers, each applying the records for its
+ * share of the dnode blocks.  Raw receives depend on the encryption
+ * parameters of the preceding DRR_OBJECT_RANGE, resumable receives on the
+ * resume state being saved in stream order, and healing receives issue
+ * their I/O asynchronously anyway, so those are always applied serially.
+ */
+static void
+receive_writer_workers_init(struct receive_writer_arg *rwa)
+{
+	uint_t nworkers = MIN(zfs_recv_writer_threads, (uint_t)boot_ncpus);
+
+	if (nworkers <= 1 || rwa->raw || rwa->resumable || rwa->heal)
+		return;
+
+	rwa->nworkers = nworkers;
+	rwa->workers = kmem_alloc(nworkers * sizeof (*rwa->workers), KM_SLEEP);
+	for (uint_t i = 0; i < nworkers; i++) {
+		struct receive_writer_arg *w = kmem_zalloc(sizeof (*w),
+		    KM_SLEEP);
+
+		(void) bqueue_init(&w->q, zfs_recv_queue_ff,
+		    MAX(zfs_recv_queue_length, 2 * zfs_max_recordsize),
+		    offsetof(struct receive_record_arg, node));
+		cv_init(&w->cv, NULL, CV_DEFAULT, NULL);
+		mutex_init(&w->mutex, NULL, MUTEX_DEFAULT, NULL);
+		w->os = rwa->os;
+		w->byteswap = rwa->byteswap;
+		w->tofs = rwa->tofs;
+		w->spill = rwa->spill;
+		w->full = rwa->full;
+		w->parent = rwa;
+		list_create(&w->write_batch, sizeof (struct receive_record_arg),
+		    offsetof(struct receive_record_arg, node.bqn_node));
+		rwa->workers[i] = w;
+
+		(void) thread_create(NULL, 0, receive_writer_thread, w, 0,
+		    curproc, TS_RUN, minclsyspri);
+	}
+}
+
 static int
 resume_check(dmu_recv_cookie_t *drc, nvlist_t *begin_nvl)
 {
@@ -3320,6 +3571,11 @@ resume_check(dmu_recv_cookie_t *drc, nvlist_t *begin_nvl)
  * thread doesn't have to wait for reads to complete, since everything it needs
  * (the indirect blocks) will be prefetched.
  *
+ * If zfs_recv_writer_threads is greater than one, the worker thread instead
+ * dispatches the records to that many writer threads by dnode block, so that
+ * records for different objects are applied concurrently.  See
+ * receive_dispatch_record().
+ *
  * NB: callers *must* call dmu_recv_end() if this succeeds.
  */
 int
@@ -3426,12 +3682,14 @@ dmu_recv_stream(dmu_recv_cookie_t *drc, offset_t *voffp)
 	}
 	list_create(&rwa->write_batch, sizeof (struct receive_record_arg),
 	    offsetof(struct receive_record_arg, node.bqn_node));
+	receive_writer_workers_init(rwa);
 
 	(void) thread_create(NULL, 0, receive_writer_thread, rwa, 0, curproc,
 	    TS_RUN, minclsyspri);
 	/*
 	 * We're reading rwa->err without locks, which is safe since we are the
-	 * only reader, and the worker thread is the only writer.  It's ok if we
+	 * only reader, and the writer threads only ever set it once (under
+	 * rwa->mutex if there are several of them).  It's ok if we
 	 * miss a write for an iteration or two of the loop, since the writer
 	 * thread will keep freeing records we send it until we send it an eos
 	 * marker.
@@ -3864,5 +4122,8 @@ ZFS_MODULE_PARAM(zfs_recv, zfs_recv_, queue_ff, UINT, ZMOD_RW,
 ZFS_MODULE_PARAM(zfs_recv, zfs_recv_, write_batch_size, UINT, ZMOD_RW,
 	"Maximum amount of writes to batch into one transaction");
 
+ZFS_MODULE_PARAM(zfs_recv, zfs_recv_, writer_threads, UINT, ZMOD_RW,
+	"Number of threads applying records of one receive");
+
 ZFS_MODULE_PARAM(zfs_recv, zfs_recv_, best_effort_corrective, INT, ZMOD_RW,
 	"Ignore errors during corrective receive");
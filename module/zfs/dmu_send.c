@@ -106,6 +106,24 @@ static const boolean_t zfs_send_set_freerecords_bit = B_TRUE;
 /* Set this tunable to FALSE is disable sending unmodified spill blocks. */
 static int zfs_send_unmodified_spill_blocks = B_TRUE;
 
+/*
+ * When the output supports it, blocks which are not cached in the ARC are
+ * read into scatter ABDs and handed to the output one chunk at a time,
+ * instead of first being gathered into a linear buffer.  Set this tunable
+ * to FALSE to always read into linear buffers.
+ */
+static int zfs_send_scatter_reads = B_TRUE;
+
+/*
+ * Number of threads traversing the dataset for a single send.  With more than
+ * one, the object space is split into chunks which are traversed concurrently
+ * (see send_traverse_parallel()).
+ */
+static uint_t zfs_send_traverse_threads = 1;
+
+/* Number of chunks per traversal thread, to balance uneven chunks */
+#define	SEND_TRAVERSE_CHUNKS_PER_THREAD	4
+
 static inline boolean_t
 overflow_multiply(uint64_t a, uint64_t b, uint64_t *c)
 {
@@ -125,6 +143,10 @@ struct send_thread_arg {
 	boolean_t	cancel;
 	zbookmark_phys_t resume;
 	uint64_t	*num_blocks_visited;
+	/* Set for the chunks of a parallel traversal */
+	struct send_thread_arg *parent;
+	uint64_t	start_object;	/* First object of the chunk */
+	uint64_t	end_object;	/* End of the chunk, 0 if unbounded */
 };
 
 struct redact_list_thread_arg {
@@ -258,9 +280,13 @@ range_free(struct send_range *range)
  * For all record types except BEGIN, fill in the checksum (overlaid in
  * drr_u.drr_checksum.drr_checksum).  The checksum verifies everything
  * up to the start of the checksum itself.
+ *
+ * The payload is either a linear buffer or, if the output has a
+ * dso_outfunc_abd, an ABD which is checksummed and written out in place.
  */
 static int
-dump_record(dmu_send_cookie_t *dscp, void *payload, int payload_len)
+dump_record_impl(dmu_send_cookie_t *dscp, void *payload, abd_t *payload_abd,
+    int payload_len)
 {
 	dmu_send_outparams_t *dso = dscp->dsc_dso;
 	ASSERT3U(offsetof(dmu_replay_record_t, drr_u.drr_checksum.drr_checksum),
@@ -292,7 +318,10 @@ dump_record(dmu_send_cookie_t *dscp, void *payload, int payload_len)
 		 * payload is null when dso_dryrun == B_TRUE (i.e. when we're
 		 * doing a send size calculation)
 		 */
-		if (payload != NULL) {
+		if (payload_abd != NULL) {
+			(void) abd_iterate_func(payload_abd, 0, payload_len,
+			    fletcher_4_incremental_native, &dscp->dsc_zc);
+		} else if (payload != NULL) {
 			(void) fletcher_4_incremental_native(
 			    payload, payload_len, &dscp->dsc_zc);
 		}
@@ -311,14 +340,26 @@ dump_record(dmu_send_cookie_t *dscp, void *payload, int payload_len)
 		ASSERT((payload_len % 8 == 0) ||
 		    (dscp->dsc_featureflags & DMU_BACKUP_FEATURE_RAW));
 
-		dscp->dsc_err = dso->dso_outfunc(dscp->dsc_os, payload,
-		    payload_len, dso->dso_arg);
+		if (payload_abd != NULL) {
+			ASSERT3P(dso->dso_outfunc_abd, !=, NULL);
+			dscp->dsc_err = dso->dso_outfunc_abd(dscp->dsc_os,
+			    payload_abd, payload_len, dso->dso_arg);
+		} else {
+			dscp->dsc_err = dso->dso_outfunc(dscp->dsc_os, payload,
+			    payload_len, dso->dso_arg);
+		}
 		if (dscp->dsc_err != 0)
 			return (SET_ERROR(EINTR));
 	}
 	return (0);
 }
 
+static int
+dump_record(dmu_send_cookie_t *dscp, void *payload, int payload_len)
+{
+	return (dump_record_impl(dscp, payload, NULL, payload_len));
+}
+
 /*
  * Fill in the drr_free struct, or perform aggregation if the previous record is
  * also a free record, and the two are adjacent.
@@ -457,7 +498,7 @@ dump_redact(dmu_send_cookie_t *dscp, uint64_t object, uint64_t offset,
 static int
 dmu_dump_write(dmu_send_cookie_t *dscp, dmu_object_type_t type, uint64_t object,
     uint64_t offset, int lsize, int psize, const blkptr_t *bp,
-    boolean_t io_compressed, void *data)
+    boolean_t io_compressed, void *data, abd_t *abd)
 {
 	uint64_t payload_size;
 	boolean_t raw = (dscp->dsc_featureflags & DMU_BACKUP_FEATURE_RAW);
@@ -556,7 +597,7 @@ dmu_dump_write(dmu_send_cookie_t *dscp, dmu_object_type_t type, uint64_t object,
 		drrw->drr_key.ddk_cksum = bp->blk_cksum;
 	}
 
-	if (dump_record(dscp, data, payload_size) != 0)
+	if (dump_record_impl(dscp, data, abd, payload_size) != 0)
 		return (SET_ERROR(EINTR));
 	return (0);
 }
@@ -960,14 +1001,19 @@ do_dump(dmu_send_cookie_t *dscp, struct send_range *range)
 		    srdp->abuf != NULL || srdp->abd != NULL);
 
 		char *data = NULL;
+		abd_t *abd = NULL;
 		if (srdp->abd != NULL) {
-			data = abd_to_buf(srdp->abd);
 			ASSERT3P(srdp->abuf, ==, NULL);
+			if (abd_is_linear(srdp->abd))
+				data = abd_to_buf(srdp->abd);
+			else
+				abd = srdp->abd;
 		} else if (srdp->abuf != NULL) {
 			data = srdp->abuf->b_data;
 		}
 
 		if (BP_GET_TYPE(bp) == DMU_OT_SA) {
+			ASSERT3P(abd, ==, NULL);
 			ASSERT3U(range->start_blkid, ==, DMU_SPILL_BLKID);
 			err = dump_spill(dscp, bp, range->object, data);
 			return (err);
@@ -983,12 +1029,13 @@ do_dump(dmu_send_cookie_t *dscp, struct send_range *range)
 		if (srdp->datablksz > SPA_OLD_MAXBLOCKSIZE &&
 		    !(dscp->dsc_featureflags &
 		    DMU_BACKUP_FEATURE_LARGE_BLOCKS)) {
+			ASSERT3P(abd, ==, NULL);
 			while (srdp->datablksz > 0 && err == 0) {
 				int n = MIN(srdp->datablksz,
 				    SPA_OLD_MAXBLOCKSIZE);
 				err = dmu_dump_write(dscp, srdp->obj_type,
 				    range->object, offset, n, n, NULL, B_FALSE,
-				    data);
+				    data, NULL);
 				offset += n;
 				/*
 				 * When doing dry run, data==NULL is used as a
@@ -1003,7 +1050,7 @@ do_dump(dmu_send_cookie_t *dscp, struct send_range *range)
 			err = dmu_dump_write(dscp, srdp->obj_type,
 			    range->object, offset,
 			    srdp->datablksz, srdp->datasz, bp,
-			    srdp->io_compressed, data);
+			    srdp->io_compressed, data, abd);
 		}
 		return (err);
 	}
@@ -1063,6 +1110,27 @@ range_alloc(enum type type, uint64_t object, uint64_t start_blkid,
 	return (range);
 }
 
+/*
+ * Returns B_TRUE if the block is past the end of the chunk traversed by sta.
+ * Since traverse_dataset() visits objects in order, the traversal of the
+ * chunk is over once the first such block is reached.
+ */
+static boolean_t
+send_cb_past_end(const struct send_thread_arg *sta, const zbookmark_phys_t *zb,
+    const struct dnode_phys *dnp)
+{
+	uint64_t first;
+
+	if (zb->zb_object != DMU_META_DNODE_OBJECT)
+		return (zb->zb_object >= sta->end_object);
+	if (zb->zb_level < 0)
+		return (B_FALSE);
+	if (!overflow_multiply(bp_span_in_blocks(dnp->dn_indblkshift,
+	    zb->zb_level), zb->zb_blkid, &first))
+		return (B_TRUE);
+	return (first >= sta->end_object >> DNODES_PER_BLOCK_SHIFT);
+}
+
 /*
  * This is the callback function to traverse_dataset that acts as a worker
  * thread for dmu_send_impl.
@@ -1078,6 +1146,9 @@ send_cb(spa_t *spa, zilog_t *zilog, const blkptr_t *bp,
 	ASSERT(zb->zb_object == DMU_META_DNODE_OBJECT ||
 	    zb->zb_object >= sta->resume.zb_object);
 
+	if (sta->end_object != 0 && send_cb_past_end(sta, zb, dnp))
+		return (SET_ERROR(EINTR));
+
 	/*
 	 * All bps of an encrypted os should have the encryption bit set.
 	 * If this is not true it indicates tampering and we report an error.
@@ -1088,7 +1159,7 @@ send_cb(spa_t *spa, zilog_t *zilog, const blkptr_t *bp,
 		return (SET_ERROR(EIO));
 	}
 
-	if (sta->cancel)
+	if (sta->cancel || (sta->parent != NULL && sta->parent->cancel))
 		return (SET_ERROR(EINTR));
 	if (zb->zb_object != DMU_META_DNODE_OBJECT &&
 	    DMU_OBJECT_IS_SPECIAL(zb->zb_object))
@@ -1145,8 +1216,25 @@ send_cb(spa_t *spa, zilog_t *zilog, const blkptr_t *bp,
 	else
 		record_type = DATA;
 
-	record = range_alloc(record_type, zb->zb_object, start,
-	    (start + span < start ? 0 : start + span), B_FALSE);
+	uint64_t end = (start + span < start ? 0 : start + span);
+
+	/*
+	 * Holes in the meta-dnode may cover several chunks of a parallel
+	 * traversal; clip them so that each chunk only frees its own objects.
+	 */
+	if (zb->zb_object == DMU_META_DNODE_OBJECT && sta->parent != NULL) {
+		uint64_t first_blk =
+		    sta->start_object >> DNODES_PER_BLOCK_SHIFT;
+		uint64_t end_blk = sta->end_object >> DNODES_PER_BLOCK_SHIFT;
+
+		start = MAX(start, first_blk);
+		if (end_blk != 0 && (end == 0 || end > end_blk))
+			end = end_blk;
+		if (end != 0 && start >= end)
+			return (0);
+	}
+
+	record = range_alloc(record_type, zb->zb_object, start, end, B_FALSE);
 
 	uint64_t datablksz = (zb->zb_blkid == DMU_SPILL_BLKID ?
 	    BP_GET_LSIZE(bp) : dnp->dn_datablkszsec << SPA_MINBLOCKSHIFT);
@@ -1200,8 +1288,8 @@ redact_list_cb(redact_block_phys_t *rb, void *arg)
  * error code of the thread in case something goes wrong, and pushes the End of
  * Stream record when the traverse_dataset call has finished.
  */
-static __attribute__((noreturn)) void
-send_traverse_thread(void *arg)
+static void
+send_traverse(void *arg)
 {
 	struct send_thread_arg *st_arg = arg;
 	int err = 0;
@@ -1217,6 +1305,112 @@ send_traverse_thread(void *arg)
 	data = range_alloc(DATA, 0, 0, 0, B_TRUE);
 	bqueue_enqueue_flush(&st_arg->q, data, sizeof (*data));
 	spl_fstrans_unmark(cookie);
+}
+
+/*
+ * Traverse the dataset with zfs_send_traverse_threads threads.  The object
+ * space from the resume point on is split into chunks, aligned to the span of
+ * a meta-dnode indirect block, which are traversed concurrently by a taskq,
+ * each into its own queue.  The chunks are dispatched in order and cover
+ * increasing, disjoint ranges of objects, so concatenating their output in
+ * chunk order yields exactly the records of a serial traversal; this thread
+ * does that, forwarding them to st_arg's queue.  The chunks' queues bound
+ * how far ahead of the consumer the traversal threads may run.
+ *
+ * Returns B_FALSE, without doing anything, if the dataset is too small to be
+ * worth splitting.
+ */
+static boolean_t
+send_traverse_parallel(struct send_thread_arg *st_arg)
+{
+	uint_t nthreads = MIN(zfs_send_traverse_threads, (uint_t)boot_ncpus);
+	dnode_t *mdn = DMU_META_DNODE(st_arg->os);
+	uint64_t first = st_arg->resume.zb_object;
+	uint64_t objects = (mdn->dn_maxblkid + 1) << DNODES_PER_BLOCK_SHIFT;
+	uint64_t align = bp_span_in_blocks(mdn->dn_indblkshift, 1) <<
+	    DNODES_PER_BLOCK_SHIFT;
+
+	if (nthreads <= 1 || objects <= first)
+		return (B_FALSE);
+
+	uint64_t chunk = roundup(MAX((objects - first) /
+	    (nthreads * SEND_TRAVERSE_CHUNKS_PER_THREAD), 1), align);
+	uint64_t nchunks = howmany(objects, chunk) - first / chunk;
+	if (nchunks <= 1)
+		return (B_FALSE);
+
+	struct send_thread_arg *chunks =
+	    kmem_zalloc(nchunks * sizeof (*chunks), KM_SLEEP);
+	taskq_t *tq = taskq_create("send_traverse", nthreads, minclsyspri,
+	    nthreads, INT_MAX, TASKQ_PREPOPULATE);
+
+	for (uint64_t i = 0; i < nchunks; i++) {
+		struct send_thread_arg *c = &chunks[i];
+
+		VERIFY0(bqueue_init(&c->q, zfs_send_no_prefetch_queue_ff,
+		    MAX(zfs_send_no_prefetch_queue_length,
+		    2 * zfs_max_recordsize), offsetof(struct send_range, ln)));
+		c->os = st_arg->os;
+		c->fromtxg = st_arg->fromtxg;
+		c->flags = st_arg->flags;
+		c->num_blocks_visited = st_arg->num_blocks_visited;
+		c->parent = st_arg;
+		if (i == 0) {
+			c->resume = st_arg->resume;
+		} else {
+			c->start_object = (first / chunk + i) * chunk;
+			SET_BOOKMARK(&c->resume, st_arg->resume.zb_objset,
+			    c->start_object, 0, 0);
+		}
+		if (i < nchunks - 1)
+			c->end_object = (first / chunk + i + 1) * chunk;
+		VERIFY3U(taskq_dispatch(tq, send_traverse, c, TQ_SLEEP), !=,
+		    TASKQID_INVALID);
+	}
+
+	int err = 0;
+	for (uint64_t i = 0; i < nchunks; i++) {
+		struct send_thread_arg *c = &chunks[i];
+		struct send_range *range;
+
+		for (range = bqueue_dequeue(&c->q); !range->eos_marker;
+		    range = bqueue_dequeue(&c->q)) {
+			if (err == 0 && !st_arg->cancel)
+				bqueue_enqueue(&st_arg->q, range,
+				    sizeof (*range));
+			else
+				range_free(range);
+		}
+		range_free(range);
+
+		/* Stop the remaining chunks after an error */
+		if (err == 0 && c->error_code != 0) {
+			err = c->error_code;
+			st_arg->cancel = B_TRUE;
+		}
+	}
+
+	taskq_wait(tq);
+	taskq_destroy(tq);
+	for (uint64_t i = 0; i < nchunks; i++)
+		bqueue_destroy(&chunks[i].q);
+	kmem_free(chunks, nchunks * sizeof (*chunks));
+
+	st_arg->error_code = err;
+	struct send_range *data = range_alloc(DATA, 0, 0, 0, B_TRUE);
+	bqueue_enqueue_flush(&st_arg->q, data, sizeof (*data));
+	return (B_TRUE);
+}
+
+static __attribute__((noreturn)) void
+send_traverse_thread(void *arg)
+{
+	struct send_thread_arg *st_arg = arg;
+	fstrans_cookie_t cookie = spl_fstrans_mark();
+
+	if (!send_traverse_parallel(st_arg))
+		send_traverse(st_arg);
+	spl_fstrans_unmark(cookie);
 	thread_exit();
 }
 
@@ -1563,6 +1757,7 @@ struct send_reader_thread_arg {
 	bqueue_t q;
 	boolean_t cancel;
 	boolean_t issue_reads;
+	boolean_t scatter_reads;
 	uint64_t featureflags;
 	int error;
 };
@@ -1657,7 +1852,15 @@ issue_data_read(struct send_reader_thread_arg *srta, struct send_range *range)
 	 * data that is not likely to be used in the future.
 	 */
 	if (arc_err != 0) {
-		srdp->abd = abd_alloc_linear(srdp->datasz, B_FALSE);
+		/*
+		 * Spill blocks and blocks which are split into smaller
+		 * records are consumed from a linear buffer by do_dump().
+		 */
+		if (srta->scatter_reads && !split_large_blocks &&
+		    BP_GET_TYPE(bp) != DMU_OT_SA)
+			srdp->abd = abd_alloc(srdp->datasz, B_FALSE);
+		else
+			srdp->abd = abd_alloc_linear(srdp->datasz, B_FALSE);
 		srdp->io_outstanding = B_TRUE;
 		zio_nowait(zio_read(NULL, os->os_spa, bp, srdp->abd,
 		    srdp->datasz, dmu_send_read_done, range,
@@ -2166,6 +2369,8 @@ setup_reader_thread(struct send_reader_thread_arg *srt_arg,
 	    offsetof(struct send_range, ln)));
 	srt_arg->smta = smt_arg;
 	srt_arg->issue_reads = !dspp->dso->dso_dryrun;
+	srt_arg->scatter_reads = zfs_send_scatter_reads &&
+	    dspp->dso->dso_outfunc_abd != NULL;
 	srt_arg->featureflags = featureflags;
 	(void) thread_create(NULL, 0, send_reader_thread, srt_arg, 0,
 	    curproc, TS_RUN, minclsyspri);
@@ -3127,6 +3332,12 @@ ZFS_MODULE_PARAM(zfs_send, zfs_send_, queue_length, UINT, ZMOD_RW,
 ZFS_MODULE_PARAM(zfs_send, zfs_send_, unmodified_spill_blocks, INT, ZMOD_RW,
 	"Send unmodified spill blocks");
 
+ZFS_MODULE_PARAM(zfs_send, zfs_send_, scatter_reads, INT, ZMOD_RW,
+	"Write uncached blocks to the send stream without linearizing them");
+
+ZFS_MODULE_PARAM(zfs_send, zfs_send_, traverse_threads, UINT, ZMOD_RW,
+	"Number of threads traversing the dataset for a single send");
+
 ZFS_MODULE_PARAM(zfs_send, zfs_send_, no_prefetch_queue_length, UINT, ZMOD_RW,
 	"Maximum send queue length for non-prefetch queues");
 
@@ -88,11 +88,18 @@
  * dsl_scan_sync() every spa_sync(). If we have either fully scanned all
  * metadata on the pool, or we need to make room in memory because our
  * queues are too large, dsl_scan_visit() is postponed and
- * scan_io_queues_run() is called from dsl_scan_sync() instead. This implies
- * that metadata scanning and queued I/O issuing are mutually exclusive. This
- * allows us to provide maximum sequential I/O throughput for the majority of
- * I/O's issued since sequential I/O performance is significantly negatively
- * impacted if it is interleaved with random I/O.
+ * scan_io_queues_run() is called from dsl_scan_sync() instead.
+ *
+ * With zfs_scan_concurrent_issue set (the default), the per-vdev issue
+ * threads also run while dsl_scan_visit() is scanning metadata, within the
+ * same txg time slice. Each of them only issues the largest extents of its
+ * queue, and only while the queue uses more than its share of the soft
+ * memory limit, so that the queues keep enough extents to sort and the
+ * time spent issuing mostly goes to large sequential I/Os. This keeps the
+ * disks busy during the scanning phase instead of leaving them to the
+ * random metadata reads, while the hard memory limit still forces the
+ * mutually exclusive clearing described above. Setting the tunable to 0
+ * restores the strictly alternating phases.
  *
  * Implementation Notes
  *
@@ -132,6 +139,7 @@ static void scan_ds_queue_remove(dsl_scan_t *scn, uint64_t dsobj);
 static void scan_ds_queue_sync(dsl_scan_t *scn, dmu_tx_t *tx);
 static uint64_t dsl_scan_count_data_disks(spa_t *spa);
 static void read_by_block_level(dsl_scan_t *scn, zbookmark_phys_t zb);
+static boolean_t scan_rate_pause(dsl_scan_t *scn);
 
 extern uint_t zfs_vdev_async_write_active_min_dirty_percent;
 static int zfs_scan_blkstats = 0;
@@ -163,10 +171,24 @@ static int zfs_scan_strict_mem_lim = B_FALSE;
  */
 static uint64_t zfs_scan_vdev_limit = 16 << 20;
 
+/*
+ * The scrub_rate pool and top-level vdev properties limit scan I/O in
+ * bytes/sec, see scan_rate_wait(). Up to SCAN_RATE_BURST worth of I/O may
+ * be issued at once, and waiting issuers look at the limits again every
+ * SCAN_RATE_POLL_MS, so that changes to them take effect right away.
+ * Unsorted scans are paced by dsl_scan_check_suspend() instead, since they
+ * issue I/O from syncing context.  Limits below SCAN_RATE_MIN are refused.
+ */
+#define	SCAN_RATE_BURST		MSEC2NSEC(100)
+#define	SCAN_RATE_POLL_MS	10
+
 static uint_t zfs_scan_issue_strategy = 0;
 
 /* don't queue & sort zios, go direct */
 static int zfs_scan_legacy = B_FALSE;
+
+/* issue sorted I/O while scanning metadata, see the comment at the top */
+static int zfs_scan_concurrent_issue = B_TRUE;
 static uint64_t zfs_scan_max_ext_gap = 2 << 20; /* in bytes */
 
 /*
@@ -335,6 +357,7 @@ struct dsl_scan_io_queue {
 	uint64_t	q_maxinflight_bytes;
 	uint64_t	q_inflight_bytes;
 	kcondvar_t	q_zio_cv; /* used under vd->vdev_scan_io_queue_lock */
+	dsl_scan_rate_t	q_rate;	/* vdev scrub_rate, under spa_scrub_lock */
 
 	/* per txg statistics */
 	uint64_t	q_total_seg_size_this_txg;
@@ -1144,7 +1167,12 @@ dsl_scan_done(dsl_scan_t *scn, boolean_t complete, dmu_tx_t *tx)
 	} else {
 		spa_history_log_internal(spa, "scan done", tx,
 		    "errors=%llu", (u_longlong_t)spa_approx_errlog_size(spa));
-		if (DSL_SCAN_IS_SCRUB(scn)) {
+		/*
+		 * An incremental scrub only extends last_scrubbed_txg if it
+		 * started at or before it, i.e. if no blocks were left out.
+		 */
+		if (DSL_SCAN_IS_SCRUB(scn) &&
+		    scn->scn_phys.scn_min_txg <= spa->spa_scrubbed_last_txg) {
 			VERIFY0(zap_update(dp->dp_meta_objset,
 			    DMU_POOL_DIRECTORY_OBJECT,
 			    DMU_POOL_LAST_SCRUBBED_TXG,
@@ -1581,22 +1609,44 @@ scan_ds_queue_sync(dsl_scan_t *scn, dmu_tx_t *tx)
  *	worth of queues is about 1.2 GiB of on-pool data, so scanning
  *	that should take at least a decent fraction of a second).
  */
-static boolean_t
-dsl_scan_should_clear(dsl_scan_t *scn)
+static void
+dsl_scan_mem_limits(dsl_scan_t *scn, uint64_t *mlim_hard, uint64_t *mlim_soft)
 {
 	spa_t *spa = scn->scn_dp->dp_spa;
-	vdev_t *rvd = scn->scn_dp->dp_spa->spa_root_vdev;
-	uint64_t alloc, mlim_hard, mlim_soft, mused;
+	uint64_t alloc;
 
 	alloc = metaslab_class_get_alloc(spa_normal_class(spa));
 	alloc += metaslab_class_get_alloc(spa_special_class(spa));
 	alloc += metaslab_class_get_alloc(spa_dedup_class(spa));
 
-	mlim_hard = MAX((physmem / zfs_scan_mem_lim_fact) * PAGESIZE,
+	*mlim_hard = MAX((physmem / zfs_scan_mem_lim_fact) * PAGESIZE,
 	    zfs_scan_mem_lim_min);
-	mlim_hard = MIN(mlim_hard, alloc / 20);
-	mlim_soft = mlim_hard - MIN(mlim_hard / zfs_scan_mem_lim_soft_fact,
+	*mlim_hard = MIN(*mlim_hard, alloc / 20);
+	*mlim_soft = *mlim_hard - MIN(*mlim_hard / zfs_scan_mem_lim_soft_fact,
 	    zfs_scan_mem_lim_soft_max);
+}
+
+static uint64_t
+scan_io_queue_mem_used(dsl_scan_io_queue_t *queue)
+{
+	ASSERT(MUTEX_HELD(&queue->q_vd->vdev_scan_io_queue_lock));
+
+	/*
+	 * # of extents in exts_by_addr = # in exts_by_size.
+	 * B-tree efficiency is ~75%, but can be as low as 50%.
+	 */
+	return (zfs_btree_numnodes(&queue->q_exts_by_size) * ((
+	    sizeof (zfs_range_seg_gap_t) + sizeof (uint64_t)) * 3 / 2) +
+	    queue->q_sio_memused);
+}
+
+static boolean_t
+dsl_scan_should_clear(dsl_scan_t *scn)
+{
+	vdev_t *rvd = scn->scn_dp->dp_spa->spa_root_vdev;
+	uint64_t mlim_hard, mlim_soft, mused;
+
+	dsl_scan_mem_limits(scn, &mlim_hard, &mlim_soft);
 	mused = 0;
 	for (uint64_t i = 0; i < rvd->vdev_children; i++) {
 		vdev_t *tvd = rvd->vdev_child[i];
@@ -1604,15 +1654,8 @@ dsl_scan_should_clear(dsl_scan_t *scn)
 
 		mutex_enter(&tvd->vdev_scan_io_queue_lock);
 		queue = tvd->vdev_scan_io_queue;
-		if (queue != NULL) {
-			/*
-			 * # of extents in exts_by_addr = # in exts_by_size.
-			 * B-tree efficiency is ~75%, but can be as low as 50%.
-			 */
-			mused += zfs_btree_numnodes(&queue->q_exts_by_size) * ((
-			    sizeof (zfs_range_seg_gap_t) + sizeof (uint64_t)) *
-			    3 / 2) + queue->q_sio_memused;
-		}
+		if (queue != NULL)
+			mused += scan_io_queue_mem_used(queue);
 		mutex_exit(&tvd->vdev_scan_io_queue_lock);
 	}
 
@@ -1634,23 +1677,12 @@ dsl_scan_should_clear(dsl_scan_t *scn)
 		return (scn->scn_clearing);
 }
 
+/*
+ * Returns B_TRUE when the traversal should stop for this txg.
+ */
 static boolean_t
-dsl_scan_check_suspend(dsl_scan_t *scn, const zbookmark_phys_t *zb)
+dsl_scan_suspend_due(dsl_scan_t *scn)
 {
-	/* we never skip user/group accounting objects */
-	if (zb && (int64_t)zb->zb_object < 0)
-		return (B_FALSE);
-
-	if (scn->scn_suspending)
-		return (B_TRUE); /* we're already suspending */
-
-	if (!ZB_IS_ZERO(&scn->scn_phys.scn_bookmark))
-		return (B_FALSE); /* we're resuming */
-
-	/* We only know how to resume from level-0 and objset blocks. */
-	if (zb && (zb->zb_level != 0 && zb->zb_level != ZB_ROOT_LEVEL))
-		return (B_FALSE);
-
 	/*
 	 * We suspend if:
 	 *  - we have scanned for at least the minimum time (default 1 sec
@@ -1674,13 +1706,45 @@ dsl_scan_check_suspend(dsl_scan_t *scn, const zbookmark_phys_t *zb)
 	uint_t mintime = (scn->scn_phys.scn_func == POOL_SCAN_RESILVER) ?
 	    zfs_resilver_min_time_ms : zfs_scrub_min_time_ms;
 
-	if ((NSEC2MSEC(scan_time_ns) > mintime &&
+	return ((NSEC2MSEC(scan_time_ns) > mintime &&
 	    (scn->scn_dp->dp_dirty_total >= dirty_min_bytes ||
 	    txg_sync_waiting(scn->scn_dp) ||
 	    NSEC2SEC(sync_time_ns) >= zfs_txg_timeout)) ||
 	    spa_shutting_down(scn->scn_dp->dp_spa) ||
 	    (zfs_scan_strict_mem_lim && dsl_scan_should_clear(scn)) ||
-	    !ddt_walk_ready(scn->scn_dp->dp_spa)) {
+	    !ddt_walk_ready(scn->scn_dp->dp_spa));
+}
+
+static boolean_t
+dsl_scan_check_suspend(dsl_scan_t *scn, const zbookmark_phys_t *zb)
+{
+	/* we never skip user/group accounting objects */
+	if (zb && (int64_t)zb->zb_object < 0)
+		return (B_FALSE);
+
+	if (scn->scn_suspending)
+		return (B_TRUE); /* we're already suspending */
+
+	if (!ZB_IS_ZERO(&scn->scn_phys.scn_bookmark))
+		return (B_FALSE); /* we're resuming */
+
+	/* We only know how to resume from level-0 and objset blocks. */
+	if (zb && (zb->zb_level != 0 && zb->zb_level != ZB_ROOT_LEVEL))
+		return (B_FALSE);
+
+	/*
+	 * Unsorted scans issue their I/O from this context, so the pool's
+	 * scrub_rate is applied here, where the traversal can stop, rather
+	 * than in scan_exec_io().  The rate clock is only waited on for as
+	 * long as it is not time to suspend anyway, so syncing context is
+	 * never held up by it any longer than by scanning.
+	 */
+	boolean_t suspend;
+	while (!(suspend = dsl_scan_suspend_due(scn)) &&
+	    !scn->scn_is_sorted && scan_rate_pause(scn))
+		;
+
+	if (suspend) {
 		if (zb && zb->zb_level == ZB_ROOT_LEVEL) {
 			dprintf("suspending at first available bookmark "
 			    "%llx/%llx/%llx/%llx\n",
@@ -3250,6 +3314,120 @@ scan_io_queue_check_suspend(dsl_scan_t *scn)
 	    spa_shutting_down(scn->scn_dp->dp_spa));
 }
 
+/*
+ * Returns how long an I/O has to wait for the scrub_rate clock dsr, which
+ * is reset whenever the limit changes.
+ */
+static hrtime_t
+scan_rate_delay(dsl_scan_rate_t *dsr, uint64_t limit, hrtime_t now)
+{
+	if (limit != dsr->dsr_limit) {
+		dsr->dsr_limit = limit;
+		dsr->dsr_tat = 0;
+	}
+	if (limit == 0)
+		return (0);
+
+	return (MAX(dsr->dsr_tat - SCAN_RATE_BURST - now, 0));
+}
+
+static void
+scan_rate_charge(dsl_scan_rate_t *dsr, uint64_t size, hrtime_t now)
+{
+	if (dsr->dsr_limit != 0) {
+		dsr->dsr_tat = MAX(dsr->dsr_tat, now) +
+		    size * NANOSEC / dsr->dsr_limit;
+	}
+}
+
+/*
+ * Waits until the scrub_rate limits of the pool and of the queue's
+ * top-level vdev allow size more bytes of sorted I/O to be issued, and
+ * charges them. Each limit is a virtual clock like the dataset iolimits
+ * (see dmu_iolimit.c): the time at which all I/O charged so far would have
+ * been issued at that rate. Gives up with B_TRUE when it is time to
+ * suspend, without charging anything.
+ */
+static boolean_t
+scan_rate_wait(dsl_scan_t *scn, dsl_scan_io_queue_t *queue, uint64_t size)
+{
+	spa_t *spa = scn->scn_dp->dp_spa;
+	hrtime_t now, delay;
+
+	mutex_enter(&spa->spa_scrub_lock);
+	for (;;) {
+		now = gethrtime();
+		delay = MAX(scan_rate_delay(&scn->scn_rate,
+		    spa->spa_scrub_rate, now), scan_rate_delay(&queue->q_rate,
+		    queue->q_vd->vdev_scrub_rate, now));
+		if (delay == 0)
+			break;
+
+		mutex_exit(&spa->spa_scrub_lock);
+		if (scan_io_queue_check_suspend(scn))
+			return (B_TRUE);
+		mutex_enter(&spa->spa_scrub_lock);
+		(void) cv_timedwait_idle(&spa->spa_scrub_io_cv,
+		    &spa->spa_scrub_lock, ddi_get_lbolt() +
+		    MSEC_TO_TICK(MIN(NSEC2MSEC(delay) + 1, SCAN_RATE_POLL_MS)));
+	}
+	scan_rate_charge(&scn->scn_rate, size, now);
+	scan_rate_charge(&queue->q_rate, size, now);
+	mutex_exit(&spa->spa_scrub_lock);
+
+	return (B_FALSE);
+}
+
+/*
+ * Sleeps for up to SCAN_RATE_POLL_MS if the pool's scrub_rate clock is
+ * ahead, and returns B_TRUE if it was. Nothing is charged.
+ */
+static boolean_t
+scan_rate_pause(dsl_scan_t *scn)
+{
+	spa_t *spa = scn->scn_dp->dp_spa;
+	hrtime_t delay;
+
+	mutex_enter(&spa->spa_scrub_lock);
+	delay = scan_rate_delay(&scn->scn_rate, spa->spa_scrub_rate,
+	    gethrtime());
+	if (delay != 0) {
+		(void) cv_timedwait_idle(&spa->spa_scrub_io_cv,
+		    &spa->spa_scrub_lock, ddi_get_lbolt() +
+		    MSEC_TO_TICK(MIN(NSEC2MSEC(delay) + 1, SCAN_RATE_POLL_MS)));
+	}
+	mutex_exit(&spa->spa_scrub_lock);
+
+	return (delay != 0);
+}
+
+/*
+ * Returns the scrub_rate limit in effect for the pool, as reported by
+ * zpool status: the pool's own, or the sum of those of the top-level
+ * vdevs if all of them are limited to less than that. 0 means unlimited.
+ */
+uint64_t
+dsl_scan_rate_limit(spa_t *spa)
+{
+	vdev_t *rvd = spa->spa_root_vdev;
+	uint64_t limit = spa->spa_scrub_rate;
+	uint64_t vdev_limits = 0;
+
+	for (uint64_t c = 0; c < rvd->vdev_children; c++) {
+		vdev_t *tvd = rvd->vdev_child[c];
+
+		if (!vdev_is_concrete(tvd))
+			continue;
+		if (tvd->vdev_scrub_rate == 0)
+			return (limit);
+		vdev_limits += tvd->vdev_scrub_rate;
+	}
+
+	if (limit == 0 || (vdev_limits != 0 && vdev_limits < limit))
+		return (vdev_limits);
+	return (limit);
+}
+
 /*
  * Given a list of scan_io_t's in io_list, this issues the I/Os out to
  * disk. This consumes the io_list and frees the scan_io_t's. This is
@@ -3274,6 +3452,11 @@ scan_io_queue_issue(dsl_scan_io_queue_t *queue, list_t *io_list)
 		}
 
 		sio2bp(sio, &bp);
+		if (scan_rate_wait(scn, queue, BP_GET_PSIZE(&bp))) {
+			suspended = B_TRUE;
+			break;
+		}
+
 		scan_exec_io(scn->scn_dp, &bp, sio->sio_flags,
 		    &sio->sio_zb, queue);
 		(void) list_remove_head(io_list);
@@ -3368,7 +3551,8 @@ scan_io_queue_gather(dsl_scan_io_queue_t *queue, zfs_range_seg_t *rs,
  * 1) We select extents in an elevator algorithm (LBA-order) if the scan
  * 	needs to perform a checkpoint
  * 2) We select the largest available extent if we are up against the
- * 	memory limit.
+ * 	memory limit, or if metadata is being scanned concurrently and the
+ * 	queue is above its share of the soft memory limit (scn_issue_mlim).
  * 3) Otherwise we don't select any extents.
  */
 static zfs_range_seg_t *
@@ -3380,7 +3564,9 @@ scan_io_queue_fetch_ext(dsl_scan_io_queue_t *queue)
 	ASSERT(MUTEX_HELD(&queue->q_vd->vdev_scan_io_queue_lock));
 	ASSERT(scn->scn_is_sorted);
 
-	if (!scn->scn_checkpointing && !scn->scn_clearing)
+	if (!scn->scn_checkpointing && !scn->scn_clearing &&
+	    (scn->scn_issue_mlim == 0 ||
+	    scan_io_queue_mem_used(queue) < scn->scn_issue_mlim))
 		return (NULL);
 
 	/*
@@ -3436,6 +3622,7 @@ scan_io_queues_run_one(void *arg)
 	dsl_scan_io_queue_t *queue = arg;
 	kmutex_t *q_lock = &queue->q_vd->vdev_scan_io_queue_lock;
 	boolean_t suspended = B_FALSE;
+	uint64_t seg_start = 0, seg_end = 0;
 	zfs_range_seg_t *rs;
 	scan_io_t *sio;
 	zio_t *zio;
@@ -3460,51 +3647,52 @@ scan_io_queues_run_one(void *arg)
 	queue->q_total_zio_size_this_txg = 0;
 	queue->q_zios_this_txg = 0;
 
-	/* loop until we run out of time or sios */
+	/*
+	 * Loop until we run out of time or sios. Once an extent has more
+	 * sios than we gather at once, scan_io_queue_fetch_ext() returns it
+	 * again so that we continue where we left off.
+	 */
 	while ((rs = scan_io_queue_fetch_ext(queue)) != NULL) {
-		uint64_t seg_start = 0, seg_end = 0;
+		scan_io_t *first_sio, *last_sio;
 		boolean_t more_left;
 
 		ASSERT(list_is_empty(&sio_list));
 
-		/* loop while we still have sios left to process in this rs */
-		do {
-			scan_io_t *first_sio, *last_sio;
-
-			/*
-			 * We have selected which extent needs to be
-			 * processed next. Gather up the corresponding sios.
-			 */
-			more_left = scan_io_queue_gather(queue, rs, &sio_list);
-			ASSERT(!list_is_empty(&sio_list));
-			first_sio = list_head(&sio_list);
-			last_sio = list_tail(&sio_list);
-
-			seg_end = SIO_GET_END_OFFSET(last_sio);
-			if (seg_start == 0)
-				seg_start = SIO_GET_OFFSET(first_sio);
+		/*
+		 * We have selected which extent needs to be processed
+		 * next. Gather up the corresponding sios.
+		 */
+		more_left = scan_io_queue_gather(queue, rs, &sio_list);
+		ASSERT(!list_is_empty(&sio_list));
+		first_sio = list_head(&sio_list);
+		last_sio = list_tail(&sio_list);
 
-			/*
-			 * Issuing sios can take a long time so drop the
-			 * queue lock. The sio queue won't be updated by
-			 * other threads since we're in syncing context so
-			 * we can be sure that our trees will remain exactly
-			 * as we left them.
-			 */
-			mutex_exit(q_lock);
-			suspended = scan_io_queue_issue(queue, &sio_list);
-			mutex_enter(q_lock);
+		seg_end = SIO_GET_END_OFFSET(last_sio);
+		if (seg_start == 0)
+			seg_start = SIO_GET_OFFSET(first_sio);
 
-			if (suspended)
-				break;
-		} while (more_left);
+		/*
+		 * Issuing sios can take a long time so drop the queue
+		 * lock. Metadata scanning may insert new sios meanwhile,
+		 * which can merge or move extents, so rs must not be used
+		 * once we have dropped the lock.
+		 */
+		mutex_exit(q_lock);
+		suspended = scan_io_queue_issue(queue, &sio_list);
+		mutex_enter(q_lock);
 
 		/* update statistics for debugging purposes */
-		scan_io_queues_update_seg_stats(queue, seg_start, seg_end);
+		if (!more_left) {
+			scan_io_queues_update_seg_stats(queue, seg_start,
+			    seg_end);
+			seg_start = 0;
+		}
 
 		if (suspended)
 			break;
 	}
+	if (seg_start != 0)
+		scan_io_queues_update_seg_stats(queue, seg_start, seg_end);
 
 	/*
 	 * If we were suspended in the middle of processing,
@@ -3520,16 +3708,17 @@ scan_io_queues_run_one(void *arg)
 }
 
 /*
- * Performs an emptying run on all scan queues in the pool. This just
+ * Starts an emptying run on all scan queues in the pool. This just
  * punches out one thread per top-level vdev, each of which processes
  * only that vdev's scan queue. We can parallelize the I/O here because
  * we know that each queue's I/Os only affect its own top-level vdev.
  *
- * This function waits for the queue runs to complete, and must be
- * called from dsl_scan_sync (or in general, syncing context).
+ * This function must be called from dsl_scan_sync (or in general,
+ * syncing context), which then waits for the runs with taskq_wait().
+ * Returns B_FALSE if there was nothing to run.
  */
-static void
-scan_io_queues_run(dsl_scan_t *scn)
+static boolean_t
+scan_io_queues_start(dsl_scan_t *scn)
 {
 	spa_t *spa = scn->scn_dp->dp_spa;
 
@@ -3537,7 +3726,7 @@ scan_io_queues_run(dsl_scan_t *scn)
 	ASSERT(spa_config_held(spa, SCL_CONFIG, RW_READER));
 
 	if (scn->scn_queues_pending == 0)
-		return;
+		return (B_FALSE);
 
 	if (scn->scn_taskq == NULL) {
 		int nthreads = spa->spa_root_vdev->vdev_children;
@@ -3565,12 +3754,19 @@ scan_io_queues_run(dsl_scan_t *scn)
 		mutex_exit(&vd->vdev_scan_io_queue_lock);
 	}
 
-	/*
-	 * Wait for the queues to finish issuing their IOs for this run
-	 * before we return. There may still be IOs in flight at this
-	 * point.
-	 */
-	taskq_wait(scn->scn_taskq);
+	return (B_TRUE);
+}
+
+/*
+ * Performs an emptying run on all scan queues in the pool and waits for
+ * the queue runs to complete. There may still be IOs in flight at this
+ * point.
+ */
+static void
+scan_io_queues_run(dsl_scan_t *scn)
+{
+	if (scan_io_queues_start(scn))
+		taskq_wait(scn->scn_taskq);
 }
 
 static boolean_t
@@ -4561,6 +4757,21 @@ dsl_scan_sync(dsl_pool_t *dp, dmu_tx_t *tx)
 		    dsl_scan_prefetch_thread, scn, TQ_SLEEP);
 		ASSERT(prefetch_tqid != TASKQID_INVALID);
 
+		/*
+		 * Let the queues issue their largest extents while we scan,
+		 * as long as they hold more than their share of the soft
+		 * memory limit.
+		 */
+		boolean_t issuing = B_FALSE;
+		if (scn->scn_is_sorted && zfs_scan_concurrent_issue) {
+			uint64_t mlim_hard, mlim_soft;
+
+			dsl_scan_mem_limits(scn, &mlim_hard, &mlim_soft);
+			scn->scn_issue_mlim = MAX(1, mlim_soft /
+			    spa->spa_root_vdev->vdev_children);
+			issuing = scan_io_queues_start(scn);
+		}
+
 		dsl_pool_config_enter(dp, FTAG);
 		dsl_scan_visit(scn, tx);
 		dsl_pool_config_exit(dp, FTAG);
@@ -4571,6 +4782,9 @@ dsl_scan_sync(dsl_pool_t *dp, dmu_tx_t *tx)
 		mutex_exit(&dp->dp_spa->spa_scrub_lock);
 
 		taskq_wait_id(dp->dp_sync_taskq, prefetch_tqid);
+		if (issuing)
+			taskq_wait(scn->scn_taskq);
+		scn->scn_issue_mlim = 0;
 		(void) zio_wait(scn->scn_zio_root);
 		scn->scn_zio_root = NULL;
 
@@ -4587,6 +4801,18 @@ dsl_scan_sync(dsl_pool_t *dp, dmu_tx_t *tx)
 		    (longlong_t)scn->scn_ddt_contained_this_txg,
 		    (longlong_t)scn->scn_gt_max_this_txg);
 
+		if (issuing) {
+			dsl_scan_update_stats(scn);
+			zfs_dbgmsg("scan issued %llu blocks for %s (%llu segs) "
+			    "while scanning (avg_block_size = %llu, "
+			    "avg_seg_size = %llu)",
+			    (longlong_t)scn->scn_zios_this_txg,
+			    spa->spa_name,
+			    (longlong_t)scn->scn_segs_this_txg,
+			    (longlong_t)scn->scn_avg_zio_size_this_txg,
+			    (longlong_t)scn->scn_avg_seg_size_this_txg);
+		}
+
 		if (!scn->scn_suspending) {
 			ASSERT0(avl_numnodes(&scn->scn_queue));
 			scn->scn_done_txg = tx->tx_txg + 1;
@@ -4918,6 +5144,14 @@ scan_exec_io(dsl_pool_t *dp, const blkptr_t *bp, int zio_flags,
 	if (queue == NULL) {
 		ASSERT3U(scn->scn_maxinflight_bytes, >, 0);
 		mutex_enter(&spa->spa_scrub_lock);
+		/*
+		 * This is syncing context, so only charge the scrub_rate
+		 * clock; dsl_scan_check_suspend() waits for it.
+		 */
+		hrtime_t now = gethrtime();
+		(void) scan_rate_delay(&scn->scn_rate, spa->spa_scrub_rate,
+		    now);
+		scan_rate_charge(&scn->scn_rate, size, now);
 		while (spa->spa_scrub_inflight >= scn->scn_maxinflight_bytes)
 			cv_wait(&spa->spa_scrub_io_cv, &spa->spa_scrub_lock);
 		spa->spa_scrub_inflight += BP_GET_PSIZE(bp);
@@ -5340,6 +5574,9 @@ ZFS_MODULE_PARAM(zfs, zfs_, scan_max_ext_gap, U64, ZMOD_RW,
 ZFS_MODULE_PARAM(zfs, zfs_, scan_mem_lim_soft_fact, UINT, ZMOD_RW,
 	"Fraction of hard limit used as soft limit");
 
+ZFS_MODULE_PARAM(zfs, zfs_, scan_concurrent_issue, INT, ZMOD_RW,
+	"Issue sorted scrub I/O while scanning metadata");
+
 ZFS_MODULE_PARAM(zfs, zfs_, scan_strict_mem_lim, INT, ZMOD_RW,
 	"Tunable to attempt to reduce lock contention");
 
@@ -40,12 +40,15 @@
  * It also contains a couple of defines from the old lz4.c to make things
  * fit together smoothly.
  *
+ * The fast decode loop's literal and match copies have been routed through
+ * small copy kernels so that the decompressor can be instantiated once per
+ * instruction set (see sys/lz4_impl.h); the scalar instance is the
+ * upstream code.
+ *
  */
 
 #include <sys/zfs_context.h>
-
-int LZ4_uncompress_unknownOutputSize(const char *source, char *dest,
-    int isize, int maxOutputSize);
+#include <sys/lz4_impl.h>
 
 /*
  * Tuning parameters
@@ -451,6 +454,141 @@ LZ4_memcpy_using_offset(BYTE* dstPtr, const BYTE* srcPtr, BYTE* dstEnd, const si
         dstPtr += 8;
     }
 }
+
+/*
+ * x86 copy kernels for the fast decode loop.  The kernel is built without
+ * SSE, so the compiler never keeps anything in the vector registers there
+ * (and kfpu_begin() has saved them); in user space they have to be declared
+ * clobbered.  Every asm statement loads and stores within itself, so no
+ * vector state is carried between statements.
+ */
+#if defined(__x86_64) && defined(HAVE_SSE2)
+#if defined(_KERNEL)
+#define LZ4_VEC_CLOBBER(...)
+#define LZ4_VEC_CLOBBER_MORE(...)
+#else
+#define LZ4_VEC_CLOBBER(...)        : __VA_ARGS__
+#define LZ4_VEC_CLOBBER_MORE(...)   , __VA_ARGS__
+#endif
+
+typedef struct { BYTE b[16]; } LZ4_vec16_t;
+typedef struct { BYTE b[32]; } LZ4_vec32_t;
+
+LZ4_FORCE_INLINE void
+LZ4_copy16_sse2(void* dstPtr, const void* srcPtr)
+{
+    __asm__ __volatile__(
+        "movdqu %1, %%xmm0\n"
+        "movdqu %%xmm0, %0\n"
+        : "=m" (*(LZ4_vec16_t*)dstPtr)
+        : "m" (*(const LZ4_vec16_t*)srcPtr)
+        LZ4_VEC_CLOBBER("xmm0"));
+}
+
+#if defined(HAVE_AVX2)
+LZ4_FORCE_INLINE void
+LZ4_copy32_avx2(void* dstPtr, const void* srcPtr)
+{
+    __asm__ __volatile__(
+        "vmovdqu %1, %%ymm0\n"
+        "vmovdqu %%ymm0, %0\n"
+        : "=m" (*(LZ4_vec32_t*)dstPtr)
+        : "m" (*(const LZ4_vec32_t*)srcPtr)
+        LZ4_VEC_CLOBBER("xmm0"));
+}
+#endif
+
+#if defined(HAVE_SSSE3)
+/* pshufb masks replicating the first `offset` bytes across a vector */
+#define LZ4_PMASK(o) { 0%(o), 1%(o), 2%(o), 3%(o), 4%(o), 5%(o), 6%(o), \
+    7%(o), 8%(o), 9%(o), 10%(o), 11%(o), 12%(o), 13%(o), 14%(o), 15%(o) }
+
+static const LZ4_vec16_t LZ4_pattern_mask[16] = {
+    { { 0 } },
+    { LZ4_PMASK(1) }, { LZ4_PMASK(2) }, { LZ4_PMASK(3) }, { LZ4_PMASK(4) },
+    { LZ4_PMASK(5) }, { LZ4_PMASK(6) }, { LZ4_PMASK(7) }, { LZ4_PMASK(8) },
+    { LZ4_PMASK(9) }, { LZ4_PMASK(10) }, { LZ4_PMASK(11) }, { LZ4_PMASK(12) },
+    { LZ4_PMASK(13) }, { LZ4_PMASK(14) }, { LZ4_PMASK(15) }
+};
+
+/* Overlapping match with 0 < offset < 16 : build the repeating pattern in a
+ * register once, then store it at steps of the largest multiple of offset
+ * that fits in 16 bytes.  May write up to 15 bytes beyond dstEnd, which the
+ * fast loop always leaves room for. */
+LZ4_FORCE_INLINE void
+LZ4_memcpy_using_offset_ssse3(BYTE* dstPtr, const BYTE* srcPtr, BYTE* dstEnd, const size_t offset)
+{
+    size_t const step = 16 - (16 % offset);
+
+    assert(offset > 0 && offset < 16);
+    __asm__ __volatile__(
+        "movdqu %3, %%xmm0\n"
+        "pshufb %4, %%xmm0\n"
+        "1:\n"
+        "movdqu %%xmm0, (%0)\n"
+        "add %1, %0\n"
+        "cmp %2, %0\n"
+        "jb 1b\n"
+        : "+r" (dstPtr)
+        : "r" (step), "r" (dstEnd),
+          "m" (*(const LZ4_vec16_t*)srcPtr), "m" (LZ4_pattern_mask[offset])
+        : "cc", "memory" LZ4_VEC_CLOBBER_MORE("xmm0"));
+}
+#endif
+#endif /* __x86_64 && HAVE_SSE2 */
+
+/* 16 byte literal copy of the fast loop */
+LZ4_FORCE_INLINE void
+LZ4_copy16_k(void* dstPtr, const void* srcPtr, const lz4_kernel_t kernel)
+{
+#if defined(__x86_64) && defined(HAVE_SSE2)
+    if (kernel != LZ4_KERNEL_SCALAR) { LZ4_copy16_sse2(dstPtr, srcPtr); return; }
+#endif
+    (void)kernel;
+    LZ4_memcpy(dstPtr, srcPtr, 16);
+}
+
+/* LZ4_wildCopy32() for a given kernel; `wide` allows a single 32 byte
+ * move per step, which is only correct when source and destination are at
+ * least 32 bytes apart (literals, or matches with offset >= 32). */
+LZ4_FORCE_INLINE void
+LZ4_wildCopy32_k(void* dstPtr, const void* srcPtr, void* dstEnd, const lz4_kernel_t kernel, const int wide)
+{
+#if defined(__x86_64) && defined(HAVE_SSE2)
+    BYTE* d = (BYTE*)dstPtr;
+    const BYTE* s = (const BYTE*)srcPtr;
+    BYTE* const e = (BYTE*)dstEnd;
+
+#if defined(HAVE_SSSE3) && defined(HAVE_AVX2)
+    if (kernel == LZ4_KERNEL_AVX2 && wide) {
+        do { LZ4_copy32_avx2(d, s); d+=32; s+=32; } while (d<e);
+        /* the rest of the decoder is legacy SSE, avoid transition stalls */
+        __asm__ __volatile__("vzeroupper" ::: "memory");
+        return;
+    }
+#endif
+    if (kernel != LZ4_KERNEL_SCALAR) {
+        do { LZ4_copy16_sse2(d, s); LZ4_copy16_sse2(d+16, s+16); d+=32; s+=32; } while (d<e);
+        return;
+    }
+#endif
+    (void)kernel; (void)wide;
+    LZ4_wildCopy32(dstPtr, srcPtr, dstEnd);
+}
+
+/* LZ4_memcpy_using_offset() for a given kernel */
+LZ4_FORCE_INLINE void
+LZ4_memcpy_using_offset_k(BYTE* dstPtr, const BYTE* srcPtr, BYTE* dstEnd, const size_t offset, const lz4_kernel_t kernel)
+{
+#if defined(__x86_64) && defined(HAVE_SSE2) && defined(HAVE_SSSE3)
+    if ((kernel == LZ4_KERNEL_SSSE3 || kernel == LZ4_KERNEL_AVX2) && likely(offset > 0)) {
+        LZ4_memcpy_using_offset_ssse3(dstPtr, srcPtr, dstEnd, offset);
+        return;
+    }
+#endif
+    (void)kernel;
+    LZ4_memcpy_using_offset(dstPtr, srcPtr, dstEnd, offset);
+}
 #endif
 
 
@@ -539,9 +677,11 @@ LZ4_decompress_generic(
                  dict_directive dict,                 /* noDict, withPrefix64k, usingExtDict */
                  const BYTE* const lowPrefix,  /* always <= dst, == dst when no prefix */
                  const BYTE* const dictStart,  /* only if dict==usingExtDict */
-                 const size_t dictSize         /* note : = 0 if noDict */
+                 const size_t dictSize,        /* note : = 0 if noDict */
+                 const lz4_kernel_t kernel     /* copy kernels of the fast loop */
                  )
 {
+    (void)kernel;   /* only used by the copy kernels and LZ4_FPU_YIELD() */
     if ((src == NULL) || (outputSize < 0)) { return -1; }
 
     {   const BYTE* ip = (const BYTE*) src;
@@ -550,6 +690,7 @@ LZ4_decompress_generic(
         BYTE* op = (BYTE*) dst;
         BYTE* const oend = op + outputSize;
         BYTE* cpy;
+        BYTE* fpuNext = op + LZ4_FPU_CHUNK;
 
         const BYTE* const dictEnd = (dictStart == NULL) ? NULL : dictStart + dictSize;
 
@@ -588,6 +729,9 @@ LZ4_decompress_generic(
 
         /* Fast loop : decode sequences as long as output < iend-FASTLOOP_SAFE_DISTANCE */
         while (1) {
+            /* no vector registers are live between sequences */
+            LZ4_FPU_YIELD(kernel, op, fpuNext);
+
             /* Main fastloop assertion: We can always wildcopy FASTLOOP_SAFE_DISTANCE */
             assert(oend - op >= FASTLOOP_SAFE_DISTANCE);
             if (endOnInput) { assert(ip < iend); }
@@ -609,7 +753,7 @@ LZ4_decompress_generic(
                 LZ4_STATIC_ASSERT(MFLIMIT >= WILDCOPYLENGTH);
                 if (endOnInput) {  /* LZ4_decompress_safe() */
                     if ((cpy>oend-32) || (ip+length>iend-32)) { goto safe_literal_copy; }
-                    LZ4_wildCopy32(op, ip, cpy);
+                    LZ4_wildCopy32_k(op, ip, cpy, kernel, 1);
                 } else {   /* LZ4_decompress_fast() */
                     if (cpy>oend-8) { goto safe_literal_copy; }
                     LZ4_wildCopy8(op, ip, cpy); /* LZ4_decompress_fast() cannot copy more than 8 bytes at a time :
@@ -623,7 +767,7 @@ LZ4_decompress_generic(
                     /* We don't need to check oend, since we check it once for each loop below */
                     if (ip > iend-(16 + 1/*max lit + offset + nextToken*/)) { goto safe_literal_copy; }
                     /* Literals can only be 14, but hope compilers optimize if we copy by a register size */
-                    LZ4_memcpy(op, ip, 16);
+                    LZ4_copy16_k(op, ip, kernel);
                 } else {  /* LZ4_decompress_fast() */
                     /* LZ4_decompress_fast() cannot copy more than 8 bytes at a time :
                      * it doesn't know input length, and relies on end-of-block properties */
@@ -708,9 +852,9 @@ LZ4_decompress_generic(
 
             assert((op <= oend) && (oend-op >= 32));
             if (unlikely(offset<16)) {
-                LZ4_memcpy_using_offset(op, match, cpy, offset);
+                LZ4_memcpy_using_offset_k(op, match, cpy, offset, kernel);
             } else {
-                LZ4_wildCopy32(op, match, cpy);
+                LZ4_wildCopy32_k(op, match, cpy, kernel, offset >= 32);
             }
 
             op = cpy;   /* wildcopy correction */
@@ -720,6 +864,7 @@ LZ4_decompress_generic(
 
         /* Main Loop : decode remaining sequences where output < FASTLOOP_SAFE_DISTANCE */
         while (1) {
+            LZ4_FPU_YIELD(kernel, op, fpuNext);
             token = *ip++;
             length = token >> ML_BITS;  /* literal length */
 
@@ -984,5 +1129,37 @@ int LZ4_uncompress_unknownOutputSize(const char* source, char* dest, int compres
 {
     return LZ4_decompress_generic(source, dest, compressedSize, maxDecompressedSize,
                                   endOnInputSize, decode_full_block, noDict,
-                                  (BYTE*)dest, NULL, 0);
+                                  (BYTE*)dest, NULL, 0, LZ4_KERNEL_SCALAR);
+}
+
+/*
+ * Instruction set specific instances of the above.  The caller is
+ * responsible for kfpu_begin()/kfpu_end() around them; they briefly end
+ * and re-enter the FPU section every LZ4_FPU_CHUNK bytes of output.
+ */
+#if defined(__x86_64) && defined(HAVE_SSE2)
+int LZ4_uncompress_unknownOutputSize_sse2(const char* source, char* dest, int compressedSize, int maxDecompressedSize)
+{
+    return LZ4_decompress_generic(source, dest, compressedSize, maxDecompressedSize,
+                                  endOnInputSize, decode_full_block, noDict,
+                                  (BYTE*)dest, NULL, 0, LZ4_KERNEL_SSE2);
 }
+#endif
+
+#if defined(__x86_64) && defined(HAVE_SSE2) && defined(HAVE_SSSE3)
+int LZ4_uncompress_unknownOutputSize_ssse3(const char* source, char* dest, int compressedSize, int maxDecompressedSize)
+{
+    return LZ4_decompress_generic(source, dest, compressedSize, maxDecompressedSize,
+                                  endOnInputSize, decode_full_block, noDict,
+                                  (BYTE*)dest, NULL, 0, LZ4_KERNEL_SSSE3);
+}
+#endif
+
+#if defined(__x86_64) && defined(HAVE_SSE2) && defined(HAVE_SSSE3) && defined(HAVE_AVX2)
+int LZ4_uncompress_unknownOutputSize_avx2(const char* source, char* dest, int compressedSize, int maxDecompressedSize)
+{
+    return LZ4_decompress_generic(source, dest, compressedSize, maxDecompressedSize,
+                                  endOnInputSize, decode_full_block, noDict,
+                                  (BYTE*)dest, NULL, 0, LZ4_KERNEL_AVX2);
+}
+#endif
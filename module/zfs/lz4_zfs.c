@@ -39,17 +39,12 @@
 
 #include <sys/zfs_context.h>
 #include <sys/zio_compress.h>
+#include <sys/lz4_impl.h>
+#include <sys/simd.h>
 
 static int real_LZ4_compress(const char *source, char *dest, int isize,
     int osize);
-static int LZ4_compressCtx(void *ctx, const char *source, char *dest,
-    int isize, int osize);
-static int LZ4_compress64kCtx(void *ctx, const char *source, char *dest,
-    int isize, int osize);
-
-/* See lz4.c */
-int LZ4_uncompress_unknownOutputSize(const char *source, char *dest,
-    int isize, int maxOutputSize);
+static const lz4_impl_ops_t *lz4_impl_get(void);
 
 static kmem_cache_t *lz4_cache;
 
@@ -93,12 +88,21 @@ zfs_lz4_decompress_buf(void *s_start, void *d_start, size_t s_len,
 	if (bufsiz + sizeof (bufsiz) > s_len)
 		return (1);
 
+	const lz4_impl_ops_t *ops = lz4_impl_get();
+	int ret;
+
+	/* the SIMD decoder re-enters the FPU every LZ4_FPU_CHUNK bytes */
+	if (ops->uses_fpu)
+		kfpu_begin();
+	ret = ops->decompress(&src[sizeof (bufsiz)], d_start, bufsiz, d_len);
+	if (ops->uses_fpu)
+		kfpu_end();
+
 	/*
 	 * Returns 0 on success (decompression function returned non-negative)
 	 * and non-zero on failure (decompression function returned negative).
 	 */
-	return (LZ4_uncompress_unknownOutputSize(&src[sizeof (bufsiz)],
-	    d_start, bufsiz, d_len) < 0);
+	return (ret < 0);
 }
 
 ZFS_COMPRESS_WRAP_DECL(zfs_lz4_compress)
@@ -471,11 +475,121 @@ LZ4_NbCommonBytes(register U32 val)
 
 #endif
 
+#if defined(__x86_64) && defined(HAVE_SSE2)
+/*
+ * Vector match length counting.  As in lz4.c, the vector registers are only
+ * declared clobbered in user space; the kernel is built without SSE and the
+ * callers bracket these with kfpu_begin()/kfpu_end().
+ */
+#if defined(_KERNEL)
+#define	LZ4_VEC_CLOBBER(...)
+#else
+#define	LZ4_VEC_CLOBBER(...)	: __VA_ARGS__
+#endif
+
+typedef struct { BYTE v[16]; } LZ4_V16;
+typedef struct { BYTE v[32]; } LZ4_V32;
+
+/* Number of equal leading bytes at ip and ref (0 - 16) */
+static inline int
+LZ4_count16_sse2(const BYTE *ip, const BYTE *ref)
+{
+	U32 mask;
+
+	__asm__ __volatile__(
+	    "movdqu	%1, %%xmm0\n"
+	    "movdqu	%2, %%xmm1\n"
+	    "pcmpeqb	%%xmm1, %%xmm0\n"
+	    "pmovmskb	%%xmm0, %0\n"
+	    : "=r" (mask)
+	    : "m" (*(const LZ4_V16 *)ip), "m" (*(const LZ4_V16 *)ref)
+	    LZ4_VEC_CLOBBER("xmm0", "xmm1"));
+
+	return (mask == 0xffff ? 16 : __builtin_ctz(~mask));
+}
+
+#if defined(HAVE_AVX2)
+/* Number of equal leading bytes at ip and ref (0 - 32) */
+static inline int
+LZ4_count32_avx2(const BYTE *ip, const BYTE *ref)
+{
+	U32 mask;
+
+	__asm__ __volatile__(
+	    "vmovdqu	%1, %%ymm0\n"
+	    "vmovdqu	%2, %%ymm1\n"
+	    "vpcmpeqb	%%ymm1, %%ymm0, %%ymm0\n"
+	    "vpmovmskb	%%ymm0, %0\n"
+	    : "=r" (mask)
+	    : "m" (*(const LZ4_V32 *)ip), "m" (*(const LZ4_V32 *)ref)
+	    LZ4_VEC_CLOBBER("xmm0", "xmm1"));
+
+	return (mask == 0xffffffff ? 32 : __builtin_ctz(~mask));
+}
+#endif
+#endif /* __x86_64 && HAVE_SSE2 */
+
+/*
+ * Extend a match using the vector kernel, a full vector at a time.  Returns
+ * B_TRUE if the end of the match was found, otherwise the caller finishes
+ * the last few bytes before limit with the scalar code.  Like the scalar
+ * loop, both *ipp and *refp are advanced past the matching bytes.
+ */
+static inline __attribute__((always_inline)) boolean_t
+LZ4_count_k(const BYTE **ipp, const BYTE **refp, const BYTE *limit,
+    const lz4_kernel_t kernel)
+{
+#if defined(__x86_64) && defined(HAVE_SSE2)
+	const BYTE *ip = *ipp;
+	const BYTE *ref = *refp;
+	const BYTE *fpu_next = ip + LZ4_FPU_CHUNK;
+	boolean_t found = B_FALSE;
+	int n;
+
+#if defined(HAVE_AVX2)
+	if (kernel == LZ4_KERNEL_AVX2) {
+		while (likely(ip < limit - 31)) {
+			n = LZ4_count32_avx2(ip, ref);
+			ip += n;
+			ref += n;
+			if (n < 32) {
+				found = B_TRUE;
+				break;
+			}
+			LZ4_FPU_YIELD(kernel, ip, fpu_next);
+		}
+		/* the rest of the compressor may use legacy SSE */
+		__asm__ __volatile__("vzeroupper" ::: "memory");
+		*ipp = ip;
+		*refp = ref;
+		return (found);
+	}
+#endif
+	if (kernel != LZ4_KERNEL_SCALAR) {
+		while (likely(ip < limit - 15)) {
+			n = LZ4_count16_sse2(ip, ref);
+			ip += n;
+			ref += n;
+			if (n < 16) {
+				found = B_TRUE;
+				break;
+			}
+			LZ4_FPU_YIELD(kernel, ip, fpu_next);
+		}
+		*ipp = ip;
+		*refp = ref;
+		return (found);
+	}
+#endif
+	(void) ipp, (void) refp, (void) limit, (void) kernel;
+	return (B_FALSE);
+}
+
 /* Compression functions */
 
-static int
+static inline __attribute__((always_inline)) int
 LZ4_compressCtx(void *ctx, const char *source, char *dest, int isize,
-    int osize)
+    int osize, const lz4_kernel_t kernel)
 {
 	struct refTables *srt = (struct refTables *)ctx;
 	HTYPE *HashTable = (HTYPE *) (srt->hashTable);
@@ -493,6 +607,7 @@ LZ4_compressCtx(void *ctx, const char *source, char *dest, int isize,
 	int len, length;
 	const int skipStrength = SKIPSTRENGTH;
 	U32 forwardH;
+	const BYTE *fpu_next = ip + LZ4_FPU_CHUNK;
 
 
 	/* Init */
@@ -525,6 +640,7 @@ LZ4_compressCtx(void *ctx, const char *source, char *dest, int isize,
 			forwardH = LZ4_HASH_VALUE(forwardIp);
 			ref = base + HashTable[h];
 			HashTable[h] = ip - base;
+			LZ4_FPU_YIELD(kernel, ip, fpu_next);
 
 		} while ((ref < ip - MAX_DISTANCE) || (A32(ref) != A32(ip)));
 
@@ -564,6 +680,8 @@ LZ4_compressCtx(void *ctx, const char *source, char *dest, int isize,
 		ip += MINMATCH;
 		ref += MINMATCH;	/* MinMatch verified */
 		anchor = ip;
+		if (LZ4_count_k(&ip, &ref, matchlimit, kernel))
+			goto _endCount;
 		while (likely(ip < matchlimit - (STEPSIZE - 1))) {
 			UARCH diff = AARCH(ref) ^ AARCH(ip);
 			if (!diff) {
@@ -663,9 +781,9 @@ LZ4_compressCtx(void *ctx, const char *source, char *dest, int isize,
 	HASHLOG64K))
 #define	LZ4_HASH64K_VALUE(p)	LZ4_HASH64K_FUNCTION(A32(p))
 
-static int
+static inline __attribute__((always_inline)) int
 LZ4_compress64kCtx(void *ctx, const char *source, char *dest, int isize,
-    int osize)
+    int osize, const lz4_kernel_t kernel)
 {
 	struct refTables *srt = (struct refTables *)ctx;
 	U16 *HashTable = (U16 *) (srt->hashTable);
@@ -683,6 +801,7 @@ LZ4_compress64kCtx(void *ctx, const char *source, char *dest, int isize,
 	int len, length;
 	const int skipStrength = SKIPSTRENGTH;
 	U32 forwardH;
+	const BYTE *fpu_next = ip + LZ4_FPU_CHUNK;
 
 	/* Init */
 	if (isize < MINLENGTH)
@@ -713,6 +832,7 @@ LZ4_compress64kCtx(void *ctx, const char *source, char *dest, int isize,
 			forwardH = LZ4_HASH64K_VALUE(forwardIp);
 			ref = base + HashTable[h];
 			HashTable[h] = ip - base;
+			LZ4_FPU_YIELD(kernel, ip, fpu_next);
 
 		} while (A32(ref) != A32(ip));
 
@@ -752,6 +872,8 @@ LZ4_compress64kCtx(void *ctx, const char *source, char *dest, int isize,
 		ip += MINMATCH;
 		ref += MINMATCH;	/* MinMatch verified */
 		anchor = ip;
+		if (LZ4_count_k(&ip, &ref, matchlimit, kernel))
+			goto _endCount;
 		while (ip < matchlimit - (STEPSIZE - 1)) {
 			UARCH diff = AARCH(ref) ^ AARCH(ip);
 			if (!diff) {
@@ -840,9 +962,253 @@ LZ4_compress64kCtx(void *ctx, const char *source, char *dest, int isize,
 	return (int)(((char *)op) - dest);
 }
 
+/*
+ * Compressor instances, one per kernel.  The SSSE3 implementation shares
+ * the SSE2 compressor, SSSE3 only adds to the decompressor.
+ */
+static int
+LZ4_compress_scalar(void *ctx, const char *source, char *dest, int isize,
+    int osize)
+{
+	if (isize < LZ4_64KLIMIT)
+		return (LZ4_compress64kCtx(ctx, source, dest, isize, osize,
+		    LZ4_KERNEL_SCALAR));
+	return (LZ4_compressCtx(ctx, source, dest, isize, osize,
+	    LZ4_KERNEL_SCALAR));
+}
+
+#if defined(__x86_64) && defined(HAVE_SSE2)
+static int
+LZ4_compress_sse2(void *ctx, const char *source, char *dest, int isize,
+    int osize)
+{
+	if (isize < LZ4_64KLIMIT)
+		return (LZ4_compress64kCtx(ctx, source, dest, isize, osize,
+		    LZ4_KERNEL_SSE2));
+	return (LZ4_compressCtx(ctx, source, dest, isize, osize,
+	    LZ4_KERNEL_SSE2));
+}
+#endif
+
+#if defined(__x86_64) && defined(HAVE_SSE2) && defined(HAVE_AVX2)
+static int
+LZ4_compress_avx2(void *ctx, const char *source, char *dest, int isize,
+    int osize)
+{
+	if (isize < LZ4_64KLIMIT)
+		return (LZ4_compress64kCtx(ctx, source, dest, isize, osize,
+		    LZ4_KERNEL_AVX2));
+	return (LZ4_compressCtx(ctx, source, dest, isize, osize,
+	    LZ4_KERNEL_AVX2));
+}
+#endif
+
+static boolean_t
+lz4_scalar_will_work(void)
+{
+	return (B_TRUE);
+}
+
+static const lz4_impl_ops_t lz4_scalar_impl = {
+	.compress = LZ4_compress_scalar,
+	.decompress = LZ4_uncompress_unknownOutputSize,
+	.is_supported = lz4_scalar_will_work,
+	.uses_fpu = B_FALSE,
+	.name = "scalar"
+};
+
+#if defined(__x86_64) && defined(HAVE_SSE2)
+static boolean_t
+lz4_sse2_will_work(void)
+{
+	return (kfpu_allowed() && zfs_sse2_available());
+}
+
+static const lz4_impl_ops_t lz4_sse2_impl = {
+	.compress = LZ4_compress_sse2,
+	.decompress = LZ4_uncompress_unknownOutputSize_sse2,
+	.is_supported = lz4_sse2_will_work,
+	.uses_fpu = B_TRUE,
+	.name = "sse2"
+};
+#endif
+
+#if defined(__x86_64) && defined(HAVE_SSE2) && defined(HAVE_SSSE3)
+static boolean_t
+lz4_ssse3_will_work(void)
+{
+	return (kfpu_allowed() && zfs_sse2_available() &&
+	    zfs_ssse3_available());
+}
+
+static const lz4_impl_ops_t lz4_ssse3_impl = {
+	.compress = LZ4_compress_sse2,
+	.decompress = LZ4_uncompress_unknownOutputSize_ssse3,
+	.is_supported = lz4_ssse3_will_work,
+	.uses_fpu = B_TRUE,
+	.name = "ssse3"
+};
+#endif
+
+#if defined(__x86_64) && defined(HAVE_SSE2) && defined(HAVE_SSSE3) && \
+	defined(HAVE_AVX2)
+static boolean_t
+lz4_avx2_will_work(void)
+{
+	return (kfpu_allowed() && zfs_ssse3_available() &&
+	    zfs_avx2_available());
+}
+
+static const lz4_impl_ops_t lz4_avx2_impl = {
+	.compress = LZ4_compress_avx2,
+	.decompress = LZ4_uncompress_unknownOutputSize_avx2,
+	.is_supported = lz4_avx2_will_work,
+	.uses_fpu = B_TRUE,
+	.name = "avx2"
+};
+#endif
+
+/* All compiled in implementations */
+static const lz4_impl_ops_t *const lz4_impls[] = {
+	&lz4_scalar_impl,
+#if defined(__x86_64) && defined(HAVE_SSE2)
+	&lz4_sse2_impl,
+#endif
+#if defined(__x86_64) && defined(HAVE_SSE2) && defined(HAVE_SSSE3)
+	&lz4_ssse3_impl,
+#endif
+#if defined(__x86_64) && defined(HAVE_SSE2) && defined(HAVE_SSSE3) && \
+	defined(HAVE_AVX2)
+	&lz4_avx2_impl,
+#endif
+};
+
+/* Hold all supported implementations */
+static uint32_t lz4_supp_impls_cnt = 0;
+static const lz4_impl_ops_t *lz4_supp_impls[ARRAY_SIZE(lz4_impls)];
+
+/* Fastest compressor and decompressor, possibly from different impls */
+static lz4_impl_ops_t lz4_fastest_impl = {
+	.name = "fastest"
+};
+
+/* Select LZ4 implementation */
+#define	IMPL_FASTEST	(UINT32_MAX)
+#define	IMPL_CYCLE	(UINT32_MAX - 1)
+#define	IMPL_SCALAR	(0)
+
+static uint32_t lz4_impl_chosen = IMPL_FASTEST;
+
+#define	IMPL_READ(i)	(*(volatile uint32_t *) &(i))
+
+static struct lz4_impl_selector {
+	const char	*lis_name;
+	uint32_t	lis_sel;
+} lz4_impl_selectors[] = {
+	{ "cycle",	IMPL_CYCLE },
+	{ "fastest",	IMPL_FASTEST },
+	{ "scalar",	IMPL_SCALAR }
+};
+
+#if defined(_KERNEL)
+static kstat_t *lz4_kstat;
+
+static struct lz4_impl_kstat {
+	uint64_t compress;
+	uint64_t decompress;
+} lz4_stat_data[ARRAY_SIZE(lz4_impls) + 1];
+#endif
+
+/* Indicate that benchmark has been completed */
+static boolean_t lz4_initialized = B_FALSE;
+
+int
+lz4_impl_set(const char *val)
+{
+	int err = -EINVAL;
+	uint32_t impl = IMPL_READ(lz4_impl_chosen);
+	size_t i, val_len;
+
+	val_len = strlen(val);
+	while ((val_len > 0) && !!isspace(val[val_len-1])) /* trim '\n' */
+		val_len--;
+
+	/* check mandatory implementations */
+	for (i = 0; i < ARRAY_SIZE(lz4_impl_selectors); i++) {
+		const char *name = lz4_impl_selectors[i].lis_name;
+
+		if (val_len == strlen(name) &&
+		    strncmp(val, name, val_len) == 0) {
+			impl = lz4_impl_selectors[i].lis_sel;
+			err = 0;
+			break;
+		}
+	}
+
+	if (err != 0 && lz4_initialized) {
+		/* check all supported implementations */
+		for (i = 0; i < lz4_supp_impls_cnt; i++) {
+			const char *name = lz4_supp_impls[i]->name;
+
+			if (val_len == strlen(name) &&
+			    strncmp(val, name, val_len) == 0) {
+				impl = i;
+				err = 0;
+				break;
+			}
+		}
+	}
+
+	if (err == 0) {
+		atomic_swap_32(&lz4_impl_chosen, impl);
+		membar_producer();
+	}
+
+	return (err);
+}
+
+/*
+ * Returns the LZ4 operations to use.  When a SIMD implementation is not
+ * allowed in the current context, then fallback to the scalar one.
+ */
+static const lz4_impl_ops_t *
+lz4_impl_get(void)
+{
+	if (!kfpu_allowed())
+		return (&lz4_scalar_impl);
+
+	const lz4_impl_ops_t *ops = NULL;
+	uint32_t impl = IMPL_READ(lz4_impl_chosen);
+
+	switch (impl) {
+	case IMPL_FASTEST:
+		ASSERT(lz4_initialized);
+		ops = &lz4_fastest_impl;
+		break;
+	case IMPL_CYCLE:
+		/* Cycle through supported implementations */
+		ASSERT(lz4_initialized);
+		ASSERT3U(lz4_supp_impls_cnt, >, 0);
+		static uint32_t cycle_count = 0;
+		uint32_t idx = (++cycle_count) % lz4_supp_impls_cnt;
+		ops = lz4_supp_impls[idx];
+		break;
+	default:
+		ASSERT3U(lz4_supp_impls_cnt, >, 0);
+		ASSERT3U(impl, <, lz4_supp_impls_cnt);
+		ops = lz4_supp_impls[impl];
+		break;
+	}
+
+	ASSERT3P(ops, !=, NULL);
+
+	return (ops);
+}
+
 static int
 real_LZ4_compress(const char *source, char *dest, int isize, int osize)
 {
+	const lz4_impl_ops_t *ops;
 	void *ctx;
 	int result;
 
@@ -858,28 +1224,401 @@ real_LZ4_compress(const char *source, char *dest, int isize, int osize)
 
 	memset(ctx, 0, sizeof (struct refTables));
 
-	if (isize < LZ4_64KLIMIT)
-		result = LZ4_compress64kCtx(ctx, source, dest, isize, osize);
-	else
-		result = LZ4_compressCtx(ctx, source, dest, isize, osize);
+	/* the SIMD encoder re-enters the FPU every LZ4_FPU_CHUNK bytes */
+	ops = lz4_impl_get();
+	if (ops->uses_fpu)
+		kfpu_begin();
+	result = ops->compress(ctx, source, dest, isize, osize);
+	if (ops->uses_fpu)
+		kfpu_end();
 
 	kmem_cache_free(lz4_cache, ctx);
 	return (result);
 }
 
+#if defined(_KERNEL)
+/*
+ * LZ4 kstats
+ */
+static int
+lz4_kstat_headers(char *buf, size_t size)
+{
+	ssize_t off = 0;
+
+	off += snprintf(buf + off, size, "%-17s", "implementation");
+	off += snprintf(buf + off, size - off, "%-15s", "compress");
+	(void) snprintf(buf + off, size - off, "%-15s\n", "decompress");
+
+	return (0);
+}
+
+static int
+lz4_kstat_data(char *buf, size_t size, void *data)
+{
+	struct lz4_impl_kstat *fastest_stat =
+	    &lz4_stat_data[lz4_supp_impls_cnt];
+	struct lz4_impl_kstat *curr_stat = (struct lz4_impl_kstat *)data;
+	ssize_t off = 0;
+
+	if (curr_stat == fastest_stat) {
+		off += snprintf(buf + off, size - off, "%-17s", "fastest");
+		off += snprintf(buf + off, size - off, "%-15s",
+		    lz4_supp_impls[fastest_stat->compress]->name);
+		(void) snprintf(buf + off, size - off, "%-15s\n",
+		    lz4_supp_impls[fastest_stat->decompress]->name);
+	} else {
+		ptrdiff_t id = curr_stat - lz4_stat_data;
+
+		off += snprintf(buf + off, size - off, "%-17s",
+		    lz4_supp_impls[id]->name);
+		off += snprintf(buf + off, size - off, "%-15llu",
+		    (u_longlong_t)curr_stat->compress);
+		(void) snprintf(buf + off, size - off, "%-15llu\n",
+		    (u_longlong_t)curr_stat->decompress);
+	}
+
+	return (0);
+}
+
+static void *
+lz4_kstat_addr(kstat_t *ksp, loff_t n)
+{
+	if (n <= lz4_supp_impls_cnt)
+		ksp->ks_private = (void *) (lz4_stat_data + n);
+	else
+		ksp->ks_private = NULL;
+
+	return (ksp->ks_private);
+}
+
+#define	LZ4_BENCH_SIZE	(1 << SPA_OLD_MAXBLOCKSHIFT)	/* 128kiB */
+#define	LZ4_BENCH_NS	(MSEC2NSEC(1))			/* 1ms */
+
+#define	LZ4_BENCH_RAND(x) \
+	((x) = (x) * 6364136223846793005ULL + 1442695040888963407ULL)
+
+/*
+ * Fill the benchmark buffer with compressible data: short runs of literals
+ * from a small alphabet, interleaved with matches at both short (less than
+ * 16 bytes, i.e. overlapping) and long offsets so that every copy kernel
+ * of the decompressor is exercised.
+ */
+static void
+lz4_benchmark_fill(uint8_t *buf, size_t size)
+{
+	uint64_t x = 0x9e3779b97f4a7c15ULL;
+	size_t i = 0, len, off;
+
+	while (i < size) {
+		uint32_t r = LZ4_BENCH_RAND(x) >> 32;
+
+		if (i < 64 || (r & 3) == 0) {
+			len = MIN(1 + (r >> 8) % 32, size - i);
+			for (; len > 0; len--, i++)
+				buf[i] = 'a' + (LZ4_BENCH_RAND(x) >> 59);
+		} else {
+			off = (r & 4) ? 1 + (r >> 16) % 15 :
+			    1 + (r >> 16) % MIN(i, 4096);
+			len = MIN(4 + (r >> 8) % 64, size - i);
+			for (; len > 0; len--, i++)
+				buf[i] = buf[i - off];
+		}
+	}
+}
+
+typedef int lz4_bench_f(const lz4_impl_ops_t *ops, void *ctx,
+    const char *src, char *dst, int len, int size);
+
+static int
+lz4_bench_compress(const lz4_impl_ops_t *ops, void *ctx, const char *src,
+    char *dst, int len, int size)
+{
+	int result;
+
+	memset(ctx, 0, sizeof (struct refTables));
+	if (ops->uses_fpu)
+		kfpu_begin();
+	result = ops->compress(ctx, src, dst, len, size);
+	if (ops->uses_fpu)
+		kfpu_end();
+
+	return (result);
+}
+
+static int
+lz4_bench_decompress(const lz4_impl_ops_t *ops, void *ctx, const char *src,
+    char *dst, int len, int size)
+{
+	(void) ctx;
+	int result;
+
+	if (ops->uses_fpu)
+		kfpu_begin();
+	result = ops->decompress(src, dst, len, size);
+	if (ops->uses_fpu)
+		kfpu_end();
+
+	return (result);
+}
+
+static uint64_t
+lz4_benchmark_run(lz4_bench_f *func, const lz4_impl_ops_t *ops, void *ctx,
+    const char *src, char *dst, int len)
+{
+	uint64_t run_bw, run_time_ns, run_count = 0;
+	hrtime_t start;
+
+	kpreempt_disable();
+	start = gethrtime();
+	do {
+		(void) func(ops, ctx, src, dst, len, LZ4_BENCH_SIZE);
+		run_count++;
+		run_time_ns = gethrtime() - start;
+	} while (run_time_ns < LZ4_BENCH_NS);
+	kpreempt_enable();
+
+	run_bw = LZ4_BENCH_SIZE * run_count * NANOSEC;
+	run_bw /= run_time_ns;	/* B/s */
+
+	return (run_bw);
+}
+
+static void
+lz4_benchmark_impl(void)
+{
+	struct lz4_impl_kstat *fastest_stat =
+	    &lz4_stat_data[lz4_supp_impls_cnt];
+	uint64_t best_compress = 0, best_decompress = 0;
+	char *src = vmem_alloc(LZ4_BENCH_SIZE, KM_SLEEP);
+	char *ref = vmem_alloc(LZ4_BENCH_SIZE, KM_SLEEP);
+	char *dst = vmem_alloc(LZ4_BENCH_SIZE, KM_SLEEP);
+	void *ctx = kmem_cache_alloc(lz4_cache, KM_SLEEP);
+	int ref_len, len;
+
+	lz4_benchmark_fill((uint8_t *)src, LZ4_BENCH_SIZE);
+
+	/* The scalar compressor provides the reference stream */
+	ref_len = lz4_bench_compress(&lz4_scalar_impl, ctx, src, ref,
+	    LZ4_BENCH_SIZE, LZ4_BENCH_SIZE);
+	VERIFY3S(ref_len, >, 0);
+
+	for (uint32_t i = 0; i < lz4_supp_impls_cnt; i++) {
+		const lz4_impl_ops_t *ops = lz4_supp_impls[i];
+		struct lz4_impl_kstat *stat = &lz4_stat_data[i];
+
+		/*
+		 * An implementation which does not produce the reference
+		 * stream, or fails to restore the original data from it,
+		 * reports zero throughput and is never picked as fastest.
+		 */
+		len = lz4_bench_compress(ops, ctx, src, dst, LZ4_BENCH_SIZE,
+		    LZ4_BENCH_SIZE);
+		if (len == ref_len && memcmp(dst, ref, len) == 0) {
+			stat->compress = lz4_benchmark_run(lz4_bench_compress,
+			    ops, ctx, src, dst, LZ4_BENCH_SIZE);
+		} else {
+			stat->compress = 0;
+		}
+
+		len = lz4_bench_decompress(ops, ctx, ref, dst, ref_len,
+		    LZ4_BENCH_SIZE);
+		if (len == LZ4_BENCH_SIZE &&
+		    memcmp(dst, src, LZ4_BENCH_SIZE) == 0) {
+			stat->decompress = lz4_benchmark_run(
+			    lz4_bench_decompress, ops, ctx, ref, dst, ref_len);
+		} else {
+			stat->decompress = 0;
+		}
+
+		if (stat->compress > best_compress) {
+			best_compress = stat->compress;
+			fastest_stat->compress = i;
+		}
+		if (stat->decompress > best_decompress) {
+			best_decompress = stat->decompress;
+			fastest_stat->decompress = i;
+		}
+	}
+
+	lz4_fastest_impl.compress =
+	    lz4_supp_impls[fastest_stat->compress]->compress;
+	lz4_fastest_impl.decompress =
+	    lz4_supp_impls[fastest_stat->decompress]->decompress;
+	lz4_fastest_impl.uses_fpu =
+	    lz4_supp_impls[fastest_stat->compress]->uses_fpu ||
+	    lz4_supp_impls[fastest_stat->decompress]->uses_fpu;
+
+	kmem_cache_free(lz4_cache, ctx);
+	vmem_free(dst, LZ4_BENCH_SIZE);
+	vmem_free(ref, LZ4_BENCH_SIZE);
+	vmem_free(src, LZ4_BENCH_SIZE);
+}
+#endif /* _KERNEL */
+
+/*
+ * Initialize and benchmark all supported implementations.
+ */
+static void
+lz4_benchmark(void)
+{
+	const lz4_impl_ops_t *curr_impl;
+	int i, c;
+
+	/* Move supported implementations into lz4_supp_impls */
+	for (i = 0, c = 0; i < ARRAY_SIZE(lz4_impls); i++) {
+		curr_impl = lz4_impls[i];
+
+		if (curr_impl->is_supported())
+			lz4_supp_impls[c++] = curr_impl;
+	}
+	membar_producer();	/* complete lz4_supp_impls[] init */
+	lz4_supp_impls_cnt = c;	/* number of supported impl */
+
+#if defined(_KERNEL)
+	lz4_benchmark_impl();
+#else
+	/*
+	 * Skip the benchmark in user space to avoid impacting libzpool
+	 * consumers (zdb, zhack, zinject, ztest).  The last implementation
+	 * is assumed to be the fastest and used by default.
+	 */
+	curr_impl = lz4_supp_impls[lz4_supp_impls_cnt - 1];
+	lz4_fastest_impl.compress = curr_impl->compress;
+	lz4_fastest_impl.decompress = curr_impl->decompress;
+	lz4_fastest_impl.uses_fpu = curr_impl->uses_fpu;
+#endif /* _KERNEL */
+	membar_producer();
+}
+
 void
 lz4_init(void)
 {
 	lz4_cache = kmem_cache_create("lz4_cache",
 	    sizeof (struct refTables), 0, NULL, NULL, NULL, NULL, NULL,
 	    KMC_RECLAIMABLE);
+
+	/* Determine the fastest available implementation. */
+	lz4_benchmark();
+
+#if defined(_KERNEL)
+	/* Install kstats for all implementations */
+	lz4_kstat = kstat_create("zfs", 0, "lz4_bench", "misc",
+	    KSTAT_TYPE_RAW, 0, KSTAT_FLAG_VIRTUAL);
+	if (lz4_kstat != NULL) {
+		lz4_kstat->ks_data = NULL;
+		lz4_kstat->ks_ndata = UINT32_MAX;
+		kstat_set_raw_ops(lz4_kstat,
+		    lz4_kstat_headers,
+		    lz4_kstat_data,
+		    lz4_kstat_addr);
+		kstat_install(lz4_kstat);
+	}
+#endif
+
+	/* Finish initialization */
+	lz4_initialized = B_TRUE;
 }
 
 void
 lz4_fini(void)
 {
+#if defined(_KERNEL)
+	if (lz4_kstat != NULL) {
+		kstat_delete(lz4_kstat);
+		lz4_kstat = NULL;
+	}
+#endif
+	lz4_initialized = B_FALSE;
+
 	if (lz4_cache) {
 		kmem_cache_destroy(lz4_cache);
 		lz4_cache = NULL;
 	}
 }
+
+#if defined(_KERNEL)
+
+#define	IMPL_FMT(impl, i)	(((impl) == (i)) ? "[%s] " : "%s ")
+
+#if defined(__linux__)
+
+static int
+lz4_param_get(char *buffer, zfs_kernel_param_t *unused)
+{
+	const uint32_t impl = IMPL_READ(lz4_impl_chosen);
+	char *fmt;
+	int cnt = 0;
+
+	/* list mandatory selectors */
+	fmt = IMPL_FMT(impl, IMPL_FASTEST);
+	cnt += kmem_scnprintf(buffer + cnt, PAGE_SIZE - cnt, fmt, "fastest");
+
+	/* list all supported implementations */
+	for (uint32_t i = 0; i < lz4_supp_impls_cnt; ++i) {
+		fmt = IMPL_FMT(impl, i);
+		cnt += kmem_scnprintf(buffer + cnt, PAGE_SIZE - cnt, fmt,
+		    lz4_supp_impls[i]->name);
+	}
+
+	return (cnt);
+}
+
+static int
+lz4_param_set(const char *val, zfs_kernel_param_t *unused)
+{
+	return (lz4_impl_set(val));
+}
+
+#else
+
+#include <sys/sbuf.h>
+
+static int
+lz4_param(ZFS_MODULE_PARAM_ARGS)
+{
+	int err;
+
+	if (req->newptr == NULL) {
+		const uint32_t impl = IMPL_READ(lz4_impl_chosen);
+		const int init_buflen = 64;
+		const char *fmt;
+		struct sbuf *s;
+
+		s = sbuf_new_for_sysctl(NULL, NULL, init_buflen, req);
+
+		/* list fastest */
+		fmt = IMPL_FMT(impl, IMPL_FASTEST);
+		(void) sbuf_printf(s, fmt, "fastest");
+
+		/* list all supported implementations */
+		for (uint32_t i = 0; i < lz4_supp_impls_cnt; ++i) {
+			fmt = IMPL_FMT(impl, i);
+			(void) sbuf_printf(s, fmt, lz4_supp_impls[i]->name);
+		}
+
+		err = sbuf_finish(s);
+		sbuf_delete(s);
+
+		return (err);
+	}
+
+	char buf[16];
+
+	err = sysctl_handle_string(oidp, buf, sizeof (buf), req);
+	if (err)
+		return (err);
+	return (-lz4_impl_set(buf));
+}
+
+#endif
+
+#undef IMPL_FMT
+
+/*
+ * Choose an LZ4 implementation; "cycle" rotates through all supported
+ * implementations on every call and is only meant for testing.
+ */
+ZFS_MODULE_VIRTUAL_PARAM_CALL(zfs, zfs_, lz4_impl,
+    lz4_param_set, lz4_param_get, ZMOD_RW,
+	"Select LZ4 implementation.");
+#endif
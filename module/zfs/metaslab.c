@@ -721,6 +721,12 @@ metaslab_class_get_dspace(metaslab_class_t *mc)
 	return (spa_deflate(mc->mc_spa) ? mc->mc_dspace : mc->mc_space);
 }
 
+uint64_t
+metaslab_class_get_groups(metaslab_class_t *mc)
+{
+	return (mc->mc_groups);
+}
+
 void
 metaslab_class_histogram_verify(metaslab_class_t *mc)
 {
@@ -3906,8 +3912,8 @@ metaslab_condense(metaslab_t *msp, dmu_tx_t *tx)
 
 	ASSERT3U(spa->spa_unflushed_stats.sus_memused, >=,
 	    metaslab_unflushed_changes_memused(msp));
-	spa->spa_unflushed_stats.sus_memused -=
-	    metaslab_unflushed_changes_memused(msp);
+	atomic_sub_64(&spa->spa_unflushed_stats.sus_memused,
+	    metaslab_unflushed_changes_memused(msp));
 	zfs_range_tree_vacate(msp->ms_unflushed_allocs, NULL, NULL);
 	zfs_range_tree_vacate(msp->ms_unflushed_frees, NULL, NULL);
 
@@ -4247,9 +4253,14 @@ metaslab_sync(metaslab_t *msp, uint64_t txg)
 	tx = dmu_tx_create_assigned(spa_get_dsl(spa), txg);
 
 	/*
-	 * Generate a log space map if one doesn't exist already.
+	 * Generate a log space map if one doesn't exist already.  The
+	 * metaslabs of different vdevs may be synced concurrently (see
+	 * spa_sync_vdevs()), so anything touching the log space map and
+	 * its bookkeeping is serialized by the spa_syncing_log_sm_lock.
 	 */
+	mutex_enter(&spa->spa_syncing_log_sm_lock);
 	spa_generate_syncing_log_sm(spa, tx);
+	mutex_exit(&spa->spa_syncing_log_sm_lock);
 
 	if (msp->ms_sm == NULL) {
 		uint64_t new_object = space_map_alloc(mos,
@@ -4317,6 +4328,7 @@ metaslab_sync(metaslab_t *msp, uint64_t txg)
 	space_map_t *log_sm = spa_syncing_log_sm(spa);
 	if (log_sm != NULL) {
 		ASSERT(spa_feature_is_enabled(spa, SPA_FEATURE_LOG_SPACEMAP));
+		mutex_enter(&spa->spa_syncing_log_sm_lock);
 		if (metaslab_unflushed_txg(msp) == 0)
 			metaslab_unflushed_add(msp, tx);
 		else if (!metaslab_unflushed_dirty(msp))
@@ -4326,18 +4338,18 @@ metaslab_sync(metaslab_t *msp, uint64_t txg)
 		    vd->vdev_id, tx);
 		space_map_write(log_sm, msp->ms_freeing, SM_FREE,
 		    vd->vdev_id, tx);
+		mutex_exit(&spa->spa_syncing_log_sm_lock);
 		mutex_enter(&msp->ms_lock);
 
-		ASSERT3U(spa->spa_unflushed_stats.sus_memused, >=,
-		    metaslab_unflushed_changes_memused(msp));
-		spa->spa_unflushed_stats.sus_memused -=
-		    metaslab_unflushed_changes_memused(msp);
+		uint64_t memused = metaslab_unflushed_changes_memused(msp);
+		ASSERT3U(spa->spa_unflushed_stats.sus_memused, >=, memused);
 		zfs_range_tree_remove_xor_add(alloctree,
 		    msp->ms_unflushed_frees, msp->ms_unflushed_allocs);
 		zfs_range_tree_remove_xor_add(msp->ms_freeing,
 		    msp->ms_unflushed_allocs, msp->ms_unflushed_frees);
-		spa->spa_unflushed_stats.sus_memused +=
-		    metaslab_unflushed_changes_memused(msp);
+		atomic_add_64(&spa->spa_unflushed_stats.sus_memused,
+		    (int64_t)metaslab_unflushed_changes_memused(msp) -
+		    (int64_t)memused);
 	} else {
 		ASSERT(!spa_feature_is_enabled(spa, SPA_FEATURE_LOG_SPACEMAP));
 
@@ -4368,8 +4380,8 @@ metaslab_sync(metaslab_t *msp, uint64_t txg)
 		    msp->ms_checkpointing, SM_FREE, SM_NO_VDEVID, tx);
 		mutex_enter(&msp->ms_lock);
 
-		spa->spa_checkpoint_info.sci_dspace +=
-		    zfs_range_tree_space(msp->ms_checkpointing);
+		atomic_add_64(&spa->spa_checkpoint_info.sci_dspace,
+		    zfs_range_tree_space(msp->ms_checkpointing));
 		vd->vdev_stat.vs_checkpoint_space +=
 		    zfs_range_tree_space(msp->ms_checkpointing);
 		ASSERT3U(vd->vdev_stat.vs_checkpoint_space, ==,
@@ -6015,6 +6027,101 @@ metaslab_alloc_range(spa_t *spa, metaslab_class_t *mc, uint64_t psize,
 	return (0);
 }
 
+/*
+ * Allocate single copy blocks for several i/os of the same class, txg and
+ * allocator at once.  One range large enough for all of them is taken from
+ * a metaslab of the group at the rotor and carved into consecutive DVAs, so
+ * that the metaslab and its range trees are searched once instead of once
+ * per block, and the blocks end up next to each other on disk.
+ *
+ * If the largest range found is shorter than asked for, only the leading
+ * blocks which fit in it are allocated and the rest of the range is given
+ * back.  Returns the number of blocks allocated, possibly zero; the caller
+ * is expected to allocate the others with metaslab_alloc(), which also does
+ * everything needed when the class is short on space.
+ */
+int
+metaslab_alloc_batch(spa_t *spa, metaslab_class_t *mc, int count,
+    const uint64_t *psize, blkptr_t **bp, uint64_t txg, int flags,
+    zio_alloc_list_t *zal, int allocator, const void **tag)
+{
+	metaslab_class_allocator_t *mca = &mc->mc_allocator[allocator];
+	metaslab_group_t *mg;
+	vdev_t *vd;
+	int n = 0;
+
+	ASSERT3S(count, >, 0);
+	ASSERT3P(zal, !=, NULL);
+
+	/* Leave the forced gang blocks of ztest to metaslab_alloc() */
+	if (metaslab_force_ganging_pct > 0) {
+		while (n < count && psize[n] < metaslab_force_ganging)
+			n++;
+		count = n;
+		n = 0;
+		if (count == 0)
+			return (0);
+	}
+
+	spa_config_enter(spa, SCL_ALLOC, FTAG, RW_READER);
+
+	mg = mca->mca_rotor;
+	if (mg == NULL || !metaslab_group_allocatable(spa, mg, psize[0], 0,
+	    flags, B_FALSE, zal, allocator)) {
+		spa_config_exit(spa, SCL_ALLOC, FTAG);
+		return (0);
+	}
+
+	vd = mg->mg_vd;
+	uint64_t asize = vdev_psize_to_asize_txg(vd, psize[0], txg);
+	uint64_t max_asize = 0;
+	for (int i = 0; i < count; i++) {
+		ASSERT0(BP_GET_NDVAS(bp[i]));
+		max_asize += vdev_psize_to_asize_txg(vd, psize[i], txg);
+	}
+
+	dva_t dva;
+	memset(&dva, 0, sizeof (dva_t));
+	uint64_t offset = metaslab_group_alloc(mg, zal, asize, max_asize, txg,
+	    &dva, 0, allocator, B_FALSE, &asize);
+	if (offset == -1ULL) {
+		spa_config_exit(spa, SCL_ALLOC, FTAG);
+		return (0);
+	}
+	ASSERT0(P2PHASE(asize, 1ULL << vd->vdev_ashift));
+
+	uint64_t used = 0, used_psize = 0;
+	for (n = 0; n < count; n++) {
+		uint64_t bsize = vdev_psize_to_asize_txg(vd, psize[n], txg);
+		if (used + bsize > asize)
+			break;
+
+		dva_t *bdva = &bp[n]->blk_dva[0];
+		DVA_SET_VDEV(bdva, vd->vdev_id);
+		DVA_SET_OFFSET(bdva, offset + used);
+		DVA_SET_GANG(bdva, 0);
+		DVA_SET_ASIZE(bdva, bsize);
+		BP_SET_BIRTH(bp[n], txg, 0);
+		metaslab_group_alloc_increment(spa, vd->vdev_id, allocator,
+		    flags, psize[n], tag[n]);
+		used += bsize;
+		used_psize += psize[n];
+	}
+	ASSERT3S(n, >, 0);
+
+	if (used < asize) {
+		DVA_SET_VDEV(&dva, vd->vdev_id);
+		DVA_SET_OFFSET(&dva, offset + used);
+		DVA_SET_ASIZE(&dva, asize - used);
+		metaslab_unalloc_dva(spa, &dva, txg);
+	}
+	metaslab_class_rotate(mg, allocator, used_psize, B_TRUE);
+
+	spa_config_exit(spa, SCL_ALLOC, FTAG);
+
+	return (n);
+}
+
 void
 metaslab_free(spa_t *spa, const blkptr_t *bp, uint64_t txg, boolean_t now)
 {
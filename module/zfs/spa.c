@@ -289,6 +289,13 @@ uint64_t	zfs_max_missing_tvds_scan = 0;
  */
 static const boolean_t	zfs_pause_spa_sync = B_FALSE;
 
+/*
+ * Sync the dirty metaslabs of different top-level vdevs in parallel on the
+ * dp_sync_taskq, whose thread count follows spa_num_allocators.  When
+ * disabled all metaslabs are synced one at a time by the sync thread.
+ */
+static int spa_sync_metaslabs_parallel = B_TRUE;
+
 /*
  * Variables to indicate the livelist condense zthr func should wait at certain
  * points for the livelist to be removed - used to test condense/destroy races
@@ -720,6 +727,12 @@ spa_prop_validate(spa_t *spa, nvlist_t *props)
 			error = nvpair_value_uint64(elem, &intval);
 			break;
 
+		case ZPOOL_PROP_SCRUB_RATE:
+			error = nvpair_value_uint64(elem, &intval);
+			if (!error && intval != 0 && intval < SCAN_RATE_MIN)
+				error = SET_ERROR(EINVAL);
+			break;
+
 		case ZPOOL_PROP_DELEGATION:
 		case ZPOOL_PROP_AUTOREPLACE:
 		case ZPOOL_PROP_LISTSNAPS:
@@ -2029,6 +2042,10 @@ spa_destroy_aux_threads(spa_t *spa)
 		zthr_destroy(spa->spa_raidz_expand_zthr);
 		spa->spa_raidz_expand_zthr = NULL;
 	}
+	if (spa->spa_hotset_zthr != NULL) {
+		zthr_destroy(spa->spa_hotset_zthr);
+		spa->spa_hotset_zthr = NULL;
+	}
 }
 
 /*
@@ -3338,6 +3355,12 @@ spa_spawn_aux_threads(spa_t *spa)
 	    zthr_create("z_checkpoint_discard",
 	    spa_checkpoint_discard_thread_check,
 	    spa_checkpoint_discard_thread, spa, minclsyspri);
+
+	spa_hotset_start(spa);
+	ASSERT3P(spa->spa_hotset_zthr, ==, NULL);
+	spa->spa_hotset_zthr =
+	    zthr_create_timer("z_hotset", spa_hotset_thread_check,
+	    spa_hotset_thread, spa, SEC2NSEC(1), minclsyspri);
 }
 
 /*
@@ -4805,6 +4828,7 @@ spa_ld_get_props(spa_t *spa)
 		spa_prop_find(spa, ZPOOL_PROP_AUTOEXPAND, &spa->spa_autoexpand);
 		spa_prop_find(spa, ZPOOL_PROP_DEDUP_TABLE_QUOTA,
 		    &spa->spa_dedup_table_quota);
+		spa_prop_find(spa, ZPOOL_PROP_SCRUB_RATE, &spa->spa_scrub_rate);
 		spa_prop_find(spa, ZPOOL_PROP_MULTIHOST, &spa->spa_multihost);
 		spa_prop_find(spa, ZPOOL_PROP_AUTOTRIM, &spa->spa_autotrim);
 		spa->spa_autoreplace = (autoreplace != 0);
@@ -6664,6 +6688,7 @@ spa_create(const char *pool, nvlist_t *nvroot, nvlist_t *props,
 	spa->spa_autotrim = zpool_prop_default_numeric(ZPOOL_PROP_AUTOTRIM);
 	spa->spa_dedup_table_quota =
 	    zpool_prop_default_numeric(ZPOOL_PROP_DEDUP_TABLE_QUOTA);
+	spa->spa_scrub_rate = zpool_prop_default_numeric(ZPOOL_PROP_SCRUB_RATE);
 
 	if (props != NULL) {
 		spa_configfile_set(spa, props, B_FALSE);
@@ -9254,6 +9279,10 @@ spa_async_suspend(spa_t *spa)
 	zthr_t *ll_condense_thread = spa->spa_livelist_condense_zthr;
 	if (ll_condense_thread != NULL)
 		zthr_cancel(ll_condense_thread);
+
+	zthr_t *hotset_thread = spa->spa_hotset_zthr;
+	if (hotset_thread != NULL)
+		zthr_cancel(hotset_thread);
 }
 
 void
@@ -9284,6 +9313,10 @@ spa_async_resume(spa_t *spa)
 	zthr_t *ll_condense_thread = spa->spa_livelist_condense_zthr;
 	if (ll_condense_thread != NULL)
 		zthr_resume(ll_condense_thread);
+
+	zthr_t *hotset_thread = spa->spa_hotset_zthr;
+	if (hotset_thread != NULL)
+		zthr_resume(hotset_thread);
 }
 
 static boolean_t
@@ -9835,6 +9868,9 @@ spa_sync_props(void *arg, dmu_tx_t *tx)
 				case ZPOOL_PROP_DEDUP_TABLE_QUOTA:
 					spa->spa_dedup_table_quota = intval;
 					break;
+				case ZPOOL_PROP_SCRUB_RATE:
+					spa->spa_scrub_rate = intval;
+					break;
 				default:
 					break;
 				}
@@ -9988,6 +10024,50 @@ spa_sync_condense_indirect(spa_t *spa, dmu_tx_t *tx)
 	}
 }
 
+static void
+spa_sync_vdev_metaslabs_task(void *arg)
+{
+	vdev_t *vd = arg;
+
+	vdev_sync_metaslabs(vd, spa_syncing_txg(vd->vdev_spa));
+}
+
+/*
+ * Sync all dirty top-level vdevs.  The metaslabs of vdevs which already
+ * have their metaslab array are first synced in parallel, one dp_sync_taskq
+ * task per vdev, since each metaslab only writes to its own space map (the
+ * shared log space map is serialized by spa_syncing_log_sm_lock).  The
+ * remainder of vdev_sync(), and the metaslabs of vdevs that are being
+ * added or removed, are then handled by the sync thread.
+ */
+static void
+spa_sync_vdevs(spa_t *spa, uint64_t txg)
+{
+	dsl_pool_t *dp = spa_get_dsl(spa);
+	txg_list_t *tl = &spa->spa_vdev_txg_list;
+	vdev_t *vd;
+
+	if (spa_sync_metaslabs_parallel) {
+		int dispatched = 0;
+
+		for (vd = txg_list_head(tl, txg); vd != NULL;
+		    vd = txg_list_next(tl, vd, txg)) {
+			if (!vdev_is_concrete(vd) || vd->vdev_removing ||
+			    vd->vdev_ms_array == 0 ||
+			    txg_list_empty(&vd->vdev_ms_list, txg))
+				continue;
+			(void) taskq_dispatch(dp->dp_sync_taskq,
+			    spa_sync_vdev_metaslabs_task, vd, TQ_SLEEP);
+			dispatched++;
+		}
+		if (dispatched > 0)
+			taskq_wait(dp->dp_sync_taskq);
+	}
+
+	while ((vd = txg_list_remove(tl, txg)) != NULL)
+		vdev_sync(vd, txg);
+}
+
 static void
 spa_sync_iterate_to_convergence(spa_t *spa, dmu_tx_t *tx)
 {
@@ -10005,7 +10085,13 @@ spa_sync_iterate_to_convergence(spa_t *spa, dmu_tx_t *tx)
 		spa_sync_aux_dev(spa, &spa->spa_l2cache, tx,
 		    ZPOOL_CONFIG_L2CACHE, DMU_POOL_L2CACHE);
 		spa_errlog_sync(spa, txg);
+
+		hrtime_t phase_start = gethrtime();
 		dsl_pool_sync(dp, txg);
+		hrtime_t phase_end = gethrtime();
+		spa->spa_sync_phase_time[SPA_SYNC_PHASE_DATASETS] +=
+		    phase_end - phase_start;
+		phase_start = phase_end;
 
 		if (pass < zfs_sync_pass_deferred_free ||
 		    spa_feature_is_active(spa, SPA_FEATURE_LOG_SPACEMAP)) {
@@ -10035,10 +10121,15 @@ spa_sync_iterate_to_convergence(spa_t *spa, dmu_tx_t *tx)
 
 		spa_flush_metaslabs(spa, tx);
 
-		vdev_t *vd = NULL;
-		while ((vd = txg_list_remove(&spa->spa_vdev_txg_list, txg))
-		    != NULL)
-			vdev_sync(vd, txg);
+		phase_end = gethrtime();
+		spa->spa_sync_phase_time[SPA_SYNC_PHASE_FREES] +=
+		    phase_end - phase_start;
+		phase_start = phase_end;
+
+		spa_sync_vdevs(spa, txg);
+
+		spa->spa_sync_phase_time[SPA_SYNC_PHASE_VDEVS] +=
+		    gethrtime() - phase_start;
 
 		if (pass == 1) {
 			/*
@@ -10222,6 +10313,8 @@ spa_sync(spa_t *spa, uint64_t txg)
 	dmu_tx_t *tx = dmu_tx_create_assigned(dp, txg);
 
 	spa->spa_sync_starttime = gethrtime();
+	memset(spa->spa_sync_phase_time, 0,
+	    sizeof (spa->spa_sync_phase_time));
 	taskq_cancel_id(system_delay_taskq, spa->spa_deadman_tqid);
 	spa->spa_deadman_tqid = taskq_dispatch_delay(system_delay_taskq,
 	    spa_deadman, spa, TQ_SLEEP, ddi_get_lbolt() +
@@ -11066,6 +11159,9 @@ ZFS_MODULE_PARAM(zfs_spa, spa_, load_verify_data, INT, ZMOD_RW,
 ZFS_MODULE_PARAM(zfs_spa, spa_, load_print_vdev_tree, INT, ZMOD_RW,
 	"Print vdev tree to zfs_dbgmsg during pool import");
 
+ZFS_MODULE_PARAM(zfs_spa, spa_, sync_metaslabs_parallel, INT, ZMOD_RW,
+	"Sync the metaslabs of different top-level vdevs in parallel");
+
 ZFS_MODULE_PARAM(zfs_zio, zio_, taskq_batch_pct, UINT, ZMOD_RW,
 	"Percentage of CPUs to run an IO worker thread");
 
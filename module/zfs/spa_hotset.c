@@ -0,0 +1,578 @@
+// SPDX-License-Identifier: CDDL-1.0
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at usr/src/OPENSOLARIS.LICENSE
+ * or https://opensource.org/licenses/CDDL-1.0.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at usr/src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*
+ * Persistent ARC hot set.
+ *
+ * The ARC starts out empty after every import, and it can take hours of
+ * cache misses before a large pool is back to its steady state hit rate.
+ * The L2ARC can be rebuilt from its devices (see l2arc_rebuild()), but
+ * that does not help pools without cache devices, nor does it bring the
+ * hottest blocks back into memory.
+ *
+ * With zfs_hotset_enabled set, arc_read() reports every block that a
+ * demand read finds newly promoted to the MFU state to spa_hotset_access(),
+ * which keeps its block pointer and bookmark in a per pool table of at most
+ * zfs_hotset_max_blocks entries.  Every zfs_hotset_save_secs the z_hotset
+ * thread drops the entries that are no longer cached and writes the rest
+ * into a MOS object, those still in the MFU first, unless that set is the
+ * same as the one saved last.  The object is
+ * referenced by the DMU_POOL_HOTSET entry of the pool directory.
+ *
+ * When the pool is imported again the same thread reads the saved set back
+ * and replays it, in order, as speculative prefetch reads at
+ * ZIO_PRIORITY_ASYNC_READ, paced to zfs_hotset_restore_rate bytes per
+ * second and stopping once the target size of the ARC is reached.  Blocks
+ * freed since the set was saved simply fail their checksum and are counted
+ * as errors.  Restored blocks are kept in the table so that the first
+ * demand read of each can be counted as a restore hit.
+ *
+ * Progress is exported in the per pool "hotset" kstat.
+ */
+
+#include <sys/zfs_context.h>
+#include <sys/spa_impl.h>
+#include <sys/spa_hotset.h>
+#include <sys/arc.h>
+#include <sys/dmu.h>
+#include <sys/dmu_tx.h>
+#include <sys/dsl_synctask.h>
+#include <sys/zap.h>
+#include <sys/zio.h>
+#include <zfs_fletcher.h>
+
+/* Record and periodically save the hot set, and restore it on import */
+static int zfs_hotset_enabled = 0;
+
+/* Seconds between saves of the hot set */
+static uint_t zfs_hotset_save_secs = 300;
+
+/* Max number of blocks tracked, and saved, per pool */
+static uint_t zfs_hotset_max_blocks = 65536;
+
+/* Bytes per second read back on import, 0 for no limit */
+static uint64_t zfs_hotset_restore_rate = 128 * 1024 * 1024;
+
+/* Entries read from the saved set and issued per batch */
+#define	SPA_HOTSET_BATCH	128
+
+typedef struct spa_hotset_ent {
+	avl_node_t		she_node;
+	spa_hotset_ent_phys_t	she_phys;
+	boolean_t		she_restored;	/* restored, not read since */
+} spa_hotset_ent_t;
+
+typedef struct spa_hotset_save_arg {
+	spa_hotset_phys_t	*shs_phys;
+	size_t			shs_size;
+} spa_hotset_save_arg_t;
+
+static const spa_hotset_kstat_values_t spa_hotset_kstat_template = {
+	{ "blocks",			KSTAT_DATA_UINT64 },
+	{ "dropped",			KSTAT_DATA_UINT64 },
+	{ "saves",			KSTAT_DATA_UINT64 },
+	{ "saved_blocks",		KSTAT_DATA_UINT64 },
+	{ "saved_txg",			KSTAT_DATA_UINT64 },
+	{ "restore_total",		KSTAT_DATA_UINT64 },
+	{ "restore_done",		KSTAT_DATA_UINT64 },
+	{ "restore_bytes",		KSTAT_DATA_UINT64 },
+	{ "restore_skipped",		KSTAT_DATA_UINT64 },
+	{ "restore_errors",		KSTAT_DATA_UINT64 },
+	{ "restore_hits",		KSTAT_DATA_UINT64 },
+};
+
+#define	SPA_HOTSET_STAT(sh, stat)	((sh)->sh_stats.stat.value.ui64)
+#define	SPA_HOTSET_INCR(sh, stat, val) \
+	atomic_add_64(&SPA_HOTSET_STAT(sh, stat), (val))
+
+/*
+ * Entries are keyed like ARC headers, by the first DVA and birth txg.
+ */
+static int
+spa_hotset_compare(const void *x1, const void *x2)
+{
+	const spa_hotset_ent_t *she1 = x1;
+	const spa_hotset_ent_t *she2 = x2;
+	const blkptr_t *bp1 = &she1->she_phys.shep_bp;
+	const blkptr_t *bp2 = &she2->she_phys.shep_bp;
+
+	int cmp = TREE_CMP(DVA_GET_VDEV(&bp1->blk_dva[0]),
+	    DVA_GET_VDEV(&bp2->blk_dva[0]));
+	if (likely(cmp))
+		return (cmp);
+
+	cmp = TREE_CMP(DVA_GET_OFFSET(&bp1->blk_dva[0]),
+	    DVA_GET_OFFSET(&bp2->blk_dva[0]));
+	if (likely(cmp))
+		return (cmp);
+
+	return (TREE_CMP(BP_GET_BIRTH(bp1), BP_GET_BIRTH(bp2)));
+}
+
+static int
+spa_hotset_kstat_update(kstat_t *ksp, int rw)
+{
+	spa_hotset_t *sh = ksp->ks_private;
+
+	if (rw == KSTAT_WRITE)
+		return (SET_ERROR(EACCES));
+
+	SPA_HOTSET_STAT(sh, shkv_blocks) = avl_numnodes(&sh->sh_tree);
+	return (0);
+}
+
+void
+spa_hotset_init(spa_t *spa)
+{
+	spa_hotset_t *sh = &spa->spa_hotset;
+	kstat_t *ksp;
+	char *name;
+
+	mutex_init(&sh->sh_lock, NULL, MUTEX_DEFAULT, NULL);
+	avl_create(&sh->sh_tree, spa_hotset_compare,
+	    sizeof (spa_hotset_ent_t), offsetof(spa_hotset_ent_t, she_node));
+	sh->sh_restored = 0;
+	sh->sh_restore_pending = B_FALSE;
+	sh->sh_restore_next = 0;
+	sh->sh_next_save = 0;
+	ZIO_SET_CHECKSUM(&sh->sh_saved_cksum, 0, 0, 0, 0);
+	memcpy(&sh->sh_stats, &spa_hotset_kstat_template,
+	    sizeof (spa_hotset_kstat_values_t));
+
+	name = kmem_asprintf("zfs/%s", spa_name(spa));
+	ksp = kstat_create(name, 0, "hotset", "misc", KSTAT_TYPE_NAMED,
+	    sizeof (spa_hotset_kstat_values_t) / sizeof (kstat_named_t),
+	    KSTAT_FLAG_VIRTUAL);
+	if (ksp != NULL) {
+		ksp->ks_lock = &sh->sh_lock;
+		ksp->ks_data = &sh->sh_stats;
+		ksp->ks_private = sh;
+		ksp->ks_update = spa_hotset_kstat_update;
+		kstat_install(ksp);
+	}
+	sh->sh_ksp = ksp;
+	kmem_strfree(name);
+}
+
+void
+spa_hotset_fini(spa_t *spa)
+{
+	spa_hotset_t *sh = &spa->spa_hotset;
+	spa_hotset_ent_t *she;
+	void *cookie = NULL;
+
+	if (sh->sh_ksp != NULL)
+		kstat_delete(sh->sh_ksp);
+
+	while ((she = avl_destroy_nodes(&sh->sh_tree, &cookie)) != NULL)
+		kmem_free(she, sizeof (spa_hotset_ent_t));
+	avl_destroy(&sh->sh_tree);
+	mutex_destroy(&sh->sh_lock);
+}
+
+/*
+ * Called when the pool is loaded, before the z_hotset thread is created,
+ * to replay the saved set from the beginning.
+ */
+void
+spa_hotset_start(spa_t *spa)
+{
+	spa_hotset_t *sh = &spa->spa_hotset;
+
+	mutex_enter(&sh->sh_lock);
+	sh->sh_restore_pending = B_TRUE;
+	sh->sh_restore_next = 0;
+	sh->sh_next_save = gethrtime() + SEC2NSEC(zfs_hotset_save_secs);
+	SPA_HOTSET_STAT(sh, shkv_restore_total) = 0;
+	SPA_HOTSET_STAT(sh, shkv_restore_done) = 0;
+	SPA_HOTSET_STAT(sh, shkv_restore_bytes) = 0;
+	SPA_HOTSET_STAT(sh, shkv_restore_skipped) = 0;
+	SPA_HOTSET_STAT(sh, shkv_restore_errors) = 0;
+	SPA_HOTSET_STAT(sh, shkv_restore_hits) = 0;
+	mutex_exit(&sh->sh_lock);
+}
+
+/*
+ * Add an entry for bp, unless the table is full.  Returns the entry, or
+ * NULL if it could not be added.
+ */
+static spa_hotset_ent_t *
+spa_hotset_add(spa_hotset_t *sh, const blkptr_t *bp,
+    const zbookmark_phys_t *zb, avl_index_t where)
+{
+	spa_hotset_ent_t *she;
+
+	ASSERT(MUTEX_HELD(&sh->sh_lock));
+
+	if (avl_numnodes(&sh->sh_tree) >= zfs_hotset_max_blocks ||
+	    (she = kmem_alloc(sizeof (*she), KM_NOSLEEP)) == NULL) {
+		SPA_HOTSET_STAT(sh, shkv_dropped)++;
+		return (NULL);
+	}
+	she->she_phys.shep_bp = *bp;
+	she->she_phys.shep_zb = *zb;
+	she->she_restored = B_FALSE;
+	avl_insert(&sh->sh_tree, she, where);
+
+	return (she);
+}
+
+/*
+ * Called by arc_read() after a demand read that either promoted the block
+ * to the MFU state or was the first one of a prefetched block.  Blocks in
+ * the MFU are recorded in the hot set, and the first read of a restored
+ * block is counted as a restore hit.
+ */
+void
+spa_hotset_access(spa_t *spa, const blkptr_t *bp, const zbookmark_phys_t *zb,
+    boolean_t mfu)
+{
+	spa_hotset_t *sh = &spa->spa_hotset;
+	spa_hotset_ent_t search, *she;
+	avl_index_t where;
+
+	if (!zfs_hotset_enabled || BP_IS_EMBEDDED(bp) || BP_IS_HOLE(bp))
+		return;
+	if (!mfu && sh->sh_restored == 0)
+		return;
+
+	search.she_phys.shep_bp = *bp;
+
+	mutex_enter(&sh->sh_lock);
+	she = avl_find(&sh->sh_tree, &search, &where);
+	if (she != NULL) {
+		if (she->she_restored) {
+			she->she_restored = B_FALSE;
+			sh->sh_restored--;
+			SPA_HOTSET_STAT(sh, shkv_restore_hits)++;
+		}
+	} else if (mfu) {
+		(void) spa_hotset_add(sh, bp, zb, where);
+	}
+	mutex_exit(&sh->sh_lock);
+}
+
+static void
+spa_hotset_remove(spa_hotset_t *sh, spa_hotset_ent_t *she)
+{
+	ASSERT(MUTEX_HELD(&sh->sh_lock));
+
+	if (she->she_restored)
+		sh->sh_restored--;
+	avl_remove(&sh->sh_tree, she);
+	kmem_free(she, sizeof (*she));
+}
+
+static void
+spa_hotset_save_sync(void *arg, dmu_tx_t *tx)
+{
+	spa_hotset_save_arg_t *shs = arg;
+	objset_t *mos = dmu_tx_pool(tx)->dp_meta_objset;
+	uint64_t obj;
+
+	if (zap_lookup(mos, DMU_POOL_DIRECTORY_OBJECT, DMU_POOL_HOTSET,
+	    sizeof (uint64_t), 1, &obj) != 0) {
+		obj = dmu_object_alloc(mos, DMU_OTN_UINT64_METADATA,
+		    SPA_OLD_MAXBLOCKSIZE, DMU_OT_NONE, 0, tx);
+		VERIFY0(zap_add(mos, DMU_POOL_DIRECTORY_OBJECT,
+		    DMU_POOL_HOTSET, sizeof (uint64_t), 1, &obj, tx));
+	}
+
+	shs->shs_phys->shp_txg = dmu_tx_get_txg(tx);
+	dmu_write(mos, obj, 0, shs->shs_size, shs->shs_phys, tx);
+	VERIFY0(dmu_free_range(mos, obj, shs->shs_size, DMU_OBJECT_END, tx));
+}
+
+/*
+ * Write the entries that are still cached to the hot set object, those in
+ * the MFU first, and drop the others from the table.  Restored blocks that
+ * have not been read since are kept in the table but not saved.  The ARC
+ * is probed on a copy of the table, so that sh_lock is not held across
+ * the lookups.
+ */
+static void
+spa_hotset_save(spa_t *spa)
+{
+	spa_hotset_t *sh = &spa->spa_hotset;
+	spa_hotset_ent_t *she;
+	spa_hotset_ent_phys_t *ents, *snap;
+	spa_hotset_save_arg_t shs;
+	uint64_t max, n = 0, nmfu = 0, nmru = 0, ndrop = 0;
+	boolean_t *restored;
+	zio_cksum_t cksum;
+	size_t size;
+
+	sh->sh_next_save = gethrtime() + SEC2NSEC(zfs_hotset_save_secs);
+
+	mutex_enter(&sh->sh_lock);
+	max = avl_numnodes(&sh->sh_tree);
+	mutex_exit(&sh->sh_lock);
+	if (max == 0)
+		return;
+
+	_Static_assert(sizeof (spa_hotset_phys_t) ==
+	    sizeof (spa_hotset_ent_phys_t), "hotset header size mismatch");
+	size = (max + 1) * sizeof (spa_hotset_ent_phys_t);
+	shs.shs_phys = vmem_zalloc(size, KM_SLEEP);
+	ents = (spa_hotset_ent_phys_t *)(shs.shs_phys + 1);
+	snap = vmem_alloc(max * sizeof (*snap), KM_SLEEP);
+	restored = vmem_alloc(max * sizeof (*restored), KM_SLEEP);
+
+	/* Entries added since max was sampled wait for the next save */
+	mutex_enter(&sh->sh_lock);
+	for (she = avl_first(&sh->sh_tree); she != NULL && n < max;
+	    she = AVL_NEXT(&sh->sh_tree, she)) {
+		snap[n] = she->she_phys;
+		restored[n++] = she->she_restored;
+	}
+	mutex_exit(&sh->sh_lock);
+
+	/*
+	 * MFU entries are filled in from the front and MRU entries from the
+	 * back, and then moved up behind the MFU ones.  Entries no longer
+	 * cached are moved to the front of the snapshot to be dropped.
+	 */
+	for (uint64_t i = 0; i < n; i++) {
+		int flags = arc_cached(spa, &snap[i].shep_bp);
+		if (flags & ARC_CACHED_IN_MFU) {
+			ents[nmfu++] = snap[i];
+		} else if (flags & ARC_CACHED_IN_MRU) {
+			if (!restored[i])
+				ents[max - ++nmru] = snap[i];
+		} else if (!(flags & ARC_CACHED_IN_L1)) {
+			snap[ndrop++] = snap[i];
+		}
+	}
+
+	if (ndrop > 0) {
+		spa_hotset_ent_t search;
+
+		mutex_enter(&sh->sh_lock);
+		for (uint64_t i = 0; i < ndrop; i++) {
+			search.she_phys.shep_bp = snap[i].shep_bp;
+			if ((she = avl_find(&sh->sh_tree, &search, NULL)) !=
+			    NULL)
+				spa_hotset_remove(sh, she);
+		}
+		mutex_exit(&sh->sh_lock);
+	}
+	vmem_free(restored, max * sizeof (*restored));
+	vmem_free(snap, max * sizeof (*snap));
+
+	memmove(&ents[nmfu], &ents[max - nmru], nmru * sizeof (*ents));
+	shs.shs_phys->shp_magic = SPA_HOTSET_MAGIC;
+	shs.shs_phys->shp_count = nmfu + nmru;
+	shs.shs_size = (nmfu + nmru + 1) * sizeof (spa_hotset_ent_phys_t);
+
+	/* Nothing to do if the set has not changed since the last save */
+	fletcher_4_native(shs.shs_phys, shs.shs_size, NULL, &cksum);
+	if (ZIO_CHECKSUM_EQUAL(cksum, sh->sh_saved_cksum)) {
+		vmem_free(shs.shs_phys, size);
+		return;
+	}
+
+	if (dsl_sync_task(spa_name(spa), NULL, spa_hotset_save_sync, &shs,
+	    howmany(shs.shs_size, SPA_OLD_MAXBLOCKSIZE) + 1,
+	    ZFS_SPACE_CHECK_NORMAL) == 0) {
+		sh->sh_saved_cksum = cksum;
+		mutex_enter(&sh->sh_lock);
+		SPA_HOTSET_STAT(sh, shkv_saves)++;
+		SPA_HOTSET_STAT(sh, shkv_saved_blocks) = nmfu + nmru;
+		SPA_HOTSET_STAT(sh, shkv_saved_txg) = shs.shs_phys->shp_txg;
+		mutex_exit(&sh->sh_lock);
+	}
+
+	vmem_free(shs.shs_phys, size);
+}
+
+static void
+spa_hotset_read_done(zio_t *zio, const zbookmark_phys_t *zb,
+    const blkptr_t *bp, arc_buf_t *buf, void *private)
+{
+	(void) zb, (void) bp;
+	spa_hotset_t *sh = private;
+
+	ASSERT0P(buf);
+	if (zio != NULL && zio->io_error != 0)
+		SPA_HOTSET_INCR(sh, shkv_restore_errors, 1);
+}
+
+/*
+ * Issue the read for one entry of the saved set.  Returns the number of
+ * bytes read, 0 if the block was skipped or is cached already.
+ */
+static uint64_t
+spa_hotset_restore_one(spa_t *spa, zio_t *pio, spa_hotset_ent_phys_t *ent)
+{
+	spa_hotset_t *sh = &spa->spa_hotset;
+	spa_hotset_ent_t search, *she;
+	blkptr_t *bp = &ent->shep_bp;
+	avl_index_t where;
+
+	if (BP_IS_HOLE(bp) || BP_IS_EMBEDDED(bp) || BP_IS_REDACTED(bp) ||
+	    BP_GET_BIRTH(bp) > spa_last_synced_txg(spa) ||
+	    zfs_blkptr_verify(spa, bp, BLK_CONFIG_NEEDED, BLK_VERIFY_ONLY)) {
+		SPA_HOTSET_INCR(sh, shkv_restore_skipped, 1);
+		return (0);
+	}
+	if (arc_cached(spa, bp) & ARC_CACHED_IN_L1)
+		return (0);
+
+	search.she_phys.shep_bp = *bp;
+	mutex_enter(&sh->sh_lock);
+	if (avl_find(&sh->sh_tree, &search, &where) == NULL &&
+	    (she = spa_hotset_add(sh, bp, &ent->shep_zb, where)) != NULL) {
+		she->she_restored = B_TRUE;
+		sh->sh_restored++;
+	}
+	mutex_exit(&sh->sh_lock);
+
+	int zio_flags = ZIO_FLAG_CANFAIL | ZIO_FLAG_SPECULATIVE;
+	arc_flags_t aflags = ARC_FLAG_NOWAIT | ARC_FLAG_PREFETCH |
+	    ARC_FLAG_PRESCIENT_PREFETCH | ARC_FLAG_NO_BUF;
+
+	/* dnodes are always read as raw and then converted later */
+	if (BP_GET_TYPE(bp) == DMU_OT_DNODE && BP_IS_PROTECTED(bp) &&
+	    BP_GET_LEVEL(bp) == 0)
+		zio_flags |= ZIO_FLAG_RAW;
+
+	(void) arc_read(pio, spa, bp, spa_hotset_read_done, sh,
+	    ZIO_PRIORITY_ASYNC_READ, zio_flags, &aflags, &ent->shep_zb);
+
+	return (BP_GET_PSIZE(bp));
+}
+
+/*
+ * Time it takes to read bytes at rate bytes per second.
+ */
+static hrtime_t
+spa_hotset_restore_time(uint64_t bytes, uint64_t rate)
+{
+	return (SEC2NSEC(bytes / rate) + (bytes % rate) * NANOSEC / rate);
+}
+
+/*
+ * Replay the saved hot set, from where it was left off if the thread was
+ * cancelled.
+ */
+static void
+spa_hotset_restore(spa_t *spa, zthr_t *zthr)
+{
+	spa_hotset_t *sh = &spa->spa_hotset;
+	objset_t *mos = spa->spa_meta_objset;
+	spa_hotset_ent_phys_t *ents;
+	spa_hotset_phys_t shp;
+	uint64_t obj, count, bytes = 0, limit = arc_target_bytes();
+	hrtime_t start = gethrtime();
+
+	if (zap_lookup(mos, DMU_POOL_DIRECTORY_OBJECT, DMU_POOL_HOTSET,
+	    sizeof (uint64_t), 1, &obj) != 0 ||
+	    dmu_read(mos, obj, 0, sizeof (shp), &shp, DMU_READ_PREFETCH) != 0 ||
+	    shp.shp_magic != SPA_HOTSET_MAGIC) {
+		sh->sh_restore_pending = B_FALSE;
+		return;
+	}
+	count = shp.shp_count;
+	SPA_HOTSET_STAT(sh, shkv_restore_total) = count;
+
+	ents = vmem_alloc(SPA_HOTSET_BATCH * sizeof (*ents), KM_SLEEP);
+	while (sh->sh_restore_next < count && !zthr_iscancelled(zthr)) {
+		uint64_t n = MIN(count - sh->sh_restore_next,
+		    SPA_HOTSET_BATCH);
+		uint64_t rate = zfs_hotset_restore_rate;
+		uint64_t i, batch = 0;
+
+		/*
+		 * Past the target size of the ARC the restore would only
+		 * evict what it read before.
+		 */
+		if (SPA_HOTSET_STAT(sh, shkv_restore_bytes) >= limit) {
+			SPA_HOTSET_INCR(sh, shkv_restore_skipped,
+			    count - sh->sh_restore_next);
+			sh->sh_restore_next = count;
+			break;
+		}
+
+		if (dmu_read(mos, obj, (sh->sh_restore_next + 1) *
+		    sizeof (*ents), n * sizeof (*ents), ents,
+		    DMU_READ_PREFETCH) != 0)
+			break;
+
+		/*
+		 * Keep each batch to about a tenth of a second worth of
+		 * reads, so that cancelling the thread does not take long.
+		 */
+		zio_t *pio = zio_root(spa, NULL, NULL, ZIO_FLAG_CANFAIL);
+		for (i = 0; i < n && (rate == 0 || batch < rate / 10); i++)
+			batch += spa_hotset_restore_one(spa, pio, &ents[i]);
+		(void) zio_wait(pio);
+
+		sh->sh_restore_next += i;
+		SPA_HOTSET_STAT(sh, shkv_restore_done) = sh->sh_restore_next;
+		SPA_HOTSET_INCR(sh, shkv_restore_bytes, batch);
+
+		bytes += batch;
+		if (rate != 0)
+			zfs_sleep_until(start +
+			    spa_hotset_restore_time(bytes, rate));
+	}
+	vmem_free(ents, SPA_HOTSET_BATCH * sizeof (*ents));
+
+	if (sh->sh_restore_next >= count)
+		sh->sh_restore_pending = B_FALSE;
+}
+
+boolean_t
+spa_hotset_thread_check(void *arg, zthr_t *zthr)
+{
+	(void) zthr;
+	spa_t *spa = arg;
+	spa_hotset_t *sh = &spa->spa_hotset;
+
+	if (!zfs_hotset_enabled || !spa_writeable(spa))
+		return (B_FALSE);
+
+	return (sh->sh_restore_pending || gethrtime() >= sh->sh_next_save);
+}
+
+void
+spa_hotset_thread(void *arg, zthr_t *zthr)
+{
+	spa_t *spa = arg;
+
+	if (spa->spa_hotset.sh_restore_pending)
+		spa_hotset_restore(spa, zthr);
+	else
+		spa_hotset_save(spa);
+}
+
+ZFS_MODULE_PARAM(zfs, zfs_hotset_, enabled, INT, ZMOD_RW,
+	"Save the hot ARC blocks of each pool and restore them on import");
+
+ZFS_MODULE_PARAM(zfs, zfs_hotset_, save_secs, UINT, ZMOD_RW,
+	"Seconds between saves of the hot set");
+
+ZFS_MODULE_PARAM(zfs, zfs_hotset_, max_blocks, UINT, ZMOD_RW,
+	"Max number of blocks in the hot set of a pool");
+
+ZFS_MODULE_PARAM(zfs, zfs_hotset_, restore_rate, U64, ZMOD_RW,
+	"Bytes per second read when restoring the hot set, 0 for no limit");
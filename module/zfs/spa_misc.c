@@ -714,6 +714,7 @@ spa_add(const char *name, nvlist_t *config, const char *altroot)
 	mutex_init(&spa->spa_vdev_top_lock, NULL, MUTEX_DEFAULT, NULL);
 	mutex_init(&spa->spa_feat_stats_lock, NULL, MUTEX_DEFAULT, NULL);
 	mutex_init(&spa->spa_flushed_ms_lock, NULL, MUTEX_DEFAULT, NULL);
+	mutex_init(&spa->spa_syncing_log_sm_lock, NULL, MUTEX_DEFAULT, NULL);
 	mutex_init(&spa->spa_activities_lock, NULL, MUTEX_DEFAULT, NULL);
 
 	cv_init(&spa->spa_async_cv, NULL, CV_DEFAULT, NULL);
@@ -745,6 +746,7 @@ spa_add(const char *name, nvlist_t *config, const char *altroot)
 	zfs_refcount_create(&spa->spa_refcount);
 	spa_config_lock_init(spa);
 	spa_stats_init(spa);
+	spa_hotset_init(spa);
 
 	ASSERT(MUTEX_HELD(&spa_namespace_lock));
 	avl_add(&spa_namespace_avl, spa);
@@ -873,6 +875,7 @@ spa_remove(spa_t *spa)
 
 	zfs_refcount_destroy(&spa->spa_refcount);
 
+	spa_hotset_fini(spa);
 	spa_stats_destroy(spa);
 	spa_config_lock_destroy(spa);
 
@@ -890,6 +893,7 @@ spa_remove(spa_t *spa)
 	cv_destroy(&spa->spa_waiters_cv);
 
 	mutex_destroy(&spa->spa_flushed_ms_lock);
+	mutex_destroy(&spa->spa_syncing_log_sm_lock);
 	mutex_destroy(&spa->spa_async_lock);
 	mutex_destroy(&spa->spa_errlist_lock);
 	mutex_destroy(&spa->spa_errlog_lock);
@@ -2595,6 +2599,7 @@ spa_init(spa_mode_t mode)
 	vdev_file_init();
 	zfs_prop_init();
 	chksum_init();
+	zio_compress_bench_init();
 	zpool_prop_init();
 	zpool_feature_init();
 	spa_config_load();
@@ -2616,6 +2621,7 @@ spa_fini(void)
 	vdev_file_fini();
 	vdev_mirror_stat_fini();
 	vdev_raidz_math_fini();
+	zio_compress_bench_fini();
 	chksum_fini();
 	zil_fini();
 	dmu_fini();
@@ -2786,6 +2792,8 @@ spa_scan_get_stats(spa_t *spa, pool_scan_stat_t *ps)
 	ps->pss_skipped = scn->scn_phys.scn_skipped;
 	ps->pss_processed = scn->scn_phys.scn_processed;
 	ps->pss_errors = scn->scn_phys.scn_errors;
+	ps->pss_min_txg = scn->scn_phys.scn_min_txg;
+	ps->pss_max_txg = scn->scn_phys.scn_max_txg;
 
 	/* data not stored on disk */
 	ps->pss_pass_exam = spa->spa_scan_pass_exam;
@@ -2808,6 +2816,8 @@ spa_scan_get_stats(spa_t *spa, pool_scan_stat_t *ps)
 	/* error scrub data not stored on disk */
 	ps->pss_pass_error_scrub_pause = spa->spa_scan_pass_errorscrub_pause;
 
+	ps->pss_rate_limit = dsl_scan_rate_limit(spa);
+
 	return (0);
 }
 
@@ -200,6 +200,7 @@ typedef struct spa_txg_history {
 	uint64_t	writes;		/* number of write operations */
 	uint64_t	ndirty;		/* number of dirty bytes */
 	hrtime_t	times[TXG_STATE_COMMITTED]; /* completion times */
+	hrtime_t	phases[SPA_SYNC_PHASES]; /* spa_sync() phase times */
 	procfs_list_node_t	sth_node;
 } spa_txg_history_t;
 
@@ -207,9 +208,10 @@ static int
 spa_txg_history_show_header(struct seq_file *f)
 {
 	seq_printf(f, "%-8s %-16s %-5s %-12s %-12s %-12s "
-	    "%-8s %-8s %-12s %-12s %-12s %-12s\n", "txg", "birth", "state",
-	    "ndirty", "nread", "nwritten", "reads", "writes",
-	    "otime", "qtime", "wtime", "stime");
+	    "%-8s %-8s %-12s %-12s %-12s %-12s %-12s %-12s %-12s\n",
+	    "txg", "birth", "state", "ndirty", "nread", "nwritten",
+	    "reads", "writes", "otime", "qtime", "wtime", "stime",
+	    "dstime", "fstime", "vstime");
 	return (0);
 }
 
@@ -247,13 +249,17 @@ spa_txg_history_show(struct seq_file *f, void *data)
 		    sth->times[TXG_STATE_WAIT_FOR_SYNC];
 
 	seq_printf(f, "%-8llu %-16llu %-5c %-12llu "
-	    "%-12llu %-12llu %-8llu %-8llu %-12llu %-12llu %-12llu %-12llu\n",
+	    "%-12llu %-12llu %-8llu %-8llu %-12llu %-12llu %-12llu %-12llu "
+	    "%-12llu %-12llu %-12llu\n",
 	    (longlong_t)sth->txg, sth->times[TXG_STATE_BIRTH], state,
 	    (u_longlong_t)sth->ndirty,
 	    (u_longlong_t)sth->nread, (u_longlong_t)sth->nwritten,
 	    (u_longlong_t)sth->reads, (u_longlong_t)sth->writes,
 	    (u_longlong_t)open, (u_longlong_t)quiesce, (u_longlong_t)wait,
-	    (u_longlong_t)sync);
+	    (u_longlong_t)sync,
+	    (u_longlong_t)sth->phases[SPA_SYNC_PHASE_DATASETS],
+	    (u_longlong_t)sth->phases[SPA_SYNC_PHASE_FREES],
+	    (u_longlong_t)sth->phases[SPA_SYNC_PHASE_VDEVS]);
 
 	return (0);
 }
@@ -366,11 +372,12 @@ spa_txg_history_set(spa_t *spa, uint64_t txg, txg_state_t completed_state,
 }
 
 /*
- * Set txg IO stats.
+ * Set txg IO stats and the time spent in each phase of spa_sync().
  */
 static int
 spa_txg_history_set_io(spa_t *spa, uint64_t txg, uint64_t nread,
-    uint64_t nwritten, uint64_t reads, uint64_t writes, uint64_t ndirty)
+    uint64_t nwritten, uint64_t reads, uint64_t writes, uint64_t ndirty,
+    const hrtime_t *phases)
 {
 	spa_history_list_t *shl = &spa->spa_stats.txg_history;
 	spa_txg_history_t *sth;
@@ -388,6 +395,8 @@ spa_txg_history_set_io(spa_t *spa, uint64_t txg, uint64_t nread,
 			sth->reads = reads;
 			sth->writes = writes;
 			sth->ndirty = ndirty;
+			for (int p = 0; p < SPA_SYNC_PHASES; p++)
+				sth->phases[p] = phases[p];
 			error = 0;
 			break;
 		}
@@ -440,7 +449,7 @@ spa_txg_history_fini_io(spa_t *spa, txg_stat_t *ts)
 	    ts->vs2.vs_bytes[ZIO_TYPE_WRITE] - ts->vs1.vs_bytes[ZIO_TYPE_WRITE],
 	    ts->vs2.vs_ops[ZIO_TYPE_READ] - ts->vs1.vs_ops[ZIO_TYPE_READ],
 	    ts->vs2.vs_ops[ZIO_TYPE_WRITE] - ts->vs1.vs_ops[ZIO_TYPE_WRITE],
-	    ts->ndirty);
+	    ts->ndirty, spa->spa_sync_phase_time);
 
 	kmem_free(ts, sizeof (txg_stat_t));
 }
@@ -3881,6 +3881,29 @@ vdev_load(vdev_t *vd)
 		if (error && error != ENOENT)
 			vdev_dbgmsg(vd, "vdev_load: zap_lookup(zap=%llu) "
 			    "failed [error=%d]", (u_longlong_t)zapobj, error);
+
+		if (vd == vd->vdev_top) {
+			error = vdev_prop_get_int(vd, VDEV_PROP_SCRUB_RATE,
+			    &vd->vdev_scrub_rate);
+			if (error && error != ENOENT)
+				vdev_dbgmsg(vd, "vdev_load: zap_lookup(zap="
+				    "%llu) failed [error=%d]",
+				    (u_longlong_t)zapobj, error);
+		}
+
+		if (vd->vdev_ops->vdev_op_leaf) {
+			uint64_t sched;
+
+			error = vdev_prop_get_int(vd, VDEV_PROP_SCHEDULER,
+			    &sched);
+			if (error && error != ENOENT) {
+				vdev_dbgmsg(vd, "vdev_load: zap_lookup(zap="
+				    "%llu) failed [error=%d]",
+				    (u_longlong_t)zapobj, error);
+			} else if (sched <= VDEV_SCHEDULER_DEADLINE) {
+				vdev_queue_set_scheduler(vd, sched);
+			}
+		}
 	}
 
 	/*
@@ -4112,12 +4135,28 @@ vdev_sync_done(vdev_t *vd, uint64_t txg)
 	}
 }
 
+/*
+ * Write out the dirty metaslabs of a top-level vdev.  This is called either
+ * from vdev_sync() or, for vdevs that already have their metaslab array,
+ * from a dp_sync_taskq task so that the metaslabs of different top-level
+ * vdevs are synced in parallel (see spa_sync_vdevs()).
+ */
+void
+vdev_sync_metaslabs(vdev_t *vd, uint64_t txg)
+{
+	metaslab_t *msp;
+
+	while ((msp = txg_list_remove(&vd->vdev_ms_list, txg)) != NULL) {
+		metaslab_sync(msp, txg);
+		(void) txg_list_add(&vd->vdev_ms_list, msp, TXG_CLEAN(txg));
+	}
+}
+
 void
 vdev_sync(vdev_t *vd, uint64_t txg)
 {
 	spa_t *spa = vd->vdev_spa;
 	vdev_t *lvd;
-	metaslab_t *msp;
 
 	ASSERT3U(txg, ==, spa->spa_syncing_txg);
 	dmu_tx_t *tx = dmu_tx_create_assigned(spa->spa_dsl_pool, txg);
@@ -4151,10 +4190,7 @@ vdev_sync(vdev_t *vd, uint64_t txg)
 		vdev_config_dirty(vd);
 	}
 
-	while ((msp = txg_list_remove(&vd->vdev_ms_list, txg)) != NULL) {
-		metaslab_sync(msp, txg);
-		(void) txg_list_add(&vd->vdev_ms_list, msp, TXG_CLEAN(txg));
-	}
+	vdev_sync_metaslabs(vd, txg);
 
 	while ((lvd = txg_list_remove(&vd->vdev_dtl_list, txg)) != NULL)
 		vdev_dtl_sync(lvd, txg);
@@ -6074,6 +6110,32 @@ vdev_prop_set(vdev_t *vd, nvlist_t *innvl, nvlist_t *outnvl)
 			}
 			vd->vdev_failfast = intval & 1;
 			break;
+		case VDEV_PROP_SCHEDULER:
+			if (nvpair_value_uint64(elem, &intval) != 0 ||
+			    intval > VDEV_SCHEDULER_DEADLINE) {
+				error = EINVAL;
+				break;
+			}
+			/* Only leaf vdevs queue I/O */
+			if (!vd->vdev_ops->vdev_op_leaf) {
+				error = ENOTSUP;
+				break;
+			}
+			vdev_queue_set_scheduler(vd, intval);
+			break;
+		case VDEV_PROP_SCRUB_RATE:
+			if (nvpair_value_uint64(elem, &intval) != 0 ||
+			    (intval != 0 && intval < SCAN_RATE_MIN)) {
+				error = EINVAL;
+				break;
+			}
+			/* Scan I/O is queued per top-level vdev */
+			if (vd != vd->vdev_top) {
+				error = ENOTSUP;
+				break;
+			}
+			vd->vdev_scrub_rate = intval;
+			break;
 		case VDEV_PROP_CHECKSUM_N:
 			if (nvpair_value_uint64(elem, &intval) != 0) {
 				error = EINVAL;
@@ -6455,6 +6517,7 @@ vdev_prop_get(vdev_t *vd, nvlist_t *innvl, nvlist_t *outnvl)
 				    intval, src);
 				break;
 			case VDEV_PROP_FAILFAST:
+			case VDEV_PROP_SCHEDULER:
 				src = ZPROP_SRC_LOCAL;
 				strval = NULL;
 
@@ -6479,6 +6542,7 @@ vdev_prop_get(vdev_t *vd, nvlist_t *innvl, nvlist_t *outnvl)
 			case VDEV_PROP_IO_T:
 			case VDEV_PROP_SLOW_IO_N:
 			case VDEV_PROP_SLOW_IO_T:
+			case VDEV_PROP_SCRUB_RATE:
 				err = vdev_prop_get_int(vd, prop, &intval);
 				if (err && err != ENOENT)
 					break;
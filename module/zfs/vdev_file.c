@@ -52,6 +52,13 @@ static taskq_t *vdev_file_taskq;
 static uint_t vdev_file_logical_ashift = SPA_MINBLOCKSHIFT;
 static uint_t vdev_file_physical_ashift = SPA_MINBLOCKSHIFT;
 
+/*
+ * Issue reads and writes with zfs_file_pread_async() and
+ * zfs_file_pwrite_async() where the platform supports it, rather than
+ * blocking a vdev_file_taskq thread on each of them.
+ */
+static int vdev_file_async = 1;
+
 void
 vdev_file_init(void)
 {
@@ -238,6 +245,66 @@ vdev_file_io_strategy(void *arg)
 	zio_delay_interrupt(zio);
 }
 
+static void
+vdev_file_io_async_done(void *arg, int error, ssize_t resid)
+{
+	zio_t *zio = arg;
+
+	zio->io_error = error;
+	if (resid != 0 && zio->io_error == 0)
+		zio->io_error = SET_ERROR(ENOSPC);
+
+	/*
+	 * We may be in interrupt context, so the buffer borrowed in
+	 * vdev_file_io_async() is returned by vdev_file_io_done().
+	 */
+	zio_delay_interrupt(zio);
+}
+
+/*
+ * Start a read or write asynchronously.  The borrowed buffer is kept in
+ * io_bio until vdev_file_io_done() returns it.  On failure nothing was
+ * issued and the caller must fall back to vdev_file_io_strategy().
+ */
+static int
+vdev_file_io_async(zio_t *zio)
+{
+	vdev_file_t *vf = zio->io_vd->vdev_tsd;
+	void *buf;
+	int err;
+
+	if (zio->io_type == ZIO_TYPE_READ) {
+		buf = abd_borrow_buf(zio->io_abd, zio->io_size);
+		zio->io_bio = buf;
+		err = zfs_file_pread_async(vf->vf_file, buf, zio->io_size,
+		    zio->io_offset, vdev_file_io_async_done, zio);
+		/*
+		 * Nothing was read, so there is nothing to copy back.  Debug
+		 * builds check that a returned copy still matches the ABD.
+		 */
+		if (err != 0) {
+#ifdef ZFS_DEBUG
+			if (!abd_is_linear(zio->io_abd))
+				abd_copy_to_buf(buf, zio->io_abd, zio->io_size);
+#endif
+			abd_return_buf(zio->io_abd, buf, zio->io_size);
+		}
+	} else {
+		buf = abd_borrow_buf_copy(zio->io_abd, zio->io_size);
+		zio->io_bio = buf;
+		err = zfs_file_pwrite_async(vf->vf_file, buf, zio->io_size,
+		    zio->io_offset, vdev_file_io_async_done, zio);
+		if (err != 0)
+			abd_return_buf(zio->io_abd, buf, zio->io_size);
+	}
+
+	/* On success the zio may already be done, so leave it alone */
+	if (err != 0)
+		zio->io_bio = NULL;
+
+	return (err);
+}
+
 static void
 vdev_file_io_fsync(void *arg)
 {
@@ -298,6 +365,9 @@ vdev_file_io_start(zio_t *zio)
 	ASSERT(zio->io_type == ZIO_TYPE_READ || zio->io_type == ZIO_TYPE_WRITE);
 	zio->io_target_timestamp = zio_handle_io_delay(zio);
 
+	if (vdev_file_async && vdev_file_io_async(zio) == 0)
+		return;
+
 	VERIFY3U(taskq_dispatch(vdev_file_taskq, vdev_file_io_strategy, zio,
 	    TQ_SLEEP), !=, TASKQID_INVALID);
 }
@@ -305,7 +375,16 @@ vdev_file_io_start(zio_t *zio)
 static void
 vdev_file_io_done(zio_t *zio)
 {
-	(void) zio;
+	void *buf = zio->io_bio;
+
+	if (buf == NULL)
+		return;
+
+	zio->io_bio = NULL;
+	if (zio->io_type == ZIO_TYPE_READ)
+		abd_return_buf_copy(zio->io_abd, buf, zio->io_size);
+	else
+		abd_return_buf(zio->io_abd, buf, zio->io_size);
 }
 
 vdev_ops_t vdev_file_ops = {
@@ -370,3 +449,5 @@ ZFS_MODULE_PARAM(zfs_vdev_file, vdev_file_, logical_ashift, UINT, ZMOD_RW,
 	"Logical ashift for file-based devices");
 ZFS_MODULE_PARAM(zfs_vdev_file, vdev_file_, physical_ashift, UINT, ZMOD_RW,
 	"Physical ashift for file-based devices");
+ZFS_MODULE_PARAM(zfs_vdev_file, vdev_file_, async, INT, ZMOD_RW,
+	"Issue file-based device I/O asynchronously where supported");
@@ -116,6 +116,30 @@
  * maximum percentage, this indicates that the rate of incoming data is
  * greater than the rate that the backend storage can handle. In this case, we
  * must further throttle incoming writes (see dmu_tx_delay() for details).
+ *
+ * Deadline Scheduling
+ *
+ * The limits above do not know how long the device actually takes to
+ * complete an operation, so a scrub or a txg sync can still push the latency
+ * of synchronous reads well beyond what the application tolerates.  Setting
+ * the "scheduler" vdev property of a leaf vdev to "deadline" changes two
+ * things for that vdev:
+ *
+ * - The foreground classes (sync read, sync write and async read) have a
+ *   latency target, zfs_vdev_*_latency_target.  Once every class is at its
+ *   min_active, the foreground class whose oldest queued i/o has the
+ *   earliest deadline (queue time + target) is issued first.
+ *
+ * - The completion latency of every class is averaged.  Whenever the average
+ *   of a foreground class exceeded its target during the last
+ *   zfs_vdev_deadline_interval_ms, the share of their min/max_active the
+ *   background classes (async write, scrub, removal, initializing, trim and
+ *   rebuild) may use is halved.  Otherwise it grows back by 5% per interval.
+ *   Async writes always keep zfs_vdev_async_write_min_active so that txgs
+ *   make progress, the other background classes keep at least one.
+ *
+ * The averages, the target misses and the current background share are
+ * exported per vdev in the vdev_queue_<guid> kstat of the pool.
  */
 
 /*
@@ -193,6 +217,51 @@ static uint_t zfs_vdev_nia_delay = 5;
  */
 static uint_t zfs_vdev_nia_credit = 5;
 
+/*
+ * Latency targets (in microseconds) of the foreground classes for vdevs
+ * using the deadline scheduler, 0 disables the target of a class.
+ */
+static uint_t zfs_vdev_sync_read_latency_target = 2000;
+static uint_t zfs_vdev_sync_write_latency_target = 2000;
+static uint_t zfs_vdev_async_read_latency_target = 10000;
+
+/* How often the deadline scheduler adjusts the background share */
+static uint_t zfs_vdev_deadline_interval_ms = 10;
+
+typedef struct vdev_queue_kstats {
+	kstat_named_t	vqks_background_pct;
+	kstat_named_t	vqks_background_decreases;
+	kstat_named_t	vqks_latency_us[ZIO_PRIORITY_NUM_QUEUEABLE];
+	kstat_named_t	vqks_slo_misses[ZIO_PRIORITY_NUM_QUEUEABLE];
+} vdev_queue_kstats_t;
+
+static const vdev_queue_kstats_t vdev_queue_kstats_template = {
+	{ "background_pct",			KSTAT_DATA_UINT64 },
+	{ "background_decreases",		KSTAT_DATA_UINT64 },
+	{
+		{ "sync_read_latency_us",	KSTAT_DATA_UINT64 },
+		{ "sync_write_latency_us",	KSTAT_DATA_UINT64 },
+		{ "async_read_latency_us",	KSTAT_DATA_UINT64 },
+		{ "async_write_latency_us",	KSTAT_DATA_UINT64 },
+		{ "scrub_latency_us",		KSTAT_DATA_UINT64 },
+		{ "removal_latency_us",		KSTAT_DATA_UINT64 },
+		{ "initializing_latency_us",	KSTAT_DATA_UINT64 },
+		{ "trim_latency_us",		KSTAT_DATA_UINT64 },
+		{ "rebuild_latency_us",		KSTAT_DATA_UINT64 },
+	},
+	{
+		{ "sync_read_slo_misses",	KSTAT_DATA_UINT64 },
+		{ "sync_write_slo_misses",	KSTAT_DATA_UINT64 },
+		{ "async_read_slo_misses",	KSTAT_DATA_UINT64 },
+		{ "async_write_slo_misses",	KSTAT_DATA_UINT64 },
+		{ "scrub_slo_misses",		KSTAT_DATA_UINT64 },
+		{ "removal_slo_misses",		KSTAT_DATA_UINT64 },
+		{ "initializing_slo_misses",	KSTAT_DATA_UINT64 },
+		{ "trim_slo_misses",		KSTAT_DATA_UINT64 },
+		{ "rebuild_slo_misses",		KSTAT_DATA_UINT64 },
+	},
+};
+
 /*
  * To reduce IOPs, we aggregate small adjacent I/Os into one large I/O.
  * For read I/Os, we also aggregate across small adjacency gaps; for writes
@@ -401,6 +470,83 @@ vdev_queue_class_max_active(vdev_queue_t *vq, zio_priority_t p)
 	}
 }
 
+static inline boolean_t
+vdev_queue_class_foreground(zio_priority_t p)
+{
+	return (p == ZIO_PRIORITY_SYNC_READ || p == ZIO_PRIORITY_SYNC_WRITE ||
+	    p == ZIO_PRIORITY_ASYNC_READ);
+}
+
+/*
+ * Latency target of a class for the deadline scheduler, 0 if none.
+ */
+static hrtime_t
+vdev_queue_class_target(zio_priority_t p)
+{
+	switch (p) {
+	case ZIO_PRIORITY_SYNC_READ:
+		return (USEC2NSEC(zfs_vdev_sync_read_latency_target));
+	case ZIO_PRIORITY_SYNC_WRITE:
+		return (USEC2NSEC(zfs_vdev_sync_write_latency_target));
+	case ZIO_PRIORITY_ASYNC_READ:
+		return (USEC2NSEC(zfs_vdev_async_read_latency_target));
+	default:
+		return (0);
+	}
+}
+
+/*
+ * Scale the min/max_active of a background class down to the share the
+ * deadline scheduler currently allows it.
+ */
+static uint_t
+vdev_queue_class_throttle(vdev_queue_t *vq, zio_priority_t p, uint_t active)
+{
+	uint_t floor;
+
+	if (vq->vq_sched != VDEV_SCHEDULER_DEADLINE ||
+	    vdev_queue_class_foreground(p))
+		return (active);
+
+	floor = (p == ZIO_PRIORITY_ASYNC_WRITE) ?
+	    zfs_vdev_async_write_min_active : 1;
+	return (MAX(MIN(active, floor), active * vq->vq_bg_pct / 100));
+}
+
+/*
+ * Return the foreground class below its max_active whose oldest queued i/o
+ * is closest to its deadline, or ZIO_PRIORITY_NUM_QUEUEABLE if none.  For
+ * the LBA-ordered async read queue the first entry of the tree is only
+ * approximately the oldest one, which is good enough here.
+ */
+static zio_priority_t
+vdev_queue_class_earliest(vdev_queue_t *vq, uint32_t cq)
+{
+	zio_priority_t best = ZIO_PRIORITY_NUM_QUEUEABLE;
+	hrtime_t best_deadline = 0;
+
+	for (zio_priority_t p = 0; p < ZIO_PRIORITY_NUM_QUEUEABLE; p++) {
+		hrtime_t target = vdev_queue_class_target(p);
+		zio_t *zio;
+
+		if (target == 0 || (cq & (1U << p)) == 0 ||
+		    vq->vq_cactive[p] >= vdev_queue_class_max_active(vq, p))
+			continue;
+
+		if (vdev_queue_class_fifo(p))
+			zio = list_head(&vq->vq_class[p].vqc_list);
+		else
+			zio = avl_first(&vq->vq_class[p].vqc_tree);
+		if (best == ZIO_PRIORITY_NUM_QUEUEABLE ||
+		    zio->io_timestamp + target < best_deadline) {
+			best = p;
+			best_deadline = zio->io_timestamp + target;
+		}
+	}
+
+	return (best);
+}
+
 /*
  * Return the i/o class to issue from, or ZIO_PRIORITY_NUM_QUEUEABLE if
  * there is no eligible class.
@@ -424,12 +570,24 @@ vdev_queue_class_to_issue(vdev_queue_t *vq)
 		p1 = 0;
 	for (p = p1; p < ZIO_PRIORITY_NUM_QUEUEABLE; p++) {
 		if ((cq & (1U << p)) != 0 && vq->vq_cactive[p] <
-		    vdev_queue_class_min_active(vq, p))
+		    vdev_queue_class_throttle(vq, p,
+		    vdev_queue_class_min_active(vq, p)))
 			goto found;
 	}
 	for (p = 0; p < p1; p++) {
 		if ((cq & (1U << p)) != 0 && vq->vq_cactive[p] <
-		    vdev_queue_class_min_active(vq, p))
+		    vdev_queue_class_throttle(vq, p,
+		    vdev_queue_class_min_active(vq, p)))
+			goto found;
+	}
+
+	/*
+	 * The deadline scheduler serves the foreground class with the most
+	 * urgent i/o first.
+	 */
+	if (vq->vq_sched == VDEV_SCHEDULER_DEADLINE) {
+		p = vdev_queue_class_earliest(vq, cq);
+		if (p != ZIO_PRIORITY_NUM_QUEUEABLE)
 			goto found;
 	}
 
@@ -439,7 +597,8 @@ vdev_queue_class_to_issue(vdev_queue_t *vq)
 	 */
 	for (p = 0; p < ZIO_PRIORITY_NUM_QUEUEABLE; p++) {
 		if ((cq & (1U << p)) != 0 && vq->vq_cactive[p] <
-		    vdev_queue_class_max_active(vq, p))
+		    vdev_queue_class_throttle(vq, p,
+		    vdev_queue_class_max_active(vq, p)))
 			break;
 	}
 
@@ -448,6 +607,63 @@ found:
 	return (p);
 }
 
+static int
+vdev_queue_kstat_update(kstat_t *ksp, int rw)
+{
+	vdev_queue_t *vq = ksp->ks_private;
+	vdev_queue_kstats_t *vqks = ksp->ks_data;
+
+	if (rw == KSTAT_WRITE)
+		return (SET_ERROR(EACCES));
+
+	/* ks_lock is vq_lock */
+	vqks->vqks_background_pct.value.ui64 = vq->vq_bg_pct;
+	vqks->vqks_background_decreases.value.ui64 = vq->vq_bg_decreases;
+	for (zio_priority_t p = 0; p < ZIO_PRIORITY_NUM_QUEUEABLE; p++) {
+		vqks->vqks_latency_us[p].value.ui64 =
+		    NSEC2USEC(vq->vq_lat[p]);
+		vqks->vqks_slo_misses[p].value.ui64 = vq->vq_slo_misses[p];
+	}
+
+	return (0);
+}
+
+static kstat_t *
+vdev_queue_kstat_create(vdev_queue_t *vq)
+{
+	vdev_t *vd = vq->vq_vdev;
+	char *mod = kmem_asprintf("zfs/%s", spa_name(vd->vdev_spa));
+	char *name = kmem_asprintf("vdev_queue_%llu",
+	    (u_longlong_t)vd->vdev_guid);
+	kstat_t *ksp;
+
+	ksp = kstat_create(mod, 0, name, "misc", KSTAT_TYPE_NAMED,
+	    sizeof (vdev_queue_kstats_t) / sizeof (kstat_named_t),
+	    KSTAT_FLAG_VIRTUAL);
+	if (ksp != NULL) {
+		vdev_queue_kstats_t *vqks = kmem_alloc(sizeof (*vqks),
+		    KM_SLEEP);
+		memcpy(vqks, &vdev_queue_kstats_template, sizeof (*vqks));
+		ksp->ks_data = vqks;
+		ksp->ks_lock = &vq->vq_lock;
+		ksp->ks_update = vdev_queue_kstat_update;
+		ksp->ks_private = vq;
+	}
+
+	kmem_strfree(name);
+	kmem_strfree(mod);
+
+	return (ksp);
+}
+
+static void
+vdev_queue_kstat_destroy(kstat_t *ksp)
+{
+	kmem_free(ksp->ks_data, sizeof (vdev_queue_kstats_t));
+	ksp->ks_data = NULL;
+	kstat_delete(ksp);
+}
+
 void
 vdev_queue_init(vdev_t *vd)
 {
@@ -478,6 +694,9 @@ vdev_queue_init(vdev_t *vd)
 	list_create(&vq->vq_active_list, sizeof (struct zio),
 	    offsetof(struct zio, io_queue_node.l));
 	mutex_init(&vq->vq_lock, NULL, MUTEX_DEFAULT, NULL);
+
+	vq->vq_sched = VDEV_SCHEDULER_CLASSIC;
+	vq->vq_bg_pct = 100;
 }
 
 void
@@ -485,6 +704,11 @@ vdev_queue_fini(vdev_t *vd)
 {
 	vdev_queue_t *vq = &vd->vdev_queue;
 
+	if (vq->vq_ksp != NULL) {
+		vdev_queue_kstat_destroy(vq->vq_ksp);
+		vq->vq_ksp = NULL;
+	}
+
 	for (zio_priority_t p = 0; p < ZIO_PRIORITY_NUM_QUEUEABLE; p++) {
 		if (vdev_queue_class_fifo(p))
 			list_destroy(&vq->vq_class[p].vqc_list);
@@ -943,6 +1167,81 @@ vdev_queue_io(zio_t *zio)
 	return (nio);
 }
 
+/*
+ * Account the completion latency of an i/o and, once per
+ * zfs_vdev_deadline_interval_ms, adjust the share of the background classes.
+ */
+static void
+vdev_queue_deadline_update(vdev_queue_t *vq, zio_t *zio, hrtime_t now)
+{
+	zio_priority_t p = zio->io_priority;
+	hrtime_t target = vdev_queue_class_target(p);
+
+	ASSERT(MUTEX_HELD(&vq->vq_lock));
+	ASSERT3U(p, <, ZIO_PRIORITY_NUM_QUEUEABLE);
+
+	vq->vq_lat[p] += (zio->io_delta - vq->vq_lat[p]) / 8;
+	if (target != 0) {
+		if (zio->io_delta > target)
+			vq->vq_slo_misses[p]++;
+		if (vq->vq_lat[p] > target)
+			vq->vq_slo_missed = B_TRUE;
+	}
+
+	if (now - vq->vq_adjust_ts < MSEC2NSEC(zfs_vdev_deadline_interval_ms))
+		return;
+	vq->vq_adjust_ts = now;
+
+	if (vq->vq_slo_missed) {
+		vq->vq_bg_pct = MAX(vq->vq_bg_pct / 2, 1);
+		vq->vq_bg_decreases++;
+	} else {
+		vq->vq_bg_pct = MIN(vq->vq_bg_pct + 5, 100);
+	}
+	vq->vq_slo_missed = B_FALSE;
+}
+
+/*
+ * Switch a leaf vdev between the classic and the deadline scheduler, see
+ * the "scheduler" vdev property.  The statistics start over on every call.
+ */
+void
+vdev_queue_set_scheduler(vdev_t *vd, vdev_scheduler_t sched)
+{
+	vdev_queue_t *vq = &vd->vdev_queue;
+	kstat_t *ksp = NULL;
+
+	ASSERT(vd->vdev_ops->vdev_op_leaf);
+
+	if (sched == VDEV_SCHEDULER_DEADLINE && vq->vq_ksp == NULL)
+		ksp = vdev_queue_kstat_create(vq);
+
+	mutex_enter(&vq->vq_lock);
+	vq->vq_sched = sched;
+	vq->vq_bg_pct = 100;
+	vq->vq_slo_missed = B_FALSE;
+	vq->vq_adjust_ts = gethrtime();
+	vq->vq_bg_decreases = 0;
+	memset(vq->vq_lat, 0, sizeof (vq->vq_lat));
+	memset(vq->vq_slo_misses, 0, sizeof (vq->vq_slo_misses));
+
+	/* Publish our kstat unless a concurrent caller beat us to it */
+	if (sched == VDEV_SCHEDULER_DEADLINE && vq->vq_ksp == NULL) {
+		vq->vq_ksp = ksp;
+		ksp = NULL;
+		if (vq->vq_ksp != NULL)
+			kstat_install(vq->vq_ksp);
+	} else if (sched == VDEV_SCHEDULER_CLASSIC) {
+		ksp = vq->vq_ksp;
+		vq->vq_ksp = NULL;
+	}
+	mutex_exit(&vq->vq_lock);
+
+	/* kstat_delete() waits for readers, which hold vq_lock */
+	if (ksp != NULL)
+		vdev_queue_kstat_destroy(ksp);
+}
+
 void
 vdev_queue_io_done(zio_t *zio)
 {
@@ -955,6 +1254,8 @@ vdev_queue_io_done(zio_t *zio)
 	vq->vq_io_delta_ts = zio->io_delta = now - zio->io_timestamp;
 
 	mutex_enter(&vq->vq_lock);
+	if (vq->vq_sched == VDEV_SCHEDULER_DEADLINE)
+		vdev_queue_deadline_update(vq, zio, now);
 	vdev_queue_pending_remove(vq, zio);
 
 	while ((nio = vdev_queue_io_to_issue(vq)) != NULL) {
@@ -1143,3 +1444,15 @@ ZFS_MODULE_PARAM(zfs_vdev, zfs_vdev_, nia_credit, UINT, ZMOD_RW,
 
 ZFS_MODULE_PARAM(zfs_vdev, zfs_vdev_, nia_delay, UINT, ZMOD_RW,
 	"Number of non-interactive I/Os before _max_active");
+
+ZFS_MODULE_PARAM(zfs_vdev, zfs_vdev_, sync_read_latency_target, UINT,
+	ZMOD_RW, "Deadline scheduler sync read latency target in us");
+
+ZFS_MODULE_PARAM(zfs_vdev, zfs_vdev_, sync_write_latency_target, UINT,
+	ZMOD_RW, "Deadline scheduler sync write latency target in us");
+
+ZFS_MODULE_PARAM(zfs_vdev, zfs_vdev_, async_read_latency_target, UINT,
+	ZMOD_RW, "Deadline scheduler async read latency target in us");
+
+ZFS_MODULE_PARAM(zfs_vdev, zfs_vdev_, deadline_interval_ms, UINT, ZMOD_RW,
+	"Deadline scheduler background throttle adjustment interval");
@@ -1700,10 +1700,12 @@ zfs_ioc_pool_scan(zfs_cmd_t *zc)
  * poolname             name of the pool
  * scan_type            scan func (pool_scan_func_t)
  * scan_command         scrub pause/resume flag (pool_scrub_cmd_t)
+ * (optional) scan_txg_start  only scrub blocks born after this txg
  */
 static const zfs_ioc_key_t zfs_keys_pool_scrub[] = {
 	{"scan_type",		DATA_TYPE_UINT64,	0},
 	{"scan_command",	DATA_TYPE_UINT64,	0},
+	{"scan_txg_start",	DATA_TYPE_UINT64,	ZK_OPTIONAL},
 };
 
 static int
@@ -1711,7 +1713,7 @@ zfs_ioc_pool_scrub(const char *poolname, nvlist_t *innvl, nvlist_t *outnvl)
 {
 	spa_t *spa;
 	int error;
-	uint64_t scan_type, scan_cmd;
+	uint64_t scan_type, scan_cmd, txgstart;
 
 	if (nvlist_lookup_uint64(innvl, "scan_type", &scan_type) != 0)
 		return (SET_ERROR(EINVAL));
@@ -1731,6 +1733,17 @@ zfs_ioc_pool_scrub(const char *poolname, nvlist_t *innvl, nvlist_t *outnvl)
 	} else if (scan_cmd == POOL_SCRUB_FROM_LAST_TXG) {
 		error = spa_scan_range(spa, scan_type,
 		    spa_get_last_scrubbed_txg(spa), 0);
+	} else if (nvlist_lookup_uint64(innvl, "scan_txg_start",
+	    &txgstart) == 0) {
+		/*
+		 * Starting would resume the paused scrub over its own range,
+		 * so it has to be cancelled first.
+		 */
+		if (scan_type == POOL_SCAN_SCRUB &&
+		    dsl_scan_is_paused_scrub(spa->spa_dsl_pool->dp_scan))
+			error = SET_ERROR(EBUSY);
+		else
+			error = spa_scan_range(spa, scan_type, txgstart, 0);
 	} else {
 		error = spa_scan(spa, scan_type);
 	}
@@ -5802,10 +5815,17 @@ out:
 typedef struct dump_bytes_io {
 	zfs_file_t	*dbi_fp;
 	caddr_t		dbi_buf;
+	abd_t		*dbi_abd;
 	int		dbi_len;
 	int		dbi_err;
 } dump_bytes_io_t;
 
+static int
+dump_bytes_abd_cb(void *buf, size_t len, void *arg)
+{
+	return (zfs_file_write((zfs_file_t *)arg, buf, len, NULL));
+}
+
 static void
 dump_bytes_cb(void *arg)
 {
@@ -5816,7 +5836,16 @@ dump_bytes_cb(void *arg)
 	fp = dbi->dbi_fp;
 	buf = dbi->dbi_buf;
 
-	dbi->dbi_err = zfs_file_write(fp, buf, dbi->dbi_len, NULL);
+	/*
+	 * A scatter ABD is written out one chunk at a time, straight from
+	 * its pages, rather than being copied into a linear buffer first.
+	 */
+	if (dbi->dbi_abd != NULL) {
+		dbi->dbi_err = abd_iterate_func(dbi->dbi_abd, 0, dbi->dbi_len,
+		    dump_bytes_abd_cb, fp);
+	} else {
+		dbi->dbi_err = zfs_file_write(fp, buf, dbi->dbi_len, NULL);
+	}
 }
 
 typedef struct dump_bytes_arg {
@@ -5828,13 +5857,13 @@ typedef struct dump_bytes_arg {
 } dump_bytes_arg_t;
 
 static int
-dump_bytes(objset_t *os, void *buf, int len, void *arg)
+dump_bytes_impl(dump_bytes_arg_t *dba, void *buf, abd_t *abd, int len)
 {
-	dump_bytes_arg_t *dba = (dump_bytes_arg_t *)arg;
 	dump_bytes_io_t dbi;
 
 	dbi.dbi_fp = dba->dba_fp;
 	dbi.dbi_buf = buf;
+	dbi.dbi_abd = abd;
 	dbi.dbi_len = len;
 
 #ifdef USE_SEND_TASKQ
@@ -5848,6 +5877,20 @@ dump_bytes(objset_t *os, void *buf, int len, void *arg)
 	return (dbi.dbi_err);
 }
 
+static int
+dump_bytes(objset_t *os, void *buf, int len, void *arg)
+{
+	(void) os;
+	return (dump_bytes_impl(arg, buf, NULL, len));
+}
+
+static int
+dump_bytes_abd(objset_t *os, abd_t *abd, int len, void *arg)
+{
+	(void) os;
+	return (dump_bytes_impl(arg, NULL, abd, len));
+}
+
 static int
 dump_bytes_init(dump_bytes_arg_t *dba, int fd, dmu_send_outparams_t *out)
 {
@@ -5863,6 +5906,7 @@ dump_bytes_init(dump_bytes_arg_t *dba, int fd, dmu_send_outparams_t *out)
 
 	memset(out, 0, sizeof (dmu_send_outparams_t));
 	out->dso_outfunc = dump_bytes;
+	out->dso_outfunc_abd = dump_bytes_abd;
 	out->dso_arg = dba;
 	out->dso_dryrun = B_FALSE;
 
@@ -307,6 +307,22 @@ out:
 	return (error);
 }
 
+/*
+ * Wait until the dataset's iolimit_* properties allow a read or write of
+ * n bytes.
+ */
+static int
+zfs_iolimit(zfsvfs_t *zfsvfs, boolean_t write, ssize_t n)
+{
+	hrtime_t delay;
+	int error;
+
+	error = dmu_objset_iolimit(zfsvfs->z_os, write, n, B_TRUE, &delay);
+	dataset_kstats_update_iolimit_kstats(&zfsvfs->z_kstat, write, delay);
+
+	return (error);
+}
+
 /*
  * Read bytes from specified file into supplied buffer.
  *
@@ -363,6 +379,11 @@ zfs_read(struct znode *zp, zfs_uio_t *uio, int ioflag, cred_t *cr)
 		return (0);
 	}
 
+	if ((error = zfs_iolimit(zfsvfs, B_FALSE, zfs_uio_resid(uio))) != 0) {
+		zfs_exit(zfsvfs, FTAG);
+		return (error);
+	}
+
 #ifdef FRSYNC
 	/*
 	 * If we're in FRSYNC mode, sync out this znode before reading it.
@@ -674,6 +695,11 @@ zfs_write(znode_t *zp, zfs_uio_t *uio, int ioflag, cred_t *cr)
 		return (SET_ERROR(EINVAL));
 	}
 
+	if ((error = zfs_iolimit(zfsvfs, B_TRUE, n)) != 0) {
+		zfs_exit(zfsvfs, FTAG);
+		return (error);
+	}
+
 	/*
 	 * Setting up Direct I/O if requested.
 	 */
@@ -1009,11 +1035,11 @@ zfs_write(znode_t *zp, zfs_uio_t *uio, int ioflag, cred_t *cr)
 		}
 		/*
 		 * If we are replaying and eof is non zero then force
-		 * the file size to the specified eof. Note, there's no
-		 * concurrency during replay.
+		 * the file size to the specified eof. Note, writes to the
+		 * same file are never replayed concurrently.
 		 */
-		if (zfsvfs->z_replay && zfsvfs->z_replay_eof != 0)
-			zp->z_size = zfsvfs->z_replay_eof;
+		if (zfsvfs->z_replay && zp->z_replay_eof != 0)
+			zp->z_size = zp->z_replay_eof;
 
 		error1 = sa_bulk_update(zp->z_sa_hdl, bulk, count, tx);
 		if (error1 != 0)
@@ -104,6 +104,8 @@ static zil_kstat_values_t zil_stats = {
 	{ "zil_commit_stall_count",		KSTAT_DATA_UINT64 },
 	{ "zil_commit_suspend_count",		KSTAT_DATA_UINT64 },
 	{ "zil_itx_count",			KSTAT_DATA_UINT64 },
+	{ "zil_itx_assign_count",		KSTAT_DATA_UINT64 },
+	{ "zil_itx_assign_contended",		KSTAT_DATA_UINT64 },
 	{ "zil_itx_indirect_count",		KSTAT_DATA_UINT64 },
 	{ "zil_itx_indirect_bytes",		KSTAT_DATA_UINT64 },
 	{ "zil_itx_copied_count",		KSTAT_DATA_UINT64 },
@@ -118,6 +120,10 @@ static zil_kstat_values_t zil_stats = {
 	{ "zil_itx_metaslab_slog_bytes",	KSTAT_DATA_UINT64 },
 	{ "zil_itx_metaslab_slog_write",	KSTAT_DATA_UINT64 },
 	{ "zil_itx_metaslab_slog_alloc",	KSTAT_DATA_UINT64 },
+	{ "zil_replay_count",			KSTAT_DATA_UINT64 },
+	{ "zil_replay_parallel_count",		KSTAT_DATA_UINT64 },
+	{ "zil_replay_bytes",			KSTAT_DATA_UINT64 },
+	{ "zil_replay_time_ms",			KSTAT_DATA_UINT64 },
 };
 
 static zil_sums_t zil_sums_global;
@@ -142,12 +148,43 @@ static int zil_nocacheflush = 0;
  */
 static uint64_t zil_slog_bulk = 64 * 1024 * 1024;
 
+/*
+ * Smallest amount of log data per block when splitting a commit across
+ * several log devices so that they are all written in parallel.  Zero
+ * disables the split, committing as few blocks as possible instead.
+ */
+static uint_t zil_slog_stripe_min = 32 * 1024;
+
+/*
+ * Number of lists the in-memory itxs of every txg are spread over, to keep
+ * threads logging transactions concurrently from contending on a single
+ * lock.  Zero means one per CPU.  Read when a dataset's ZIL is set up.
+ */
+#define	ZIL_ITXG_SUBLISTS_MAX	64
+static uint_t zil_itxg_sublists = 0;
+
+/*
+ * Number of threads zil_replay() applies write records with.  Writes to
+ * different objects are replayed concurrently, everything else is replayed
+ * in log order once all preceding records have been applied.  Values below
+ * two replay every record from the thread parsing the log.
+ */
+#define	ZIL_REPLAY_THREADS_MAX	64
+static uint_t zil_replay_threads = 8;
+
+/*
+ * Limit on the log records and write data that have been read from the log
+ * but not yet applied by the replay threads.
+ */
+static uint64_t zil_replay_max_inflight = 64 * 1024 * 1024;
+
 static kmem_cache_t *zil_lwb_cache;
 static kmem_cache_t *zil_zcw_cache;
 
 static void zil_lwb_commit(zilog_t *zilog, lwb_t *lwb, itx_t *itx);
 static itx_t *zil_itx_clone(itx_t *oitx);
 static uint64_t zil_max_waste_space(zilog_t *zilog);
+static uint64_t zil_replay_synced(zilog_t *zilog, uint64_t txg);
 
 static int
 zil_bp_compare(const void *x1, const void *x2)
@@ -368,6 +405,8 @@ zil_sums_init(zil_sums_t *zs)
 	wmsum_init(&zs->zil_commit_stall_count, 0);
 	wmsum_init(&zs->zil_commit_suspend_count, 0);
 	wmsum_init(&zs->zil_itx_count, 0);
+	wmsum_init(&zs->zil_itx_assign_count, 0);
+	wmsum_init(&zs->zil_itx_assign_contended, 0);
 	wmsum_init(&zs->zil_itx_indirect_count, 0);
 	wmsum_init(&zs->zil_itx_indirect_bytes, 0);
 	wmsum_init(&zs->zil_itx_copied_count, 0);
@@ -382,6 +421,10 @@ zil_sums_init(zil_sums_t *zs)
 	wmsum_init(&zs->zil_itx_metaslab_slog_bytes, 0);
 	wmsum_init(&zs->zil_itx_metaslab_slog_write, 0);
 	wmsum_init(&zs->zil_itx_metaslab_slog_alloc, 0);
+	wmsum_init(&zs->zil_replay_count, 0);
+	wmsum_init(&zs->zil_replay_parallel_count, 0);
+	wmsum_init(&zs->zil_replay_bytes, 0);
+	wmsum_init(&zs->zil_replay_time_ms, 0);
 }
 
 void
@@ -393,6 +436,8 @@ zil_sums_fini(zil_sums_t *zs)
 	wmsum_fini(&zs->zil_commit_stall_count);
 	wmsum_fini(&zs->zil_commit_suspend_count);
 	wmsum_fini(&zs->zil_itx_count);
+	wmsum_fini(&zs->zil_itx_assign_count);
+	wmsum_fini(&zs->zil_itx_assign_contended);
 	wmsum_fini(&zs->zil_itx_indirect_count);
 	wmsum_fini(&zs->zil_itx_indirect_bytes);
 	wmsum_fini(&zs->zil_itx_copied_count);
@@ -407,6 +452,10 @@ zil_sums_fini(zil_sums_t *zs)
 	wmsum_fini(&zs->zil_itx_metaslab_slog_bytes);
 	wmsum_fini(&zs->zil_itx_metaslab_slog_write);
 	wmsum_fini(&zs->zil_itx_metaslab_slog_alloc);
+	wmsum_fini(&zs->zil_replay_count);
+	wmsum_fini(&zs->zil_replay_parallel_count);
+	wmsum_fini(&zs->zil_replay_bytes);
+	wmsum_fini(&zs->zil_replay_time_ms);
 }
 
 void
@@ -424,6 +473,10 @@ zil_kstat_values_update(zil_kstat_values_t *zs, zil_sums_t *zil_sums)
 	    wmsum_value(&zil_sums->zil_commit_suspend_count);
 	zs->zil_itx_count.value.ui64 =
 	    wmsum_value(&zil_sums->zil_itx_count);
+	zs->zil_itx_assign_count.value.ui64 =
+	    wmsum_value(&zil_sums->zil_itx_assign_count);
+	zs->zil_itx_assign_contended.value.ui64 =
+	    wmsum_value(&zil_sums->zil_itx_assign_contended);
 	zs->zil_itx_indirect_count.value.ui64 =
 	    wmsum_value(&zil_sums->zil_itx_indirect_count);
 	zs->zil_itx_indirect_bytes.value.ui64 =
@@ -452,6 +505,14 @@ zil_kstat_values_update(zil_kstat_values_t *zs, zil_sums_t *zil_sums)
 	    wmsum_value(&zil_sums->zil_itx_metaslab_slog_write);
 	zs->zil_itx_metaslab_slog_alloc.value.ui64 =
 	    wmsum_value(&zil_sums->zil_itx_metaslab_slog_alloc);
+	zs->zil_replay_count.value.ui64 =
+	    wmsum_value(&zil_sums->zil_replay_count);
+	zs->zil_replay_parallel_count.value.ui64 =
+	    wmsum_value(&zil_sums->zil_replay_parallel_count);
+	zs->zil_replay_bytes.value.ui64 =
+	    wmsum_value(&zil_sums->zil_replay_bytes);
+	zs->zil_replay_time_ms.value.ui64 =
+	    wmsum_value(&zil_sums->zil_replay_time_ms);
 }
 
 /*
@@ -1749,6 +1810,23 @@ zil_lwb_write_open(zilog_t *zilog, lwb_t *lwb)
  */
 static uint_t zil_maxblocksize = SPA_OLD_MAXBLOCKSIZE;
 
+/*
+ * Number of blocks a burst of the provided size should be split into at
+ * least, to write it to all log devices of the pool at once.  Log class
+ * allocations move to the next device for every block.
+ */
+static uint_t
+zil_lwb_stripes(zilog_t *zilog, uint64_t size)
+{
+	uint64_t groups;
+
+	if (zil_slog_stripe_min == 0)
+		return (1);
+
+	groups = metaslab_class_get_groups(spa_log_class(zilog->zl_spa));
+	return ((uint_t)MAX(MIN(groups, size / zil_slog_stripe_min), 1));
+}
+
 /*
  * Plan splitting of the provided burst size between several blocks.
  */
@@ -1756,14 +1834,15 @@ static uint_t
 zil_lwb_plan(zilog_t *zilog, uint64_t size, uint_t *minsize)
 {
 	uint_t md = zilog->zl_max_block_size - sizeof (zil_chain_t);
+	uint_t stripes = zil_lwb_stripes(zilog, size);
 
-	if (size <= md) {
+	if (size <= md && stripes == 1) {
 		/*
 		 * Small bursts are written as-is in one block.
 		 */
 		*minsize = size;
 		return (size);
-	} else if (size > 8 * md) {
+	} else if (size > MAX(stripes, 8) * md) {
 		/*
 		 * Big bursts use maximum blocks.  The first block size
 		 * is hard to predict, but it does not really matter.
@@ -1774,17 +1853,19 @@ zil_lwb_plan(zilog_t *zilog, uint64_t size, uint_t *minsize)
 
 	/*
 	 * Medium bursts try to divide evenly to better utilize several SLOG
-	 * VDEVs.  The first block size we predict assuming the worst case of
-	 * maxing out others.  Fall back to using maximum blocks if due to
-	 * large records or wasted space we can not predict anything better.
+	 * VDEVs, into at least as many blocks as there are of them.  The
+	 * first block size we predict assuming the worst case of maxing out
+	 * others.  Fall back to using maximum blocks if due to large records
+	 * or wasted space we can not predict anything better.
 	 */
 	uint_t s = size;
-	uint_t n = DIV_ROUND_UP(s, md - sizeof (lr_write_t));
+	uint_t n = MAX(DIV_ROUND_UP(s, md - sizeof (lr_write_t)), stripes);
 	uint_t chunk = DIV_ROUND_UP(s, n);
 	uint_t waste = zil_max_waste_space(zilog);
 	waste = MAX(waste, zilog->zl_cur_max);
 	if (chunk <= md - waste) {
-		*minsize = MAX(s - (md - waste) * (n - 1), waste);
+		uint_t rest = (md - waste) * (n - 1);
+		*minsize = MAX((s > rest) ? s - rest : 0, waste);
 		return (chunk);
 	} else {
 		*minsize = 0;
@@ -2434,13 +2515,12 @@ zil_itx_destroy(itx_t *itx)
  * so no locks are needed.
  */
 static void
-zil_itxg_clean(void *arg)
+zil_itxs_free(itxs_t *itxs)
 {
 	itx_t *itx;
 	list_t *list;
 	avl_tree_t *t;
 	void *cookie;
-	itxs_t *itxs = arg;
 	itx_async_node_t *ian;
 
 	list = &itxs->i_sync_list;
@@ -2487,6 +2567,20 @@ zil_itxg_clean(void *arg)
 	kmem_free(itxs, sizeof (itxs_t));
 }
 
+/*
+ * Free up a chain of detached itxs_t linked through i_next.
+ */
+static void
+zil_itxg_clean(void *arg)
+{
+	itxs_t *itxs = arg, *next;
+
+	for (; itxs != NULL; itxs = next) {
+		next = itxs->i_next;
+		zil_itxs_free(itxs);
+	}
+}
+
 static int
 zil_aitx_compare(const void *x1, const void *x2)
 {
@@ -2496,6 +2590,25 @@ zil_aitx_compare(const void *x1, const void *x2)
 	return (TREE_CMP(o1, o2));
 }
 
+/*
+ * Move all itxs of src into dst, both sorted by itx_seq, keeping dst sorted.
+ * The itxs moved are usually newer than those already in dst.
+ */
+static void
+zil_itx_list_merge(list_t *dst, list_t *src)
+{
+	itx_t *itx, *pos = list_tail(dst);
+
+	while ((itx = list_remove_tail(src)) != NULL) {
+		while (pos != NULL && pos->itx_seq > itx->itx_seq)
+			pos = list_prev(dst, pos);
+		if (pos == NULL)
+			list_insert_head(dst, itx);
+		else
+			list_insert_after(dst, pos, itx);
+	}
+}
+
 /*
  * Remove all async itx with the given oid.
  */
@@ -2518,23 +2631,25 @@ zil_remove_async(zilog_t *zilog, uint64_t oid)
 		otxg = spa_last_synced_txg(zilog->zl_spa) + 1;
 
 	for (txg = otxg; txg < (otxg + TXG_CONCURRENT_STATES); txg++) {
-		itxg_t *itxg = &zilog->zl_itxg[txg & TXG_MASK];
+		for (uint_t i = 0; i < zilog->zl_itxg_sublists; i++) {
+			itxg_t *itxg = &zilog->zl_itxg[txg & TXG_MASK][i];
 
-		mutex_enter(&itxg->itxg_lock);
-		if (itxg->itxg_txg != txg) {
+			mutex_enter(&itxg->itxg_lock);
+			if (itxg->itxg_txg != txg) {
+				mutex_exit(&itxg->itxg_lock);
+				continue;
+			}
+
+			/*
+			 * Locate the object node and append its list.
+			 */
+			t = &itxg->itxg_itxs->i_async_tree;
+			ian_search.ia_foid = oid;
+			ian = avl_find(t, &ian_search, &where);
+			if (ian != NULL)
+				list_move_tail(&clean_list, &ian->ia_list);
 			mutex_exit(&itxg->itxg_lock);
-			continue;
 		}
-
-		/*
-		 * Locate the object node and append its list.
-		 */
-		t = &itxg->itxg_itxs->i_async_tree;
-		ian_search.ia_foid = oid;
-		ian = avl_find(t, &ian_search, &where);
-		if (ian != NULL)
-			list_move_tail(&clean_list, &ian->ia_list);
-		mutex_exit(&itxg->itxg_lock);
 	}
 	while ((itx = list_remove_head(&clean_list)) != NULL) {
 		/* commit itxs should never be on the async lists. */
@@ -2562,8 +2677,13 @@ zil_itx_assign(zilog_t *zilog, itx_t *itx, dmu_tx_t *tx)
 	else
 		txg = dmu_tx_get_txg(tx);
 
-	itxg = &zilog->zl_itxg[txg & TXG_MASK];
-	mutex_enter(&itxg->itxg_lock);
+	itxg = &zilog->zl_itxg[txg & TXG_MASK][CPU_SEQID_UNSTABLE %
+	    zilog->zl_itxg_sublists];
+	if (!mutex_tryenter(&itxg->itxg_lock)) {
+		ZIL_STAT_BUMP(zilog, zil_itx_assign_contended);
+		mutex_enter(&itxg->itxg_lock);
+	}
+	ZIL_STAT_BUMP(zilog, zil_itx_assign_count);
 	itxs = itxg->itxg_itxs;
 	if (itxg->itxg_txg != txg) {
 		if (itxs != NULL) {
@@ -2586,6 +2706,7 @@ zil_itx_assign(zilog_t *zilog, itx_t *itx, dmu_tx_t *tx)
 		    sizeof (itx_async_node_t),
 		    offsetof(itx_async_node_t, ia_node));
 	}
+	itx->itx_seq = atomic_inc_64_nv(&zilog->zl_itx_seq);
 	if (itx->itx_sync) {
 		list_insert_tail(&itxs->i_sync_list, itx);
 	} else {
@@ -2633,22 +2754,28 @@ zil_itx_assign(zilog_t *zilog, itx_t *itx, dmu_tx_t *tx)
 void
 zil_clean(zilog_t *zilog, uint64_t synced_txg)
 {
-	itxg_t *itxg = &zilog->zl_itxg[synced_txg & TXG_MASK];
-	itxs_t *clean_me;
+	itxs_t *clean_me = NULL;
 
 	ASSERT3U(synced_txg, <, ZILTEST_TXG);
 
-	mutex_enter(&itxg->itxg_lock);
-	if (itxg->itxg_itxs == NULL || itxg->itxg_txg == ZILTEST_TXG) {
+	for (uint_t i = 0; i < zilog->zl_itxg_sublists; i++) {
+		itxg_t *itxg = &zilog->zl_itxg[synced_txg & TXG_MASK][i];
+
+		mutex_enter(&itxg->itxg_lock);
+		if (itxg->itxg_itxs == NULL || itxg->itxg_txg == ZILTEST_TXG) {
+			mutex_exit(&itxg->itxg_lock);
+			continue;
+		}
+		ASSERT3U(itxg->itxg_txg, <=, synced_txg);
+		ASSERT3U(itxg->itxg_txg, !=, 0);
+		itxg->itxg_itxs->i_next = clean_me;
+		clean_me = itxg->itxg_itxs;
+		itxg->itxg_itxs = NULL;
+		itxg->itxg_txg = 0;
 		mutex_exit(&itxg->itxg_lock);
-		return;
 	}
-	ASSERT3U(itxg->itxg_txg, <=, synced_txg);
-	ASSERT3U(itxg->itxg_txg, !=, 0);
-	clean_me = itxg->itxg_itxs;
-	itxg->itxg_itxs = NULL;
-	itxg->itxg_txg = 0;
-	mutex_exit(&itxg->itxg_lock);
+	if (clean_me == NULL)
+		return;
 	/*
 	 * Preferably start a task queue to free up the old itxs but
 	 * if taskq_dispatch can't allocate resources to do that then
@@ -2664,29 +2791,17 @@ zil_clean(zilog_t *zilog, uint64_t synced_txg)
 }
 
 /*
- * This function will traverse the queue of itxs that need to be
- * committed, and move them onto the ZIL's zl_itx_commit_list.
+ * Move the itxs of the sync lists of one txg onto the per sublist
+ * zl_itx_merge lists, stopping at the first one numbered after seq.
  */
 static uint64_t
-zil_get_commit_list(zilog_t *zilog)
+zil_get_commit_sublists(zilog_t *zilog, uint64_t txg, uint64_t seq)
 {
-	uint64_t otxg, txg, wtxg = 0;
-	list_t *commit_list = &zilog->zl_itx_commit_list;
-
-	ASSERT(MUTEX_HELD(&zilog->zl_issuer_lock));
+	uint64_t wtxg = 0;
 
-	if (spa_freeze_txg(zilog->zl_spa) != UINT64_MAX) /* ziltest support */
-		otxg = ZILTEST_TXG;
-	else
-		otxg = spa_last_synced_txg(zilog->zl_spa) + 1;
-
-	/*
-	 * This is inherently racy, since there is nothing to prevent
-	 * the last synced txg from changing. That's okay since we'll
-	 * only commit things in the future.
-	 */
-	for (txg = otxg; txg < (otxg + TXG_CONCURRENT_STATES); txg++) {
-		itxg_t *itxg = &zilog->zl_itxg[txg & TXG_MASK];
+	for (uint_t i = 0; i < zilog->zl_itxg_sublists; i++) {
+		itxg_t *itxg = &zilog->zl_itxg[txg & TXG_MASK][i];
+		list_t *merge = &zilog->zl_itx_merge[i];
 
 		mutex_enter(&itxg->itxg_lock);
 		if (itxg->itxg_txg != txg) {
@@ -2705,7 +2820,7 @@ zil_get_commit_list(zilog_t *zilog)
 		ASSERT(zilog_is_dirty_in_txg(zilog, txg) ||
 		    spa_freeze_txg(zilog->zl_spa) != UINT64_MAX);
 		list_t *sync_list = &itxg->itxg_itxs->i_sync_list;
-		itx_t *itx = NULL;
+		itx_t *itx;
 		if (unlikely(zilog->zl_suspend > 0)) {
 			/*
 			 * ZIL was just suspended, but we lost the race.
@@ -2713,14 +2828,90 @@ zil_get_commit_list(zilog_t *zilog)
 			 * caller to do txg_wait_synced(txg) for any new.
 			 */
 			if (!list_is_empty(sync_list))
-				wtxg = MAX(wtxg, txg);
+				wtxg = txg;
+		} else if ((itx = list_tail(sync_list)) != NULL &&
+		    itx->itx_seq <= seq) {
+			list_move_tail(merge, sync_list);
 		} else {
-			itx = list_head(sync_list);
-			list_move_tail(commit_list, sync_list);
+			while ((itx = list_head(sync_list)) != NULL &&
+			    itx->itx_seq <= seq) {
+				list_remove(sync_list, itx);
+				list_insert_tail(merge, itx);
+			}
 		}
 
 		mutex_exit(&itxg->itxg_lock);
+	}
+	return (wtxg);
+}
+
+/*
+ * This function will traverse the queue of itxs that need to be
+ * committed, and move them onto the ZIL's zl_itx_commit_list.
+ */
+static uint64_t
+zil_get_commit_list(zilog_t *zilog)
+{
+	uint64_t otxg, txg, wtxg = 0, seq;
+	list_t *commit_list = &zilog->zl_itx_commit_list;
+	list_t *merge = zilog->zl_itx_merge;
 
+	ASSERT(MUTEX_HELD(&zilog->zl_issuer_lock));
+
+	if (spa_freeze_txg(zilog->zl_spa) != UINT64_MAX) /* ziltest support */
+		otxg = ZILTEST_TXG;
+	else
+		otxg = spa_last_synced_txg(zilog->zl_spa) + 1;
+
+	/*
+	 * Only take the itxs numbered up to now.  Whatever an itx depends
+	 * on was assigned before the itx got its number, so the sublists
+	 * can be visited one after the other without ever taking an itx
+	 * but missing an earlier one it depends on.
+	 */
+	seq = atomic_load_64(&zilog->zl_itx_seq);
+
+	/*
+	 * This is inherently racy, since there is nothing to prevent
+	 * the last synced txg from changing. That's okay since we'll
+	 * only commit things in the future.
+	 */
+	for (txg = otxg; txg < (otxg + TXG_CONCURRENT_STATES); txg++) {
+		itx_t *itx = list_tail(commit_list);
+
+		wtxg = MAX(wtxg, zil_get_commit_sublists(zilog, txg, seq));
+
+		/*
+		 * Append the sublists to the commit list in itx_seq order.
+		 * Once only one of them is left, it can be moved as a whole.
+		 */
+		for (;;) {
+			itx_t *first = NULL;
+			uint_t m = 0, nonempty = 0;
+
+			for (uint_t i = 0; i < zilog->zl_itxg_sublists; i++) {
+				itx_t *head = list_head(&merge[i]);
+
+				if (head == NULL)
+					continue;
+				nonempty++;
+				if (first == NULL ||
+				    head->itx_seq < first->itx_seq) {
+					first = head;
+					m = i;
+				}
+			}
+			if (nonempty <= 1) {
+				if (first != NULL)
+					list_move_tail(commit_list, &merge[m]);
+				break;
+			}
+			list_remove(&merge[m], first);
+			list_insert_tail(commit_list, first);
+		}
+
+		itx = (itx != NULL) ? list_next(commit_list, itx) :
+		    list_head(commit_list);
 		while (itx != NULL) {
 			uint64_t s = zil_itx_full_size(itx);
 			zilog->zl_cur_size += s;
@@ -2733,6 +2924,39 @@ zil_get_commit_list(zilog_t *zilog)
 	return (wtxg);
 }
 
+/*
+ * Move the async itxs for a specified object, or all of them if foid is
+ * zero, into the sync list of a sublist.
+ */
+static void
+zil_itxg_async_to_sync(itxs_t *itxs, uint64_t foid)
+{
+	itx_async_node_t *ian, ian_search;
+	avl_tree_t *t = &itxs->i_async_tree;
+	avl_index_t where;
+
+	/*
+	 * If a foid is specified then find that node and merge its list
+	 * into the sync list. Otherwise walk the tree merging all the
+	 * lists. The itxs keep their place in assignment order, which
+	 * ensures the create still comes first.
+	 */
+	if (foid != 0) {
+		ian_search.ia_foid = foid;
+		ian = avl_find(t, &ian_search, &where);
+		if (ian != NULL)
+			zil_itx_list_merge(&itxs->i_sync_list, &ian->ia_list);
+	} else {
+		void *cookie = NULL;
+
+		while ((ian = avl_destroy_nodes(t, &cookie)) != NULL) {
+			zil_itx_list_merge(&itxs->i_sync_list, &ian->ia_list);
+			list_destroy(&ian->ia_list);
+			kmem_free(ian, sizeof (itx_async_node_t));
+		}
+	}
+}
+
 /*
  * Move the async itxs for a specified object to commit into sync lists.
  */
@@ -2740,9 +2964,6 @@ void
 zil_async_to_sync(zilog_t *zilog, uint64_t foid)
 {
 	uint64_t otxg, txg;
-	itx_async_node_t *ian, ian_search;
-	avl_tree_t *t;
-	avl_index_t where;
 
 	if (spa_freeze_txg(zilog->zl_spa) != UINT64_MAX) /* ziltest support */
 		otxg = ZILTEST_TXG;
@@ -2754,39 +2975,14 @@ zil_async_to_sync(zilog_t *zilog, uint64_t foid)
 	 * the last synced txg from changing.
 	 */
 	for (txg = otxg; txg < (otxg + TXG_CONCURRENT_STATES); txg++) {
-		itxg_t *itxg = &zilog->zl_itxg[txg & TXG_MASK];
+		for (uint_t i = 0; i < zilog->zl_itxg_sublists; i++) {
+			itxg_t *itxg = &zilog->zl_itxg[txg & TXG_MASK][i];
 
-		mutex_enter(&itxg->itxg_lock);
-		if (itxg->itxg_txg != txg) {
+			mutex_enter(&itxg->itxg_lock);
+			if (itxg->itxg_txg == txg)
+				zil_itxg_async_to_sync(itxg->itxg_itxs, foid);
 			mutex_exit(&itxg->itxg_lock);
-			continue;
 		}
-
-		/*
-		 * If a foid is specified then find that node and append its
-		 * list. Otherwise walk the tree appending all the lists
-		 * to the sync list. We add to the end rather than the
-		 * beginning to ensure the create has happened.
-		 */
-		t = &itxg->itxg_itxs->i_async_tree;
-		if (foid != 0) {
-			ian_search.ia_foid = foid;
-			ian = avl_find(t, &ian_search, &where);
-			if (ian != NULL) {
-				list_move_tail(&itxg->itxg_itxs->i_sync_list,
-				    &ian->ia_list);
-			}
-		} else {
-			void *cookie = NULL;
-
-			while ((ian = avl_destroy_nodes(t, &cookie)) != NULL) {
-				list_move_tail(&itxg->itxg_itxs->i_sync_list,
-				    &ian->ia_list);
-				list_destroy(&ian->ia_list);
-				kmem_free(ian, sizeof (itx_async_node_t));
-			}
-		}
-		mutex_exit(&itxg->itxg_lock);
 	}
 }
 
@@ -3618,8 +3814,12 @@ zil_commit(zilog_t *zilog, uint64_t foid)
 		 */
 		ASSERT(list_is_empty(&zilog->zl_lwb_list));
 		ASSERT3P(zilog->zl_last_lwb_opened, ==, NULL);
-		for (int i = 0; i < TXG_SIZE; i++)
-			ASSERT3P(zilog->zl_itxg[i].itxg_itxs, ==, NULL);
+		for (int i = 0; i < TXG_SIZE; i++) {
+			for (uint_t j = 0; j < zilog->zl_itxg_sublists; j++) {
+				ASSERT3P(zilog->zl_itxg[i][j].itxg_itxs, ==,
+				    NULL);
+			}
+		}
 		return;
 	}
 
@@ -3707,6 +3907,7 @@ zil_sync(zilog_t *zilog, dmu_tx_t *tx)
 	uint64_t txg = dmu_tx_get_txg(tx);
 	spa_t *spa = zilog->zl_spa;
 	uint64_t *replayed_seq = &zilog->zl_replayed_seq[txg & TXG_MASK];
+	uint64_t seq;
 	lwb_t *lwb;
 
 	/*
@@ -3722,11 +3923,17 @@ zil_sync(zilog_t *zilog, dmu_tx_t *tx)
 
 	ASSERT(zilog->zl_stop_sync == 0);
 
-	if (*replayed_seq != 0) {
-		ASSERT(zh->zh_replay_seq < *replayed_seq);
-		zh->zh_replay_seq = *replayed_seq;
-		*replayed_seq = 0;
-	}
+	/*
+	 * Records replayed from the parsing thread set the sequence of their
+	 * txg directly.  Those applied by the replay threads can be committed
+	 * out of log order, and only count once every record before them is
+	 * in a synced txg, see zil_replay_rec_done().  Never move the header
+	 * backwards.
+	 */
+	seq = MAX(*replayed_seq, zil_replay_synced(zilog, txg));
+	if (zh->zh_replay_seq < seq)
+		zh->zh_replay_seq = seq;
+	*replayed_seq = 0;
 
 	if (zilog->zl_destroy_txg == txg) {
 		blkptr_t blk = zh->zh_log;
@@ -3883,9 +4090,23 @@ zil_alloc(objset_t *os, zil_header_t *zh_phys)
 	mutex_init(&zilog->zl_issuer_lock, NULL, MUTEX_DEFAULT, NULL);
 	mutex_init(&zilog->zl_lwb_io_lock, NULL, MUTEX_DEFAULT, NULL);
 
+	uint_t sublists = zil_itxg_sublists;
+	if (sublists == 0)
+		sublists = boot_ncpus;
+	zilog->zl_itxg_sublists = MIN(MAX(sublists, 1), ZIL_ITXG_SUBLISTS_MAX);
+	zilog->zl_itx_merge = kmem_alloc(zilog->zl_itxg_sublists *
+	    sizeof (list_t), KM_SLEEP);
+	for (uint_t j = 0; j < zilog->zl_itxg_sublists; j++) {
+		list_create(&zilog->zl_itx_merge[j], sizeof (itx_t),
+		    offsetof(itx_t, itx_node));
+	}
 	for (int i = 0; i < TXG_SIZE; i++) {
-		mutex_init(&zilog->zl_itxg[i].itxg_lock, NULL,
-		    MUTEX_DEFAULT, NULL);
+		zilog->zl_itxg[i] = kmem_zalloc(zilog->zl_itxg_sublists *
+		    sizeof (itxg_t), KM_SLEEP);
+		for (uint_t j = 0; j < zilog->zl_itxg_sublists; j++) {
+			mutex_init(&zilog->zl_itxg[i][j].itxg_lock, NULL,
+			    MUTEX_DEFAULT, NULL);
+		}
 	}
 
 	list_create(&zilog->zl_lwb_list, sizeof (lwb_t),
@@ -3929,10 +4150,20 @@ zil_free(zilog_t *zilog)
 		 *
 		 * Also free up the ziltest itxs.
 		 */
-		if (zilog->zl_itxg[i].itxg_itxs)
-			zil_itxg_clean(zilog->zl_itxg[i].itxg_itxs);
-		mutex_destroy(&zilog->zl_itxg[i].itxg_lock);
+		for (uint_t j = 0; j < zilog->zl_itxg_sublists; j++) {
+			itxg_t *itxg = &zilog->zl_itxg[i][j];
+
+			if (itxg->itxg_itxs)
+				zil_itxg_clean(itxg->itxg_itxs);
+			mutex_destroy(&itxg->itxg_lock);
+		}
+		kmem_free(zilog->zl_itxg[i],
+		    zilog->zl_itxg_sublists * sizeof (itxg_t));
 	}
+	for (uint_t j = 0; j < zilog->zl_itxg_sublists; j++)
+		list_destroy(&zilog->zl_itx_merge[j]);
+	kmem_free(zilog->zl_itx_merge,
+	    zilog->zl_itxg_sublists * sizeof (list_t));
 
 	mutex_destroy(&zilog->zl_issuer_lock);
 	mutex_destroy(&zilog->zl_lock);
@@ -4187,27 +4418,324 @@ zil_resume(void *cookie)
 	dsl_dataset_rele(dmu_objset_ds(os), suspend_tag);
 }
 
+/*
+ * A TX_WRITE or TX_WRITE2 record handed to a replay thread.  A copy of the
+ * log record follows the structure, then room for the data of an indirect
+ * write, which is read by the replay thread.
+ */
+typedef struct zil_replay_rec {
+	list_node_t	zrr_node;
+	struct zil_replay_arg *zrr_zr;
+	uint64_t	zrr_seq;
+	uint64_t	zrr_txtype;	/* still including TX_CI */
+	uint64_t	zrr_reclen;
+	uint64_t	zrr_bytes;	/* replayed bytes, for the kstats */
+	uint64_t	zrr_txg;	/* highest txg it was committed in */
+	size_t		zrr_size;	/* of the whole allocation */
+	uint_t		zrr_thread;	/* index of its replay thread */
+	boolean_t	zrr_done;
+} zil_replay_rec_t;
+
+/*
+ * Replay has applied every record up to zrc_seq once txg zrc_txg has
+ * synced.
+ */
+typedef struct zil_replay_ckpt {
+	uint64_t	zrc_seq;
+	uint64_t	zrc_txg;
+} zil_replay_ckpt_t;
+
+#define	ZIL_REPLAY_CKPTS	8
+
 typedef struct zil_replay_arg {
 	zil_replay_func_t *const *zr_replay;
 	void		*zr_arg;
 	boolean_t	zr_byteswap;
 	char		*zr_lr;
+	zilog_t		*zr_zilog;
+	uint_t		zr_nthreads;
+	taskq_t		**zr_taskqs;	/* single threaded, one per object */
+	zil_replay_rec_t **zr_current;	/* record applied by each thread */
+	kmutex_t	zr_lock;	/* protects the fields below */
+	kcondvar_t	zr_cv;
+	list_t		zr_inflight;	/* zil_replay_rec_t, in seq order */
+	uint64_t	zr_inflight_bytes;
+	int		zr_error;	/* first replay error */
+	uint64_t	zr_last_seq;	/* of the last record parsed */
+	uint64_t	zr_retired_txg;	/* highest txg of retired records */
+	uint_t		zr_nckpts;
+	zil_replay_ckpt_t zr_ckpts[ZIL_REPLAY_CKPTS]; /* by ascending txg */
 } zil_replay_arg_t;
 
-static int
-zil_replay_error(zilog_t *zilog, const lr_t *lr, int error)
+static void
+zil_replay_warn(zilog_t *zilog, uint64_t seq, uint64_t txtype, int error)
 {
 	char name[ZFS_MAX_DATASET_NAME_LEN];
 
-	zilog->zl_replaying_seq--;	/* didn't actually replay this one */
-
 	dmu_objset_name(zilog->zl_os, name);
 
 	cmn_err(CE_WARN, "ZFS replay transaction error %d, "
 	    "dataset %s, seq 0x%llx, txtype %llu %s\n", error, name,
-	    (u_longlong_t)lr->lrc_seq,
-	    (u_longlong_t)(lr->lrc_txtype & ~TX_CI),
-	    (lr->lrc_txtype & TX_CI) ? "CI" : "");
+	    (u_longlong_t)seq, (u_longlong_t)(txtype & ~TX_CI),
+	    (txtype & TX_CI) ? "CI" : "");
+}
+
+static int
+zil_replay_error(zil_replay_arg_t *zr, const lr_t *lr, int error)
+{
+	zilog_t *zilog = zr->zr_zilog;
+
+	zilog->zl_replaying_seq--;	/* didn't actually replay this one */
+
+	mutex_enter(&zr->zr_lock);
+	if (zr->zr_error == 0)
+		zr->zr_error = error;
+	mutex_exit(&zr->zr_lock);
+
+	zil_replay_warn(zilog, lr->lrc_seq, lr->lrc_txtype, error);
+
+	return (error);
+}
+
+/*
+ * Bytes a log record accounts for in zil_replay_bytes: the record itself
+ * and, for indirect writes, the data read from the block it points to.
+ */
+static uint64_t
+zil_replay_lr_bytes(const lr_t *lr, uint64_t txtype)
+{
+	if (txtype == TX_WRITE && lr->lrc_reclen == sizeof (lr_write_t))
+		return (lr->lrc_reclen + ((const lr_write_t *)lr)->lr_length);
+	return (lr->lrc_reclen);
+}
+
+/*
+ * Record that all records up to seq are applied once txg has synced.
+ * Checkpoints are kept in ascending txg order; when there is no room
+ * left, the oldest is dropped, which only delays the header update to
+ * the txg of the next one.
+ */
+static void
+zil_replay_ckpt(zil_replay_arg_t *zr, uint64_t seq, uint64_t txg)
+{
+	zil_replay_ckpt_t *zrc;
+
+	ASSERT(MUTEX_HELD(&zr->zr_lock));
+
+	if (zr->zr_nckpts > 0) {
+		zrc = &zr->zr_ckpts[zr->zr_nckpts - 1];
+		ASSERT3U(zrc->zrc_txg, <=, txg);
+		if (zrc->zrc_txg == txg) {
+			zrc->zrc_seq = seq;
+			return;
+		}
+	}
+	if (zr->zr_nckpts == ZIL_REPLAY_CKPTS) {
+		memmove(&zr->zr_ckpts[0], &zr->zr_ckpts[1],
+		    (ZIL_REPLAY_CKPTS - 1) * sizeof (zil_replay_ckpt_t));
+		zr->zr_nckpts--;
+	}
+	zrc = &zr->zr_ckpts[zr->zr_nckpts++];
+	zrc->zrc_seq = seq;
+	zrc->zrc_txg = txg;
+}
+
+/*
+ * Called by zil_sync() with zl_lock held: return the highest sequence up
+ * to which every record applied by the replay threads is in a txg up to
+ * and including txg, or 0 if that didn't change.
+ */
+static uint64_t
+zil_replay_synced(zilog_t *zilog, uint64_t txg)
+{
+	zil_replay_arg_t *zr = zilog->zl_replay_arg;
+	uint64_t seq = 0;
+	uint_t i;
+
+	ASSERT(MUTEX_HELD(&zilog->zl_lock));
+
+	if (zr == NULL)
+		return (0);
+
+	mutex_enter(&zr->zr_lock);
+	for (i = 0; i < zr->zr_nckpts && zr->zr_ckpts[i].zrc_txg <= txg; i++)
+		seq = zr->zr_ckpts[i].zrc_seq;
+	zr->zr_nckpts -= i;
+	memmove(&zr->zr_ckpts[0], &zr->zr_ckpts[i],
+	    zr->zr_nckpts * sizeof (zil_replay_ckpt_t));
+	mutex_exit(&zr->zr_lock);
+
+	return (seq);
+}
+
+/*
+ * Called by a replay thread once it is done with a record.  Records are
+ * retired in log order.  The writes of different records are committed in
+ * whatever txg is open when their thread gets to them, so a record can
+ * land in an earlier txg than one logged before it.  The sequence of a
+ * retired record therefore only becomes the replayed sequence of the
+ * highest txg of all records up to it, and zil_sync() picks it up when
+ * that txg syncs.  After a crash a write may be replayed again, but never
+ * skipped.
+ */
+static void
+zil_replay_rec_done(zil_replay_arg_t *zr, zil_replay_rec_t *zrr, int error)
+{
+	mutex_enter(&zr->zr_lock);
+	if (error != 0 && zr->zr_error == 0)
+		zr->zr_error = error;
+	zrr->zrr_done = B_TRUE;
+	while ((zrr = list_head(&zr->zr_inflight)) != NULL && zrr->zrr_done) {
+		list_remove(&zr->zr_inflight, zrr);
+		zr->zr_inflight_bytes -= zrr->zrr_size;
+		if (zr->zr_error == 0) {
+			zr->zr_retired_txg = MAX(zr->zr_retired_txg,
+			    zrr->zrr_txg);
+			zil_replay_ckpt(zr, zrr->zrr_seq, zr->zr_retired_txg);
+		}
+		vmem_free(zrr, zrr->zrr_size);
+	}
+	cv_broadcast(&zr->zr_cv);
+	mutex_exit(&zr->zr_lock);
+}
+
+/*
+ * Called by zil_replaying(): if this is a replay thread, note the txg the
+ * record it is applying is committed in and return B_TRUE.
+ */
+static boolean_t
+zil_replay_thread_txg(zilog_t *zilog, uint64_t txg)
+{
+	zil_replay_arg_t *zr = zilog->zl_replay_arg;
+
+	if (zr == NULL)
+		return (B_FALSE);
+
+	for (uint_t i = 0; i < zr->zr_nthreads; i++) {
+		if (taskq_member(zr->zr_taskqs[i], curthread)) {
+			zil_replay_rec_t *zrr = zr->zr_current[i];
+
+			zrr->zrr_txg = MAX(zrr->zrr_txg, txg);
+			return (B_TRUE);
+		}
+	}
+
+	return (B_FALSE);
+}
+
+static void
+zil_replay_rec_func(void *arg)
+{
+	zil_replay_rec_t *zrr = arg;
+	zil_replay_arg_t *zr = zrr->zrr_zr;
+	zilog_t *zilog = zr->zr_zilog;
+	lr_t *lr = (lr_t *)(zrr + 1);
+	uint64_t txtype = zrr->zrr_txtype & ~TX_CI;
+	int error;
+
+	zr->zr_current[zrr->zrr_thread] = zrr;
+
+	/* Like the serial replay, stop at the first error */
+	mutex_enter(&zr->zr_lock);
+	error = zr->zr_error;
+	mutex_exit(&zr->zr_lock);
+	if (error != 0) {
+		zil_replay_rec_done(zr, zrr, 0);
+		return;
+	}
+
+	if (txtype == TX_WRITE && zrr->zrr_reclen == sizeof (lr_write_t)) {
+		error = zil_read_log_data(zilog, (lr_write_t *)lr,
+		    (char *)lr + zrr->zrr_reclen);
+	}
+
+	if (error == 0) {
+		if (zr->zr_byteswap)
+			byteswap_uint64_array(lr, zrr->zrr_reclen);
+
+		/* See zil_replay_log_record() */
+		error = zr->zr_replay[txtype](zr->zr_arg, lr, zr->zr_byteswap);
+		if (error != 0) {
+			txg_wait_synced(spa_get_dsl(zilog->zl_spa), 0);
+			error = zr->zr_replay[txtype](zr->zr_arg, lr, B_FALSE);
+		}
+	}
+
+	if (error != 0) {
+		zil_replay_warn(zilog, zrr->zrr_seq, zrr->zrr_txtype, error);
+	} else {
+		ZIL_STAT_BUMP(zilog, zil_replay_count);
+		ZIL_STAT_BUMP(zilog, zil_replay_parallel_count);
+		ZIL_STAT_INCR(zilog, zil_replay_bytes, zrr->zrr_bytes);
+	}
+	zil_replay_rec_done(zr, zrr, error);
+}
+
+/*
+ * Queue a write for the replay thread of its object.  All records of an
+ * object go to the same thread, so they are still applied in log order.
+ */
+static int
+zil_replay_dispatch(zil_replay_arg_t *zr, const lr_t *lr, uint64_t txtype)
+{
+	const lr_write_t *lrw = (const lr_write_t *)lr;
+	uint64_t reclen = lr->lrc_reclen;
+	uint64_t obj = LR_FOID_GET_OBJ(lrw->lr_foid);
+	size_t size = sizeof (zil_replay_rec_t) + reclen;
+	zil_replay_rec_t *zrr;
+	int error;
+
+	/* zil_read_log_data() fills in the whole block */
+	if (txtype == TX_WRITE && reclen == sizeof (lr_write_t))
+		size += MAX(BP_GET_LSIZE(&lrw->lr_blkptr), lrw->lr_length);
+
+	zrr = vmem_alloc(size, KM_SLEEP);
+	zrr->zrr_zr = zr;
+	zrr->zrr_seq = lr->lrc_seq;
+	zrr->zrr_txtype = lr->lrc_txtype;
+	zrr->zrr_reclen = reclen;
+	zrr->zrr_bytes = zil_replay_lr_bytes(lr, txtype);
+	zrr->zrr_txg = 0;
+	zrr->zrr_size = size;
+	zrr->zrr_thread = obj % zr->zr_nthreads;
+	zrr->zrr_done = B_FALSE;
+	memcpy(zrr + 1, lr, reclen);
+
+	mutex_enter(&zr->zr_lock);
+	while (zr->zr_error == 0 && zr->zr_inflight_bytes != 0 &&
+	    zr->zr_inflight_bytes + size > zil_replay_max_inflight)
+		cv_wait(&zr->zr_cv, &zr->zr_lock);
+	error = zr->zr_error;
+	if (error == 0) {
+		list_insert_tail(&zr->zr_inflight, zrr);
+		zr->zr_inflight_bytes += size;
+	}
+	mutex_exit(&zr->zr_lock);
+
+	if (error != 0) {
+		vmem_free(zrr, size);
+		return (error);
+	}
+
+	VERIFY3U(taskq_dispatch(zr->zr_taskqs[zrr->zrr_thread],
+	    zil_replay_rec_func, zrr, TQ_SLEEP), !=, TASKQID_INVALID);
+
+	return (0);
+}
+
+/*
+ * Wait for the replay threads to apply all queued records.
+ */
+static int
+zil_replay_drain(zil_replay_arg_t *zr)
+{
+	int error;
+
+	mutex_enter(&zr->zr_lock);
+	while (!list_is_empty(&zr->zr_inflight))
+		cv_wait(&zr->zr_cv, &zr->zr_lock);
+	error = zr->zr_error;
+	mutex_exit(&zr->zr_lock);
 
 	return (error);
 }
@@ -4220,9 +4748,10 @@ zil_replay_log_record(zilog_t *zilog, const lr_t *lr, void *zra,
 	const zil_header_t *zh = zilog->zl_header;
 	uint64_t reclen = lr->lrc_reclen;
 	uint64_t txtype = lr->lrc_txtype;
+	boolean_t parallel;
 	int error = 0;
 
-	zilog->zl_replaying_seq = lr->lrc_seq;
+	zr->zr_last_seq = lr->lrc_seq;
 
 	if (lr->lrc_seq <= zh->zh_replay_seq)	/* already replayed */
 		return (0);
@@ -4233,8 +4762,22 @@ zil_replay_log_record(zilog_t *zilog, const lr_t *lr, void *zra,
 	/* Strip case-insensitive bit, still present in log record */
 	txtype &= ~TX_CI;
 
+	/*
+	 * Writes only depend on earlier records for the same object, and
+	 * can be handed to the replay threads.  Anything else may depend on
+	 * any object (e.g. rename, link, remove), so it is only replayed
+	 * once all records before it have been applied.
+	 */
+	parallel = (zr->zr_nthreads > 1 &&
+	    (txtype == TX_WRITE || txtype == TX_WRITE2));
+	if (!parallel) {
+		if ((error = zil_replay_drain(zr)) != 0)
+			return (error);
+		zilog->zl_replaying_seq = lr->lrc_seq;
+	}
+
 	if (txtype == 0 || txtype >= TX_MAX_TYPE)
-		return (zil_replay_error(zilog, lr, EINVAL));
+		return (zil_replay_error(zr, lr, EINVAL));
 
 	/*
 	 * If this record type can be logged out of order, the object
@@ -4247,6 +4790,9 @@ zil_replay_log_record(zilog_t *zilog, const lr_t *lr, void *zra,
 			return (0);
 	}
 
+	if (parallel)
+		return (zil_replay_dispatch(zr, lr, txtype));
+
 	/*
 	 * Make a copy of the data so we can revise and extend it.
 	 */
@@ -4259,7 +4805,7 @@ zil_replay_log_record(zilog_t *zilog, const lr_t *lr, void *zra,
 		error = zil_read_log_data(zilog, (lr_write_t *)lr,
 		    zr->zr_lr + reclen);
 		if (error != 0)
-			return (zil_replay_error(zilog, lr, error));
+			return (zil_replay_error(zr, lr, error));
 	}
 
 	/*
@@ -4290,8 +4836,10 @@ zil_replay_log_record(zilog_t *zilog, const lr_t *lr, void *zra,
 		txg_wait_synced(spa_get_dsl(zilog->zl_spa), 0);
 		error = zr->zr_replay[txtype](zr->zr_arg, zr->zr_lr, B_FALSE);
 		if (error != 0)
-			return (zil_replay_error(zilog, lr, error));
+			return (zil_replay_error(zr, lr, error));
 	}
+	ZIL_STAT_BUMP(zilog, zil_replay_count);
+	ZIL_STAT_INCR(zilog, zil_replay_bytes, zil_replay_lr_bytes(lr, txtype));
 	return (0);
 }
 
@@ -4316,6 +4864,7 @@ zil_replay(objset_t *os, void *arg,
 	zilog_t *zilog = dmu_objset_zil(os);
 	const zil_header_t *zh = zilog->zl_header;
 	zil_replay_arg_t zr;
+	hrtime_t start;
 
 	if ((zh->zh_flags & ZIL_REPLAY_NEEDED) == 0) {
 		return (zil_destroy(zilog, B_TRUE));
@@ -4325,6 +4874,32 @@ zil_replay(objset_t *os, void *arg,
 	zr.zr_arg = arg;
 	zr.zr_byteswap = BP_SHOULD_BYTESWAP(&zh->zh_log);
 	zr.zr_lr = vmem_alloc(2 * SPA_MAXBLOCKSIZE, KM_SLEEP);
+	zr.zr_zilog = zilog;
+	zr.zr_nthreads = MIN(zil_replay_threads, ZIL_REPLAY_THREADS_MAX);
+	zr.zr_taskqs = NULL;
+	zr.zr_current = NULL;
+	mutex_init(&zr.zr_lock, NULL, MUTEX_DEFAULT, NULL);
+	cv_init(&zr.zr_cv, NULL, CV_DEFAULT, NULL);
+	list_create(&zr.zr_inflight, sizeof (zil_replay_rec_t),
+	    offsetof(zil_replay_rec_t, zrr_node));
+	zr.zr_inflight_bytes = 0;
+	zr.zr_error = 0;
+	zr.zr_last_seq = 0;
+	zr.zr_retired_txg = 0;
+	zr.zr_nckpts = 0;
+	if (zr.zr_nthreads > 1) {
+		zr.zr_taskqs = kmem_alloc(zr.zr_nthreads * sizeof (taskq_t *),
+		    KM_SLEEP);
+		zr.zr_current = kmem_zalloc(zr.zr_nthreads *
+		    sizeof (zil_replay_rec_t *), KM_SLEEP);
+		for (uint_t i = 0; i < zr.zr_nthreads; i++) {
+			zr.zr_taskqs[i] = taskq_create("z_zil_replay", 1,
+			    defclsyspri, 1, INT_MAX, 0);
+		}
+		mutex_enter(&zilog->zl_lock);
+		zilog->zl_replay_arg = &zr;
+		mutex_exit(&zilog->zl_lock);
+	}
 
 	/*
 	 * Wait for in-progress removes to sync before starting replay.
@@ -4333,9 +4908,34 @@ zil_replay(objset_t *os, void *arg,
 
 	zilog->zl_replay = B_TRUE;
 	zilog->zl_replay_time = ddi_get_lbolt();
+	zilog->zl_replaying_seq = zh->zh_replay_seq;
 	ASSERT(zilog->zl_replay_blks == 0);
+	start = gethrtime();
 	(void) zil_parse(zilog, zil_incr_blks, zil_replay_log_record, &zr,
 	    zh->zh_claim_txg, B_TRUE);
+	/*
+	 * Once everything has been applied, the replay has got as far as
+	 * the last record, even if it didn't need replaying.
+	 */
+	if (zil_replay_drain(&zr) == 0 &&
+	    zilog->zl_replaying_seq < zr.zr_last_seq)
+		zilog->zl_replaying_seq = zr.zr_last_seq;
+	ZIL_STAT_INCR(zilog, zil_replay_time_ms,
+	    NSEC2MSEC(gethrtime() - start));
+
+	if (zr.zr_taskqs != NULL) {
+		mutex_enter(&zilog->zl_lock);
+		zilog->zl_replay_arg = NULL;
+		mutex_exit(&zilog->zl_lock);
+		for (uint_t i = 0; i < zr.zr_nthreads; i++)
+			taskq_destroy(zr.zr_taskqs[i]);
+		kmem_free(zr.zr_taskqs, zr.zr_nthreads * sizeof (taskq_t *));
+		kmem_free(zr.zr_current,
+		    zr.zr_nthreads * sizeof (zil_replay_rec_t *));
+	}
+	list_destroy(&zr.zr_inflight);
+	cv_destroy(&zr.zr_cv);
+	mutex_destroy(&zr.zr_lock);
 	vmem_free(zr.zr_lr, 2 * SPA_MAXBLOCKSIZE);
 
 	zil_destroy(zilog, B_FALSE);
@@ -4352,9 +4952,13 @@ zil_replaying(zilog_t *zilog, dmu_tx_t *tx)
 		return (B_TRUE);
 
 	if (zilog->zl_replay) {
+		uint64_t txg = dmu_tx_get_txg(tx);
+
 		dsl_dataset_dirty(dmu_objset_ds(zilog->zl_os), tx);
-		zilog->zl_replayed_seq[dmu_tx_get_txg(tx) & TXG_MASK] =
-		    zilog->zl_replaying_seq;
+		if (!zil_replay_thread_txg(zilog, txg)) {
+			zilog->zl_replayed_seq[txg & TXG_MASK] =
+			    zilog->zl_replaying_seq;
+		}
 		return (B_TRUE);
 	}
 
@@ -4407,12 +5011,24 @@ ZFS_MODULE_PARAM(zfs, zfs_, commit_timeout_pct, UINT, ZMOD_RW,
 ZFS_MODULE_PARAM(zfs_zil, zil_, replay_disable, INT, ZMOD_RW,
 	"Disable intent logging replay");
 
+ZFS_MODULE_PARAM(zfs_zil, zil_, replay_threads, UINT, ZMOD_RW,
+	"Number of threads replaying writes to different objects");
+
+ZFS_MODULE_PARAM(zfs_zil, zil_, replay_max_inflight, U64, ZMOD_RW,
+	"Limit in bytes of log records queued for replay threads");
+
 ZFS_MODULE_PARAM(zfs_zil, zil_, nocacheflush, INT, ZMOD_RW,
 	"Disable ZIL cache flushes");
 
 ZFS_MODULE_PARAM(zfs_zil, zil_, slog_bulk, U64, ZMOD_RW,
 	"Limit in bytes slog sync writes per commit");
 
+ZFS_MODULE_PARAM(zfs_zil, zil_, slog_stripe_min, UINT, ZMOD_RW,
+	"Minimum bytes per log block when striping a commit over slogs");
+
+ZFS_MODULE_PARAM(zfs_zil, zil_, itxg_sublists, UINT, ZMOD_RW,
+	"Number of in-memory itx lists per txg, 0 for one per CPU");
+
 ZFS_MODULE_PARAM(zfs_zil, zil_, maxblocksize, UINT, ZMOD_RW,
 	"Limit in bytes of ZIL log block size");
 
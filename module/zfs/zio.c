@@ -71,6 +71,16 @@ const char *const zio_type_name[ZIO_TYPES] = {
 int zio_dva_throttle_enabled = B_TRUE;
 static int zio_deadman_log_all = B_FALSE;
 
+/*
+ * Throttled asynchronous writes of at most zio_alloc_batch_max_size bytes
+ * waiting for allocation are allocated up to zio_alloc_batch at a time,
+ * as consecutive blocks of a single metaslab range.  See
+ * zio_dva_allocate_batch().
+ */
+#define	ZIO_ALLOC_BATCH_MAX	32
+static uint_t zio_alloc_batch = 16;
+static uint_t zio_alloc_batch_max_size = 32 << 10;
+
 /*
  * ==========================================================================
  * I/O kmem caches
@@ -151,6 +161,7 @@ typedef struct zio_stats {
 	kstat_named_t ziostat_alloc_class_fallbacks;
 	kstat_named_t ziostat_gang_writes;
 	kstat_named_t ziostat_gang_multilevel;
+	kstat_named_t ziostat_batch_allocations;
 } zio_stats_t;
 
 static zio_stats_t zio_stats = {
@@ -158,6 +169,7 @@ static zio_stats_t zio_stats = {
 	{ "alloc_class_fallbacks",	KSTAT_DATA_UINT64 },
 	{ "gang_writes",	KSTAT_DATA_UINT64 },
 	{ "gang_multilevel",	KSTAT_DATA_UINT64 },
+	{ "batch_allocations",	KSTAT_DATA_UINT64 },
 };
 
 struct {
@@ -165,6 +177,7 @@ struct {
 	wmsum_t ziostat_alloc_class_fallbacks;
 	wmsum_t ziostat_gang_writes;
 	wmsum_t ziostat_gang_multilevel;
+	wmsum_t ziostat_batch_allocations;
 } ziostat_sums;
 
 #define	ZIOSTAT_BUMP(stat)	wmsum_add(&ziostat_sums.stat, 1);
@@ -190,6 +203,8 @@ zio_kstats_update(kstat_t *ksp, int rw)
 	    wmsum_value(&ziostat_sums.ziostat_gang_writes);
 	zs->ziostat_gang_multilevel.value.ui64 =
 	    wmsum_value(&ziostat_sums.ziostat_gang_multilevel);
+	zs->ziostat_batch_allocations.value.ui64 =
+	    wmsum_value(&ziostat_sums.ziostat_batch_allocations);
 	return (0);
 }
 
@@ -207,6 +222,7 @@ zio_init(void)
 	wmsum_init(&ziostat_sums.ziostat_alloc_class_fallbacks, 0);
 	wmsum_init(&ziostat_sums.ziostat_gang_writes, 0);
 	wmsum_init(&ziostat_sums.ziostat_gang_multilevel, 0);
+	wmsum_init(&ziostat_sums.ziostat_batch_allocations, 0);
 	zio_ksp = kstat_create("zfs", 0, "zio_stats",
 	    "misc", KSTAT_TYPE_NAMED, sizeof (zio_stats) /
 	    sizeof (kstat_named_t), KSTAT_FLAG_VIRTUAL);
@@ -352,6 +368,7 @@ zio_fini(void)
 	wmsum_fini(&ziostat_sums.ziostat_alloc_class_fallbacks);
 	wmsum_fini(&ziostat_sums.ziostat_gang_writes);
 	wmsum_fini(&ziostat_sums.ziostat_gang_multilevel);
+	wmsum_fini(&ziostat_sums.ziostat_batch_allocations);
 
 	kmem_cache_destroy(zio_link_cache);
 	kmem_cache_destroy(zio_cache);
@@ -1981,12 +1998,23 @@ zio_write_compress(zio_t *zio)
 			psize = 0;
 		else if (compress == ZIO_COMPRESS_EMPTY)
 			psize = lsize;
-		else
+		else {
+			hrtime_t start = 0;
+
+			if (zp->zp_compress_auto != NULL)
+				start = gethrtime();
 			psize = zio_compress_data(compress, zio->io_abd, &cabd,
 			    lsize,
 			    zio_get_compression_max_size(compress,
 			    spa->spa_gcd_alloc, spa->spa_min_alloc, lsize),
 			    zp->zp_complevel);
+			/* compression=auto learns from every block it picks */
+			if (zp->zp_compress_auto != NULL) {
+				zio_compress_auto_update(zp->zp_compress_auto,
+				    compress, zp->zp_complevel, lsize, psize,
+				    gethrtime() - start);
+			}
+		}
 		if (psize == 0) {
 			compress = ZIO_COMPRESS_OFF;
 		} else if (psize >= lsize) {
@@ -3219,6 +3247,7 @@ zio_write_gang_block(zio_t *pio, metaslab_class_t *mc)
 		zp.zp_encrypt = gio->io_prop.zp_encrypt;
 		zp.zp_byteorder = gio->io_prop.zp_byteorder;
 		zp.zp_direct_write = B_FALSE;
+		zp.zp_compress_auto = NULL;
 		memset(zp.zp_salt, 0, ZIO_DATA_SALT_LEN);
 		memset(zp.zp_iv, 0, ZIO_DATA_IV_LEN);
 		memset(zp.zp_mac, 0, ZIO_DATA_MAC_LEN);
@@ -4146,6 +4175,87 @@ zio_allocate_dispatch(metaslab_class_t *mc, int allocator)
 	} while (more);
 }
 
+/*
+ * Can this zio be allocated as part of a batch, see zio_dva_allocate_batch()?
+ */
+static boolean_t
+zio_dva_batchable(zio_t *zio, metaslab_class_t *mc, uint64_t txg)
+{
+	return (zio->io_metaslab_class == mc && zio->io_txg == txg &&
+	    zio->io_priority == ZIO_PRIORITY_ASYNC_WRITE &&
+	    zio->io_prop.zp_copies == 1 &&
+	    zio->io_size <= zio_alloc_batch_max_size &&
+	    (zio->io_pipeline & ZIO_STAGE_DVA_ALLOCATE) &&
+	    !(zio->io_flags & (ZIO_FLAG_GANG_CHILD | ZIO_FLAG_PREALLOCATED)) &&
+	    BP_IS_HOLE(zio->io_bp));
+}
+
+/*
+ * Many small writes in the same txg reach the allocator one by one, each
+ * walking a metaslab's range trees and scattering its block around the
+ * current allocation cursor.  When the allocation throttle has queued more
+ * of them behind this one, take the compatible ones from the head of the
+ * queue, reserving their throttle slots as zio_io_to_allocate() would, and
+ * allocate all of them with one metaslab_alloc_batch() call.  The queued
+ * zios that got their block are marked ZIO_FLAG_ALLOC_BATCHED, so that
+ * their own DVA_ALLOCATE stage does nothing, and all the taken zios are
+ * then dispatched; those that did not fit allocate their block as usual.
+ *
+ * Returns B_TRUE if this zio got its block.
+ */
+static boolean_t
+zio_dva_allocate_batch(zio_t *zio, metaslab_class_t *mc, int flags)
+{
+	metaslab_class_allocator_t *mca =
+	    &mc->mc_allocator[zio->io_allocator];
+	uint_t max = MIN(zio_alloc_batch, ZIO_ALLOC_BATCH_MAX);
+	zio_t *zios[ZIO_ALLOC_BATCH_MAX];
+	uint64_t psize[ZIO_ALLOC_BATCH_MAX];
+	blkptr_t *bps[ZIO_ALLOC_BATCH_MAX];
+	boolean_t more;
+	uint_t count = 1, i;
+	int n;
+
+	zios[0] = zio;
+	mutex_enter(&mca->mca_lock);
+	while (count < max) {
+		zio_t *nio = avl_first(&mca->mca_tree);
+
+		if (nio == NULL || !zio_dva_batchable(nio, mc, zio->io_txg) ||
+		    !metaslab_class_throttle_reserve(mc, 1, nio, B_FALSE,
+		    &more))
+			break;
+		avl_remove(&mca->mca_tree, nio);
+		zios[count++] = nio;
+	}
+	mutex_exit(&mca->mca_lock);
+
+	if (count == 1)
+		return (B_FALSE);
+
+	for (i = 0; i < count; i++) {
+		psize[i] = zios[i]->io_size;
+		bps[i] = zios[i]->io_bp;
+	}
+	n = metaslab_alloc_batch(zio->io_spa, mc, count, psize, bps,
+	    zio->io_txg, flags, &zio->io_alloc_list, zio->io_allocator,
+	    (const void **)zios);
+
+	for (i = 1; i < count; i++) {
+		zio_t *nio = zios[i];
+
+		ASSERT3U(nio->io_stage, ==, ZIO_STAGE_DVA_THROTTLE);
+		ASSERT0(nio->io_error);
+		if (i < n)
+			nio->io_flags |= ZIO_FLAG_ALLOC_BATCHED;
+		zio_taskq_dispatch(nio, ZIO_TASKQ_ISSUE, B_TRUE);
+	}
+	for (i = 0; i < n; i++)
+		ZIOSTAT_BUMP(ziostat_batch_allocations);
+
+	return (n > 0);
+}
+
 static zio_t *
 zio_dva_allocate(zio_t *zio)
 {
@@ -4167,6 +4277,12 @@ zio_dva_allocate(zio_t *zio)
 		    BP_GET_PHYSICAL_BIRTH(&zio->io_bp_orig));
 		return (zio);
 	}
+	if (zio->io_flags & ZIO_FLAG_ALLOC_BATCHED) {
+		ASSERT3U(BP_GET_NDVAS(bp), ==, 1);
+		ASSERT(zio->io_flags & ZIO_FLAG_IO_ALLOCATING);
+		ZIOSTAT_BUMP(ziostat_total_allocations);
+		return (zio);
+	}
 
 	ASSERT(BP_IS_HOLE(bp));
 	ASSERT0(BP_GET_NDVAS(bp));
@@ -4190,6 +4306,11 @@ zio_dva_allocate(zio_t *zio)
 	}
 	ZIOSTAT_BUMP(ziostat_total_allocations);
 
+	if (zio_alloc_batch > 1 && (zio->io_flags & ZIO_FLAG_IO_ALLOCATING) &&
+	    zio_dva_batchable(zio, mc, zio->io_txg) &&
+	    zio_dva_allocate_batch(zio, mc, flags))
+		return (zio);
+
 again:
 	/*
 	 * Try allocating the block in the usual metaslab class.
@@ -5867,5 +5988,11 @@ ZFS_MODULE_PARAM(zfs, zfs_, sync_pass_rewrite, UINT, ZMOD_RW,
 ZFS_MODULE_PARAM(zfs_zio, zio_, dva_throttle_enabled, INT, ZMOD_RW,
 	"Throttle block allocations in the ZIO pipeline");
 
+ZFS_MODULE_PARAM(zfs_zio, zio_, alloc_batch, UINT, ZMOD_RW,
+	"Max number of small blocks to allocate at once");
+
+ZFS_MODULE_PARAM(zfs_zio, zio_, alloc_batch_max_size, UINT, ZMOD_RW,
+	"Max size of blocks to allocate in batches");
+
 ZFS_MODULE_PARAM(zfs_zio, zio_, deadman_log_all, INT, ZMOD_RW,
 	"Log all slow ZIOs, not just those with vdevs");
@@ -0,0 +1,288 @@
+// SPDX-License-Identifier: CDDL-1.0
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at usr/src/OPENSOLARIS.LICENSE
+ * or https://opensource.org/licenses/CDDL-1.0.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at usr/src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*
+ * Adaptive compression (compression=auto).
+ *
+ * The property value is stored as the reserved zstd level
+ * ZIO_ZSTD_LEVEL_AUTO, so it needs and activates the zstd_compress feature
+ * like any other zstd level, but it never reaches the compressor or a block
+ * pointer: dmu_write_policy() asks the objset's zio_compress_auto_t for a
+ * concrete algorithm and level for every data block it writes.
+ *
+ * Each objset keeps running statistics for a small, fixed set of
+ * candidates ordered from cheapest to most expensive.  Most blocks are
+ * compressed with the current choice, but one block out of every
+ * zfs_compress_auto_sample_interval is handed to one of the other candidates
+ * in turn, so that all of them keep being measured as the data changes.
+ * zio_write_compress() reports the size and the time it took to compress
+ * every such block, and after every zfs_compress_auto_window reported
+ * blocks the candidates are re-evaluated:
+ *
+ * - a candidate is only eligible when its observed single thread
+ *   compression throughput is at least zfs_compress_auto_min_mbps; this is
+ *   the CPU budget, lowering it allows more expensive levels to be chosen.
+ * - starting from "off", a more expensive eligible candidate replaces the
+ *   current best only if it saves at least zfs_compress_auto_min_gain
+ *   percent more of the logical size.  Incompressible data thus ends up
+ *   uncompressed, and higher zstd levels are only used when they pay off.
+ *
+ * The decisions and the per candidate statistics are exported through the
+ * dataset kstats (see dataset_kstats.c).
+ */
+
+#include <sys/zfs_context.h>
+#include <sys/zio.h>
+#include <sys/zio_compress.h>
+
+/*
+ * Minimum compression throughput (MB/s, single thread) a candidate must
+ * reach to be chosen.
+ */
+static uint_t zfs_compress_auto_min_mbps = 200;
+
+/*
+ * Percent of the logical size a more expensive candidate must save on top
+ * of a cheaper one to be preferred.
+ */
+static uint_t zfs_compress_auto_min_gain = 3;
+
+/* Every Nth block is used to measure a candidate other than the current */
+static uint_t zfs_compress_auto_sample_interval = 16;
+
+/* Number of compressed blocks between re-evaluations */
+static uint_t zfs_compress_auto_window = 512;
+
+static const struct {
+	const char		*zcad_name;
+	enum zio_compress	zcad_compress;
+	uint8_t			zcad_level;
+} zca_candidates[ZIO_COMPRESS_AUTO_CANDIDATES] = {
+	{ "off",	ZIO_COMPRESS_OFF,	0 },
+	{ "lz4",	ZIO_COMPRESS_LZ4,	0 },
+	{ "zstd-1",	ZIO_COMPRESS_ZSTD,	ZIO_ZSTD_LEVEL_1 },
+	{ "zstd-3",	ZIO_COMPRESS_ZSTD,	ZIO_ZSTD_LEVEL_3 },
+	{ "zstd-6",	ZIO_COMPRESS_ZSTD,	ZIO_ZSTD_LEVEL_6 },
+	{ "zstd-9",	ZIO_COMPRESS_ZSTD,	ZIO_ZSTD_LEVEL_9 },
+};
+
+/* Candidate used until the first window has been evaluated */
+#define	ZCA_INITIAL	1
+
+/* Ratio of a block that does not compress, psize per 1000 bytes lsize */
+#define	ZCA_RATIO_NONE	1000
+
+typedef struct zca_cand {
+	/* Reported by zio_compress_auto_update() in the current window */
+	uint64_t	zcc_lsize;
+	uint64_t	zcc_psize;
+	uint64_t	zcc_ns;
+	/* Blocks dmu_write_policy() assigned to this candidate */
+	uint64_t	zcc_blocks;
+	uint64_t	zcc_samples;
+	/* Smoothed over the past windows, protected by zca_lock */
+	uint64_t	zcc_ratio;	/* psize per 1000 bytes of lsize */
+	uint64_t	zcc_mbps;	/* compression throughput */
+	boolean_t	zcc_valid;
+} zca_cand_t;
+
+struct zio_compress_auto {
+	kmutex_t	zca_lock;
+	uint32_t	zca_refcnt;
+	volatile uint_t	zca_current;
+	uint64_t	zca_writes;
+	uint64_t	zca_updates;
+	uint64_t	zca_switches;
+	zca_cand_t	zca_cand[ZIO_COMPRESS_AUTO_CANDIDATES];
+};
+
+zio_compress_auto_t *
+zio_compress_auto_alloc(void)
+{
+	zio_compress_auto_t *zca = kmem_zalloc(sizeof (*zca), KM_SLEEP);
+
+	mutex_init(&zca->zca_lock, NULL, MUTEX_DEFAULT, NULL);
+	zca->zca_refcnt = 1;
+	zca->zca_current = ZCA_INITIAL;
+	zca->zca_cand[0].zcc_ratio = ZCA_RATIO_NONE;
+	zca->zca_cand[0].zcc_valid = B_TRUE;
+
+	return (zca);
+}
+
+void
+zio_compress_auto_hold(zio_compress_auto_t *zca)
+{
+	atomic_inc_32(&zca->zca_refcnt);
+}
+
+void
+zio_compress_auto_rele(zio_compress_auto_t *zca)
+{
+	if (atomic_dec_32_nv(&zca->zca_refcnt) != 0)
+		return;
+
+	mutex_destroy(&zca->zca_lock);
+	kmem_free(zca, sizeof (*zca));
+}
+
+const char *
+zio_compress_auto_name(uint_t i)
+{
+	ASSERT3U(i, <, ZIO_COMPRESS_AUTO_CANDIDATES);
+	return (zca_candidates[i].zcad_name);
+}
+
+/*
+ * Pick the algorithm and level for the next block.
+ */
+void
+zio_compress_auto_select(zio_compress_auto_t *zca, enum zio_compress *cp,
+    uint8_t *levelp)
+{
+	uint64_t n = atomic_inc_64_nv(&zca->zca_writes);
+	uint_t interval = zfs_compress_auto_sample_interval;
+	uint_t i = zca->zca_current;
+
+	if (interval != 0 && n % interval == 0) {
+		/* Cycle through everything but "off", which needs no data */
+		uint_t s = 1 +
+		    (n / interval) % (ZIO_COMPRESS_AUTO_CANDIDATES - 1);
+		if (s != i) {
+			atomic_inc_64(&zca->zca_cand[s].zcc_samples);
+			i = s;
+		}
+	}
+
+	atomic_inc_64(&zca->zca_cand[i].zcc_blocks);
+	*cp = zca_candidates[i].zcad_compress;
+	*levelp = zca_candidates[i].zcad_level;
+}
+
+/*
+ * Fold the blocks reported since the last window into the smoothed
+ * statistics and choose the candidate to use from now on.
+ */
+static void
+zio_compress_auto_evaluate(zio_compress_auto_t *zca)
+{
+	uint64_t min_gain = (uint64_t)zfs_compress_auto_min_gain *
+	    ZCA_RATIO_NONE / 100;
+	uint_t best = 0;
+
+	mutex_enter(&zca->zca_lock);
+	for (uint_t i = 1; i < ZIO_COMPRESS_AUTO_CANDIDATES; i++) {
+		zca_cand_t *zcc = &zca->zca_cand[i];
+		uint64_t lsize = atomic_swap_64(&zcc->zcc_lsize, 0);
+		uint64_t psize = atomic_swap_64(&zcc->zcc_psize, 0);
+		uint64_t ns = atomic_swap_64(&zcc->zcc_ns, 0);
+
+		if (lsize != 0) {
+			uint64_t ratio = MIN(psize * ZCA_RATIO_NONE / lsize,
+			    ZCA_RATIO_NONE);
+			uint64_t mbps = lsize * 1000 / MAX(ns, 1);
+
+			if (zcc->zcc_valid) {
+				zcc->zcc_ratio =
+				    (zcc->zcc_ratio * 3 + ratio) / 4;
+				zcc->zcc_mbps =
+				    (zcc->zcc_mbps * 3 + mbps) / 4;
+			} else {
+				zcc->zcc_ratio = ratio;
+				zcc->zcc_mbps = mbps;
+				zcc->zcc_valid = B_TRUE;
+			}
+		}
+
+		if (!zcc->zcc_valid ||
+		    zcc->zcc_mbps < zfs_compress_auto_min_mbps)
+			continue;
+		if (zca->zca_cand[best].zcc_ratio >= zcc->zcc_ratio + min_gain)
+			best = i;
+	}
+
+	if (best != zca->zca_current) {
+		zca->zca_current = best;
+		zca->zca_switches++;
+	}
+	mutex_exit(&zca->zca_lock);
+}
+
+/*
+ * Called by zio_write_compress() for every block it compressed on behalf of
+ * zio_compress_auto_select().  psize is what the compressor returned, lsize
+ * if the block did not compress.
+ */
+void
+zio_compress_auto_update(zio_compress_auto_t *zca, enum zio_compress c,
+    uint8_t level, uint64_t lsize, uint64_t psize, hrtime_t ns)
+{
+	uint_t i;
+
+	for (i = 1; i < ZIO_COMPRESS_AUTO_CANDIDATES; i++) {
+		if (zca_candidates[i].zcad_compress == c &&
+		    zca_candidates[i].zcad_level == level)
+			break;
+	}
+	if (i == ZIO_COMPRESS_AUTO_CANDIDATES)
+		return;
+
+	zca_cand_t *zcc = &zca->zca_cand[i];
+	atomic_add_64(&zcc->zcc_lsize, lsize);
+	atomic_add_64(&zcc->zcc_psize, MIN(psize, lsize));
+	atomic_add_64(&zcc->zcc_ns, ns);
+
+	uint_t window = MAX(zfs_compress_auto_window, 1);
+	if (atomic_inc_64_nv(&zca->zca_updates) % window == 0)
+		zio_compress_auto_evaluate(zca);
+}
+
+void
+zio_compress_auto_stats(zio_compress_auto_t *zca,
+    zio_compress_auto_stats_t *zcas)
+{
+	mutex_enter(&zca->zca_lock);
+	zcas->zcas_current = zca->zca_current;
+	zcas->zcas_switches = zca->zca_switches;
+	for (uint_t i = 0; i < ZIO_COMPRESS_AUTO_CANDIDATES; i++) {
+		zca_cand_t *zcc = &zca->zca_cand[i];
+
+		zcas->zcas_blocks[i] = zcc->zcc_blocks;
+		zcas->zcas_samples[i] = zcc->zcc_samples;
+		zcas->zcas_ratio[i] = zcc->zcc_valid ?
+		    ZCA_RATIO_NONE * 100 / MAX(zcc->zcc_ratio, 1) : 0;
+		zcas->zcas_mbps[i] = zcc->zcc_mbps;
+	}
+	mutex_exit(&zca->zca_lock);
+}
+
+ZFS_MODULE_PARAM(zfs_compress_auto, zfs_compress_auto_, min_mbps, UINT,
+	ZMOD_RW, "Minimum compression=auto throughput in MB/s");
+
+ZFS_MODULE_PARAM(zfs_compress_auto, zfs_compress_auto_, min_gain, UINT,
+	ZMOD_RW, "Percent more space a costlier algorithm must save");
+
+ZFS_MODULE_PARAM(zfs_compress_auto, zfs_compress_auto_, sample_interval,
+	UINT, ZMOD_RW, "Sample another algorithm every Nth block");
+
+ZFS_MODULE_PARAM(zfs_compress_auto, zfs_compress_auto_, window, UINT,
+	ZMOD_RW, "Blocks between compression=auto decisions");
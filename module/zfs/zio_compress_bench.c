@@ -0,0 +1,418 @@
+// SPDX-License-Identifier: CDDL-1.0
+/*
+ * CDDL HEADER START
+ *
+ * The contents of this file are subject to the terms of the
+ * Common Development and Distribution License (the "License").
+ * You may not use this file except in compliance with the License.
+ *
+ * You can obtain a copy of the license at usr/src/OPENSOLARIS.LICENSE
+ * or https://opensource.org/licenses/CDDL-1.0.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * When distributing Covered Code, include this CDDL HEADER in each
+ * file and include the License file at usr/src/OPENSOLARIS.LICENSE.
+ * If applicable, add the following below this CDDL HEADER, with the
+ * fields enclosed by brackets "[]" replaced with your own identifying
+ * information: Portions Copyright [yyyy] [name of copyright owner]
+ *
+ * CDDL HEADER END
+ */
+
+/*
+ * Compression micro-benchmark.
+ *
+ * Every compression algorithm and level that can be set with the
+ * compression property is run over a synthetic, mixed content buffer at
+ * several block sizes, and the compress and decompress throughput and the
+ * compression ratio are recorded.  Unlike the checksum benchmark this is
+ * far too slow to run at module load (the high zstd levels alone take
+ * seconds), so the kernel runs it on the first read of the compress_bench
+ * kstat; writing to the kstat discards the results so that the next read
+ * measures again, e.g. after changing zfs_lz4_impl.  User space tools
+ * linked against libzpool run it directly with zio_compress_bench_run().
+ */
+
+#include <sys/zfs_context.h>
+#include <sys/zio.h>
+#include <sys/zio_compress.h>
+
+/* Minimum time each algorithm, level and block size is measured for */
+#define	ZCB_BENCH_NS	(MSEC2NSEC(10))
+
+/* Content type changes every ZCB_SEGMENT bytes of the test buffer */
+#define	ZCB_SEGMENT	512
+
+static const uint32_t zcb_bsizes[] = {
+	4 << 10, 16 << 10, 128 << 10, 1 << 20
+};
+
+#define	ZCB_BSIZES	ARRAY_SIZE(zcb_bsizes)
+#define	ZCB_BSIZE_MAX	(1 << 20)
+
+/*
+ * One kstat line per algorithm and block size, throughput in MiB/s:
+ *
+ * algorithm        blocksize   compress decompress    ratio
+ * lz4                     4k        ...        ...      ...
+ */
+static zio_compress_bench_t *zcb_stat_data = NULL;
+static uint_t zcb_stat_cnt = 0;
+static boolean_t zcb_stat_valid = B_FALSE;
+static kstat_t *zcb_kstat = NULL;
+
+#define	ZCB_RAND(x) \
+	((x) = (x) * 6364136223846793005ULL + 1442695040888963407ULL)
+
+/*
+ * Fill the test buffer with a mix of the kind of content that ends up in
+ * pool blocks: English-like text, fixed size binary records with slowly
+ * changing fields, runs of zeros and incompressible random data.
+ */
+static void
+zio_compress_bench_fill(uint8_t *buf, size_t size)
+{
+	static const char *const words[] = {
+		"the", "of", "and", "to", "in", "is", "for", "that", "with",
+		"on", "as", "was", "data", "block", "pool", "file", "record",
+		"checksum", "object", "dataset", "snapshot", "write", "read",
+		"transaction", "compression", "allocation", "directory",
+	};
+	uint64_t x = 0x2545f4914f6cdd1dULL;
+	uint64_t id = 0;
+
+	for (size_t off = 0; off < size; off += ZCB_SEGMENT) {
+		uint8_t *seg = buf + off;
+		size_t len = MIN(ZCB_SEGMENT, size - off);
+		uint_t kind = ZCB_RAND(x) >> 60;
+		size_t i = 0;
+
+		if (kind < 6) {
+			/* text */
+			while (i < len) {
+				uint_t w = (ZCB_RAND(x) >> 33) %
+				    ARRAY_SIZE(words);
+				size_t wl = MIN(strlen(words[w]), len - i);
+
+				memcpy(seg + i, words[w], wl);
+				i += wl;
+				if (i < len)
+					seg[i++] = (w != 0) ? ' ' : '\n';
+			}
+		} else if (kind < 11) {
+			/* records */
+			for (; i + 4 * sizeof (uint64_t) <= len;
+			    i += 4 * sizeof (uint64_t)) {
+				uint64_t rec[4];
+
+				rec[0] = id++;
+				rec[1] = 1700000000000ULL + id * 17 +
+				    ((ZCB_RAND(x) >> 56));
+				rec[2] = (x >> 40) & 3;
+				rec[3] = 0x6174616474736574ULL;
+				memcpy(seg + i, rec, sizeof (rec));
+			}
+			memset(seg + i, 0, len - i);
+		} else if (kind < 13) {
+			/* zeros */
+			memset(seg, 0, len);
+		} else {
+			/* random */
+			for (; i < len; i++)
+				seg[i] = ZCB_RAND(x) >> 56;
+		}
+	}
+}
+
+static uint64_t
+zio_compress_bench_mbs(uint64_t bytes, hrtime_t ns)
+{
+	if (ns == 0)
+		return (0);
+
+	return (bytes * NANOSEC / ns / 1024 / 1024);	/* MiB/s */
+}
+
+static void
+zio_compress_bench_one(zio_compress_bench_t *zcb, abd_t *src, abd_t *cabd,
+    abd_t *dabd)
+{
+	zio_compress_info_t *ci = &zio_compress_table[zcb->zcb_compress];
+	int level = (zcb->zcb_compress == ZIO_COMPRESS_ZSTD) ?
+	    zcb->zcb_level : ci->ci_level;
+	size_t bsize = zcb->zcb_bsize;
+	uint64_t runs;
+	size_t c_len = 0;
+	hrtime_t start, elapsed;
+
+	runs = 0;
+	start = gethrtime();
+	do {
+		c_len = ci->ci_compress(src, cabd, bsize, bsize, level);
+		runs++;
+		elapsed = gethrtime() - start;
+	} while (elapsed < ZCB_BENCH_NS);
+	zcb->zcb_compress_mbs = zio_compress_bench_mbs(bsize * runs, elapsed);
+
+	/* An incompressible block would be stored as is */
+	if (c_len >= bsize) {
+		zcb->zcb_ratio = 100;
+		zcb->zcb_decompress_mbs = 0;
+		return;
+	}
+	zcb->zcb_ratio = bsize * 100 / c_len;
+
+	runs = 0;
+	start = gethrtime();
+	do {
+		if (ci->ci_decompress(cabd, dabd, c_len, bsize, level) != 0)
+			break;
+		runs++;
+		elapsed = gethrtime() - start;
+	} while (elapsed < ZCB_BENCH_NS);
+
+	if (runs == 0 || abd_cmp(src, dabd) != 0) {
+		zfs_dbgmsg("compress_bench: %s failed to decompress",
+		    zcb->zcb_name);
+		zcb->zcb_decompress_mbs = 0;
+		return;
+	}
+	zcb->zcb_decompress_mbs = zio_compress_bench_mbs(bsize * runs,
+	    elapsed);
+}
+
+/*
+ * The name of the compression property value selecting this algorithm.
+ */
+static void
+zio_compress_bench_name(char *buf, size_t size, enum zio_compress c,
+    uint8_t level)
+{
+	uint_t fast;
+
+	if (c != ZIO_COMPRESS_ZSTD) {
+		(void) strlcpy(buf, zio_compress_table[c].ci_name, size);
+	} else if (level <= ZIO_ZSTD_LEVEL_MAX) {
+		(void) snprintf(buf, size, "zstd-%u", level);
+	} else {
+		/* zstd-fast-1 to 10, 20 to 100 in steps of 10, 500, 1000 */
+		fast = level - ZIO_ZSTD_LEVEL_FAST_1 + 1;
+		if (level == ZIO_ZSTD_LEVEL_FAST_500)
+			fast = 500;
+		else if (level == ZIO_ZSTD_LEVEL_FAST_1000)
+			fast = 1000;
+		else if (fast > 10)
+			fast = (fast - 9) * 10;
+		(void) snprintf(buf, size, "zstd-fast-%u", fast);
+	}
+}
+
+/*
+ * Set up zcb_stat_data with one entry per algorithm, level and block size.
+ */
+static void
+zio_compress_bench_setup(void)
+{
+	static const enum zio_compress algs[] = {
+		ZIO_COMPRESS_LZ4, ZIO_COMPRESS_LZJB, ZIO_COMPRESS_ZLE,
+		ZIO_COMPRESS_GZIP_1, ZIO_COMPRESS_GZIP_2, ZIO_COMPRESS_GZIP_3,
+		ZIO_COMPRESS_GZIP_4, ZIO_COMPRESS_GZIP_5, ZIO_COMPRESS_GZIP_6,
+		ZIO_COMPRESS_GZIP_7, ZIO_COMPRESS_GZIP_8, ZIO_COMPRESS_GZIP_9,
+	};
+	uint_t nlevels = (ZIO_ZSTD_LEVEL_MAX - ZIO_ZSTD_LEVEL_MIN + 1) +
+	    (ZIO_ZSTD_LEVEL_FAST_MAX - ZIO_ZSTD_LEVEL_FAST_1 + 1);
+	uint_t n = 0;
+
+	zcb_stat_cnt = (ARRAY_SIZE(algs) + nlevels) * ZCB_BSIZES;
+	zcb_stat_data = kmem_zalloc(sizeof (zio_compress_bench_t) *
+	    zcb_stat_cnt, KM_SLEEP);
+
+	for (uint_t a = 0; a < ARRAY_SIZE(algs) + nlevels; a++) {
+		enum zio_compress c = ZIO_COMPRESS_ZSTD;
+		uint8_t level;
+		char name[ZIO_COMPRESS_BENCH_NAMELEN];
+
+		if (a < ARRAY_SIZE(algs)) {
+			c = algs[a];
+			level = ZIO_COMPLEVEL_INHERIT;
+		} else if (a - ARRAY_SIZE(algs) <
+		    ZIO_ZSTD_LEVEL_MAX - ZIO_ZSTD_LEVEL_MIN + 1) {
+			level = ZIO_ZSTD_LEVEL_MIN + a - ARRAY_SIZE(algs);
+		} else {
+			level = ZIO_ZSTD_LEVEL_FAST_1 + a - ARRAY_SIZE(algs) -
+			    (ZIO_ZSTD_LEVEL_MAX - ZIO_ZSTD_LEVEL_MIN + 1);
+		}
+
+		zio_compress_bench_name(name, sizeof (name), c, level);
+
+		for (uint_t b = 0; b < ZCB_BSIZES; b++) {
+			zio_compress_bench_t *zcb = &zcb_stat_data[n++];
+
+			(void) strlcpy(zcb->zcb_name, name,
+			    sizeof (zcb->zcb_name));
+			zcb->zcb_compress = c;
+			zcb->zcb_level = level;
+			zcb->zcb_bsize = zcb_bsizes[b];
+		}
+	}
+	ASSERT3U(n, ==, zcb_stat_cnt);
+}
+
+/*
+ * Whether an entry's name matches filter: the whole name, or any name
+ * starting with it if it ends in '-' or '*' (the '*' itself is dropped), so
+ * that "zstd-1" is only zstd-1 while "zstd-" and "zstd-*" are every level.
+ */
+boolean_t
+zio_compress_bench_match(const char *name, const char *filter)
+{
+	size_t len = strlen(filter);
+
+	if (len > 0 && filter[len - 1] == '*')
+		return (strncmp(name, filter, len - 1) == 0);
+	if (len > 0 && filter[len - 1] == '-')
+		return (strncmp(name, filter, len) == 0);
+	return (strcmp(name, filter) == 0);
+}
+
+/*
+ * Measure all entries matching filter (all when NULL), see
+ * zio_compress_bench_match().  Returns the number of entries, see
+ * zio_compress_bench_get().
+ */
+uint_t
+zio_compress_bench_run(const char *filter)
+{
+	abd_t *src, *cabd, *dabd;
+
+	src = abd_alloc_linear(ZCB_BSIZE_MAX, B_FALSE);
+	cabd = abd_alloc_linear(ZCB_BSIZE_MAX, B_FALSE);
+	dabd = abd_alloc_linear(ZCB_BSIZE_MAX, B_FALSE);
+	zio_compress_bench_fill(abd_to_buf(src), ZCB_BSIZE_MAX);
+
+	for (uint_t i = 0; i < zcb_stat_cnt; i++) {
+		zio_compress_bench_t *zcb = &zcb_stat_data[i];
+		abd_t *s, *d;
+
+		if (filter != NULL &&
+		    !zio_compress_bench_match(zcb->zcb_name, filter))
+			continue;
+
+		s = abd_get_offset_size(src, 0, zcb->zcb_bsize);
+		d = abd_get_offset_size(dabd, 0, zcb->zcb_bsize);
+		zio_compress_bench_one(zcb, s, cabd, d);
+		abd_free(d);
+		abd_free(s);
+	}
+
+	abd_free(dabd);
+	abd_free(cabd);
+	abd_free(src);
+
+	return (zcb_stat_cnt);
+}
+
+const zio_compress_bench_t *
+zio_compress_bench_get(uint_t i)
+{
+	return (i < zcb_stat_cnt ? &zcb_stat_data[i] : NULL);
+}
+
+static int
+zio_compress_bench_kstat_update(kstat_t *ksp, int rw)
+{
+	(void) ksp;
+
+	if (rw == KSTAT_WRITE) {
+		zcb_stat_valid = B_FALSE;
+	} else if (!zcb_stat_valid) {
+		(void) zio_compress_bench_run(NULL);
+		zcb_stat_valid = B_TRUE;
+	}
+
+	return (0);
+}
+
+static int
+zio_compress_bench_kstat_headers(char *buf, size_t size)
+{
+	ssize_t off = 0;
+
+	off += kmem_scnprintf(buf + off, size, "%-16s", "algorithm");
+	off += kmem_scnprintf(buf + off, size - off, "%10s", "blocksize");
+	off += kmem_scnprintf(buf + off, size - off, "%11s", "compress");
+	off += kmem_scnprintf(buf + off, size - off, "%11s", "decompress");
+	(void) kmem_scnprintf(buf + off, size - off, "%9s\n", "ratio");
+
+	return (0);
+}
+
+static int
+zio_compress_bench_kstat_data(char *buf, size_t size, void *data)
+{
+	zio_compress_bench_t *zcb = data;
+	ssize_t off = 0;
+
+	off += kmem_scnprintf(buf + off, size - off, "%-16s", zcb->zcb_name);
+	off += kmem_scnprintf(buf + off, size - off, "%9uk",
+	    zcb->zcb_bsize >> 10);
+	off += kmem_scnprintf(buf + off, size - off, "%11llu",
+	    (u_longlong_t)zcb->zcb_compress_mbs);
+	off += kmem_scnprintf(buf + off, size - off, "%11llu",
+	    (u_longlong_t)zcb->zcb_decompress_mbs);
+	(void) kmem_scnprintf(buf + off, size - off, "%6llu.%02llu\n",
+	    (u_longlong_t)zcb->zcb_ratio / 100,
+	    (u_longlong_t)zcb->zcb_ratio % 100);
+
+	return (0);
+}
+
+static void *
+zio_compress_bench_kstat_addr(kstat_t *ksp, loff_t n)
+{
+	if (n < zcb_stat_cnt)
+		ksp->ks_private = (void *)(zcb_stat_data + n);
+	else
+		ksp->ks_private = NULL;
+
+	return (ksp->ks_private);
+}
+
+void
+zio_compress_bench_init(void)
+{
+	zio_compress_bench_setup();
+
+	/* The benchmark itself runs on the first read of the kstat */
+	zcb_kstat = kstat_create("zfs", 0, "compress_bench", "misc",
+	    KSTAT_TYPE_RAW, 0, KSTAT_FLAG_VIRTUAL);
+
+	if (zcb_kstat != NULL) {
+		zcb_kstat->ks_data = NULL;
+		zcb_kstat->ks_ndata = UINT32_MAX;
+		zcb_kstat->ks_update = zio_compress_bench_kstat_update;
+		kstat_set_raw_ops(zcb_kstat,
+		    zio_compress_bench_kstat_headers,
+		    zio_compress_bench_kstat_data,
+		    zio_compress_bench_kstat_addr);
+		kstat_install(zcb_kstat);
+	}
+}
+
+void
+zio_compress_bench_fini(void)
+{
+	if (zcb_kstat != NULL) {
+		kstat_delete(zcb_kstat);
+		zcb_kstat = NULL;
+	}
+
+	if (zcb_stat_cnt) {
+		kmem_free(zcb_stat_data,
+		    sizeof (zio_compress_bench_t) * zcb_stat_cnt);
+		zcb_stat_cnt = 0;
+		zcb_stat_data = NULL;
+		zcb_stat_valid = B_FALSE;
+	}
+}
@@ -74,6 +74,7 @@
 
 #include <sys/dataset_kstats.h>
 #include <sys/dbuf.h>
+#include <sys/dmu_objset.h>
 #include <sys/dmu_traverse.h>
 #include <sys/dsl_dataset.h>
 #include <sys/dsl_prop.h>
@@ -858,6 +859,47 @@ zil_replay_func_t *const zvol_replay_vector[TX_MAX_TYPE] = {
 	zvol_replay_clone_range,	/* TX_CLONE_RANGE */
 };
 
+/*
+ * Wait until the volume's iolimit_* properties allow a read or write of
+ * size bytes.  Block I/O is not failed because of a signal, so the wait is
+ * not interruptible.  Call this from the submitting thread, never from a
+ * worker shared with other zvols.
+ *
+ * The caller holds zv_suspend_lock, which is dropped while sleeping so
+ * that zvol_suspend() is not held up by a throttled volume.
+ * The objset may change while the volume is suspended, so the wait cannot
+ * be on the objset's condition variable: it sleeps in slices of at most
+ * ZVOL_IOLIMIT_SLICE instead, and goes ahead early if the limits changed.
+ * Anything the caller looked up under the lock before has to be looked up
+ * again afterwards.
+ */
+#define	ZVOL_IOLIMIT_SLICE	MSEC2NSEC(100)
+
+void
+zvol_iolimit(zvol_state_t *zv, boolean_t write, uint64_t size)
+{
+	krw_t rw = RW_WRITE_HELD(&zv->zv_suspend_lock) ? RW_WRITER : RW_READER;
+	hrtime_t start, now, wakeup;
+	uint64_t gen;
+
+	ASSERT(RW_LOCK_HELD(&zv->zv_suspend_lock));
+
+	start = now = gethrtime();
+	wakeup = dmu_objset_iolimit_charge(zv->zv_objset, write, size, &gen);
+
+	while (now < wakeup) {
+		rw_exit(&zv->zv_suspend_lock);
+		zfs_sleep_until(MIN(wakeup, now + ZVOL_IOLIMIT_SLICE));
+		rw_enter(&zv->zv_suspend_lock, rw);
+
+		now = gethrtime();
+		if (dmu_objset_iolimit_changed(zv->zv_objset, gen))
+			break;
+	}
+
+	dataset_kstats_update_iolimit_kstats(&zv->zv_kstat, write, now - start);
+}
+
 /*
  * zvol_log_write() handles synchronous writes using TX_WRITE ZIL transactions.
  *
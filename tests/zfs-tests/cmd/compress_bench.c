@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: CDDL-1.0
+/*
+ * This file and its contents are supplied under the terms of the
+ * Common Development and Distribution License ("CDDL"), version 1.0.
+ * You may only use this file in accordance with the terms of version
+ * 1.0 of the CDDL.
+ *
+ * A full copy of the text of the CDDL should have accompanied this
+ * source.  A copy of the CDDL is also available via the Internet at
+ * http://www.illumos.org/license/CDDL.
+ */
+
+/*
+ * User space front end for the compression benchmark.
+ *
+ * Runs the same measurement as the compress_bench kstat of the kernel
+ * module, using the libzpool build of the compression code, and prints
+ * compress and decompress throughput and the compression ratio for every
+ * algorithm, level and block size.  An optional prefix restricts the run
+ * to matching algorithms, e.g. "zstd-fast" or "gzip".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/zfs_context.h>
+#include <sys/spa.h>
+#include <sys/zio_compress.h>
+
+static void
+usage(int exit_value)
+{
+	(void) fprintf(stderr, "Usage:\tcompress_bench [algorithm]\n");
+	(void) fprintf(stderr, "\te.g. compress_bench lz4, "
+	    "compress_bench zstd-1, compress_bench 'zstd-*'\n");
+	exit(exit_value);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *filter = NULL;
+	uint_t cnt;
+	int c;
+
+	while ((c = getopt(argc, argv, "h")) != -1) {
+		switch (c) {
+		case 'h':
+			usage(0);
+			break;
+		default:
+			usage(1);
+		}
+	}
+
+	if (optind < argc - 1)
+		usage(1);
+	if (optind == argc - 1)
+		filter = argv[optind];
+
+	kernel_init(SPA_MODE_READ);
+
+	cnt = zio_compress_bench_run(filter);
+
+	(void) printf("%-16s%10s%11s%11s%9s\n", "algorithm", "blocksize",
+	    "compress", "decompress", "ratio");
+	for (uint_t i = 0; i < cnt; i++) {
+		const zio_compress_bench_t *zcb = zio_compress_bench_get(i);
+
+		if (filter != NULL &&
+		    !zio_compress_bench_match(zcb->zcb_name, filter))
+			continue;
+
+		(void) printf("%-16s%9uk%11llu%11llu%6llu.%02llu\n",
+		    zcb->zcb_name, zcb->zcb_bsize >> 10,
+		    (u_longlong_t)zcb->zcb_compress_mbs,
+		    (u_longlong_t)zcb->zcb_decompress_mbs,
+		    (u_longlong_t)zcb->zcb_ratio / 100,
+		    (u_longlong_t)zcb->zcb_ratio % 100);
+	}
+
+	kernel_fini();
+
+	return (0);
+}
@@ -0,0 +1,283 @@
+// SPDX-License-Identifier: CDDL-1.0
+/*
+ * This file and its contents are supplied under the terms of the
+ * Common Development and Distribution License ("CDDL"), version 1.0.
+ * You may only use this file in accordance with the terms of version
+ * 1.0 of the CDDL.
+ *
+ * A full copy of the text of the CDDL should have accompanied this
+ * source.  A copy of the CDDL is also available via the Internet at
+ * http://www.illumos.org/license/CDDL.
+ */
+
+/*
+ * Microbenchmark for the dbuf hash table lookup path.
+ *
+ * A pool is created on a file vdev using libzpool, a single object is
+ * written and all of its dbufs are held once so that they are cached.
+ * Then, for an increasing number of threads, each thread repeatedly takes
+ * and releases a hold on a random block of that object.  Every hold is a
+ * dbuf_find() hit, so the reported rate is dominated by the hash table
+ * lookup and its locking, and shows how that path scales with the number
+ * of concurrent threads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/zfs_context.h>
+#include <sys/spa.h>
+#include <sys/dmu.h>
+#include <sys/dmu_objset.h>
+#include <sys/dnode.h>
+#include <sys/txg.h>
+#include <sys/fs/zfs.h>
+
+#define	BENCH_POOL	"dbuf_bench"
+#define	BENCH_DS	BENCH_POOL "/bench"
+
+static const char *bench_dir = "/var/tmp";
+static uint64_t bench_blocks = 16384;
+static uint64_t bench_blksz = 4096;
+static int bench_max_threads = 0;
+static int bench_seconds = 5;
+
+static volatile boolean_t bench_stop;
+
+typedef struct bench_thread {
+	pthread_t	bt_thread;
+	dnode_t		*bt_dn;
+	uint64_t	bt_seed;
+	uint64_t	bt_ops;
+} bench_thread_t;
+
+static void
+usage(int exit_value)
+{
+	(void) fprintf(stderr, "Usage:\tdbuf_bench [-d dir] [-n blocks] "
+	    "[-b blocksize] [-t max_threads] [-s seconds]\n");
+	(void) fprintf(stderr, "\t-d directory for the pool file "
+	    "[default: /var/tmp]\n");
+	(void) fprintf(stderr, "\t-n number of cached blocks to look up "
+	    "[default: 16384]\n");
+	(void) fprintf(stderr, "\t-b block size [default: 4096]\n");
+	(void) fprintf(stderr, "\t-t maximum number of threads "
+	    "[default: number of CPUs]\n");
+	(void) fprintf(stderr, "\t-s seconds to run each thread count "
+	    "[default: 5]\n");
+	exit(exit_value);
+}
+
+static uint64_t
+bench_random(uint64_t *seed)
+{
+	/* xorshift64, cheap enough to not show up in the profile */
+	uint64_t x = *seed;
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*seed = x;
+	return (x);
+}
+
+static void *
+bench_thread(void *arg)
+{
+	bench_thread_t *bt = arg;
+	dmu_buf_t *db;
+
+	while (!bench_stop) {
+		for (int i = 0; i < 1024; i++) {
+			uint64_t off = (bench_random(&bt->bt_seed) %
+			    bench_blocks) * bench_blksz;
+
+			VERIFY0(dmu_buf_hold_by_dnode(bt->bt_dn, off, FTAG,
+			    &db, DMU_READ_NO_PREFETCH));
+			dmu_buf_rele(db, FTAG);
+		}
+		bt->bt_ops += 1024;
+	}
+
+	return (NULL);
+}
+
+static uint64_t
+bench_run(dnode_t *dn, int nthreads)
+{
+	bench_thread_t *bt = umem_zalloc(nthreads * sizeof (bench_thread_t),
+	    UMEM_NOFAIL);
+	uint64_t ops = 0;
+
+	bench_stop = B_FALSE;
+	for (int t = 0; t < nthreads; t++) {
+		bt[t].bt_dn = dn;
+		bt[t].bt_seed = gethrtime() | (t + 1);
+		VERIFY0(pthread_create(&bt[t].bt_thread, NULL, bench_thread,
+		    &bt[t]));
+	}
+
+	(void) sleep(bench_seconds);
+	bench_stop = B_TRUE;
+
+	for (int t = 0; t < nthreads; t++) {
+		VERIFY0(pthread_join(bt[t].bt_thread, NULL));
+		ops += bt[t].bt_ops;
+	}
+	umem_free(bt, nthreads * sizeof (bench_thread_t));
+
+	return (ops / bench_seconds);
+}
+
+static void
+bench_create_pool(const char *path)
+{
+	nvlist_t *root, *file;
+	uint64_t size = MAX(bench_blocks * bench_blksz * 2,
+	    SPA_MINDEVSIZE * 4);
+	int fd;
+
+	fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (fd == -1 || ftruncate(fd, size) != 0) {
+		perror(path);
+		exit(1);
+	}
+	(void) close(fd);
+
+	file = fnvlist_alloc();
+	fnvlist_add_string(file, ZPOOL_CONFIG_TYPE, VDEV_TYPE_FILE);
+	fnvlist_add_string(file, ZPOOL_CONFIG_PATH, path);
+	fnvlist_add_uint64(file, ZPOOL_CONFIG_ASHIFT, SPA_MINBLOCKSHIFT);
+
+	root = fnvlist_alloc();
+	fnvlist_add_string(root, ZPOOL_CONFIG_TYPE, VDEV_TYPE_ROOT);
+	fnvlist_add_nvlist_array(root, ZPOOL_CONFIG_CHILDREN,
+	    (const nvlist_t **)&file, 1);
+
+	VERIFY0(spa_create(BENCH_POOL, root, NULL, NULL, NULL));
+	fnvlist_free(file);
+	fnvlist_free(root);
+
+	VERIFY0(dmu_objset_create(BENCH_DS, DMU_OST_OTHER, 0, NULL, NULL,
+	    NULL));
+}
+
+static uint64_t
+bench_create_object(objset_t *os)
+{
+	char *buf = umem_zalloc(bench_blksz, UMEM_NOFAIL);
+	uint64_t object;
+	dmu_tx_t *tx;
+
+	tx = dmu_tx_create(os);
+	dmu_tx_hold_bonus(tx, DMU_NEW_OBJECT);
+	VERIFY0(dmu_tx_assign(tx, DMU_TX_WAIT));
+	object = dmu_object_alloc(os, DMU_OT_UINT64_OTHER, bench_blksz,
+	    DMU_OT_NONE, 0, tx);
+	dmu_tx_commit(tx);
+
+	for (uint64_t b = 0; b < bench_blocks; b++) {
+		(void) memset(buf, (int)b, bench_blksz);
+		tx = dmu_tx_create(os);
+		dmu_tx_hold_write(tx, object, b * bench_blksz, bench_blksz);
+		VERIFY0(dmu_tx_assign(tx, DMU_TX_WAIT));
+		dmu_write(os, object, b * bench_blksz, bench_blksz, buf, tx);
+		dmu_tx_commit(tx);
+	}
+	txg_wait_synced(dmu_objset_pool(os), 0);
+	umem_free(buf, bench_blksz);
+
+	return (object);
+}
+
+int
+main(int argc, char *argv[])
+{
+	char path[MAXPATHLEN];
+	objset_t *os;
+	dnode_t *dn;
+	dmu_buf_t **dbp;
+	uint64_t object, base = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "d:n:b:t:s:h")) != -1) {
+		switch (c) {
+		case 'd':
+			bench_dir = optarg;
+			break;
+		case 'n':
+			bench_blocks = strtoull(optarg, NULL, 0);
+			break;
+		case 'b':
+			bench_blksz = strtoull(optarg, NULL, 0);
+			break;
+		case 't':
+			bench_max_threads = atoi(optarg);
+			break;
+		case 's':
+			bench_seconds = atoi(optarg);
+			break;
+		case 'h':
+			usage(0);
+			break;
+		default:
+			usage(1);
+		}
+	}
+
+	if (bench_blocks == 0 || bench_seconds <= 0 ||
+	    bench_blksz < SPA_MINBLOCKSIZE ||
+	    bench_blksz > SPA_OLD_MAXBLOCKSIZE ||
+	    !ISP2(bench_blksz))
+		usage(1);
+	if (bench_max_threads <= 0)
+		bench_max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	(void) snprintf(path, sizeof (path), "%s/%s.%d", bench_dir,
+	    BENCH_POOL, (int)getpid());
+
+	kernel_init(SPA_MODE_READ | SPA_MODE_WRITE);
+	bench_create_pool(path);
+
+	VERIFY0(dmu_objset_own(BENCH_DS, DMU_OST_OTHER, B_FALSE, B_TRUE,
+	    FTAG, &os));
+	object = bench_create_object(os);
+	VERIFY0(dnode_hold(os, object, FTAG, &dn));
+
+	/*
+	 * Hold every block once so the dbufs are instantiated, and keep
+	 * them held so that the dbuf cache cannot evict them while the
+	 * benchmark is running.
+	 */
+	dbp = umem_zalloc(bench_blocks * sizeof (dmu_buf_t *), UMEM_NOFAIL);
+	for (uint64_t b = 0; b < bench_blocks; b++) {
+		VERIFY0(dmu_buf_hold_by_dnode(dn, b * bench_blksz, FTAG,
+		    &dbp[b], DMU_READ_NO_PREFETCH));
+	}
+
+	(void) printf("%8s %16s %10s\n", "threads", "lookups/s", "speedup");
+	/* Double the thread count each round, ending at exactly the max */
+	for (int t = 1; t <= bench_max_threads; t = (t == bench_max_threads) ?
+	    bench_max_threads + 1 : MIN(t * 2, bench_max_threads)) {
+		uint64_t rate = bench_run(dn, t);
+
+		if (base == 0)
+			base = MAX(rate, 1);
+		(void) printf("%8d %16llu %9.2fx\n", t, (u_longlong_t)rate,
+		    (double)rate / base);
+	}
+
+	for (uint64_t b = 0; b < bench_blocks; b++)
+		dmu_buf_rele(dbp[b], FTAG);
+	umem_free(dbp, bench_blocks * sizeof (dmu_buf_t *));
+
+	dnode_rele(dn, FTAG);
+	dmu_objset_disown(os, B_TRUE, FTAG);
+	VERIFY0(spa_destroy(BENCH_POOL));
+	kernel_fini();
+	(void) unlink(path);
+
+	return (0);
+}
@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: CDDL-1.0
+/*
+ * This file and its contents are supplied under the terms of the
+ * Common Development and Distribution License ("CDDL"), version 1.0.
+ * You may only use this file in accordance with the terms of version
+ * 1.0 of the CDDL.
+ *
+ * A full copy of the text of the CDDL should have accompanied this
+ * source.  A copy of the CDDL is also available via the Internet at
+ * http://www.illumos.org/license/CDDL.
+ */
+
+/*
+ * Throughput benchmark for "zfs send".
+ *
+ * The given snapshot is sent with lzc_send() into a pipe, a second thread
+ * drains the pipe and discards the stream, and the rate at which the
+ * stream was produced is reported.  Since nothing is done with the data
+ * the result reflects the cost of generating the stream and writing it to
+ * the file descriptor, which is what the kernel send path is responsible
+ * for.  The send is repeated the requested number of times, which allows
+ * comparing cold and warm (ARC cached) runs.
+ */
+
+#include <libzfs_core.h>
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+#include <time.h>
+#include <unistd.h>
+
+#define	SEND_BENCH_BUFSIZE	(1024 * 1024)
+
+typedef struct send_bench_drain {
+	int		sbd_fd;
+	uint64_t	sbd_bytes;
+} send_bench_drain_t;
+
+static void
+usage(const char *name)
+{
+	(void) fprintf(stderr, "usage: %s [-cLew] [-i fromsnap] "
+	    "[-n count] snap\n", name);
+	(void) fprintf(stderr, "\t-c compressed stream (zfs send -c)\n");
+	(void) fprintf(stderr, "\t-L large blocks (zfs send -L)\n");
+	(void) fprintf(stderr, "\t-e embedded data (zfs send -e)\n");
+	(void) fprintf(stderr, "\t-w raw stream (zfs send -w)\n");
+	(void) fprintf(stderr, "\t-i incremental source snapshot\n");
+	(void) fprintf(stderr, "\t-n number of sends [default: 1]\n");
+	exit(EX_USAGE);
+}
+
+static void *
+send_bench_drain(void *arg)
+{
+	send_bench_drain_t *sbd = arg;
+	char *buf = malloc(SEND_BENCH_BUFSIZE);
+	ssize_t n;
+
+	if (buf == NULL)
+		err(EX_OSERR, "malloc");
+
+	while ((n = read(sbd->sbd_fd, buf, SEND_BENCH_BUFSIZE)) != 0) {
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			err(EX_IOERR, "read");
+		}
+		sbd->sbd_bytes += n;
+	}
+
+	free(buf);
+	return (NULL);
+}
+
+static double
+send_bench_now(void)
+{
+	struct timespec ts;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+int
+main(int argc, char *argv[])
+{
+	enum lzc_send_flags flags = 0;
+	const char *from = NULL;
+	int count = 1;
+	int c;
+
+	while ((c = getopt(argc, argv, "cLewi:n:")) != -1) {
+		switch (c) {
+		case 'c':
+			flags |= LZC_SEND_FLAG_COMPRESS;
+			break;
+		case 'L':
+			flags |= LZC_SEND_FLAG_LARGE_BLOCK;
+			break;
+		case 'e':
+			flags |= LZC_SEND_FLAG_EMBED_DATA;
+			break;
+		case 'w':
+			flags |= LZC_SEND_FLAG_RAW;
+			break;
+		case 'i':
+			from = optarg;
+			break;
+		case 'n':
+			count = atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (optind != argc - 1 || count <= 0)
+		usage(argv[0]);
+
+	const char *snap = argv[optind];
+
+	if (libzfs_core_init() != 0)
+		err(EX_OSERR, "libzfs_core_init");
+
+	(void) printf("%6s %16s %10s %12s\n", "run", "bytes", "seconds",
+	    "MiB/s");
+	for (int i = 1; i <= count; i++) {
+		send_bench_drain_t sbd = { 0 };
+		pthread_t tid;
+		int fds[2];
+
+		if (pipe(fds) != 0)
+			err(EX_OSERR, "pipe");
+#ifdef F_SETPIPE_SZ
+		/* Use a large pipe so the drain thread is rarely the limit */
+		(void) fcntl(fds[0], F_SETPIPE_SZ, SEND_BENCH_BUFSIZE);
+#endif
+
+		sbd.sbd_fd = fds[0];
+		if ((errno = pthread_create(&tid, NULL, send_bench_drain,
+		    &sbd)) != 0)
+			err(EX_OSERR, "pthread_create");
+
+		double start = send_bench_now();
+		int error = lzc_send(snap, from, fds[1], flags);
+		(void) close(fds[1]);
+		(void) pthread_join(tid, NULL);
+		double secs = send_bench_now() - start;
+		(void) close(fds[0]);
+
+		if (error != 0) {
+			errno = error;
+			err(EX_SOFTWARE, "lzc_send(\"%s\")", snap);
+		}
+
+		(void) printf("%6d %16llu %10.3f %12.1f\n", i,
+		    (unsigned long long)sbd.sbd_bytes, secs,
+		    sbd.sbd_bytes / (1024.0 * 1024.0) / (secs > 0 ? secs : 1));
+	}
+
+	libzfs_core_fini();
+	return (0);
+}